@@ -3,6 +3,12 @@
 #include <random>
 #include "pico/stdlib.h"
 #include "joystick.hpp"
+#include "joystick_led.hpp"
+#include "joystick_speed.hpp"
+#include "joystick_record.hpp"
+#include "joystick_input.hpp"
+#include "joystick_drift.hpp"
+#include "joystick_poll.hpp"
 #include "joystick/joystick_config.hpp"
 #include "st7789/st7789.hpp"
 
@@ -251,22 +257,6 @@ void clearAllDots(st7789::ST7789& lcd, const WanderingDots& dots) {
     }
 }
 
-// 确定摇杆方向
-int determine_joystick_direction(int16_t x, int16_t y) {
-    int16_t abs_x = abs(x);
-    int16_t abs_y = abs(y);
-    
-    if (abs_y > abs_x * (JOYSTICK_DIRECTION_RATIO + 0.2)) {
-        return (y < 0) ? 1 : 2;  // 1=up, 2=down
-    }
-    
-    if (abs_x > abs_y * (JOYSTICK_DIRECTION_RATIO + 0.2)) {
-        return (x < 0) ? 3 : 4;  // 3=left, 4=right
-    }
-    
-    return 0;  // center
-}
-
 // 绘制红线
 void drawLines(st7789::ST7789& lcd) {
     // 绘制上方红线
@@ -354,11 +344,38 @@ int main() {
         return -1;
     }
     
+    // 协商I2C速度
+    JoystickSpeedControl bus_speed;
+    uint32_t i2c_speed = bus_speed.attach(&joystick, JOYSTICK_I2C_ADDR, JOYSTICK_I2C_MAX_SPEED);
+    if (i2c_speed != 0) {
+        printf("I2C speed: %lu Hz\n", (unsigned long)i2c_speed);
+    } else {
+        printf("I2C speed negotiation failed, staying at %lu Hz\n", (unsigned long)JOYSTICK_I2C_SPEED);
+    }
+    
+#if JOYSTICK_RECORD_MODE == JOYSTICK_RECORD_REPLAY
+    // 回放闪存中录制的输入，代替真实摇杆，用于可重复的基准测试
+    static JoystickReplayTransport replay;
+    const uint8_t *record_data;
+    uint32_t record_size;
+    if (joystick_record_load(&record_data, &record_size)) {
+        replay.begin(record_data, record_size, JOYSTICK_REPLAY_REALTIME);
+        joystick.begin(&replay, JOYSTICK_I2C_ADDR);
+        printf("Replaying input recording (%lu bytes)\n", (unsigned long)record_size);
+    }
+#elif JOYSTICK_RECORD_MODE == JOYSTICK_RECORD_CAPTURE
+    // 录制输入，缓冲区满时写入闪存并通过USB输出
+    static uint8_t record_buf[JOYSTICK_RECORD_BUFFER_SIZE];
+    JoystickRecorder recorder;
+    recorder.begin(record_buf, sizeof(record_buf));
+#endif
+    
     printf("Initialization successful!\n");
-    // 初始化成功，绿灯亮1秒后熄灭
-    joystick.set_rgb_color(JOYSTICK_LED_GREEN);
-    sleep_ms(1000);
-    joystick.set_rgb_color(JOYSTICK_LED_OFF);
+    // 初始化成功，绿灯亮1秒后熄灭（由led.tick计时，不阻塞）
+    JoystickLed led;
+    led.begin(&joystick);
+    led.flash(JOYSTICK_LED_GREEN, 1000);
+    led.tick(to_ms_since_boot(get_absolute_time()));
     
     // 清屏并显示启动提示
     lcd.clearScreen(BG_COLOR);
@@ -375,6 +392,7 @@ int main() {
             drawLines(lcd);
             sleep_ms(200);  // 消抖
         }
+        led.tick(to_ms_since_boot(get_absolute_time()));
         sleep_ms(JOYSTICK_LOOP_DELAY_MS);
     }
     
@@ -390,9 +408,17 @@ int main() {
     // 等待一小段时间，确保摇杆稳定
     sleep_ms(500);
     
+    // 方向分类与按键防抖（按时间防抖，默认10ms），长按3秒触发
+    JoystickInput input;
+    JoystickDrift drift;
+    joystick_input_config_t input_config;
+    input_config.press_threshold = 600;
+    input_config.release_threshold = 400;
+    input_config.long_press_ms = 3000;
+    input_config.repeat_delay_ms = 0;
+    input.set_config(input_config);
+    
     // 状态变量
-    static int previous_raw_direction = 0;
-    static uint8_t stable_count = 0;
     static StampPositions stamps = {0};  // 初始化盖章位置数组
     
     // 初始化小球数组
@@ -403,22 +429,36 @@ int main() {
     bool game_started = false;
     uint32_t game_start_time = 0;
     int remaining_seconds = GAME_TIME;
-    // 新增LED状态变量
-    static bool is_active = false;
+    
+    // 采样周期沿用JOYSTICK_LOOP_DELAY_MS，暂停时也按同一节拍等待
+    JoystickPoller poller;
+    poller.begin(JOYSTICK_LOOP_DELAY_MS * 1000);
     
     while (true) {
-        // 检查MID按钮状态
-        static uint32_t button_press_start_time = 0;
-        static bool button_pressed = false;
-        static bool long_press_triggered = false;
+        // 每帧读取一次摇杆偏移值和按键状态
+        joystick_state_t state;
+        joystick.read_state(&state, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+#if JOYSTICK_RECORD_MODE == JOYSTICK_RECORD_CAPTURE
+        if (!recorder.is_full() && !recorder.record(state)) {
+            joystick_record_save(recorder);
+            recorder.dump();
+        }
+#endif
+        // 中心漂移校正（在录制之后，录制的是原始数据）
+        drift.process(state);
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        input.update(state, now_ms);
         
-        if (joystick.get_button_value() == 0) {  // 按钮按下
-            uint32_t current_time = to_ms_since_boot(get_absolute_time());
-            
-            if (!button_pressed) {  // 按钮刚被按下
-                button_pressed = true;
-                button_press_start_time = current_time;
-                long_press_triggered = false;
+        // 处理MID按钮事件
+        bool restart = false;
+        joystick_event_t event;
+        while (input.poll_event(&event)) {
+            if (event.key != JOYSTICK_KEY_MID) {
+                continue;
+            }
+            if (event.type == JOYSTICK_EVENT_PRESS) {
+                // 红灯闪烁50ms后自动恢复
+                led.flash(JOYSTICK_LED_RED, 50);
                 
                 // 如果游戏暂停，再次按下中间键重新开始
                 if (game_paused) {
@@ -429,7 +469,8 @@ int main() {
                     drawLines(lcd);
                     drawAllStamps(lcd, stamps);
                     drawAllDots(lcd, wandering_dots);
-                    continue;
+                    restart = true;
+                    break;
                 }
                 
                 // 单击：绘制stamp
@@ -468,15 +509,13 @@ int main() {
                     }
                     printf("Reached maximum stamps limit (%d)\n", MAX_STAMPS);
                 }
-            } else if (!long_press_triggered && (current_time - button_press_start_time >= 3000)) {
+            } else if (event.type == JOYSTICK_EVENT_LONG_PRESS) {
                 // 长按3秒触发
-                long_press_triggered = true;
-                
                 // 添加新的小球
                 if (wandering_dots.count < MAX_DOTS) {
                     // 随机决定生成小绿球还是小黄球
                     bool is_yellow = (rand() % 2) == 0;  // 50%概率生成小黄球
-                    
+                
                     WanderingDot new_dot = {
                         {(SCREEN_WIDTH - BLOCK_SIZE) / 2, (SCREEN_HEIGHT - BLOCK_SIZE) / 2},  // 初始位置（屏幕中央）
                         static_cast<int16_t>((rand() % 5) - 2),  // 随机初始X速度
@@ -487,22 +526,22 @@ int main() {
                     wandering_dots.dots[wandering_dots.count] = new_dot;
                     wandering_dots.count++;
                     drawDot(lcd, new_dot.pos, is_yellow);
-                    
+                
                     // 如果是第一个球，开始计时
                     if (!game_started) {
                         game_started = true;
-                        game_start_time = current_time;
+                        game_start_time = event.time_ms;
                     }
                 }
             }
-        } else {
-            button_pressed = false;
-            long_press_triggered = false;
+        }
+        if (restart) {
+            continue;
         }
 
         // 如果游戏暂停，跳过更新
         if (game_paused) {
-            sleep_ms(JOYSTICK_LOOP_DELAY_MS);
+            poller.wait();
             continue;
         }
 
@@ -531,57 +570,19 @@ int main() {
             drawCountdown(lcd, remaining_seconds);
         }
 
-        // 检查方向（摇杆移动）
-        uint16_t adc_x = 0, adc_y = 0;
-        joystick.get_joy_adc_16bits_value_xy(&adc_x, &adc_y);
-        int16_t offset_x = joystick.get_joy_adc_12bits_offset_value_x();
-        int16_t offset_y = joystick.get_joy_adc_12bits_offset_value_y();
-        int raw_direction = determine_joystick_direction(offset_x, offset_y);
-        // 检查mid键
-        bool mid_pressed = (joystick.get_button_value() == 0);
-        static bool last_mid_pressed = false;
-        static absolute_time_t last_red_time = {0};
-        // 检测mid键按下的瞬间
-        if (mid_pressed && !last_mid_pressed) {
-            joystick.set_rgb_color(JOYSTICK_LED_RED);
-            last_red_time = get_absolute_time();
-        }
-        // 50ms后自动关灯
-        if (!is_nil_time(last_red_time) && absolute_time_diff_us(last_red_time, get_absolute_time()) > 50000) {
-            joystick.set_rgb_color(JOYSTICK_LED_OFF);
-            last_red_time = {0};
-        }
-        last_mid_pressed = mid_pressed;
-        // 其余LED逻辑
-        if (!mid_pressed && last_red_time == (absolute_time_t){0}) {
-            if (raw_direction > 0 && !is_active) {
-                is_active = true;
-                joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-            } else if (raw_direction == 0 && is_active) {
-                is_active = false;
-                joystick.set_rgb_color(JOYSTICK_LED_OFF);
-            }
-        }
+        // 检查方向（摇杆移动），已防抖
+        uint8_t direction = input.get_direction();
+        // LED逻辑：摇杆移动时亮蓝灯，颜色不变时不会产生I2C写入
+        led.set_color(direction != JOYSTICK_KEY_NONE ? JOYSTICK_LED_BLUE : JOYSTICK_LED_OFF);
+        led.tick(to_ms_since_boot(get_absolute_time()));
 
-        // 防抖动处理
-        if (raw_direction == previous_raw_direction) {
-            if (stable_count < 3) {
-                stable_count++;
-            }
-        } else {
-            if (stable_count > 0) {
-                stable_count--;
-            }
-            previous_raw_direction = raw_direction;
-        }
-        
         // 只有当方向稳定时才移动
-        if (stable_count >= 3) {
+        if (direction != JOYSTICK_KEY_NONE) {
             // 保存旧位置
             BlockPosition old_pos = block_pos;
             
             // 根据方向移动方块
-            switch (raw_direction) {
+            switch (direction) {
                 case 1:  // 上
                     block_pos.y = (block_pos.y - MOVE_STEP < TOP_LINE_Y + LINE_WIDTH) ? (TOP_LINE_Y + LINE_WIDTH) : block_pos.y - MOVE_STEP;
                     break;
@@ -636,7 +637,7 @@ int main() {
         
         drawAllDots(lcd, wandering_dots);
 
-        sleep_ms(JOYSTICK_LOOP_DELAY_MS);
+        poller.wait();
     }
     
     return 0;
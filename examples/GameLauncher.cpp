@@ -1,9 +1,12 @@
 #include <stdio.h>
 #include <cstdlib>
 #include <random>
-#include <cmath>  // 添加这个头文件用于 abs 函数
 #include "pico/stdlib.h"
 #include "joystick.hpp"
+#include "joystick_input.hpp"
+#include "joystick_drift.hpp"
+#include "joystick_led.hpp"
+#include "joystick_speed.hpp"
 #include "joystick/joystick_config.hpp"
 #include "st7789/st7789.hpp"
 
@@ -86,22 +89,6 @@ void drawMenu(st7789::ST7789& lcd) {
     }
 }
 
-// 确定摇杆方向
-int determine_joystick_direction(int16_t x, int16_t y) {
-    int16_t abs_x = std::abs(x);
-    int16_t abs_y = std::abs(y);
-    
-    if (abs_y > abs_x * 1.2) {
-        return (y < 0) ? 1 : 2;  // 1=up, 2=down
-    }
-    
-    if (abs_x > abs_y * 1.2) {
-        return (x < 0) ? 3 : 4;  // 3=left, 4=right
-    }
-    
-    return 0;  // center
-}
-
 // 启动选中的游戏
 void launchSelectedGame() {
     for (int i = 0; i < MENU_ITEM_COUNT; i++) {
@@ -148,11 +135,21 @@ int main() {
         return -1;
     }
     
+    // 协商I2C速度
+    JoystickSpeedControl bus_speed;
+    uint32_t i2c_speed = bus_speed.attach(&joystick, JOYSTICK_I2C_ADDR, JOYSTICK_I2C_MAX_SPEED);
+    if (i2c_speed != 0) {
+        printf("I2C speed: %lu Hz\n", (unsigned long)i2c_speed);
+    } else {
+        printf("I2C speed negotiation failed, staying at %lu Hz\n", (unsigned long)JOYSTICK_I2C_SPEED);
+    }
+    
     printf("Initialization successful!\n");
-    // 初始化成功，绿灯亮1秒后熄灭
-    joystick.set_rgb_color(JOYSTICK_LED_GREEN);
-    sleep_ms(1000);
-    joystick.set_rgb_color(JOYSTICK_LED_OFF);
+    // 初始化成功，绿灯亮1秒后熄灭（由led.tick计时，不阻塞）
+    JoystickLed led;
+    led.begin(&joystick);
+    led.flash(JOYSTICK_LED_GREEN, 1000);
+    led.tick(to_ms_since_boot(get_absolute_time()));
     
     // 初始化菜单选择
     int selectedIndex = 0;
@@ -161,65 +158,64 @@ int main() {
     // 绘制初始菜单
     drawMenu(lcd);
     
+    // 方向输入：阈值带回差，按下沿触发一次（不自动重复），无需等待摇杆回中
+    JoystickInput input;
+    JoystickDrift drift;
+    joystick_input_config_t input_config;
+    input_config.press_threshold = 1500;
+    input_config.release_threshold = 1000;
+    input_config.ratio_q8 = 307;      // 1.2
+    input_config.repeat_delay_ms = 0;
+    input.set_config(input_config);
+    
     while (true) {
-        // 熄灭LED灯
-        joystick.set_rgb_color(JOYSTICK_LED_OFF);
-
         // 读取摇杆状态
-        int16_t x = joystick.get_joy_adc_12bits_offset_value_x();
-        int16_t y = joystick.get_joy_adc_12bits_offset_value_y();
-        bool buttonPressed = (joystick.get_button_value() == 0);
+        joystick_state_t state;
+        joystick.read_state(&state, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+        // 中心漂移校正：摇杆静止时慢慢重新估计中心，避免菜单自动滚动
+        drift.process(state);
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        input.update(state, now_ms);
         
-        // 处理方向输入
-        int direction = determine_joystick_direction(x, y);
-        if (direction != 0) { // 如果不是中间位置
-            // 根据方向设置灯光
-            if (direction == 1) {  // 上
-                joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-            } else if (direction == 2) {  // 下
-                joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-            } else if (direction == 3) {  // 左
-                joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-            } else if (direction == 4) {  // 右
-                joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-            }
-
-            // 取消当前选择
-            menuItems[selectedIndex].selected = false;
-            
-            // 更新选择
-            if (direction == 1) {  // 上
-                selectedIndex = (selectedIndex - 1 + MENU_ITEM_COUNT) % MENU_ITEM_COUNT;
-            } else if (direction == 2) {  // 下
-                selectedIndex = (selectedIndex + 1) % MENU_ITEM_COUNT;
+        // 处理输入事件
+        joystick_event_t event;
+        while (input.poll_event(&event)) {
+            if (event.type != JOYSTICK_EVENT_PRESS) {
+                continue;
             }
-            // 对于左右移动，如果也想让它改变菜单选项，需要在这里添加逻辑
-            // 目前的逻辑只处理上下移动来改变菜单选项
-
-            // 设置新选择 (仅当上下移动时，若左右也需更改，则移出此if)
-            menuItems[selectedIndex].selected = true;
-            
-            // 重绘菜单
-            drawMenu(lcd);
-            
-            // 等待摇杆回中
-            while (std::abs(joystick.get_joy_adc_12bits_offset_value_x()) > 1000 || std::abs(joystick.get_joy_adc_12bits_offset_value_y()) > 1000) {
-                sleep_ms(10);
+            if (event.key == JOYSTICK_KEY_UP || event.key == JOYSTICK_KEY_DOWN) {
+                // 根据方向设置灯光
+                led.set_color(JOYSTICK_LED_BLUE);
+                led.tick(now_ms);
+                
+                // 取消当前选择并更新选择
+                menuItems[selectedIndex].selected = false;
+                if (event.key == JOYSTICK_KEY_UP) {
+                    selectedIndex = (selectedIndex - 1 + MENU_ITEM_COUNT) % MENU_ITEM_COUNT;
+                } else {
+                    selectedIndex = (selectedIndex + 1) % MENU_ITEM_COUNT;
+                }
+                menuItems[selectedIndex].selected = true;
+                
+                // 重绘菜单
+                drawMenu(lcd);
+            } else if (event.key == JOYSTICK_KEY_MID) {
+                // 处理确认按钮
+                led.set_color(JOYSTICK_LED_RED); // 按钮按下时亮红灯
+                led.tick(now_ms);
+                launchSelectedGame();
             }
-            joystick.set_rgb_color(JOYSTICK_LED_OFF); // 摇杆回中后熄灭灯
         }
         
-        // 处理确认按钮
-        if (buttonPressed) {
-            joystick.set_rgb_color(JOYSTICK_LED_RED); // 按钮按下时亮红灯
-            launchSelectedGame();
-            // 等待按钮释放
-            while (joystick.get_button_value() == 0) {
-                sleep_ms(10);
-            }
-            joystick.set_rgb_color(JOYSTICK_LED_OFF); // 按钮释放后熄灭灯
+        // 按钮按住亮红灯，摇杆偏离中心亮蓝灯，回中或释放后熄灭
+        if (input.is_button_pressed()) {
+            led.set_color(JOYSTICK_LED_RED);
+        } else if (input.get_direction() != JOYSTICK_KEY_NONE) {
+            led.set_color(JOYSTICK_LED_BLUE);
+        } else {
+            led.set_color(JOYSTICK_LED_OFF);
         }
-        
+        led.tick(now_ms);
         sleep_ms(10);
     }
     
@@ -3,6 +3,13 @@
 #include <random>
 #include "pico/stdlib.h"
 #include "joystick.hpp"
+#include "joystick_input.hpp"
+#include "joystick_drift.hpp"
+#include "joystick_pipeline.hpp"
+#include "joystick_led.hpp"
+#include "joystick_speed.hpp"
+#include "joystick_record.hpp"
+#include "joystick_poll.hpp"
 #include "joystick/joystick_config.hpp"
 #include "st7789/st7789.hpp"
 
@@ -16,8 +23,9 @@
 #define SPACESHIP_SIZE 16
 #define MISSILE_SIZE 4
 #define MISSILE_SPEED 5
-#define SPACESHIP_SPEED 4
+#define SPACESHIP_SPEED 4  // 摇杆推到底时的速度，速度与推动幅度成正比
 #define MATRIX_COUNT 5  // 1x1到5x5的矩阵数量
+#define FRAME_PERIOD_US 16667  // 约60FPS，原先的sleep_ms(16)另加绘制耗时，实际帧率低于60
 
 // 定义颜色
 #define TEXT_COLOR st7789::WHITE
@@ -67,22 +75,6 @@ struct GameState {
     uint8_t matrix_size;  // 当前矩阵大小（1-5）
 };
 
-// 确定摇杆方向
-int determine_joystick_direction(int16_t x, int16_t y) {
-    int16_t abs_x = abs(x);
-    int16_t abs_y = abs(y);
-    
-    if (abs_y > abs_x * 1.2) {
-        return (y < 0) ? 1 : 2;  // 1=up, 2=down
-    }
-    
-    if (abs_x > abs_y * 1.2) {
-        return (x < 0) ? 3 : 4;  // 3=left, 4=right
-    }
-    
-    return 0;  // center
-}
-
 // 清除方块
 void clearBlock(st7789::ST7789& lcd, const Block& block) {
     if (!block.active) return;
@@ -205,7 +197,7 @@ bool checkCollision(const Position& pos1, uint8_t size1, const Position& pos2, u
 }
 
 // 更新游戏状态
-void updateGame(GameState& game, int direction, bool fire, st7789::ST7789& lcd) {
+void updateGame(GameState& game, joystick_vector_t move, bool fire, st7789::ST7789& lcd) {
     if (game.game_over) return;
     
     // 保存旧位置
@@ -213,16 +205,11 @@ void updateGame(GameState& game, int direction, bool fire, st7789::ST7789& lcd)
     Missile old_missile = game.missile;
     Explosion old_explosion = game.explosion;
     
-    // 更新飞船位置
-    if (direction == 1) {  // 上
-        game.spaceship.y = std::max(20, game.spaceship.y - SPACESHIP_SPEED);
-    } else if (direction == 2) {  // 下
-        game.spaceship.y = std::min(SCREEN_HEIGHT - SPACESHIP_SIZE, game.spaceship.y + SPACESHIP_SPEED);
-    } else if (direction == 3) {  // 左
-        game.spaceship.x = std::max(0, game.spaceship.x - SPACESHIP_SPEED);
-    } else if (direction == 4) {  // 右
-        game.spaceship.x = std::min(SCREEN_WIDTH - SPACESHIP_SIZE, game.spaceship.x + SPACESHIP_SPEED);
-    }
+    // 更新飞船位置：Q15向量按比例换算成像素，可斜向移动
+    int dx = joystick_q15_scale(move.x, SPACESHIP_SPEED);
+    int dy = joystick_q15_scale(move.y, SPACESHIP_SPEED);
+    game.spaceship.x = std::min(SCREEN_WIDTH - SPACESHIP_SIZE, std::max(0, game.spaceship.x + dx));
+    game.spaceship.y = std::min(SCREEN_HEIGHT - SPACESHIP_SIZE, std::max(20, game.spaceship.y + dy));
     
     // 如果飞船位置改变，清除旧位置并绘制新位置
     if (old_spaceship.x != game.spaceship.x || old_spaceship.y != game.spaceship.y) {
@@ -400,11 +387,38 @@ int main() {
         return -1;
     }
     
+    // 协商I2C速度
+    JoystickSpeedControl bus_speed;
+    uint32_t i2c_speed = bus_speed.attach(&joystick, JOYSTICK_I2C_ADDR, JOYSTICK_I2C_MAX_SPEED);
+    if (i2c_speed != 0) {
+        printf("I2C speed: %lu Hz\n", (unsigned long)i2c_speed);
+    } else {
+        printf("I2C speed negotiation failed, staying at %lu Hz\n", (unsigned long)JOYSTICK_I2C_SPEED);
+    }
+    
+#if JOYSTICK_RECORD_MODE == JOYSTICK_RECORD_REPLAY
+    // 回放闪存中录制的输入，代替真实摇杆，用于可重复的基准测试
+    static JoystickReplayTransport replay;
+    const uint8_t *record_data;
+    uint32_t record_size;
+    if (joystick_record_load(&record_data, &record_size)) {
+        replay.begin(record_data, record_size, JOYSTICK_REPLAY_REALTIME);
+        joystick.begin(&replay, JOYSTICK_I2C_ADDR);
+        printf("Replaying input recording (%lu bytes)\n", (unsigned long)record_size);
+    }
+#elif JOYSTICK_RECORD_MODE == JOYSTICK_RECORD_CAPTURE
+    // 录制输入，缓冲区满时写入闪存并通过USB输出
+    static uint8_t record_buf[JOYSTICK_RECORD_BUFFER_SIZE];
+    JoystickRecorder recorder;
+    recorder.begin(record_buf, sizeof(record_buf));
+#endif
+    
     printf("Initialization successful!\n");
-    // 初始化成功，绿灯亮1秒后熄灭
-    joystick.set_rgb_color(JOYSTICK_LED_GREEN);
-    sleep_ms(1000);
-    joystick.set_rgb_color(JOYSTICK_LED_OFF);
+    // 初始化成功，绿灯亮1秒后熄灭（由led.tick计时，不阻塞）
+    JoystickLed led;
+    led.begin(&joystick);
+    led.flash(JOYSTICK_LED_GREEN, 1000);
+    led.tick(to_ms_since_boot(get_absolute_time()));
     
     // 清屏并显示启动提示
     lcd.clearScreen(BG_COLOR);
@@ -418,6 +432,7 @@ int main() {
             lcd.clearScreen(BG_COLOR);
             sleep_ms(200);  // 消抖
         }
+        led.tick(to_ms_since_boot(get_absolute_time()));
         sleep_ms(JOYSTICK_LOOP_DELAY_MS);
     }
     
@@ -432,45 +447,61 @@ int main() {
     drawSpaceship(lcd, game.spaceship);
     drawScore(lcd, game.score);
     
+    // 方向输入：整数分类，阈值带回差，不做帧计数消抖
+    JoystickInput input;
+    JoystickDrift drift;
+    joystick_input_config_t input_config;
+    input_config.press_threshold = 600;
+    input_config.release_threshold = 400;
+    input_config.ratio_q8 = 307;      // 1.2
+    input_config.debounce_ms = 0;
+    input.set_config(input_config);
+    
+    // 飞船移动：径向死区、响应曲线和滤波，输出Q15向量
+    JoystickPipeline pipeline;
+    joystick_pipeline_config_t pipeline_config;
+    pipeline_config.curve_x = &joystick_curve_expo;
+    pipeline_config.curve_y = &joystick_curve_expo;
+    pipeline.set_config(pipeline_config);
+    
+    // 帧节拍：每帧在固定截止时间读取摇杆，绘制耗时不会推迟下一帧
+    JoystickPoller poller;
+    poller.begin(FRAME_PERIOD_US);
+    
     // 主循环
-    static bool is_active = false;
     while (true) {
-        // 获取摇杆方向
-        uint16_t adc_x = 0, adc_y = 0;
-        joystick.get_joy_adc_16bits_value_xy(&adc_x, &adc_y);
-        int16_t offset_x = joystick.get_joy_adc_12bits_offset_value_x();
-        int16_t offset_y = joystick.get_joy_adc_12bits_offset_value_y();
-        int raw_direction = determine_joystick_direction(offset_x, offset_y);
-        // 检查mid键
-        bool mid_pressed = (joystick.get_button_value() == 0);
-        static bool last_mid_pressed = false;
-        static absolute_time_t last_red_time = {0};
-        // 检测mid键按下的瞬间
-        if (mid_pressed && !last_mid_pressed) {
-            joystick.set_rgb_color(JOYSTICK_LED_RED);
-            last_red_time = get_absolute_time();
+        // 获取摇杆方向和mid键状态（一次读取偏移值和按键）
+        joystick_state_t state;
+        joystick.read_state(&state, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+#if JOYSTICK_RECORD_MODE == JOYSTICK_RECORD_CAPTURE
+        if (!recorder.is_full() && !recorder.record(state)) {
+            joystick_record_save(recorder);
+            recorder.dump();
         }
-        // 50ms后自动关灯
-        if (!is_nil_time(last_red_time) && absolute_time_diff_us(last_red_time, get_absolute_time()) > 50000) {
-            joystick.set_rgb_color(JOYSTICK_LED_OFF);
-            last_red_time = {0};
-        }
-        last_mid_pressed = mid_pressed;
-        // 其余LED逻辑
-        if (!mid_pressed && last_red_time == (absolute_time_t){0}) {
-            if (raw_direction > 0 && !is_active) {
-                is_active = true;
-                joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-            } else if (raw_direction == 0 && is_active) {
-                is_active = false;
-                joystick.set_rgb_color(JOYSTICK_LED_OFF);
+#endif
+        // 中心漂移校正（在录制之后，录制的是原始数据）
+        drift.process(state);
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        input.update(state, now_ms);
+        int raw_direction = input.get_direction();
+        joystick_vector_t move = pipeline.update(state);
+        // 检查mid键
+        bool mid_pressed = input.is_button_pressed();
+        // 检测mid键按下的瞬间，红灯闪烁50ms后自动恢复
+        joystick_event_t event;
+        while (input.poll_event(&event)) {
+            if (event.type == JOYSTICK_EVENT_PRESS && event.key == JOYSTICK_KEY_MID) {
+                led.flash(JOYSTICK_LED_RED, 50);
             }
         }
+        // 其余LED逻辑：摇杆移动时亮蓝灯，颜色不变时不会产生I2C写入
+        led.set_color(raw_direction > 0 ? JOYSTICK_LED_BLUE : JOYSTICK_LED_OFF);
+        led.tick(now_ms);
         // 获取按键状态
         bool fire = mid_pressed;
         
         // 更新游戏状态
-        updateGame(game, raw_direction, fire, lcd);
+        updateGame(game, move, fire, lcd);
         
         // 如果游戏结束，等待重新开始
         if (game.game_over && fire) {
@@ -485,7 +516,7 @@ int main() {
             drawScore(lcd, game.score);
         }
         
-        sleep_ms(16);  // 约60FPS
+        poller.wait();  // 等待下一帧截止时间
     }
     
     return 0;
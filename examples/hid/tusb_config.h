@@ -0,0 +1,28 @@
+#ifndef _TUSB_CONFIG_H_
+#define _TUSB_CONFIG_H_
+
+// TinyUSB configuration of the joystick_hid gamepad
+
+#ifndef CFG_TUSB_RHPORT0_MODE
+#define CFG_TUSB_RHPORT0_MODE   OPT_MODE_DEVICE
+#endif
+
+#ifndef CFG_TUSB_OS
+#define CFG_TUSB_OS             OPT_OS_PICO
+#endif
+
+#define CFG_TUSB_MEM_SECTION
+#define CFG_TUSB_MEM_ALIGN      __attribute__ ((aligned(4)))
+
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+// One HID interface, no CDC: stdio is not used by the gamepad
+#define CFG_TUD_HID             1
+#define CFG_TUD_CDC             0
+#define CFG_TUD_MSC             0
+#define CFG_TUD_MIDI            0
+#define CFG_TUD_VENDOR          0
+
+#define CFG_TUD_HID_EP_BUFSIZE  8
+
+#endif
@@ -0,0 +1,107 @@
+#include "tusb.h"
+#include "joystick_hid.hpp"
+
+#define JOYSTICK_HID_VID        0xCAFE    // TinyUSB example vendor ID, replace for a product
+#define JOYSTICK_HID_PID        0x4063
+#define JOYSTICK_HID_EP_IN      0x81
+#define JOYSTICK_HID_INTERVAL   1         // Polled every 1 ms frame
+
+enum {
+    ITF_NUM_HID = 0,
+    ITF_NUM_TOTAL
+};
+
+static const tusb_desc_device_t desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    .bDeviceClass       = 0x00,
+    .bDeviceSubClass    = 0x00,
+    .bDeviceProtocol    = 0x00,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = JOYSTICK_HID_VID,
+    .idProduct          = JOYSTICK_HID_PID,
+    .bcdDevice          = 0x0100,
+    .iManufacturer      = 0x01,
+    .iProduct           = 0x02,
+    .iSerialNumber      = 0x03,
+    .bNumConfigurations = 0x01
+};
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(joystick_hid_report_descriptor),
+                       JOYSTICK_HID_EP_IN, CFG_TUD_HID_EP_BUFSIZE, JOYSTICK_HID_INTERVAL)
+};
+
+static const char *const string_desc[] = {
+    "",                      // 0: language, sent as 0x0409
+    "M5Stack",               // 1: manufacturer
+    "Joystick Unit Gamepad", // 2: product
+    "000001",                // 3: serial
+};
+
+extern "C" {
+
+uint8_t const *tud_descriptor_device_cb(void)
+{
+    return (uint8_t const *)&desc_device;
+}
+
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void)index;
+    return desc_configuration;
+}
+
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance)
+{
+    (void)instance;
+    return joystick_hid_report_descriptor;
+}
+
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    static uint16_t desc_str[32];
+    (void)langid;
+    uint8_t count;
+    if (index == 0) {
+        desc_str[1] = 0x0409;
+        count = 1;
+    } else {
+        if (index >= sizeof(string_desc) / sizeof(string_desc[0])) {
+            return NULL;
+        }
+        const char *str = string_desc[index];
+        for (count = 0; str[count] != '\0' && count < 31; count++) {
+            desc_str[1 + count] = str[count];
+        }
+    }
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * count + 2));
+    return desc_str;
+}
+
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                               uint8_t *buffer, uint16_t reqlen)
+{
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)reqlen;
+    return 0;
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                           uint8_t const *buffer, uint16_t bufsize)
+{
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)bufsize;
+}
+
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include "joystick.hpp"
+#include "joystick_speed.hpp"
+#include "joystick_pipeline.hpp"
+#include "joystick_trace.hpp"
+#include "joystick/joystick_config.hpp"
+#include "st7789/st7789.hpp"
+#ifdef JOYSTICK_HOST
+#include "joystick_mock_bus.hpp"
+#else
+#include "pico/stdlib.h"
+#endif
+
+// Input-to-photon latency: a square follows the stick, every frame is traced
+// from the stick read to the end of its last display transfer.
+//   TRACE frame=<n> id=<sample> latency_us=<us>        (TRACE_FRAME_OUTPUT)
+//   TRACE_SUMMARY frames= p50_us= p90_us= p99_us= max_us=
+// On the host both drivers run on mocks and the simulated clock: the unit is
+// JoystickMockBus with wire timing, the display the host ST7789 HAL.
+
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 320
+#define SQUARE_SIZE 16
+#define SQUARE_SPEED 6                // Pixels per frame at full deflection
+#define FRAME_US 16667                // 60 fps
+#define SUMMARY_FRAMES 120            // Frames between summaries
+#ifndef TRACE_FRAME_OUTPUT
+#define TRACE_FRAME_OUTPUT 0
+#endif
+#ifdef JOYSTICK_HOST
+#define HOST_FRAMES 600               // Frames simulated before exit
+#endif
+
+int main()
+{
+    Joystick joystick;
+    JoystickSpeedControl bus_speed;
+    JoystickPipeline pipeline;
+    JoystickTrace trace;
+    st7789::ST7789 lcd;
+
+#ifdef JOYSTICK_HOST
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_I2C_ADDR);
+    bus.set_wire_timing(true);
+    bus_speed.begin(&bus);
+#else
+    stdio_init_all();
+    if (!joystick.begin(JOYSTICK_I2C_PORT, JOYSTICK_I2C_ADDR, JOYSTICK_I2C_SDA_PIN, JOYSTICK_I2C_SCL_PIN,
+                        JOYSTICK_I2C_SPEED)) {
+        printf("Joystick initialization failed!\n");
+        return -1;
+    }
+    bus_speed.begin(joystick.get_transport());
+#endif
+    bus_speed.negotiate(JOYSTICK_I2C_ADDR, JOYSTICK_I2C_MAX_SPEED);
+    if (!joystick.begin(&bus_speed, JOYSTICK_I2C_ADDR)) {
+        printf("Joystick initialization failed!\n");
+        return -1;
+    }
+
+    st7789::Config lcd_config;
+    lcd_config.width = SCREEN_WIDTH;
+    lcd_config.height = SCREEN_HEIGHT;
+    if (!lcd.begin(lcd_config)) {
+        printf("LCD initialization failed!\n");
+        return -1;
+    }
+    lcd.hal().setTransferCallback(JoystickTrace::transfer_callback, &trace);
+    trace.set_frame_output(TRACE_FRAME_OUTPUT);
+
+    int16_t x = (SCREEN_WIDTH - SQUARE_SIZE) / 2;
+    int16_t y = (SCREEN_HEIGHT - SQUARE_SIZE) / 2;
+    lcd.fillRect(x, y, SQUARE_SIZE, SQUARE_SIZE, st7789::WHITE);
+
+    for (uint32_t frame = 1; ; frame++) {
+        uint64_t frame_start = joystick_time_us();
+#ifdef JOYSTICK_HOST
+        if (frame > HOST_FRAMES) {
+            break;
+        }
+        // Circle the stick, one turn every 2 s
+        static const int16_t path[8][2] = {
+            { 4000, 0 }, { 2800, 2800 }, { 0, 4000 }, { -2800, 2800 },
+            { -4000, 0 }, { -2800, -2800 }, { 0, -4000 }, { 2800, -2800 }
+        };
+        const int16_t *p = path[(frame / 15) % 8];
+        bus.set_stick(JOYSTICK_I2C_ADDR, p[0], p[1], 1);
+#endif
+        joystick_state_t state;
+        if (!joystick.read_state(&state, JOYSTICK_STATE_OFFSET)) {
+            continue;
+        }
+        joystick_trace_tag_t tag = trace.tag(state);
+
+        // Game update
+        joystick_vector_t move = pipeline.update(state);
+        int16_t nx = x + joystick_q15_scale(move.x, SQUARE_SPEED);
+        int16_t ny = y + joystick_q15_scale(move.y, SQUARE_SPEED);
+        if (nx < 0) nx = 0;
+        if (ny < 0) ny = 0;
+        if (nx > SCREEN_WIDTH - SQUARE_SIZE) nx = SCREEN_WIDTH - SQUARE_SIZE;
+        if (ny > SCREEN_HEIGHT - SQUARE_SIZE) ny = SCREEN_HEIGHT - SQUARE_SIZE;
+
+        // Draw calls showing this sample
+        trace.draw_begin(tag);
+        if (nx != x || ny != y) {
+            lcd.fillRect(x, y, SQUARE_SIZE, SQUARE_SIZE, st7789::BLACK);
+            lcd.fillRect(nx, ny, SQUARE_SIZE, SQUARE_SIZE, st7789::WHITE);
+            x = nx;
+            y = ny;
+        }
+        trace.draw_end(lcd.isDmaBusy());
+
+        if (frame % SUMMARY_FRAMES == 0) {
+            trace.print_summary();
+        }
+
+        // Wait for the next frame
+        uint64_t elapsed = joystick_time_us() - frame_start;
+        if (elapsed < FRAME_US) {
+            joystick_sleep_us(FRAME_US - elapsed);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "joystick.hpp"
+#include "joystick_speed.hpp"
+#include "joystick_input.hpp"
+#include "joystick_pipeline.hpp"
+#include "joystick/joystick_config.hpp"
+#ifdef JOYSTICK_HOST
+#include <chrono>
+#include "joystick_mock_bus.hpp"
+#else
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#endif
+
+// Getter throughput and latency at every bus speed, one line per measurement:
+//   BENCH speed=<Hz> getter=<name> bits=<8|12|16|-> calls= tx= errors= tps= min_us= mean_us= max_us= [cpu_ns=]
+//   CMP speed=<Hz> bits=<n> single_us=<x+y getters> xy_us=<combined getter> saved_pct=
+//   CLASSIFY impl=<float|fixed4|fixed8> calls= ns= [cycles=]
+//   CLASSIFY_CMP samples= mismatch=<4-way results that differ> speedup_pct=
+//   PIPELINE curve=<linear|expo|cubic> samples= ns= [cycles=]
+// On the host the unit is JoystickMockBus with wire timing: *_us is the
+// simulated bus time and cpu_ns the real driver time per call. The CLASSIFY
+// and PIPELINE lines time the CPU work per sample alone, cycles only on the device.
+
+#ifndef JOYSTICK_BENCH_ITERATIONS
+#define JOYSTICK_BENCH_ITERATIONS 500
+#endif
+
+#ifndef JOYSTICK_BENCH_CLASSIFY_ITERATIONS
+#define JOYSTICK_BENCH_CLASSIFY_ITERATIONS 100000
+#endif
+
+/**
+ * @brief Transport wrapper counting transactions and failures
+ */
+class BenchCounter : public JoystickTransport {
+public:
+    void begin(JoystickTransport *transport) { _transport = transport; reset(); }
+    void reset(void) { transactions = 0; errors = 0; }
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override
+    {
+        return count(_transport->read_reg(addr, reg, buf, nbytes), nbytes);
+    }
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override
+    {
+        return count(_transport->write_reg(addr, reg, buf, nbytes), nbytes);
+    }
+    uint32_t set_speed(uint32_t speed) override { return _transport->set_speed(speed); }
+    uint32_t get_speed(void) override { return _transport->get_speed(); }
+
+    uint32_t transactions;
+    uint32_t errors;
+
+private:
+    int count(int ret, uint8_t nbytes)
+    {
+        transactions++;
+        if (ret != nbytes) errors++;
+        return ret;
+    }
+
+    JoystickTransport *_transport;
+};
+
+typedef struct {
+    const char *name;
+    const char *bits;
+    void (*call)(Joystick &joystick);
+} bench_getter_t;
+
+// Results go to a volatile sink so no call is optimized away
+static volatile uint32_t sink;
+
+static const bench_getter_t getters[] = {
+    { "adc16_x",     "16", [](Joystick &j) { sink = j.get_joy_adc_value_x(ADC_16BIT_RESULT); } },
+    { "adc16_y",     "16", [](Joystick &j) { sink = j.get_joy_adc_value_y(ADC_16BIT_RESULT); } },
+    { "adc16_xy",    "16", [](Joystick &j) { uint16_t x, y; j.get_joy_adc_16bits_value_xy(&x, &y); sink = x + y; } },
+    { "adc8_x",      "8",  [](Joystick &j) { sink = j.get_joy_adc_value_x(ADC_8BIT_RESULT); } },
+    { "adc8_y",      "8",  [](Joystick &j) { sink = j.get_joy_adc_value_y(ADC_8BIT_RESULT); } },
+    { "adc8_xy",     "8",  [](Joystick &j) { uint8_t x, y; j.get_joy_adc_8bits_value_xy(&x, &y); sink = x + y; } },
+    { "offset12_x",  "12", [](Joystick &j) { sink = j.get_joy_adc_12bits_offset_value_x(); } },
+    { "offset12_y",  "12", [](Joystick &j) { sink = j.get_joy_adc_12bits_offset_value_y(); } },
+    { "offset8_x",   "8",  [](Joystick &j) { sink = j.get_joy_adc_8bits_offset_value_x(); } },
+    { "offset8_y",   "8",  [](Joystick &j) { sink = j.get_joy_adc_8bits_offset_value_y(); } },
+    { "state_offset", "12", [](Joystick &j) {
+        joystick_state_t s; j.read_state(&s, JOYSTICK_STATE_OFFSET); sink = s.offset_x + s.offset_y; } },
+    { "state_offset_button", "12", [](Joystick &j) {
+        joystick_state_t s; j.read_state(&s, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON); sink = s.offset_x; } },
+    { "state_all",   "-",  [](Joystick &j) { joystick_state_t s; j.read_state(&s); sink = s.offset_x; } },
+    { "button",      "-",  [](Joystick &j) { sink = j.get_button_value(); } },
+    { "rgb",         "-",  [](Joystick &j) { sink = j.get_rgb_color(); } },
+    { "cal",         "-",  [](Joystick &j) {
+        uint16_t v[8]; j.get_joy_adc_value_cal(&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]); sink = v[0]; } },
+    { "firmware",    "-",  [](Joystick &j) { sink = j.get_firmware_version(); } },
+    { "bootloader",  "-",  [](Joystick &j) { sink = j.get_bootloader_version(); } },
+    { "i2c_address", "-",  [](Joystick &j) { sink = j.get_i2c_address(); } },
+};
+#define BENCH_GETTERS (sizeof(getters) / sizeof(getters[0]))
+
+// Single x and y getters compared with the combined getter: x, y, xy
+static const uint8_t comparisons[][3] = {
+    { 0, 1, 2 },   // 16bits ADC
+    { 3, 4, 5 },   // 8bits ADC
+    { 6, 7, 10 },  // 12bits offsets, combined through read_state
+};
+
+static uint64_t cpu_time_ns(void)
+{
+#ifdef JOYSTICK_HOST
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return 0; // The device clock already includes the CPU time
+#endif
+}
+
+// Wall clock for the CPU-only benchmarks
+static uint64_t bench_clock_ns(void)
+{
+#ifdef JOYSTICK_HOST
+    return cpu_time_ns();
+#else
+    return time_us_64() * 1000;
+#endif
+}
+
+/**
+ * @brief Float classifier the examples used before JoystickInput, the baseline
+ * @return 1 up, 2 down, 3 left, 4 right, 0 center
+ */
+static int float_classify_direction(int16_t x, int16_t y)
+{
+    int16_t abs_x = abs(x);
+    int16_t abs_y = abs(y);
+
+    if (abs_y > abs_x * (JOYSTICK_DIRECTION_RATIO + 0.2)) {
+        return (y < 0) ? 1 : 2;
+    }
+    if (abs_x > abs_y * (JOYSTICK_DIRECTION_RATIO + 0.2)) {
+        return (x < 0) ? 3 : 4;
+    }
+    return 0;
+}
+
+#define CLASSIFY_SAMPLES 256
+static int16_t classify_x[CLASSIFY_SAMPLES];
+static int16_t classify_y[CLASSIFY_SAMPLES];
+
+// Ends a CPU benchmark line, with the cycles per call on the device
+static void print_cycles(uint64_t ns)
+{
+#ifndef JOYSTICK_HOST
+    printf(" cycles=%lu", (unsigned long)(ns * clock_get_hz(clk_sys) / 1000000000ULL));
+#else
+    (void)ns;
+#endif
+    printf("\n");
+}
+
+/**
+ * @brief Time one classifier over the sample table and print its line
+ * @return nanoseconds per call
+ */
+template <typename F>
+static uint32_t bench_classifier(const char *name, F classify)
+{
+    uint64_t start = bench_clock_ns();
+    for (uint32_t i = 0; i < JOYSTICK_BENCH_CLASSIFY_ITERATIONS; i++) {
+        uint32_t n = i & (CLASSIFY_SAMPLES - 1);
+        sink = classify(classify_x[n], classify_y[n]);
+    }
+    uint64_t ns = (bench_clock_ns() - start) / JOYSTICK_BENCH_CLASSIFY_ITERATIONS;
+    printf("CLASSIFY impl=%s calls=%d ns=%lu", name, JOYSTICK_BENCH_CLASSIFY_ITERATIONS, (unsigned long)ns);
+    print_cycles(ns);
+    return (uint32_t)ns;
+}
+
+// Fixed-point JoystickInput classifier against the float version it replaced
+static void bench_classify(void)
+{
+    // Offsets spread over the whole 12-bit range, every sector and the center
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < CLASSIFY_SAMPLES; i++) {
+        seed = seed * 1103515245 + 12345;
+        classify_x[i] = (int16_t)((seed >> 16) % 4096) - 2048;
+        seed = seed * 1103515245 + 12345;
+        classify_y[i] = (int16_t)((seed >> 16) % 4096) - 2048;
+    }
+
+    // Same 4-way rule as the float version: ratio 1.7, no threshold
+    joystick_input_config_t config4;
+    config4.press_threshold = 0;
+    config4.release_threshold = 0;
+    joystick_input_config_t config8 = config4;
+    config8.eight_way = true;
+
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < CLASSIFY_SAMPLES; i++) {
+        if (joystick_classify_direction(classify_x[i], classify_y[i], config4) !=
+            float_classify_direction(classify_x[i], classify_y[i])) {
+            mismatch++;
+        }
+    }
+
+    uint32_t float_ns = bench_classifier("float", float_classify_direction);
+    uint32_t fixed_ns = bench_classifier("fixed4", [&](int16_t x, int16_t y) {
+        return joystick_classify_direction(x, y, config4);
+    });
+    bench_classifier("fixed8", [&](int16_t x, int16_t y) {
+        return joystick_classify_direction(x, y, config8);
+    });
+    printf("CLASSIFY_CMP samples=%d mismatch=%lu speedup_pct=%ld\n", CLASSIFY_SAMPLES, (unsigned long)mismatch,
+           fixed_ns > 0 ? (long)((int64_t)float_ns * 100 / fixed_ns - 100) : 0L);
+}
+
+// JoystickPipeline per sample: dead zone, both curves and the filter, over the classifier offsets
+static void bench_pipeline(void)
+{
+    static const struct {
+        const char *name;
+        const JoystickCurve *curve;
+    } curves[] = {
+        {"linear", &joystick_curve_linear},
+        {"expo", &joystick_curve_expo},
+        {"cubic", &joystick_curve_cubic},
+    };
+
+    for (const auto &c : curves) {
+        joystick_pipeline_config_t config;
+        config.curve_x = c.curve;
+        config.curve_y = c.curve;
+        JoystickPipeline pipeline;
+        pipeline.set_config(config);
+
+        uint64_t start = bench_clock_ns();
+        for (uint32_t i = 0; i < JOYSTICK_BENCH_CLASSIFY_ITERATIONS; i++) {
+            uint32_t n = i & (CLASSIFY_SAMPLES - 1);
+            sink = pipeline.update(classify_x[n], classify_y[n]).x;
+        }
+        uint64_t ns = (bench_clock_ns() - start) / JOYSTICK_BENCH_CLASSIFY_ITERATIONS;
+        printf("PIPELINE curve=%s samples=%d ns=%lu", c.name, JOYSTICK_BENCH_CLASSIFY_ITERATIONS, (unsigned long)ns);
+        print_cycles(ns);
+    }
+}
+
+/**
+ * @brief Run one getter and print its line
+ * @return mean latency in us
+ */
+static uint32_t bench_getter(Joystick &joystick, BenchCounter &counter, uint32_t speed, const bench_getter_t &g)
+{
+    uint32_t min_us = 0xFFFFFFFFUL;
+    uint32_t max_us = 0;
+    uint64_t total_us = 0;
+    uint64_t cpu_ns = 0;
+    counter.reset();
+    for (uint32_t i = 0; i < JOYSTICK_BENCH_ITERATIONS; i++) {
+        uint64_t cpu_start = cpu_time_ns();
+        uint64_t start = joystick_time_us();
+        g.call(joystick);
+        uint32_t us = (uint32_t)(joystick_time_us() - start);
+        cpu_ns += cpu_time_ns() - cpu_start;
+        total_us += us;
+        if (us < min_us) min_us = us;
+        if (us > max_us) max_us = us;
+    }
+    uint32_t mean_us = (uint32_t)(total_us / JOYSTICK_BENCH_ITERATIONS);
+    uint32_t tps = total_us > 0 ? (uint32_t)((uint64_t)counter.transactions * 1000000 / total_us) : 0;
+    printf("BENCH speed=%lu getter=%s bits=%s calls=%d tx=%lu errors=%lu tps=%lu min_us=%lu mean_us=%lu max_us=%lu",
+           (unsigned long)speed, g.name, g.bits, JOYSTICK_BENCH_ITERATIONS, (unsigned long)counter.transactions,
+           (unsigned long)counter.errors, (unsigned long)tps, (unsigned long)min_us, (unsigned long)mean_us,
+           (unsigned long)max_us);
+#ifdef JOYSTICK_HOST
+    printf(" cpu_ns=%lu", (unsigned long)(cpu_ns / JOYSTICK_BENCH_ITERATIONS));
+#else
+    (void)cpu_ns;
+#endif
+    printf("\n");
+    return mean_us;
+}
+
+static void bench_speed(Joystick &joystick, BenchCounter &counter, uint32_t speed)
+{
+    uint32_t mean_us[BENCH_GETTERS];
+    for (uint32_t i = 0; i < BENCH_GETTERS; i++) {
+        mean_us[i] = bench_getter(joystick, counter, speed, getters[i]);
+    }
+    for (const uint8_t *c : comparisons) {
+        uint32_t single_us = mean_us[c[0]] + mean_us[c[1]];
+        uint32_t xy_us = mean_us[c[2]];
+        uint32_t saved = single_us > 0 && single_us > xy_us ? (single_us - xy_us) * 100 / single_us : 0;
+        printf("CMP speed=%lu bits=%s single_us=%lu xy_us=%lu saved_pct=%lu\n", (unsigned long)speed,
+               getters[c[2]].bits, (unsigned long)single_us, (unsigned long)xy_us, (unsigned long)saved);
+    }
+}
+
+int main()
+{
+    Joystick joystick;
+    BenchCounter counter;
+#ifdef JOYSTICK_HOST
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_I2C_ADDR);
+    bus.set_wire_timing(true);
+    counter.begin(&bus);
+#else
+    stdio_init_all();
+    sleep_ms(2000); // Time to open the USB console
+    if (!joystick.begin(JOYSTICK_I2C_PORT, JOYSTICK_I2C_ADDR, JOYSTICK_I2C_SDA_PIN, JOYSTICK_I2C_SCL_PIN,
+                        JOYSTICK_I2C_SPEED)) {
+        printf("BENCH_ERROR joystick not found\n");
+        return 1;
+    }
+    counter.begin(joystick.get_transport());
+#endif
+    if (!joystick.begin(&counter, JOYSTICK_I2C_ADDR)) {
+        printf("BENCH_ERROR joystick not found\n");
+        return 1;
+    }
+
+    printf("BENCH_BEGIN iterations=%d\n", JOYSTICK_BENCH_ITERATIONS);
+    for (uint32_t speed : JoystickSpeedControl::speeds) {
+        uint32_t actual = counter.set_speed(speed);
+        bench_speed(joystick, counter, actual != 0 ? actual : speed);
+    }
+    bench_classify();
+    bench_pipeline();
+    printf("BENCH_END\n");
+
+#ifndef JOYSTICK_HOST
+    while (true) {
+        sleep_ms(1000);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "joystick.hpp"
+#include "joystick_speed.hpp"
+#include "joystick_drift.hpp"
+#include "joystick_pipeline.hpp"
+#include "joystick_hid.hpp"
+#include "joystick_cal_device.hpp"
+#include "joystick/joystick_config.hpp"
+
+// USB HID gamepad bridge: one stick read per 1 ms USB frame, reports only on change
+
+// tud_sof_cb_enable() came with TinyUSB 0.16 (pico-sdk 2.0), older stacks pace the reads with the 1 ms timer
+#if TUSB_VERSION_MAJOR > 0 || TUSB_VERSION_MINOR >= 16
+#define JOYSTICK_HID_USE_SOF 1
+#else
+#define JOYSTICK_HID_USE_SOF 0
+#endif
+#define JOYSTICK_HID_FRAME_US 1000
+
+Joystick joystick;
+JoystickSpeedControl bus_speed;
+JoystickDrift drift;
+JoystickPipeline pipeline;
+JoystickCalMap cal_map;
+JoystickHidReport report;
+bool joystick_ready = false;
+bool use_calibration = false;
+volatile bool frame_started = false;
+
+// Start of frame: the host polls the interrupt endpoint once per frame
+extern "C" void tud_sof_cb(uint32_t frame_count)
+{
+    (void)frame_count;
+    frame_started = true;
+}
+
+extern "C" void tud_mount_cb(void)
+{
+    // The host has no report yet
+    report.invalidate();
+}
+
+void setup()
+{
+    tusb_init();
+#if JOYSTICK_HID_USE_SOF
+    tud_sof_cb_enable(true);
+#endif
+
+    if (!joystick.begin(JOYSTICK_I2C_PORT, JOYSTICK_I2C_ADDR,
+                        JOYSTICK_I2C_SDA_PIN, JOYSTICK_I2C_SCL_PIN,
+                        JOYSTICK_I2C_SPEED)) {
+        return;
+    }
+    // A frame leaves 1 ms for the read, run the bus as fast as the wiring allows
+    bus_speed.attach(&joystick, JOYSTICK_I2C_ADDR, JOYSTICK_I2C_MAX_SPEED);
+    joystick_ready = true;
+
+    // Same calibration profile as the other examples, no guided sweep without a console
+    joystick_cal_profile_t profile;
+    if (joystick_cal_load(&profile)) {
+        cal_map.set_profile(profile);
+        use_calibration = true;
+    }
+
+    // Games apply their own curves: linear, small dead zone
+    joystick_pipeline_config_t config;
+    config.dead_zone = JOYSTICK_HID_DEAD_ZONE;
+    pipeline.set_config(config);
+}
+
+void poll_stick()
+{
+    joystick_vector_t move;
+    bool pressed;
+    if (use_calibration) {
+        uint8_t raw_x, raw_y;
+        int16_t x, y;
+        joystick.get_joy_adc_8bits_value_xy(&raw_x, &raw_y);
+        cal_map.map(raw_x, raw_y, &x, &y);
+        move = pipeline.update(x, y);
+        pressed = joystick.get_button_value() == 0;
+    } else {
+        joystick_state_t state;
+        joystick.read_state(&state, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+        drift.process(state);
+        move = pipeline.update(state);
+        pressed = state.button == 0;
+    }
+
+    // Queued now, sent on the IN poll of the next frame
+    if (report.update(move, pressed) && tud_hid_ready() &&
+        tud_hid_report(0, report.get_report(), report.get_size())) {
+        report.mark_sent();
+    }
+}
+
+int main()
+{
+    setup();
+#if !JOYSTICK_HID_USE_SOF
+    uint64_t next_frame_us = time_us_64();
+#endif
+    while (true) {
+        tud_task();
+#if !JOYSTICK_HID_USE_SOF
+        if (time_us_64() >= next_frame_us) {
+            next_frame_us += JOYSTICK_HID_FRAME_US;
+            frame_started = true;
+        }
+#endif
+        if (frame_started && joystick_ready) {
+            frame_started = false;
+            poll_stick();
+        }
+    }
+    return 0;
+}
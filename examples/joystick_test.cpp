@@ -1,27 +1,32 @@
 #include <stdio.h>
-#include <cstdlib>  // For abs() function
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "joystick.hpp"
+#include "joystick_input.hpp"
+#include "joystick_drift.hpp"
+#include "joystick_led.hpp"
+#include "joystick_speed.hpp"
+#include "joystick_scheduler.hpp"
+#include "joystick_cal_device.hpp"
+#include "joystick_poll.hpp"
 #include "joystick/joystick_config.hpp"
 
-// Direction constants
-#define DIRECTION_UP     1
-#define DIRECTION_DOWN   2
-#define DIRECTION_LEFT   3
-#define DIRECTION_RIGHT  4
-#define DIRECTION_CENTER 5
-
 // Create Joystick instance
 Joystick joystick;
-
-// Status tracking variables
-static int16_t last_offset_x = 0;
-static int16_t last_offset_y = 0;
-static bool last_button_state = true; // 1 = not pressed
-static bool is_active = false;        // Whether there is operation
-static absolute_time_t last_print_time = {0}; // Last print time
-static int last_direction = 0;  // Last direction: 0=none, 1=up, 2=down, 3=left, 4=right, 5=mid
+JoystickInput input;
+JoystickDrift drift;
+JoystickLed led;
+JoystickSpeedControl bus_speed;
+JoystickScheduler bus;
+JoystickSchedulerClient input_client;
+JoystickSchedulerClient led_client;
+Joystick led_joystick;
+JoystickCalMap cal_map;
+bool use_calibration = false;
+JoystickPoller poller;
+#if JOYSTICK_LATENCY_PROFILE
+uint32_t last_latency_print_ms = 0;
+#endif
 
 void setup() {
     stdio_init_all();
@@ -32,162 +37,124 @@ void setup() {
                       JOYSTICK_I2C_SDA_PIN, JOYSTICK_I2C_SCL_PIN, 
                       JOYSTICK_I2C_SPEED)) {
         printf("Joystick initialization successful!\n");
-        // Set LED to green to indicate successful initialization
-        joystick.set_rgb_color(JOYSTICK_LED_GREEN);
-        sleep_ms(1000);
-        joystick.set_rgb_color(JOYSTICK_LED_OFF);
+        // Run at the fastest speed the wiring sustains, drop back if errors climb
+        bus_speed.begin(joystick.get_transport());
+        uint32_t i2c_speed = bus_speed.negotiate(JOYSTICK_I2C_ADDR, JOYSTICK_I2C_MAX_SPEED);
+        printf("I2C speed: %lu Hz\n", (unsigned long)i2c_speed);
+        
+        // The scheduler owns the bus: stick reads first, LED writes queued behind them
+        bus.begin(&bus_speed);
+        input_client.begin(&bus, JOYSTICK_PRIORITY_HIGH, JOYSTICK_INPUT_DEADLINE_US);
+        led_client.begin(&bus, JOYSTICK_PRIORITY_LOW, JOYSTICK_LED_DEADLINE_US, true);
+        joystick.begin(&input_client, JOYSTICK_I2C_ADDR);
+        led_joystick.begin(&led_client, JOYSTICK_I2C_ADDR);
+        
+        // Use the stored calibration, hold the button at boot to calibrate again
+        joystick_cal_profile_t profile;
+        bool have_profile = joystick_cal_load(&profile);
+        if (!have_profile || joystick.get_button_value() == 0) {
+            if (joystick_cal_run(&joystick, &profile)) {
+                have_profile = joystick_cal_save(profile);
+                printf(have_profile ? "Calibration saved\n" : "Calibration save failed\n");
+            }
+        }
+        if (have_profile) {
+            cal_map.set_profile(profile);
+            use_calibration = true;
+        }
+        // Set LED to green for one second to indicate successful initialization
+        led.begin(&led_joystick);
+        led.flash(JOYSTICK_LED_GREEN, 1000);
     } else {
         printf("Joystick initialization failed!\n");
     }
-}
-
-// Print operation information and update last print time
-void print_operation(int direction) {
-    static absolute_time_t last_print_time = get_absolute_time();
-    bool is_time_to_print = absolute_time_diff_us(last_print_time, get_absolute_time()) > JOYSTICK_PRINT_INTERVAL_MS * 1000;
     
-    // Print when direction changes or time interval is reached
-    if (direction != last_direction || (is_time_to_print && direction > 0)) {
-        last_direction = direction;
-        last_print_time = get_absolute_time();
-        
-        switch (direction) {
-            case 1: printf("up\n"); break;
-            case 2: printf("down\n"); break;
-            case 3: printf("left\n"); break;
-            case 4: printf("right\n"); break;
-            case 5: printf("mid\n"); break;
-            default: break;
-        }
-    }
+    // Threshold with hysteresis, held directions repeat at the print interval
+    joystick_input_config_t config;
+    config.press_threshold = JOYSTICK_THRESHOLD;
+    config.repeat_delay_ms = JOYSTICK_PRINT_INTERVAL_MS;
+    config.repeat_interval_ms = JOYSTICK_PRINT_INTERVAL_MS;
+    input.set_config(config);
+    
+    // Poll on a fixed grid of deadlines, the loop work does not stretch the period
+    poller.begin(JOYSTICK_LOOP_DELAY_MS * 1000);
 }
 
-// Determine joystick direction using stricter conditions
-int determine_joystick_direction(int16_t x, int16_t y) {
-    int16_t abs_x = abs(x);
-    int16_t abs_y = abs(y);
-    
-    // Use higher threshold to detect valid movement
-    if (abs_x < JOYSTICK_THRESHOLD && abs_y < JOYSTICK_THRESHOLD) {
-        return 0;
-    }
-    
-    // Introduce deadzone concept to reduce jitter
-    if (abs_x < JOYSTICK_THRESHOLD * 0.8 && abs_y < JOYSTICK_THRESHOLD * 0.8) {
-        return 0;
-    }
-    
-    if (abs_y > abs_x * (JOYSTICK_DIRECTION_RATIO + 0.2)) {
-        return (y < 0) ? DIRECTION_UP : DIRECTION_DOWN;
-    }
-    
-    if (abs_x > abs_y * (JOYSTICK_DIRECTION_RATIO + 0.2)) {
-        return (x < 0) ? DIRECTION_LEFT : DIRECTION_RIGHT;
+// Print operation information
+void print_operation(uint8_t key) {
+    switch (key) {
+        case JOYSTICK_KEY_UP: printf("up\n"); break;
+        case JOYSTICK_KEY_DOWN: printf("down\n"); break;
+        case JOYSTICK_KEY_LEFT: printf("left\n"); break;
+        case JOYSTICK_KEY_RIGHT: printf("right\n"); break;
+        case JOYSTICK_KEY_MID: printf("mid\n"); break;
+        default: break;
     }
-    
-    return 0;  // Return 0 when direction is unclear
 }
 
 void loop() {
-    // Use separate variables to track if operation occurred
-    bool operation_detected = false;
-    int current_direction = 0; // 0=none, 1=up, 2=down, 3=left, 4=right, 5=mid
-    static int previous_raw_direction = 0; // Previous direction for debouncing
-    static uint8_t stable_count = 0; // Stability counter
-    static uint8_t release_count = 0; // Release counter to confirm joystick returned to center
-    static bool button_debounced = false;  // 按钮防抖状态
-    static absolute_time_t last_button_press = 0;  // 上次按钮按下时间
-    
-    // Declare joystick-related variables
-    uint16_t adc_x = 0, adc_y = 0;
-    
-    // Priority read button status (0=pressed, 1=not pressed)
-    uint8_t button_state = joystick.get_button_value();
-    
-    // Read joystick data (regardless of button press to ensure state updates are available)
-    joystick.get_joy_adc_16bits_value_xy(&adc_x, &adc_y);
-    
-    // Get raw direction signal
-    int raw_direction = 0;
-    
-    // Priority handle button status - immediate response
-    if (button_state == 0) { // Button pressed
-        raw_direction = 5; // mid button
-    } 
-    // Only detect joystick direction when button is not pressed
-    else {
-        raw_direction = determine_joystick_direction(adc_x, adc_y);
-    }
-    
-    // Enhanced debouncing processing
-    if (raw_direction == previous_raw_direction) {
-        // Direction is stable, increase stability count
-        if (stable_count < 3) { // Need at least 3 consecutive same readings to consider stable
-            stable_count++;
-        }
-        
-        // If in center position (0), increase release count
-        if (raw_direction == 0) {
-            if (release_count < 5) { // Need 5 stable center readings to confirm true release
-                release_count++;
-            }
-        } else {
-            release_count = 0; // Non-center position, reset release count
-        }
+    // Time-based debouncing and direction hysteresis are handled by JoystickInput
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (use_calibration) {
+        // Raw 8bits values mapped by the local calibration table
+        uint8_t raw_x, raw_y;
+        int16_t x, y;
+        joystick.get_joy_adc_8bits_value_xy(&raw_x, &raw_y);
+        cal_map.map(raw_x, raw_y, &x, &y);
+        input.update(x, y, joystick.get_button_value() == 0, now_ms);
     } else {
-        // Direction changed, partially reset stability count
-        if (stable_count > 0) {
-            stable_count--;
-        }
-        previous_raw_direction = raw_direction;
-        
-        // If new direction is center, start release counting
-        if (raw_direction == 0) {
-            release_count = 1;
-        } else {
-            release_count = 0;
+        // Read offset values and button state in one snapshot
+        joystick_state_t state;
+        joystick.read_state(&state, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+        // Re-estimate the center while the stick rests, report when the correction changes
+        int16_t center_x = drift.get_stats().center_x;
+        int16_t center_y = drift.get_stats().center_y;
+        drift.process(state);
+        if (drift.get_stats().center_x != center_x || drift.get_stats().center_y != center_y) {
+            printf("drift correction: %d, %d\n", drift.get_stats().center_x, drift.get_stats().center_y);
         }
+        input.update(state, now_ms);
     }
     
-    // Only process when direction is stable
-    if (stable_count >= 3) {
-        // Button debouncing - avoid jitter triggering
-        if (raw_direction != 0) { // Valid direction
-            current_direction = raw_direction;
-            operation_detected = true;
+    // Print on press and on repeat while a direction is held
+    joystick_event_t event;
+    while (input.poll_event(&event)) {
+        if (event.type == JOYSTICK_EVENT_PRESS || event.type == JOYSTICK_EVENT_REPEAT) {
+            print_operation(event.key);
+        } else if (event.type == JOYSTICK_EVENT_LONG_PRESS && event.key == JOYSTICK_KEY_MID) {
+            printf("mid (long)\n");
         }
     }
     
-    // Use stricter release detection when joystick returns to center
-    bool joystick_released = (release_count >= 5);
-    
-    // If there is operation, print current direction
-    if (current_direction > 0) {
-        print_operation(current_direction);
-    } else if (joystick_released) {
-        // Only reset direction state when joystick is confirmed to be stable at center
-        last_direction = 0;
+    // Blue LED while there is an operation, written only when it changes
+    bool operation_detected = (input.get_direction() != JOYSTICK_KEY_NONE) || input.is_button_pressed();
+    led.set_color(operation_detected ? JOYSTICK_LED_BLUE : JOYSTICK_LED_OFF);
+    led.tick(now_ms);
+    // Send the queued LED writes while the bus is idle
+    bus.flush();
+    
+#if JOYSTICK_LATENCY_PROFILE
+    // Bus latency of the input path, per register group
+    if (now_ms - last_latency_print_ms >= JOYSTICK_LATENCY_PRINT_INTERVAL_MS) {
+        last_latency_print_ms = now_ms;
+        joystick.print_latency();
+        joystick.reset_latency();
+        printf("BUS input=%lu/1000 led=%lu/1000\n",
+               (unsigned long)bus.get_utilization(input_client.get_id()),
+               (unsigned long)bus.get_utilization(led_client.get_id()));
+        bus.reset_stats();
+        joystick_poll_stats_t poll;
+        poller.get_stats(&poll);
+        printf("POLL period_us=%lu mean_us=%lu stddev_us=%lu max_late_us=%lu missed=%lu\n",
+               (unsigned long)poll.period_us, (unsigned long)poll.mean_period_us,
+               (unsigned long)poll.stddev_us, (unsigned long)poll.max_late_us,
+               (unsigned long)poll.missed);
+        poller.reset_stats();
     }
+#endif
     
-    // Immediate response to operation state changes
-    // When operation occurs, immediately light up blue LED
-    if (operation_detected && !is_active) {
-        is_active = true;
-        joystick.set_rgb_color(JOYSTICK_LED_BLUE);
-    }
-    // When all operations end, immediately turn off blue LED
-    else if (!operation_detected && is_active && joystick_released) {
-        is_active = false;
-        joystick.set_rgb_color(JOYSTICK_LED_OFF);
-    }
-    
-    // Update previous states
-    last_button_state = button_state;
-    last_offset_x = adc_x;
-    last_offset_y = adc_y;
-    
-    // Reduced loop delay to 20ms to improve response speed
-    sleep_ms(JOYSTICK_LOOP_DELAY_MS);
+    // Wait for the next 20ms deadline
+    poller.wait();
 }
 
 int main() {
@@ -196,4 +163,4 @@ int main() {
         loop();
     }
     return 0;
-} 
\ No newline at end of file
+} 
@@ -2,31 +2,82 @@
 #ifndef _MY_JOYSTICK_H_
 #define _MY_JOYSTICK_H_
 
-#include <hardware/i2c.h>
-#include <pico/stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
-
-#define JOYSTICK_ADDR                        0x63
-#define JOYSTICK_ADC_VALUE_12BITS_REG        0x00
-#define JOYSTICK_ADC_VALUE_8BITS_REG         0x10
-#define JOYSTICK_BUTTON_REG                  0x20
-#define JOYSTICK_RGB_REG                     0x30
-#define JOYSTICK_ADC_VALUE_CAL_REG           0x40
-#define JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG 0x50
-#define JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG  0x60
-#define JOYSTICK_FIRMWARE_VERSION_REG        0xFE
-#define JOYSTICK_BOOTLOADER_VERSION_REG      0xFC
-#define JOYSTICK_I2C_ADDRESS_REG             0xFF
+#include "joystick_platform.hpp"
+#include "joystick_transport.hpp"
+#include "joystick_regmap.hpp"
+#include "joystick_latency.hpp"
+#ifndef JOYSTICK_HOST
+#include "joystick_i2c.hpp"
+#endif
 
 typedef enum { ADC_8BIT_RESULT = 0, ADC_16BIT_RESULT } adc_mode_t;
 
+/**
+ * @brief Status of the last Joystick transaction
+ */
+typedef enum {
+    JOYSTICK_OK = 0,
+    JOYSTICK_ERROR_NACK,    // Not acknowledged or bus error
+    JOYSTICK_ERROR_TIMEOUT, // Transaction did not complete in time
+    JOYSTICK_ERROR_SHORT    // Fewer bytes transferred than requested
+} joystick_status_t;
+
+/**
+ * @brief Transaction counters of one operation type
+ */
+typedef struct {
+    uint32_t ok;
+    uint32_t nack;
+    uint32_t timeout;
+    uint32_t short_xfer;
+} joystick_stats_t;
+
+/**
+ * @brief Getter value together with the status of its transaction
+ */
+template <typename T>
+struct joystick_result_t {
+    joystick_status_t status;
+    T value;
+
+    bool ok(void) const { return status == JOYSTICK_OK; }
+    T value_or(T fallback) const { return ok() ? value : fallback; }
+};
+
+/**
+ * @brief Field selection mask for Joystick::read_state
+ */
+typedef enum {
+    JOYSTICK_STATE_RAW    = 0x01, // 16bits ADC value of x-axis and y-axis
+    JOYSTICK_STATE_OFFSET = 0x02, // 12bits mapped (offset) value of x-axis and y-axis
+    JOYSTICK_STATE_BUTTON = 0x04, // Button value
+    JOYSTICK_STATE_ALL    = 0x07
+} joystick_state_field_t;
+
+/**
+ * @brief Snapshot of the joystick state taken by Joystick::read_state
+ */
+typedef struct {
+    uint16_t adc_x;        // x-axis 16bits ADC value
+    uint16_t adc_y;        // y-axis 16bits ADC value
+    int16_t offset_x;      // x-axis 12bits mapped value
+    int16_t offset_y;      // y-axis 12bits mapped value
+    uint8_t button;        // 0 press, 1 no press
+    uint8_t fields;        // joystick_state_field_t mask of the valid fields
+    uint64_t timestamp_us; // Time since boot when the snapshot was taken
+} joystick_state_t;
+
 /**
  * @brief Joystick control API
  */
 class Joystick {
 public:
+    Joystick();
+
+#ifndef JOYSTICK_HOST
     /**
      * @brief Joystick initialization
      * @param i2c_port I2C port
@@ -38,6 +89,21 @@ public:
      */
     bool begin(i2c_inst_t *i2c_port, uint8_t addr = JOYSTICK_ADDR, uint sda_pin = 21, uint scl_pin = 22,
                uint32_t speed = 400000UL);
+#endif
+
+    /**
+     * @brief Joystick initialization on an already initialized transport
+     * @param transport register transport (blocking I2C, async I2C, mock, ...)
+     * @param addr I2C address
+     * @return 1 success, 0 false
+     */
+    bool begin(JoystickTransport *transport, uint8_t addr = JOYSTICK_ADDR);
+
+    /**
+     * @brief Get the transport used by this Joystick
+     * @return transport
+     */
+    JoystickTransport *get_transport(void) { return _transport; }
 
     /**
      * @brief Set Joystick I2C address
@@ -162,12 +228,115 @@ public:
      */
     void get_joy_adc_8bits_value_xy(uint8_t *adc_x, uint8_t *adc_y);
 
+    /**
+     * @brief Read several Joystick values with the minimum number of burst reads
+     * @param state pointer of the snapshot to fill
+     * @param fields joystick_state_field_t mask of the values to read
+     * @return 1 all requested fields read, 0 false
+     * @note Every selected field costs one I2C transaction: the x-axis and
+     *       y-axis values of a register block are read together
+     */
+    bool read_state(joystick_state_t *state, uint8_t fields = JOYSTICK_STATE_ALL);
+
+    /**
+     * @brief Read register fields with the burst plan computed at compile time
+     * @param values one variable per field, e.g.
+     *        read<JoystickRegOffset12X, JoystickRegOffset12Y>(x, y)
+     * @return 1 success, 0 false (values are left unchanged)
+     * @note Fields closer than JOYSTICK_BURST_MAX_GAP registers share one transaction
+     */
+    template <typename... Fields>
+    bool read(typename Fields::value_type &... values)
+    {
+        typedef JoystickReadPlan<Fields...> plan_t;
+        uint8_t buf[plan_t::plan.size];
+        if (!read_bursts(plan_t::plan.bursts, plan_t::plan.burst_count, buf)) {
+            return false;
+        }
+        const uint8_t *offset = plan_t::plan.field_offset;
+        ((values = Fields::decode(&buf[*offset++])), ...);
+        return true;
+    }
+
+    /**
+     * @brief Write a register field
+     * @param value field value, e.g. write<JoystickRegRgb>(0x00FF00)
+     * @return 1 success, 0 false
+     */
+    template <typename Field>
+    bool write(typename Field::value_type value)
+    {
+        static_assert(Field::access & JOYSTICK_ACCESS_W, "read-only field");
+        uint8_t buf[Field::width];
+        Field::encode(value, buf);
+        return write_regs(Field::reg, buf, Field::width) == Field::width;
+    }
+
+    /**
+     * @brief Get the status of the last call
+     * @return joystick_status_t status, the first error of a call with
+     *         several bursts (read_state(), read<>())
+     */
+    joystick_status_t get_last_status(void) { return _status; }
+
+    /**
+     * @brief Pair a getter value with the status of its transaction
+     * @param value value returned by a getter, e.g. checked(get_button_value())
+     * @return value and status, so a failed read is not mistaken for a real 0
+     */
+    template <typename T>
+    joystick_result_t<T> checked(T value) { return joystick_result_t<T>{_status, value}; }
+
+    /**
+     * @brief Get the register read counters
+     */
+    const joystick_stats_t &get_read_stats(void) { return _read_stats; }
+
+    /**
+     * @brief Get the register write counters
+     */
+    const joystick_stats_t &get_write_stats(void) { return _write_stats; }
+
+    /**
+     * @brief Clear the read and write counters
+     */
+    void reset_stats(void);
+
+#if JOYSTICK_LATENCY_PROFILE
+    /**
+     * @brief Get the transaction latency histograms (JOYSTICK_LATENCY_PROFILE builds only)
+     * @return histograms per register group
+     */
+    const JoystickLatency &get_latency(void) { return _latency; }
+
+    /**
+     * @brief Clear the latency histograms
+     */
+    void reset_latency(void) { _latency.reset(); }
+
+    /**
+     * @brief Print the latency histograms
+     */
+    void print_latency(void) { _latency.print(); }
+#endif
+
 private:
-    i2c_inst_t *_i2c_port;
+    int read_regs(uint8_t reg, uint8_t *buf, uint8_t nbytes);
+    int write_regs(uint8_t reg, const uint8_t *buf, uint8_t nbytes);
+    bool read_bursts(const joystick_burst_t *bursts, uint8_t count, uint8_t *buf);
+    joystick_status_t account(joystick_stats_t &stats, int ret, uint8_t nbytes);
+
+#ifndef JOYSTICK_HOST
+    JoystickI2C _i2c;              // Default blocking transport used by begin(i2c_port, ...)
+#endif
+    JoystickTransport *_transport;
     uint8_t _addr;
-    uint _scl_pin;
-    uint _sda_pin;
-    uint32_t _speed;
+    joystick_status_t _status;
+    joystick_stats_t _read_stats;
+    joystick_stats_t _write_stats;
+#if JOYSTICK_LATENCY_PROFILE
+    JoystickLatency _latency;
+#endif
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef _MY_JOYSTICK_ASYNC_I2C_H_
+#define _MY_JOYSTICK_ASYNC_I2C_H_
+
+#include <hardware/i2c.h>
+#include <pico/stdlib.h>
+#include <hardware/sync.h>
+#include "joystick_async_queue.hpp"
+#include "joystick_i2c.hpp"
+
+/**
+ * @brief Interrupt-driven RP2040 I2C transport
+ *
+ * The bus side of JoystickAsyncQueue: the I2C interrupt feeds the FIFO and
+ * reports the end of each transfer, so queued transfers run back to back
+ * while the CPU is free. See JoystickAsyncQueue for submission, polling and
+ * timeouts.
+ */
+class JoystickAsyncI2C : public JoystickAsyncQueue {
+public:
+    JoystickAsyncI2C();
+    ~JoystickAsyncI2C();
+
+    /**
+     * @brief Initialize the I2C port, pins and interrupt
+     * @param i2c_port I2C port
+     * @param sda_pin SDA Pin
+     * @param scl_pin SCL Pin
+     * @param speed I2C clock
+     * @return 1 success, 0 false (port already used by another instance)
+     */
+    bool init(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed);
+
+    /**
+     * @brief Release the interrupt, pending transfers are dropped
+     */
+    void deinit(void);
+
+    /**
+     * @brief Change the bus clock once the queued transfers have completed
+     * @param speed requested I2C clock
+     * @return clock actually set
+     */
+    uint32_t set_speed(uint32_t speed) override;
+    uint32_t get_speed(void) override { return _speed; }
+
+protected:
+    bool bus_ready(void) override { return _i2c_port != nullptr; }
+    void bus_start(transfer_t &t) override;
+    void bus_stop(void) override;
+    void bus_recover(void) override;
+    uint32_t lock(void) override { return save_and_disable_interrupts(); }
+    void unlock(uint32_t state) override { restore_interrupts(state); }
+    void wait(void) override { tight_loop_contents(); }
+
+private:
+    void fill_tx_fifo(void);
+    void handle_irq(void);
+    static void irq_handler_i2c0(void);
+    static void irq_handler_i2c1(void);
+
+    i2c_inst_t *_i2c_port;
+    uint _sda_pin;
+    uint _scl_pin;
+    uint32_t _speed;
+
+    // Progress of the transfer on the bus, interrupt context only
+    uint8_t _tx_index;           // Commands pushed into the TX FIFO (register byte included)
+    uint8_t _rx_index;           // Bytes drained from the RX FIFO
+    bool _aborted;               // TX_ABRT seen (NACK, arbitration lost)
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef _MY_JOYSTICK_ASYNC_QUEUE_H_
+#define _MY_JOYSTICK_ASYNC_QUEUE_H_
+
+#include <stdint.h>
+#include "joystick_platform.hpp"
+#include "joystick_transport.hpp"
+
+#ifndef JOYSTICK_ASYNC_QUEUE_SIZE
+#define JOYSTICK_ASYNC_QUEUE_SIZE 8        // Transfers that can be queued at once
+#endif
+
+#ifndef JOYSTICK_ASYNC_MAX_DATA
+#define JOYSTICK_ASYNC_MAX_DATA 16         // Largest transfer (calibration block), fits the 16-deep FIFO
+#endif
+
+#ifndef JOYSTICK_ASYNC_TIMEOUT_US
+#define JOYSTICK_ASYNC_TIMEOUT_US 10000    // A transfer still running after this is aborted
+#endif
+
+#ifndef JOYSTICK_ASYNC_RECOVERY_THRESHOLD
+#define JOYSTICK_ASYNC_RECOVERY_THRESHOLD 3 // Consecutive failures before the bus is recovered
+#endif
+
+/**
+ * @brief Completion callback of an asynchronous transfer
+ * @param ctx user context given at submission
+ * @param result number of data bytes transferred, negative PICO_ERROR_xxx on error
+ * @param data received bytes for a read, written bytes for a write
+ * @param nbytes requested number of bytes
+ */
+typedef void (*joystick_transfer_cb_t)(void *ctx, int result, const uint8_t *data, uint8_t nbytes);
+
+/**
+ * @brief Queue of asynchronous register transfers, independent of the bus hardware
+ *
+ * Transfers are queued with begin_read()/begin_write() and started back to
+ * back: the bus side calls finish_active() when a transfer ends (from its
+ * interrupt on the device) and the queue starts the next one at once.
+ * Callbacks are never called from there: poll() dispatches them from the
+ * caller's context and also aborts a transfer that exceeds
+ * JOYSTICK_ASYNC_TIMEOUT_US. After JOYSTICK_ASYNC_RECOVERY_THRESHOLD failed
+ * transfers in a row (timeouts or NACKs) the queue holds the next transfer
+ * until poll() has run bus_recover().
+ *
+ * The blocking read_reg()/write_reg() submit a transfer and poll until it
+ * completes, so a Joystick works unchanged on top of the queue.
+ *
+ * JoystickAsyncI2C is the RP2040 bus side, host tests drive the queue with a
+ * scripted bus on the simulated clock.
+ */
+class JoystickAsyncQueue : public JoystickTransport {
+public:
+    JoystickAsyncQueue();
+    virtual ~JoystickAsyncQueue() {}
+
+    /**
+     * @brief Queue a register read
+     * @param addr I2C address
+     * @param reg first register
+     * @param nbytes number of bytes, at most JOYSTICK_ASYNC_MAX_DATA
+     * @param cb completion callback, may be nullptr
+     * @param ctx user context passed to cb
+     * @return 1 queued, 0 queue full, invalid length or bus not ready
+     */
+    bool begin_read(uint8_t addr, uint8_t reg, uint8_t nbytes, joystick_transfer_cb_t cb, void *ctx);
+
+    /**
+     * @brief Queue a register write, the data is copied
+     * @param addr I2C address
+     * @param reg first register
+     * @param buf pointer of the data
+     * @param nbytes number of bytes, at most JOYSTICK_ASYNC_MAX_DATA
+     * @param cb completion callback, may be nullptr
+     * @param ctx user context passed to cb
+     * @return 1 queued, 0 queue full, invalid length or bus not ready
+     */
+    bool begin_write(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes,
+                     joystick_transfer_cb_t cb, void *ctx);
+
+    /**
+     * @brief Dispatch the callbacks of completed transfers and handle timeouts
+     * @return number of callbacks dispatched
+     */
+    uint32_t poll(void);
+
+    /**
+     * @brief Whether every queued transfer has completed and been dispatched
+     */
+    bool is_idle(void) { return _complete == _submit; }
+
+    /**
+     * @brief Number of transfers queued or not yet dispatched
+     */
+    uint32_t pending(void) { return _submit - _complete; }
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override;
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override;
+
+    /**
+     * @brief Number of bus recoveries
+     */
+    uint32_t get_recovery_count(void) { return _recoveries; }
+
+protected:
+    struct transfer_t {
+        uint8_t addr;
+        uint8_t reg;
+        uint8_t nbytes;
+        bool is_read;
+        uint8_t data[JOYSTICK_ASYNC_MAX_DATA];
+        joystick_transfer_cb_t cb;
+        void *ctx;
+        int result;
+        uint64_t start_us;
+    };
+
+    /**
+     * @brief Whether the bus is initialized, nothing is queued before
+     */
+    virtual bool bus_ready(void) = 0;
+
+    /**
+     * @brief Put a transfer on the bus, finish_active() is called when it ends
+     * @note Called with lock() held or from finish_active()
+     */
+    virtual void bus_start(transfer_t &t) = 0;
+
+    /**
+     * @brief Stop the bus: the queue ran empty or the transfer timed out
+     */
+    virtual void bus_stop(void) = 0;
+
+    /**
+     * @brief Free a stuck bus after repeated timeouts
+     */
+    virtual void bus_recover(void) {}
+
+    /**
+     * @brief Keep finish_active() out of the queue state while it is updated
+     * @return state for unlock()
+     */
+    virtual uint32_t lock(void) { return 0; }
+    virtual void unlock(uint32_t state) { (void)state; }
+
+    /**
+     * @brief Called while the blocking accessors spin
+     */
+    virtual void wait(void) {}
+
+    /**
+     * @brief Bus side completion of the transfer on the bus
+     * @param result number of data bytes transferred, negative PICO_ERROR_xxx on error
+     */
+    void finish_active(int result);
+
+    /**
+     * @brief Transfer on the bus, valid while is_busy()
+     */
+    transfer_t &active_transfer(void) { return _queue[_active % JOYSTICK_ASYNC_QUEUE_SIZE]; }
+    bool is_busy(void) { return _busy; }
+
+    /**
+     * @brief Drop every queued transfer without calling its callback
+     */
+    void clear(void);
+
+private:
+    bool submit(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes, bool is_read,
+                joystick_transfer_cb_t cb, void *ctx);
+    int run_blocking(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes, bool is_read);
+    void start_next(void);
+
+    uint8_t _failures;           // Consecutive failed transfers
+    volatile bool _recover;      // Threshold reached, poll() recovers before the next start
+    uint32_t _recoveries;
+    transfer_t _queue[JOYSTICK_ASYNC_QUEUE_SIZE];
+
+    // Free-running ring counters: complete <= active <= submit
+    volatile uint32_t _submit;   // Next free slot, advanced by the caller
+    volatile uint32_t _active;   // Transfer on the bus, advanced by finish_active()
+    volatile uint32_t _complete; // Next callback to dispatch, advanced by poll()
+    volatile bool _busy;         // A transfer is on the bus
+};
+
+#endif
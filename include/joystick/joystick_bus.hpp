@@ -0,0 +1,143 @@
+#ifndef _MY_JOYSTICK_BUS_H_
+#define _MY_JOYSTICK_BUS_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+#include "joystick_sample_ring.hpp"
+
+#ifndef JOYSTICK_BUS_MAX_DEVICES
+#define JOYSTICK_BUS_MAX_DEVICES 4           // Units on one bus
+#endif
+
+#ifndef JOYSTICK_BUS_RING_SIZE
+#define JOYSTICK_BUS_RING_SIZE 16            // Samples buffered per unit
+#endif
+
+#ifndef JOYSTICK_BUS_FAIL_THRESHOLD
+#define JOYSTICK_BUS_FAIL_THRESHOLD 3        // Consecutive failures before a unit is backed off
+#endif
+
+#ifndef JOYSTICK_BUS_BACKOFF_MIN_US
+#define JOYSTICK_BUS_BACKOFF_MIN_US 50000    // First retry delay of an offline unit
+#endif
+
+#ifndef JOYSTICK_BUS_BACKOFF_MAX_US
+#define JOYSTICK_BUS_BACKOFF_MAX_US 2000000  // Retry delay limit, doubled on every failed retry
+#endif
+
+/**
+ * @brief Health counters of one unit on a JoystickBus
+ */
+typedef struct {
+    uint32_t reads;             // Successful polls
+    uint32_t errors;            // Failed polls
+    uint32_t skipped;           // Polls skipped while the unit was backed off
+    uint8_t consecutive_errors;
+    bool online;                // 0 while the unit is backed off
+} joystick_bus_health_t;
+
+/**
+ * @brief Several Joystick units at different addresses on one I2C bus
+ *
+ * The bus owns the transport. poll() reads every unit once per tick in a
+ * single batch, starting from a different unit each tick so no unit is
+ * always the last one sampled. Every unit has its own sample ring.
+ *
+ * A unit that fails JOYSTICK_BUS_FAIL_THRESHOLD polls in a row goes offline
+ * and is only retried after a backoff delay, so an unplugged controller
+ * does not cost a bus timeout every frame.
+ */
+class JoystickBus {
+public:
+    JoystickBus();
+
+#ifndef JOYSTICK_HOST
+    /**
+     * @brief Initialize the I2C port and pins, the bus owns the port
+     * @param i2c_port I2C port
+     * @param sda_pin SDA Pin
+     * @param scl_pin SCL Pin
+     * @param speed I2C clock
+     */
+    void begin(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed = 400000UL);
+#endif
+
+    /**
+     * @brief Use an already initialized transport (async I2C, mock bus, ...)
+     * @param transport register transport shared by every unit
+     */
+    void begin(JoystickTransport *transport);
+
+    /**
+     * @brief Add a unit
+     * @param addr I2C address of the unit
+     * @return index of the unit, -1 bus full or address already used
+     * @note A unit that does not answer yet is added offline and retried by poll()
+     */
+    int add_device(uint8_t addr);
+
+    /**
+     * @brief Poll every unit once and push the samples into their rings
+     * @param now_us current time in microseconds, drives the backoff
+     * @param fields joystick_state_field_t mask passed to Joystick::read_state
+     * @return number of units read successfully
+     */
+    uint8_t poll(uint64_t now_us, uint8_t fields = JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+
+    /**
+     * @brief Get the newest sample of a unit without consuming its ring
+     * @param index unit index
+     * @param sample pointer of the sample to fill
+     * @return 1 success, 0 no sample yet
+     */
+    bool get_latest(uint8_t index, joystick_state_t *sample);
+
+    /**
+     * @brief Remove every queued sample of a unit, oldest first
+     * @param index unit index
+     * @param samples pointer of the sample array to fill
+     * @param max_samples size of the sample array
+     * @return number of samples removed
+     */
+    uint32_t drain(uint8_t index, joystick_state_t *samples, uint32_t max_samples);
+
+    /**
+     * @brief Get the Joystick of a unit, for LED and configuration access
+     * @param index unit index
+     * @return Joystick, nullptr if the index is out of range
+     */
+    Joystick *get_joystick(uint8_t index);
+
+    /**
+     * @brief Get the health counters of a unit
+     * @param index unit index
+     * @return health counters, nullptr if the index is out of range
+     */
+    const joystick_bus_health_t *get_health(uint8_t index);
+
+    bool is_online(uint8_t index) { return index < _count && _devices[index].health.online; }
+    uint8_t get_device_count(void) { return _count; }
+    JoystickTransport *get_transport(void) { return _transport; }
+
+private:
+    struct device_t {
+        Joystick joystick;
+        uint8_t addr;
+        joystick_bus_health_t health;
+        uint64_t retry_us;      // Next poll time while offline
+        uint32_t backoff_us;
+        JoystickSampleRing<joystick_state_t, JOYSTICK_BUS_RING_SIZE> ring;
+    };
+
+    bool poll_device(device_t &dev, uint64_t now_us, uint8_t fields);
+
+#ifndef JOYSTICK_HOST
+    JoystickI2C _i2c;            // Transport used by begin(i2c_port, ...)
+#endif
+    JoystickTransport *_transport;
+    device_t _devices[JOYSTICK_BUS_MAX_DEVICES];
+    uint8_t _count;
+    uint8_t _next;               // First unit of the next batch
+};
+
+#endif
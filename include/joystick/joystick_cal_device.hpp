@@ -0,0 +1,48 @@
+#ifndef _MY_JOYSTICK_CAL_DEVICE_H_
+#define _MY_JOYSTICK_CAL_DEVICE_H_
+
+#include <hardware/flash.h>
+#include <pico/stdlib.h>
+#include "joystick.hpp"
+#include "joystick_calibration.hpp"
+
+#ifndef JOYSTICK_CAL_FLASH_OFFSET
+#define JOYSTICK_CAL_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE) // Last flash sector
+#endif
+
+#ifndef JOYSTICK_CAL_FLASH_TIMEOUT_MS
+#define JOYSTICK_CAL_FLASH_TIMEOUT_MS 100  // Wait for the other core to park before flash is written
+#endif
+
+#ifndef JOYSTICK_CAL_PHASE_MS
+#define JOYSTICK_CAL_PHASE_MS 1500         // Sampling time of one calibration step
+#endif
+
+/**
+ * @brief Load the calibration profile from flash
+ * @param profile pointer of the profile to fill
+ * @return 1 success, 0 no valid profile stored
+ */
+bool joystick_cal_load(joystick_cal_profile_t *profile);
+
+/**
+ * @brief Store the calibration profile in flash
+ * @param profile calibration profile
+ * @return 1 success (read back and verified), 0 false
+ * @note The sector is written through flash_safe_execute(), so a running
+ *       JOYSTICK_SAMPLER_CORE1 sampler is parked meanwhile. Other code on
+ *       core1 must call flash_safe_execute_core_init() first, else nothing
+ *       is written and 0 is returned
+ */
+bool joystick_cal_save(const joystick_cal_profile_t &profile);
+
+/**
+ * @brief Run the guided calibration sweep on a unit, prompts are printed with printf
+ * @param joystick initialized Joystick
+ * @param profile pointer of the profile to fill
+ * @param phase_ms sampling time of one step, the edge sweep takes three times longer
+ * @return 1 success, 0 false
+ */
+bool joystick_cal_run(Joystick *joystick, joystick_cal_profile_t *profile, uint32_t phase_ms = JOYSTICK_CAL_PHASE_MS);
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef _MY_JOYSTICK_CALIBRATION_H_
+#define _MY_JOYSTICK_CALIBRATION_H_
+
+#include <stdint.h>
+
+#ifndef JOYSTICK_CAL_OUTPUT_MAX
+#define JOYSTICK_CAL_OUTPUT_MAX 4095       // Full deflection, same scale as the 12bits offset registers
+#endif
+
+#ifndef JOYSTICK_CAL_DEAD_ZONE_MARGIN
+#define JOYSTICK_CAL_DEAD_ZONE_MARGIN 2    // Raw counts added to the center noise
+#endif
+
+#ifndef JOYSTICK_CAL_MIN_RANGE
+#define JOYSTICK_CAL_MIN_RANGE 32          // Smallest accepted raw travel on each side of the center
+#endif
+
+#define JOYSTICK_CAL_MAGIC   0x4C41434AUL  // "JCAL"
+#define JOYSTICK_CAL_VERSION 1
+#define JOYSTICK_CAL_RECORD_SIZE 20        // Encoded profile size in flash
+
+/**
+ * @brief Calibration of the raw 8bits ADC values of one unit
+ */
+typedef struct {
+    uint8_t center_x;
+    uint8_t center_y;
+    uint8_t min_x;
+    uint8_t max_x;
+    uint8_t min_y;
+    uint8_t max_y;
+    uint8_t dead_zone;   // Raw counts around the center mapped to 0
+    bool invert_x;       // Raw x decreases to the right
+    bool invert_y;       // Raw y increases upwards
+} joystick_cal_profile_t;
+
+typedef enum {
+    JOYSTICK_CAL_CENTER = 0, // Stick released: center and noise
+    JOYSTICK_CAL_UP,         // Stick held up: y orientation
+    JOYSTICK_CAL_RIGHT,      // Stick held right: x orientation
+    JOYSTICK_CAL_SWEEP,      // Stick rotated along the edge: extents
+    JOYSTICK_CAL_DONE
+} joystick_cal_phase_t;
+
+/**
+ * @brief Guided calibration sweep
+ *
+ * Feed raw 8bits samples with add_sample() and move to the next step with
+ * next_phase() once the user has done what the phase asks for. finish()
+ * turns the collected values into a profile.
+ */
+class JoystickCalibrator {
+public:
+    JoystickCalibrator();
+
+    /**
+     * @brief Restart at the center phase
+     */
+    void begin(void);
+
+    /**
+     * @brief Add one raw sample to the current phase
+     * @param x x-axis 8bits ADC value
+     * @param y y-axis 8bits ADC value
+     */
+    void add_sample(uint8_t x, uint8_t y);
+
+    /**
+     * @brief Move to the next phase
+     */
+    void next_phase(void);
+
+    joystick_cal_phase_t get_phase(void) { return _phase; }
+
+    /**
+     * @brief Compute the profile from the collected samples
+     * @param profile pointer of the profile to fill
+     * @return 1 success, 0 missing samples or travel below JOYSTICK_CAL_MIN_RANGE
+     */
+    bool finish(joystick_cal_profile_t *profile);
+
+private:
+    joystick_cal_phase_t _phase;
+    uint32_t _sum_x[JOYSTICK_CAL_DONE];  // Per phase sums, for the averages
+    uint32_t _sum_y[JOYSTICK_CAL_DONE];
+    uint32_t _count[JOYSTICK_CAL_DONE];
+    uint8_t _center_min_x, _center_max_x;
+    uint8_t _center_min_y, _center_max_y;
+    uint8_t _min_x, _max_x;
+    uint8_t _min_y, _max_y;
+};
+
+/**
+ * @brief Raw 8bits to calibrated value lookup tables
+ *
+ * Built once from a profile, then every sample costs two table reads.
+ */
+class JoystickCalMap {
+public:
+    JoystickCalMap();
+
+    /**
+     * @brief Build the lookup tables
+     * @param profile calibration profile
+     */
+    void set_profile(const joystick_cal_profile_t &profile);
+
+    /**
+     * @brief Map raw 8bits ADC values
+     * @param raw_x x-axis 8bits ADC value
+     * @param raw_y y-axis 8bits ADC value
+     * @param x pointer of the x-axis value, -JOYSTICK_CAL_OUTPUT_MAX..JOYSTICK_CAL_OUTPUT_MAX
+     * @param y pointer of the y-axis value, negative is up
+     */
+    void map(uint8_t raw_x, uint8_t raw_y, int16_t *x, int16_t *y) const
+    {
+        *x = _lut_x[raw_x];
+        *y = _lut_y[raw_y];
+    }
+
+private:
+    int16_t _lut_x[256];
+    int16_t _lut_y[256];
+};
+
+/**
+ * @brief Fill the lookup table of one axis
+ * @param lut 256 entries, indexed by the raw value
+ * @param center raw center
+ * @param min raw minimum
+ * @param max raw maximum
+ * @param dead_zone raw counts around the center mapped to 0
+ * @param invert 1 the output sign is reversed
+ */
+void joystick_cal_build_lut(int16_t *lut, uint8_t center, uint8_t min, uint8_t max, uint8_t dead_zone,
+                            bool invert);
+
+/**
+ * @brief CRC-32 (IEEE 802.3)
+ * @param data pointer of the data
+ * @param len number of bytes
+ * @return crc
+ */
+uint32_t joystick_cal_crc32(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Serialize a profile into its flash record (magic, version, fields, CRC)
+ * @param profile calibration profile
+ * @param record JOYSTICK_CAL_RECORD_SIZE bytes
+ */
+void joystick_cal_encode(const joystick_cal_profile_t &profile, uint8_t *record);
+
+/**
+ * @brief Check and deserialize a flash record
+ * @param record JOYSTICK_CAL_RECORD_SIZE bytes
+ * @param profile pointer of the profile to fill
+ * @return 1 valid record, 0 bad magic, version or CRC
+ */
+bool joystick_cal_decode(const uint8_t *record, joystick_cal_profile_t *profile);
+
+#endif
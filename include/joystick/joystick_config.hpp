@@ -5,7 +5,18 @@
 #define JOYSTICK_I2C_SDA_PIN 6        // I2C SDA pin
 #define JOYSTICK_I2C_SCL_PIN 7        // I2C SCL pin
 #define JOYSTICK_I2C_ADDR 0x63        // Joystick Unit I2C address
-#define JOYSTICK_I2C_SPEED 100000     // 100 kHz
+#define JOYSTICK_I2C_SPEED 100000     // 100 kHz, start speed before negotiation
+#define JOYSTICK_I2C_MAX_SPEED 1000000 // Fastest speed tried by JoystickSpeedControl
+#define JOYSTICK_INPUT_DEADLINE_US 1000 // JoystickScheduler deadline of stick reads
+#define JOYSTICK_LED_DEADLINE_US 20000  // JoystickScheduler deadline of posted LED writes
+
+// Input recording (JoystickRecorder / JoystickReplayTransport) in CollisionX and PicoPilot
+#define JOYSTICK_RECORD_OFF 0         // Live input
+#define JOYSTICK_RECORD_CAPTURE 1     // Record live input, saved to flash and dumped over USB when full
+#define JOYSTICK_RECORD_REPLAY 2      // Play the recording stored in flash
+#ifndef JOYSTICK_RECORD_MODE
+#define JOYSTICK_RECORD_MODE JOYSTICK_RECORD_OFF
+#endif
 
 // LED color definitions
 #define JOYSTICK_LED_OFF  0x000000    // Black (off)
@@ -17,4 +28,6 @@
 #define JOYSTICK_THRESHOLD 1800       // Increased joystick threshold to reduce false triggers
 #define JOYSTICK_LOOP_DELAY_MS 20     // Loop delay time (milliseconds)
 #define JOYSTICK_PRINT_INTERVAL_MS 250 // Repeat print interval (milliseconds)
+#define JOYSTICK_LATENCY_PRINT_INTERVAL_MS 5000 // Latency histogram print interval (JOYSTICK_LATENCY_PROFILE builds)
+#define JOYSTICK_HID_DEAD_ZONE 200    // JoystickPipeline dead zone of the USB gamepad (offset units)
 #define JOYSTICK_DIRECTION_RATIO 1.5  // Direction determination ratio 
\ No newline at end of file
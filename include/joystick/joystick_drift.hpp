@@ -0,0 +1,109 @@
+#ifndef _MY_JOYSTICK_DRIFT_H_
+#define _MY_JOYSTICK_DRIFT_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+
+/**
+ * @brief Center drift estimation parameters
+ */
+struct joystick_drift_config_t {
+    uint8_t window_shift;   // Statistics window of 2^window_shift samples
+    uint16_t idle_stddev;   // Largest standard deviation of a window taken as a released stick
+    uint16_t max_drift;     // Largest center error corrected, offset units
+    uint8_t rate_shift;     // Every idle window moves the estimate 1/2^rate_shift of the way
+    uint16_t max_step;      // Largest change of the estimate per idle window, offset units
+
+    joystick_drift_config_t() :
+        window_shift(5),    // 32 samples, about 0.6 s at 50 Hz
+        idle_stddev(24),
+        max_drift(300),
+        rate_shift(3),
+        max_step(4)
+    {}
+};
+
+/**
+ * @brief Drift estimate and activity counters
+ */
+typedef struct {
+    int16_t center_x;           // Estimated center error subtracted from x, offset units
+    int16_t center_y;
+    int16_t last_idle_x;        // Mean of the last idle window
+    int16_t last_idle_y;
+    uint32_t idle_windows;      // Windows used to update the estimate
+    uint32_t active_windows;    // Windows rejected: stick moving, held off center or button pressed
+    uint32_t corrected_samples; // Samples changed by a non-zero correction
+} joystick_drift_stats_t;
+
+/**
+ * @brief Runtime center drift tracking and software recentering
+ *
+ * Collects the mean and variance of the offset values over fixed windows.
+ * A window with a low variance, a mean within max_drift and no button press
+ * is a released stick; its mean pulls the center estimate slowly towards the
+ * real rest position, at most max_step per window, so a stick held still
+ * off center is absorbed far slower than a game reacts to it. The estimate
+ * is subtracted from every sample: a drifting unit reads 0 at rest again
+ * without any extra I2C transfer. Integer math only.
+ */
+class JoystickDrift {
+public:
+    JoystickDrift();
+
+    /**
+     * @brief Set the estimation parameters, the estimate is kept
+     * @param config parameters
+     */
+    void set_config(const joystick_drift_config_t &config);
+    const joystick_drift_config_t &get_config(void) { return _config; }
+
+    /**
+     * @brief Add one sample to the statistics
+     * @param offset_x x-axis 12bits mapped value, as read from the unit
+     * @param offset_y y-axis 12bits mapped value
+     * @param button_pressed 1 button pressed, the window is not idle
+     */
+    void update(int16_t offset_x, int16_t offset_y, bool button_pressed = false);
+
+    /**
+     * @brief Subtract the center estimate
+     * @param offset_x pointer of the x-axis value to correct
+     * @param offset_y pointer of the y-axis value to correct
+     */
+    void correct(int16_t *offset_x, int16_t *offset_y);
+
+    /**
+     * @brief Update the statistics with a Joystick::read_state snapshot and correct its offsets
+     * @param state snapshot, offset fields are corrected in place
+     */
+    void process(joystick_state_t &state);
+
+    /**
+     * @brief Get the estimate and counters
+     */
+    const joystick_drift_stats_t &get_stats(void) { return _stats; }
+
+    /**
+     * @brief Forget the estimate and the current window
+     */
+    void reset(void);
+
+private:
+    void reset_window(void);
+    int16_t center(int32_t center_q4);
+    int32_t step(int32_t delta_q4);
+
+    joystick_drift_config_t _config;
+    joystick_drift_stats_t _stats;
+    int32_t _center_q4_x;   // Estimate in 1/16 offset units
+    int32_t _center_q4_y;
+    int32_t _sum_x;
+    int32_t _sum_y;
+    uint64_t _sq_x;
+    uint64_t _sq_y;
+    uint32_t _count;
+    bool _button;
+};
+
+#endif
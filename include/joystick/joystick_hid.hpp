@@ -0,0 +1,101 @@
+#ifndef _MY_JOYSTICK_HID_H_
+#define _MY_JOYSTICK_HID_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+#include "joystick_pipeline.hpp"
+
+#define JOYSTICK_HID_REPORT_SIZE 5          // x (2), y (2), buttons (1)
+#define JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE 50
+
+#ifndef JOYSTICK_HID_MIN_DELTA
+#define JOYSTICK_HID_MIN_DELTA 64           // Axis change (Q15) that triggers a report, about 0.2%
+#endif
+
+/**
+ * @brief HID report descriptor of the gamepad: 16bits X/Y axes, one button
+ * @note Sized so sizeof() works in USB configuration descriptors
+ */
+extern const uint8_t joystick_hid_report_descriptor[JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE];
+
+/**
+ * @brief Gamepad input report packing and change detection
+ *
+ * Packs a Q15 vector (JoystickPipeline output) and the button into the
+ * little endian report described by joystick_hid_report_descriptor:
+ * X and Y from -32767 to 32767, positive right and down, then one button
+ * bit. update() tells whether the report differs from the last one sent,
+ * so a USB loop only queues reports when something changed. Axis changes
+ * below the threshold are ignored, except a move to the center or to an end
+ * which is always reported. No USB stack dependency.
+ */
+class JoystickHidReport {
+public:
+    JoystickHidReport();
+
+    /**
+     * @brief Set the smallest axis change that counts
+     * @param min_delta Q15 units, 0 any change
+     */
+    void set_threshold(uint16_t min_delta) { _min_delta = min_delta; }
+
+    /**
+     * @brief Pack a new sample
+     * @param move Q15 stick vector
+     * @param button_pressed 1 button pressed
+     * @return 1 the report differs from the last one sent, 0 nothing to send
+     */
+    bool update(const joystick_vector_t &move, bool button_pressed);
+
+    /**
+     * @brief Pack 12bits offset (or JoystickCalMap) values without shaping
+     * @param offset_x x-axis 12bits mapped value
+     * @param offset_y y-axis 12bits mapped value
+     * @param button_pressed 1 button pressed
+     * @return 1 the report differs from the last one sent, 0 nothing to send
+     */
+    bool update(int16_t offset_x, int16_t offset_y, bool button_pressed);
+
+    /**
+     * @brief Get the packed report
+     */
+    const uint8_t *get_report(void) { return _report; }
+    uint8_t get_size(void) { return JOYSTICK_HID_REPORT_SIZE; }
+
+    /**
+     * @brief The packed report was accepted by the USB stack
+     */
+    void mark_sent(void);
+
+    /**
+     * @brief Force the next update() to report, e.g. after a USB reset
+     */
+    void invalidate(void) { _valid = false; }
+
+    /**
+     * @brief Number of reports sent
+     */
+    uint32_t get_sent_count(void) { return _sent; }
+
+    /**
+     * @brief Number of updates that needed no report
+     */
+    uint32_t get_unchanged_count(void) { return _unchanged; }
+
+private:
+    bool changed(int16_t value, int16_t sent);
+
+    uint8_t _report[JOYSTICK_HID_REPORT_SIZE];
+    int16_t _x;
+    int16_t _y;
+    uint8_t _buttons;
+    int16_t _sent_x;
+    int16_t _sent_y;
+    uint8_t _sent_buttons;
+    bool _valid;            // A report was sent since the last invalidate()
+    uint16_t _min_delta;
+    uint32_t _sent;
+    uint32_t _unchanged;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef _MY_JOYSTICK_I2C_H_
+#define _MY_JOYSTICK_I2C_H_
+
+#include <hardware/i2c.h>
+#include <pico/stdlib.h>
+#include "joystick_transport.hpp"
+
+#ifndef JOYSTICK_I2C_TIMEOUT_US
+#define JOYSTICK_I2C_TIMEOUT_US 1000         // Slack added to the wire time of every transfer
+#endif
+
+#ifndef JOYSTICK_I2C_MAX_WRITE
+#define JOYSTICK_I2C_MAX_WRITE 16            // Largest register write (the calibration block)
+#endif
+
+#ifndef JOYSTICK_I2C_RECOVERY_THRESHOLD
+#define JOYSTICK_I2C_RECOVERY_THRESHOLD 3    // Consecutive failures before the bus is recovered
+#endif
+
+/**
+ * @brief Release a stuck bus and re-initialize the I2C block
+ *
+ * Clocks SCL until a device holding SDA low lets it go (at most 9 pulses),
+ * generates a STOP, then re-initializes the port and gives the pins back to
+ * the I2C function.
+ *
+ * @param i2c_port I2C port
+ * @param sda_pin SDA Pin
+ * @param scl_pin SCL Pin
+ * @param speed I2C clock
+ * @return clock actually set
+ */
+uint32_t joystick_i2c_recover_bus(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed);
+
+/**
+ * @brief Blocking RP2040 I2C transport
+ *
+ * Every transfer is bounded by a timeout derived from the bus speed, so a
+ * stuck bus never hangs the caller. After JOYSTICK_I2C_RECOVERY_THRESHOLD
+ * failed transfers in a row (timeout or NACK) the bus is recovered.
+ */
+class JoystickI2C : public JoystickTransport {
+public:
+    JoystickI2C();
+
+    /**
+     * @brief Initialize the I2C port and pins
+     * @param i2c_port I2C port
+     * @param sda_pin SDA Pin
+     * @param scl_pin SCL Pin
+     * @param speed I2C clock
+     */
+    void init(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed);
+
+    /**
+     * @brief Check whether a device acknowledges its address
+     * @param addr I2C address
+     * @return 1 device present, 0 false
+     */
+    bool probe(uint8_t addr);
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override;
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override;
+    uint32_t set_speed(uint32_t speed) override;
+    uint32_t get_speed(void) override { return _speed; }
+
+    i2c_inst_t *get_port(void) { return _i2c_port; }
+
+    /**
+     * @brief Recover the bus now
+     */
+    void recover(void);
+
+    /**
+     * @brief Number of bus recoveries
+     */
+    uint32_t get_recovery_count(void) { return _recoveries; }
+
+private:
+    uint timeout_us(uint8_t nbytes);
+    int check(int ret);
+
+    i2c_inst_t *_i2c_port;
+    uint _scl_pin;
+    uint _sda_pin;
+    uint32_t _speed;
+    uint8_t _failures;       // Consecutive failed transfers
+    uint32_t _recoveries;
+};
+
+#endif
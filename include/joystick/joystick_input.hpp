@@ -0,0 +1,166 @@
+#ifndef _MY_JOYSTICK_INPUT_H_
+#define _MY_JOYSTICK_INPUT_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+
+#ifndef JOYSTICK_INPUT_EVENT_QUEUE_SIZE
+#define JOYSTICK_INPUT_EVENT_QUEUE_SIZE 16
+#endif
+
+// tan(22.5 deg) in Q8, boundary between a cardinal and a diagonal sector
+#define JOYSTICK_INPUT_DIAGONAL_Q8 106
+// Sector widening applied to the current direction (hysteresis), in Q8
+#define JOYSTICK_INPUT_DIAGONAL_HYSTERESIS_Q8 24
+
+/**
+ * @brief Keys reported by JoystickInput, 1-5 match the numbering used by the examples
+ */
+typedef enum {
+    JOYSTICK_KEY_NONE = 0,
+    JOYSTICK_KEY_UP,
+    JOYSTICK_KEY_DOWN,
+    JOYSTICK_KEY_LEFT,
+    JOYSTICK_KEY_RIGHT,
+    JOYSTICK_KEY_MID,
+    JOYSTICK_KEY_UP_LEFT,
+    JOYSTICK_KEY_UP_RIGHT,
+    JOYSTICK_KEY_DOWN_LEFT,
+    JOYSTICK_KEY_DOWN_RIGHT
+} joystick_key_t;
+
+typedef enum {
+    JOYSTICK_EVENT_PRESS = 0,
+    JOYSTICK_EVENT_RELEASE,
+    JOYSTICK_EVENT_LONG_PRESS,
+    JOYSTICK_EVENT_REPEAT
+} joystick_event_type_t;
+
+typedef struct {
+    uint8_t type;     // joystick_event_type_t
+    uint8_t key;      // joystick_key_t
+    uint32_t time_ms; // Time of the update that produced the event
+} joystick_event_t;
+
+/**
+ * @brief Direction classification and debouncing parameters
+ */
+struct joystick_input_config_t {
+    bool eight_way;               // 8-way (diagonals) instead of 4-way
+    uint16_t press_threshold;     // Offset magnitude needed to leave the center
+    uint16_t release_threshold;   // Offset magnitude below which a direction is released
+    uint16_t ratio_q8;            // 4-way: major axis must exceed minor axis * ratio (Q8, 256 = 1.0)
+    uint16_t hold_ratio_q8;       // 4-way: ratio that keeps the current direction (hysteresis)
+    uint16_t debounce_ms;         // Time a new key state must be stable before it is reported
+    uint16_t long_press_ms;       // Hold time of a LONG_PRESS event, 0 disables
+    uint16_t repeat_delay_ms;     // First REPEAT of a held direction, 0 disables
+    uint16_t repeat_interval_ms;  // Following REPEAT events
+
+    joystick_input_config_t() :
+        eight_way(false),
+        press_threshold(1800),
+        release_threshold(1000),
+        ratio_q8(435),            // 1.7, same as JOYSTICK_DIRECTION_RATIO + 0.2
+        hold_ratio_q8(256),       // 1.0
+        debounce_ms(10),
+        long_press_ms(3000),
+        repeat_delay_ms(500),
+        repeat_interval_ms(250)
+    {}
+};
+
+/**
+ * @brief Classify an offset vector into a direction with integer math only
+ * @param x x-axis offset value
+ * @param y y-axis offset value, negative is up
+ * @param config classification parameters
+ * @param current direction reported for the previous sample (for hysteresis)
+ * @return joystick_key_t direction, JOYSTICK_KEY_NONE when centered or ambiguous
+ */
+uint8_t joystick_classify_direction(int16_t x, int16_t y, const joystick_input_config_t &config,
+                                    uint8_t current = JOYSTICK_KEY_NONE);
+
+/**
+ * @brief Debounced joystick input with edge events
+ *
+ * Feed one sample per frame with update(); the debounced direction and button
+ * are available as levels, and PRESS/RELEASE/LONG_PRESS/REPEAT edges are
+ * queued for poll_event(). Debouncing is time based, so it does not depend
+ * on the frame rate.
+ */
+class JoystickInput {
+public:
+    JoystickInput();
+
+    /**
+     * @brief Set classification and debouncing parameters
+     * @param config parameters
+     */
+    void set_config(const joystick_input_config_t &config) { _config = config; }
+    const joystick_input_config_t &get_config(void) { return _config; }
+
+    /**
+     * @brief Process one sample
+     * @param x x-axis offset value
+     * @param y y-axis offset value
+     * @param button_pressed 1 button pressed
+     * @param now_ms time in milliseconds
+     */
+    void update(int16_t x, int16_t y, bool button_pressed, uint32_t now_ms);
+
+    /**
+     * @brief Process one Joystick::read_state snapshot (offset and button fields)
+     * @param state snapshot
+     * @param now_ms time in milliseconds
+     */
+    void update(const joystick_state_t &state, uint32_t now_ms);
+
+    /**
+     * @brief Get the oldest queued event
+     * @param event pointer of the event to fill
+     * @return 1 event returned, 0 queue empty
+     */
+    bool poll_event(joystick_event_t *event);
+
+    /**
+     * @brief Debounced direction
+     * @return joystick_key_t direction, JOYSTICK_KEY_NONE when centered
+     */
+    uint8_t get_direction(void) { return _direction.stable; }
+
+    /**
+     * @brief Debounced button state
+     * @return 1 pressed, 0 released
+     */
+    bool is_button_pressed(void) { return _button.stable == JOYSTICK_KEY_MID; }
+
+    /**
+     * @brief Number of events lost because the queue was full
+     */
+    uint32_t get_dropped_events(void) { return _dropped; }
+
+private:
+    struct key_state_t {
+        uint8_t stable;          // Reported key, JOYSTICK_KEY_NONE when released
+        uint8_t candidate;       // Raw key waiting for the debounce time
+        uint32_t candidate_ms;   // Time the candidate first appeared
+        uint32_t pressed_ms;     // Time the stable key was pressed
+        uint32_t next_repeat_ms;
+        bool long_sent;
+    };
+
+    void update_key(key_state_t &key, uint8_t raw, uint32_t now_ms, bool repeat);
+    void push_event(uint8_t type, uint8_t key, uint32_t now_ms);
+
+    joystick_input_config_t _config;
+    key_state_t _direction;
+    key_state_t _button;
+    uint8_t _raw_direction;      // Classifier output of the previous sample
+
+    joystick_event_t _events[JOYSTICK_INPUT_EVENT_QUEUE_SIZE];
+    uint8_t _event_head;
+    uint8_t _event_count;
+    uint32_t _dropped;
+};
+
+#endif
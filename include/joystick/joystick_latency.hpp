@@ -0,0 +1,80 @@
+#ifndef _MY_JOYSTICK_LATENCY_H_
+#define _MY_JOYSTICK_LATENCY_H_
+
+#include <stdint.h>
+
+// 1 times every Joystick register transaction, 0 compiles the timing out
+#ifndef JOYSTICK_LATENCY_PROFILE
+#define JOYSTICK_LATENCY_PROFILE 0
+#endif
+
+// Bucket 0 holds 0us, bucket n holds [2^(n-1), 2^n) us, the last one everything above
+#define JOYSTICK_LATENCY_BUCKETS 16
+
+/**
+ * @brief Register groups timed separately
+ */
+typedef enum {
+    JOYSTICK_LATENCY_ADC = 0,  // 16bits and 8bits ADC values (0x00, 0x10)
+    JOYSTICK_LATENCY_OFFSET,   // 12bits and 8bits offset values (0x50, 0x60)
+    JOYSTICK_LATENCY_BUTTON,   // Button (0x20)
+    JOYSTICK_LATENCY_RGB,      // LED (0x30)
+    JOYSTICK_LATENCY_CAL,      // Calibration (0x40)
+    JOYSTICK_LATENCY_INFO,     // Versions and I2C address (0xFC-0xFF)
+    JOYSTICK_LATENCY_GROUPS
+} joystick_latency_group_t;
+
+/**
+ * @brief Latency distribution of one register group
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;                              // mean = total_us / count
+    uint32_t buckets[JOYSTICK_LATENCY_BUCKETS];     // log2 histogram
+} joystick_latency_t;
+
+/**
+ * @brief Per register group transaction latency histograms
+ */
+class JoystickLatency {
+public:
+    JoystickLatency();
+
+    /**
+     * @brief Add one transaction
+     * @param reg first register of the transaction
+     * @param us duration in microseconds
+     */
+    void add(uint8_t reg, uint32_t us);
+
+    /**
+     * @brief Get the distribution of a group
+     * @param group joystick_latency_group_t
+     * @return counters, min_us is 0xFFFFFFFF while count is 0
+     */
+    const joystick_latency_t &get(joystick_latency_group_t group) const { return _groups[group]; }
+
+    /**
+     * @brief Clear every group
+     */
+    void reset(void);
+
+    /**
+     * @brief Print one line per used group: name, count, min/mean/max, bucket counts
+     */
+    void print(void) const;
+
+    /**
+     * @brief Register group of a register
+     * @param reg register address
+     * @return joystick_latency_group_t
+     */
+    static joystick_latency_group_t group_of(uint8_t reg);
+
+private:
+    joystick_latency_t _groups[JOYSTICK_LATENCY_GROUPS];
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef _MY_JOYSTICK_LED_H_
+#define _MY_JOYSTICK_LED_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+
+#ifndef JOYSTICK_LED_FADE_STEP_MS
+#define JOYSTICK_LED_FADE_STEP_MS 20       // Fades are updated at most this often
+#endif
+
+typedef enum {
+    JOYSTICK_LED_SEQ_NONE = 0,
+    JOYSTICK_LED_SEQ_FLASH,
+    JOYSTICK_LED_SEQ_BLINK,
+    JOYSTICK_LED_SEQ_FADE
+} joystick_led_seq_t;
+
+/**
+ * @brief Shadow-register controller for the Joystick RGB LED
+ *
+ * set_color() and the timed sequences only change the requested color; the
+ * bus write happens in tick(), at most once per call and only when the
+ * color differs from the last one written. A write that fails is retried at
+ * the next tick. Call tick() once per frame.
+ *
+ * A sequence (flash, blink, fade) is shown on top of the base color set by
+ * set_color(), the LED returns to the base color when it ends.
+ */
+class JoystickLed {
+public:
+    JoystickLed();
+
+    /**
+     * @brief Attach the controller to a Joystick
+     * @param joystick initialized Joystick
+     */
+    void begin(Joystick *joystick);
+
+    /**
+     * @brief Set the base color, written at the next tick
+     * @param color rgb color
+     */
+    void set_color(uint32_t color);
+
+    /**
+     * @brief Show a color for a while, then return to the base color
+     * @param color rgb color
+     * @param duration_ms flash duration
+     */
+    void flash(uint32_t color, uint32_t duration_ms);
+
+    /**
+     * @brief Blink a color, the base color is shown between blinks
+     * @param color rgb color
+     * @param count number of blinks
+     * @param on_ms time the color is shown
+     * @param off_ms time the base color is shown
+     */
+    void blink(uint32_t color, uint8_t count, uint32_t on_ms, uint32_t off_ms);
+
+    /**
+     * @brief Fade from the current color to a new base color
+     * @param color rgb color, becomes the base color
+     * @param duration_ms fade duration
+     */
+    void fade(uint32_t color, uint32_t duration_ms);
+
+    /**
+     * @brief Cancel the running sequence
+     */
+    void stop(void);
+
+    /**
+     * @brief Advance the sequence and write the color if it changed
+     * @param now_ms time in milliseconds
+     */
+    void tick(uint32_t now_ms);
+
+    /**
+     * @brief Whether a sequence is running
+     */
+    bool is_animating(void) { return _seq != JOYSTICK_LED_SEQ_NONE; }
+
+    /**
+     * @brief Get the color last written to the device
+     * @return rgb color
+     */
+    uint32_t get_color(void) { return _written; }
+
+    /**
+     * @brief Number of I2C writes issued
+     */
+    uint32_t get_bus_writes(void) { return _bus_writes; }
+
+    /**
+     * @brief Number of set_color calls that did not need their own I2C write
+     */
+    uint32_t get_saved_writes(void) { return _saved; }
+
+private:
+    void start_sequence(joystick_led_seq_t seq, uint32_t color, uint32_t duration_ms);
+    static uint32_t mix_color(uint32_t from, uint32_t to, uint32_t num, uint32_t den);
+
+    Joystick *_joystick;
+    uint32_t _base;          // Color shown when no sequence runs
+    uint32_t _written;       // Shadow of the device register
+    bool _written_valid;     // Shadow is unknown until the first write
+
+    joystick_led_seq_t _seq;
+    uint32_t _seq_color;     // Flash/blink color, fade target
+    uint32_t _seq_from;      // Fade start color
+    uint32_t _seq_duration;  // Flash/fade duration, blink on time
+    uint32_t _seq_off_ms;    // Blink off time
+    uint8_t _seq_count;      // Number of blinks
+    uint32_t _seq_start_ms;
+    bool _seq_started;       // Start time is taken at the first tick
+    uint32_t _last_fade_ms;
+
+    uint32_t _pending;       // set_color calls since the last tick
+    uint32_t _saved;
+    uint32_t _bus_writes;
+};
+
+#endif
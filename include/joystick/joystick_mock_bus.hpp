@@ -0,0 +1,122 @@
+#ifndef _MY_JOYSTICK_MOCK_BUS_H_
+#define _MY_JOYSTICK_MOCK_BUS_H_
+
+#include <stdint.h>
+#include "joystick_transport.hpp"
+
+#ifndef JOYSTICK_MOCK_MAX_DEVICES
+#define JOYSTICK_MOCK_MAX_DEVICES 8
+#endif
+
+/**
+ * @brief Simulated I2C bus with several Joystick units
+ *
+ * Every unit is a 256-byte register file answering at its own address,
+ * laid out like the 0x63 unit: ADC, offset, button, RGB, calibration,
+ * version and address registers.
+ * Reads and writes of an address without a present unit fail like a NACK.
+ * Writing the address register (0xFF) moves the unit to the new address.
+ */
+class JoystickMockBus : public JoystickTransport {
+public:
+    JoystickMockBus();
+
+    /**
+     * @brief Add a unit with default register contents
+     * @param addr I2C address
+     * @return 1 success, 0 bus full or address already used
+     */
+    bool add_device(uint8_t addr);
+
+    /**
+     * @brief Connect or disconnect a unit without losing its registers
+     * @param addr I2C address
+     * @param present 0 the unit NACKs every transfer
+     */
+    void set_present(uint8_t addr, bool present);
+
+    /**
+     * @brief Write registers directly, bypassing the bus
+     * @param addr I2C address
+     * @param reg first register
+     * @param buf pointer of the data
+     * @param nbytes number of bytes
+     * @return 1 success, 0 unknown address
+     */
+    bool set_regs(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes);
+
+    /**
+     * @brief Set the stick position and button of a unit
+     *
+     * Fills the 16bits and 8bits ADC registers and both offset registers from
+     * the offsets, centered at half scale.
+     * @param addr I2C address
+     * @param offset_x x-axis 12bits mapped value
+     * @param offset_y y-axis 12bits mapped value
+     * @param button 0 press, 1 no press
+     * @return 1 success, 0 unknown address
+     */
+    bool set_stick(uint8_t addr, int16_t offset_x, int16_t offset_y, uint8_t button);
+
+    /**
+     * @brief Get the register file of a unit
+     * @param addr I2C address
+     * @return 256 registers, nullptr for an unknown address
+     */
+    uint8_t *get_regs(uint8_t addr);
+
+    /**
+     * @brief Make transfers fail when the bus runs at or above a speed
+     * @param min_speed slowest I2C clock affected
+     * @param fail_every one transfer out of fail_every fails (NACK), 0 disables
+     */
+    void set_speed_fault(uint32_t min_speed, uint32_t fail_every);
+
+    /**
+     * @brief Make every transfer take its time on the wire
+     *
+     * Each transfer sleeps for the bits it would clock at the current speed,
+     * so on the host build the simulated clock acts as a bus clock.
+     * @param enable 1 transfers take time, 0 transfers are instant
+     */
+    void set_wire_timing(bool enable) { _wire_timing = enable; }
+
+    /**
+     * @brief Time a transfer takes on the wire at the current speed
+     * @param nbytes number of data bytes
+     * @param read 1 register read (repeated start and second address byte)
+     * @return microseconds
+     */
+    uint32_t wire_time_us(uint8_t nbytes, bool read);
+
+    /**
+     * @brief Number of transfers, including failed ones
+     */
+    uint32_t get_transfer_count(void) { return _transfers; }
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override;
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override;
+    uint32_t set_speed(uint32_t speed) override { _speed = speed; return _speed; }
+    uint32_t get_speed(void) override { return _speed; }
+
+private:
+    struct device_t {
+        uint8_t addr;
+        bool present;
+        uint8_t regs[256];
+    };
+
+    device_t *find(uint8_t addr);
+    bool fault(void);
+    void wire_delay(uint8_t nbytes, bool read);
+
+    device_t _devices[JOYSTICK_MOCK_MAX_DEVICES];
+    uint8_t _count;
+    uint32_t _transfers;
+    uint32_t _speed;
+    uint32_t _fault_speed;
+    uint32_t _fault_every;
+    bool _wire_timing;
+};
+
+#endif
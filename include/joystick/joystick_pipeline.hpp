@@ -0,0 +1,183 @@
+#ifndef _MY_JOYSTICK_PIPELINE_H_
+#define _MY_JOYSTICK_PIPELINE_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+
+#define JOYSTICK_Q15_ONE 32767          // Full deflection of a Q15 value
+
+#define JOYSTICK_CURVE_SHIFT 7          // Q15 input bits below the table index
+#define JOYSTICK_CURVE_POINTS (1 << (15 - JOYSTICK_CURVE_SHIFT)) // Table segments
+
+typedef enum {
+    JOYSTICK_CURVE_LINEAR = 0,  // out = in
+    JOYSTICK_CURVE_QUADRATIC,   // out = (1 - k) * in + k * in^2
+    JOYSTICK_CURVE_CUBIC        // out = (1 - k) * in + k * in^3
+} joystick_curve_type_t;
+
+/**
+ * @brief Response curve as a fixed-point lookup table built at compile time
+ *
+ * Maps a Q15 deflection to a Q15 deflection, odd-symmetric, by linear
+ * interpolation between JOYSTICK_CURVE_POINTS + 1 entries. Declare curves
+ * constexpr so the table is generated by the compiler and stays in flash:
+ *
+ *     static constexpr JoystickCurve curve(JOYSTICK_CURVE_CUBIC, 192);
+ */
+class JoystickCurve {
+public:
+    /**
+     * @brief Generate the table
+     * @param type curve shape
+     * @param amount_q8 blend between linear and the shape (Q8, 0 linear, 256 pure shape)
+     */
+    constexpr JoystickCurve(joystick_curve_type_t type, uint16_t amount_q8) :
+        _table()
+    {
+        int32_t k = amount_q8 > 256 ? 256 : amount_q8;
+        for (int32_t i = 0; i <= JOYSTICK_CURVE_POINTS; i++) {
+            int64_t x  = (int64_t)i << JOYSTICK_CURVE_SHIFT;
+            int64_t x2 = (x * x) >> 15;
+            int64_t x3 = (x2 * x) >> 15;
+            int64_t shaped = (type == JOYSTICK_CURVE_QUADRATIC) ? x2 : (type == JOYSTICK_CURVE_CUBIC) ? x3 : x;
+            int64_t y = (x * (256 - k) + shaped * k + 128) >> 8;
+            _table[i] = (int16_t)(y > JOYSTICK_Q15_ONE ? JOYSTICK_Q15_ONE : y);
+        }
+    }
+
+    /**
+     * @brief Apply the curve
+     * @param value Q15 deflection, saturated to +-JOYSTICK_Q15_ONE
+     * @return Q15 deflection with the same sign
+     */
+    constexpr int16_t apply(int32_t value) const
+    {
+        int32_t a = value < 0 ? -value : value;
+        if (a >= JOYSTICK_Q15_ONE) {
+            return (int16_t)(value < 0 ? -_table[JOYSTICK_CURVE_POINTS] : _table[JOYSTICK_CURVE_POINTS]);
+        }
+        int32_t i = a >> JOYSTICK_CURVE_SHIFT;
+        int32_t f = a & ((1 << JOYSTICK_CURVE_SHIFT) - 1);
+        int32_t y = _table[i] + (((_table[i + 1] - _table[i]) * f) >> JOYSTICK_CURVE_SHIFT);
+        return (int16_t)(value < 0 ? -y : y);
+    }
+
+private:
+    int16_t _table[JOYSTICK_CURVE_POINTS + 1];
+};
+
+extern const JoystickCurve joystick_curve_linear;     // No shaping
+extern const JoystickCurve joystick_curve_expo;       // Half cubic: finer control near the center
+extern const JoystickCurve joystick_curve_cubic;      // Full cubic
+
+/**
+ * @brief Normalized stick vector
+ */
+typedef struct {
+    int16_t x;   // Q15, -JOYSTICK_Q15_ONE..JOYSTICK_Q15_ONE, positive is right
+    int16_t y;   // Q15, negative is up
+} joystick_vector_t;
+
+/**
+ * @brief Dead zone, curve and filter parameters
+ */
+struct joystick_pipeline_config_t {
+    uint16_t dead_zone;           // Radius mapped to 0, offset units
+    uint16_t outer_zone;          // Radius of full deflection, offset units
+    const JoystickCurve *curve_x; // Response curve of the x-axis
+    const JoystickCurve *curve_y; // Response curve of the y-axis
+    uint16_t alpha_min_q8;        // Position gain for small changes (Q8, 256 = no smoothing)
+    uint16_t alpha_max_q8;        // Position gain for changes of adapt_q15 or more
+    uint16_t beta_q8;             // Velocity gain (Q8, 0 disables the prediction)
+    uint16_t adapt_q15;           // Change at which the filter reaches alpha_max_q8
+
+    joystick_pipeline_config_t() :
+        dead_zone(400),
+        outer_zone(3900),
+        curve_x(&joystick_curve_linear),
+        curve_y(&joystick_curve_linear),
+        alpha_min_q8(77),         // 0.3
+        alpha_max_q8(256),        // Fast moves pass unfiltered
+        beta_q8(26),              // 0.1
+        adapt_q15(8192)
+    {}
+};
+
+/**
+ * @brief Radial dead zone, per-axis response curve and alpha-beta filter
+ *
+ * Turns 12bits offset values into a Q15 vector games can scale to a
+ * proportional speed. The dead zone is radial, so a diagonal starts moving at
+ * the same deflection as an axis, and the remaining travel is rescaled to the
+ * full Q15 range. The filter predicts with the estimated velocity and makes
+ * its position gain grow with the size of the change: noise around a resting
+ * position is smoothed while a fast flick passes in the same sample.
+ * Integer math only, three divisions per sample.
+ */
+class JoystickPipeline {
+public:
+    JoystickPipeline();
+
+    /**
+     * @brief Set the dead zone, curves and filter parameters, resets the filter
+     * @param config parameters
+     */
+    void set_config(const joystick_pipeline_config_t &config);
+    const joystick_pipeline_config_t &get_config(void) { return _config; }
+
+    /**
+     * @brief Process one sample
+     * @param offset_x x-axis 12bits mapped value
+     * @param offset_y y-axis 12bits mapped value
+     * @return filtered Q15 vector
+     */
+    joystick_vector_t update(int16_t offset_x, int16_t offset_y);
+
+    /**
+     * @brief Process one Joystick::read_state snapshot (offset fields)
+     * @param state snapshot
+     * @return filtered Q15 vector
+     */
+    joystick_vector_t update(const joystick_state_t &state)
+    {
+        return update(state.offset_x, state.offset_y);
+    }
+
+    /**
+     * @brief Last output
+     */
+    joystick_vector_t get_vector(void) { return _output; }
+
+    /**
+     * @brief Forget the filter history
+     */
+    void reset(void);
+
+private:
+    struct axis_t {
+        int32_t position;   // Q15
+        int32_t velocity;   // Q15 per sample
+    };
+
+    int16_t filter(axis_t &axis, int32_t target);
+
+    joystick_pipeline_config_t _config;
+    uint32_t _adapt_gain_q16;  // (alpha_max - alpha_min) / adapt_q15
+    axis_t _x;
+    axis_t _y;
+    joystick_vector_t _output;
+};
+
+/**
+ * @brief Scale a Q15 value, rounded to nearest
+ * @param value Q15 value
+ * @param max result for JOYSTICK_Q15_ONE
+ * @return value * max / 32768
+ */
+static inline int16_t joystick_q15_scale(int16_t value, int16_t max)
+{
+    int32_t product = (int32_t)value * max;
+    return (int16_t)((product + (product < 0 ? -16384 : 16384)) / 32768);
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef _MY_JOYSTICK_PLATFORM_H_
+#define _MY_JOYSTICK_PLATFORM_H_
+
+#include <stdint.h>
+
+/**
+ * Time and error codes used by the portable driver sources.
+ *
+ * The device build maps them to the Pico SDK. The host build (JOYSTICK_HOST,
+ * set by the JOYSTICK_HOST_BUILD CMake option) has no hardware: time is a
+ * simulated clock that only moves when joystick_sleep_ms/us or
+ * joystick_host_advance_us are called, so runs are deterministic. A single
+ * simulated alarm stands in for interrupts.
+ */
+#ifdef JOYSTICK_HOST
+
+#ifndef PICO_ERROR_GENERIC
+#define PICO_ERROR_GENERIC -1
+#endif
+#ifndef PICO_ERROR_TIMEOUT
+#define PICO_ERROR_TIMEOUT -2
+#endif
+
+uint64_t joystick_time_us(void);
+void joystick_sleep_us(uint64_t us);
+void joystick_sleep_ms(uint32_t ms);
+void joystick_sleep_until_us(uint64_t us);
+
+/**
+ * @brief Move the simulated clock forward
+ * @param us microseconds
+ */
+void joystick_host_advance_us(uint64_t us);
+
+/**
+ * @brief Set the simulated clock
+ * @param us time since "boot" in microseconds
+ */
+void joystick_host_set_time_us(uint64_t us);
+
+/**
+ * @brief Arm the simulated alarm, a stand-in for a timer or DMA interrupt
+ *
+ * When a sleep moves the clock past at_us, the clock stops at at_us, calls
+ * cb (which may arm the alarm again) and then continues. There is one alarm,
+ * arming it replaces the previous one.
+ * @param at_us time of the alarm
+ * @param cb callback, nullptr disarms the alarm
+ * @param ctx callback argument
+ */
+void joystick_host_set_alarm(uint64_t at_us, void (*cb)(void *ctx), void *ctx);
+
+#else
+
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+
+static inline uint64_t joystick_time_us(void) { return time_us_64(); }
+static inline void joystick_sleep_us(uint64_t us) { sleep_us(us); }
+static inline void joystick_sleep_ms(uint32_t ms) { sleep_ms(ms); }
+static inline void joystick_sleep_until_us(uint64_t us) { sleep_until(from_us_since_boot(us)); }
+
+#endif
+
+#endif
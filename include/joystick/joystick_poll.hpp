@@ -0,0 +1,139 @@
+#ifndef _MY_JOYSTICK_POLL_H_
+#define _MY_JOYSTICK_POLL_H_
+
+#include <stdint.h>
+#include "joystick_platform.hpp"
+
+/**
+ * @brief Time source of JoystickPoller
+ *
+ * The default reads the system timer and sleeps until absolute deadlines
+ * (hardware alarm on the device, simulated clock on the host). Tests derive
+ * their own clock to drive the deadline logic.
+ */
+class JoystickClock {
+public:
+    virtual ~JoystickClock() {}
+
+    /**
+     * @brief Current time in microseconds
+     */
+    virtual uint64_t now_us(void) { return joystick_time_us(); }
+
+    /**
+     * @brief Sleep until an absolute time, return at once if it has passed
+     * @param deadline_us time in microseconds
+     */
+    virtual void sleep_until_us(uint64_t deadline_us) { joystick_sleep_until_us(deadline_us); }
+};
+
+extern JoystickClock joystick_system_clock;
+
+/**
+ * @brief Poll timing statistics
+ */
+typedef struct {
+    uint32_t polls;
+    uint32_t period_us;       // Nominal period
+    uint32_t mean_period_us;  // Mean measured period
+    uint32_t stddev_us;       // Standard deviation of the measured period
+    uint32_t max_late_us;     // Worst start of a poll after its deadline
+    uint32_t missed;          // Deadlines skipped because a poll ran a whole period late
+} joystick_poll_stats_t;
+
+/**
+ * @brief Fixed-rate polling on absolute deadlines
+ *
+ * Deadlines lie on a fixed grid start + n * period, so the work done between
+ * two polls does not shift the next one as a relative sleep would. A poll
+ * that starts a whole period late skips the deadlines it missed instead of
+ * polling in a burst. Every poll updates the period and lateness statistics.
+ * Games can start their frame at a fixed phase after the latest poll with
+ * phase_deadline() / wait_phase().
+ */
+class JoystickPoller {
+public:
+    JoystickPoller();
+
+    /**
+     * @brief Start the deadline grid, the first deadline is one period from now
+     * @param period_us poll period
+     * @param clock time source
+     */
+    void begin(uint32_t period_us, JoystickClock *clock = &joystick_system_clock);
+
+    /**
+     * @brief Sleep until the next deadline and mark the poll
+     * @return time of the poll
+     */
+    uint64_t wait(void);
+
+    /**
+     * @brief Mark the poll if its deadline has passed, without sleeping
+     * @return 1 poll now, 0 not yet
+     */
+    bool poll_due(void);
+
+    /**
+     * @brief Mark a poll started by an external timer, e.g. a repeating alarm
+     * @param now_us time of the poll
+     */
+    void mark(uint64_t now_us);
+
+    /**
+     * @brief Time of the latest poll
+     */
+    uint64_t get_last_poll_us(void) { return _last_poll_us; }
+
+    /**
+     * @brief Next deadline of the grid
+     */
+    uint64_t get_next_deadline_us(void) { return _deadline_us; }
+
+    /**
+     * @brief First time from now that lies offset_us after a deadline of the grid
+     * @param offset_us phase after the poll, e.g. the time a read takes
+     * @return absolute time in microseconds
+     */
+    uint64_t phase_deadline(uint32_t offset_us);
+
+    /**
+     * @brief First time from now_us that lies offset_us after a point of a grid
+     * @param grid_us any deadline of the grid
+     * @param period_us grid period
+     * @param offset_us phase after a deadline
+     * @param now_us current time
+     * @return absolute time in microseconds
+     */
+    static uint64_t grid_phase(uint64_t grid_us, uint32_t period_us, uint32_t offset_us, uint64_t now_us);
+
+    /**
+     * @brief Sleep until phase_deadline(offset_us)
+     */
+    void wait_phase(uint32_t offset_us);
+
+    /**
+     * @brief Get the timing statistics
+     * @param stats pointer of the statistics to fill
+     */
+    void get_stats(joystick_poll_stats_t *stats);
+
+    /**
+     * @brief Clear the timing statistics, the deadline grid is kept
+     */
+    void reset_stats(void);
+
+private:
+    JoystickClock *_clock;
+    uint32_t _period_us;
+    uint64_t _deadline_us;   // Next deadline
+    uint64_t _last_poll_us;
+    uint32_t _polls;
+    uint32_t _intervals;     // Periods measured, polls - 1
+    int64_t _sum_dev;        // Sum of (period - nominal)
+    uint64_t _sum_dev2;      // Sum of (period - nominal)^2
+    uint32_t _max_late_us;
+    uint32_t _missed;
+};
+
+#endif
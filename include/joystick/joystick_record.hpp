@@ -0,0 +1,213 @@
+#ifndef _MY_JOYSTICK_RECORD_H_
+#define _MY_JOYSTICK_RECORD_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+#include "joystick_transport.hpp"
+
+#ifndef JOYSTICK_RECORD_BUFFER_SIZE
+#define JOYSTICK_RECORD_BUFFER_SIZE 16384  // Recording buffer, about 4 bytes per sample
+#endif
+
+#define JOYSTICK_RECORD_MAGIC 0x4345524AUL // "JREC"
+#define JOYSTICK_RECORD_HEADER_SIZE 16     // magic, sample count, data size, CRC-32 of the data
+
+/**
+ * @brief One recorded sample
+ */
+typedef struct {
+    uint64_t time_us;   // Time since the first sample
+    int16_t offset_x;   // x-axis 12bits mapped value
+    int16_t offset_y;   // y-axis 12bits mapped value
+    uint8_t button;     // 0 press, 1 no press
+} joystick_record_sample_t;
+
+/**
+ * @brief Delta-encoded recorder of the joystick sample stream
+ *
+ * Every sample is a flag byte (button, which fields changed) followed by
+ * varints: the time step when it differs from the previous one and the
+ * zigzag-encoded x/y deltas when they are not 0. A steady stick at a fixed
+ * poll rate costs one byte per sample.
+ */
+class JoystickRecorder {
+public:
+    JoystickRecorder();
+
+    /**
+     * @brief Start a recording
+     * @param buf pointer of the recording buffer
+     * @param size size of the buffer
+     */
+    void begin(uint8_t *buf, uint32_t size);
+
+    /**
+     * @brief Append a sample taken by Joystick::read_state (offset and button fields)
+     * @param state snapshot
+     * @return 1 success, 0 buffer full
+     */
+    bool record(const joystick_state_t &state);
+
+    /**
+     * @brief Append a sample
+     * @param time_us sample time in microseconds
+     * @param offset_x x-axis 12bits mapped value
+     * @param offset_y y-axis 12bits mapped value
+     * @param button 0 press, 1 no press
+     * @return 1 success, 0 buffer full
+     */
+    bool record(uint64_t time_us, int16_t offset_x, int16_t offset_y, uint8_t button);
+
+    /**
+     * @brief Print the recording as hex lines framed by JREC/JEND, for USB stdio capture
+     */
+    void dump(void) const;
+
+    const uint8_t *get_data(void) const { return _buf; }
+    uint32_t get_size(void) const { return _size; }
+    uint32_t get_sample_count(void) const { return _count; }
+    bool is_full(void) const { return _full; }
+
+private:
+    uint8_t *_buf;
+    uint32_t _capacity;
+    uint32_t _size;
+    uint32_t _count;
+    bool _full;
+    uint64_t _last_time;
+    uint32_t _last_dt;
+    int16_t _last_x;
+    int16_t _last_y;
+};
+
+/**
+ * @brief Sequential decoder of a recording
+ */
+class JoystickRecordReader {
+public:
+    JoystickRecordReader();
+
+    /**
+     * @brief Start decoding
+     * @param data pointer of the encoded samples
+     * @param size size of the encoded samples
+     */
+    void begin(const uint8_t *data, uint32_t size);
+
+    /**
+     * @brief Decode the next sample
+     * @param sample pointer of the sample to fill
+     * @return 1 success, 0 end of the recording or corrupt data
+     */
+    bool next(joystick_record_sample_t *sample);
+
+    /**
+     * @brief Restart at the first sample
+     */
+    void rewind(void) { begin(_data, _size); }
+
+    /**
+     * @brief Time step of the last decoded sample in microseconds
+     */
+    uint32_t get_step_us(void) const { return _dt; }
+
+private:
+    const uint8_t *_data;
+    uint32_t _size;
+    uint32_t _pos;
+    uint64_t _time;
+    uint32_t _dt;
+    int16_t _x;
+    int16_t _y;
+};
+
+/**
+ * @brief Parse a dump printed by JoystickRecorder::dump()
+ * @param text dump text, lines outside the JREC/JEND frame are ignored
+ * @param buf pointer of the buffer to fill with the encoded samples
+ * @param max_size size of the buffer
+ * @param size pointer of the decoded size
+ * @return 1 success, 0 missing frame, buffer too small or bad CRC
+ */
+bool joystick_record_parse_dump(const char *text, uint8_t *buf, uint32_t max_size, uint32_t *size);
+
+/**
+ * @brief Store a recording in flash (JOYSTICK_RECORD_FLASH_OFFSET)
+ * @param recorder recording to store
+ * @return 1 success, 0 recording larger than the flash area or flash not written
+ * @note Written through flash_safe_execute() like joystick_cal_save()
+ */
+bool joystick_record_save(const JoystickRecorder &recorder);
+
+/**
+ * @brief Find a recording stored by joystick_record_save
+ * @param data pointer set to the encoded samples (memory mapped flash)
+ * @param size pointer of the size of the encoded samples
+ * @return 1 valid recording found, 0 false
+ */
+bool joystick_record_load(const uint8_t **data, uint32_t *size);
+
+typedef enum {
+    JOYSTICK_REPLAY_REALTIME = 0, // Samples follow their recorded timestamps
+    JOYSTICK_REPLAY_FAST          // One sample per frame, as fast as the game polls
+} joystick_replay_mode_t;
+
+/**
+ * @brief Transport that plays a recording back in place of the hardware
+ *
+ * Answers the Joystick register map from the current sample: offsets, button,
+ * and 8bits/16bits ADC values derived from the offsets. LED and calibration
+ * writes are accepted and read back. Joystick runs on it unchanged.
+ *
+ * JOYSTICK_REPLAY_FAST starts a frame when an x/y register block is read a
+ * second time since the last sample, so read_state() and the getters both
+ * play one sample per game frame. In a loop the last sample lasts one
+ * recorded time step before the first one plays again.
+ */
+class JoystickReplayTransport : public JoystickTransport {
+public:
+    JoystickReplayTransport();
+
+    /**
+     * @brief Start a replay
+     * @param data pointer of the encoded samples
+     * @param size size of the encoded samples
+     * @param mode JOYSTICK_REPLAY_REALTIME or JOYSTICK_REPLAY_FAST
+     * @param loop 1 restart at the end, 0 hold the last sample
+     */
+    void begin(const uint8_t *data, uint32_t size, joystick_replay_mode_t mode = JOYSTICK_REPLAY_REALTIME,
+               bool loop = false);
+
+    /**
+     * @brief Whether the last sample has been reached
+     */
+    bool is_finished(void) { return _finished; }
+
+    /**
+     * @brief Number of samples played
+     */
+    uint32_t get_played_count(void) { return _played; }
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override;
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override;
+
+private:
+    void advance(void);
+    void play_realtime(void);
+    uint8_t reg_value(uint8_t addr, uint8_t reg);
+
+    JoystickRecordReader _reader;
+    joystick_replay_mode_t _mode;
+    bool _loop;
+    bool _finished;
+    uint32_t _played;
+    uint64_t _start_us;
+    joystick_record_sample_t _current;
+    joystick_record_sample_t _next;
+    bool _has_next;
+    uint8_t _frame_blocks;  // x/y blocks read since the current sample started, FAST mode
+    uint8_t _rgb[4];
+    uint8_t _cal[16];
+};
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef _MY_JOYSTICK_REGMAP_H_
+#define _MY_JOYSTICK_REGMAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JOYSTICK_ADDR                        0x63
+#define JOYSTICK_ADC_VALUE_12BITS_REG        0x00
+#define JOYSTICK_ADC_VALUE_8BITS_REG         0x10
+#define JOYSTICK_BUTTON_REG                  0x20
+#define JOYSTICK_RGB_REG                     0x30
+#define JOYSTICK_ADC_VALUE_CAL_REG           0x40
+#define JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG 0x50
+#define JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG  0x60
+#define JOYSTICK_FIRMWARE_VERSION_REG        0xFE
+#define JOYSTICK_BOOTLOADER_VERSION_REG      0xFC
+#define JOYSTICK_I2C_ADDRESS_REG             0xFF
+
+#ifndef JOYSTICK_BURST_MAX_GAP
+#define JOYSTICK_BURST_MAX_GAP 4   // Unused registers a burst may read through rather than start a new transaction
+#endif
+
+typedef enum {
+    JOYSTICK_ACCESS_R  = 0x01,
+    JOYSTICK_ACCESS_W  = 0x02,
+    JOYSTICK_ACCESS_RW = 0x03
+} joystick_access_t;
+
+/**
+ * @brief Position of a field in the register map, input of the burst planner
+ */
+typedef struct {
+    uint8_t reg;
+    uint8_t width;
+} joystick_field_desc_t;
+
+/**
+ * @brief One burst read of a plan
+ */
+typedef struct {
+    uint8_t reg;      // First register
+    uint8_t len;      // Number of bytes
+    uint8_t offset;   // Position of the bytes in the plan buffer
+} joystick_burst_t;
+
+/**
+ * @brief Burst reads covering N fields
+ */
+template <size_t N>
+struct joystick_read_plan_t {
+    joystick_burst_t bursts[N];
+    uint8_t burst_count;
+    uint8_t field_offset[N];  // Position of every field in the plan buffer, in request order
+    uint8_t size;             // Plan buffer size
+};
+
+/**
+ * @brief Merge fields into the fewest burst reads
+ *
+ * Fields are visited by register address. A field starting at most
+ * JOYSTICK_BURST_MAX_GAP registers after the end of the current burst extends
+ * it, anything further starts a new burst. Meant to run at compile time.
+ * @param fields field positions
+ * @return plan
+ */
+template <size_t N>
+constexpr joystick_read_plan_t<N> joystick_make_read_plan(const joystick_field_desc_t (&fields)[N])
+{
+    joystick_read_plan_t<N> plan{};
+    size_t order[N] = {};
+    for (size_t i = 0; i < N; i++) {
+        order[i] = i;
+    }
+    for (size_t i = 1; i < N; i++) {
+        for (size_t j = i; j > 0 && fields[order[j - 1]].reg > fields[order[j]].reg; j--) {
+            size_t t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+
+    uint32_t end = 0;  // One past the last register of the current burst
+    for (size_t k = 0; k < N; k++) {
+        const joystick_field_desc_t &field = fields[order[k]];
+        uint32_t field_end = (uint32_t)field.reg + field.width;
+        if (plan.burst_count == 0 || field.reg > end + JOYSTICK_BURST_MAX_GAP) {
+            joystick_burst_t &burst = plan.bursts[plan.burst_count++];
+            burst.reg    = field.reg;
+            burst.len    = field.width;
+            burst.offset = plan.size;
+            plan.size   += field.width;
+            end = field_end;
+        } else if (field_end > end) {
+            joystick_burst_t &burst = plan.bursts[plan.burst_count - 1];
+            plan.size += field_end - end;
+            burst.len  = field_end - burst.reg;
+            end = field_end;
+        }
+        const joystick_burst_t &burst = plan.bursts[plan.burst_count - 1];
+        plan.field_offset[order[k]] = burst.offset + (field.reg - burst.reg);
+    }
+    return plan;
+}
+
+template <uint8_t Width, bool Signed> struct joystick_field_value;
+template <> struct joystick_field_value<1, false> { typedef uint8_t type; };
+template <> struct joystick_field_value<1, true>  { typedef int8_t type; };
+template <> struct joystick_field_value<2, false> { typedef uint16_t type; };
+template <> struct joystick_field_value<2, true>  { typedef int16_t type; };
+template <> struct joystick_field_value<4, false> { typedef uint32_t type; };
+template <> struct joystick_field_value<4, true>  { typedef int32_t type; };
+
+/**
+ * @brief Register field descriptor
+ *
+ * Fields are little endian. value_type follows from the width and
+ * signedness, so the typed accessors Joystick::read/write need no casts.
+ */
+template <uint8_t Reg, uint8_t Width, bool Signed, uint8_t Access>
+struct JoystickField {
+    typedef typename joystick_field_value<Width, Signed>::type value_type;
+
+    static constexpr uint8_t reg    = Reg;
+    static constexpr uint8_t width  = Width;
+    static constexpr uint8_t access = Access;
+    static_assert(Reg + Width <= 256, "field runs past the register map");
+
+    static value_type decode(const uint8_t *buf)
+    {
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < Width; i++) {
+            value |= (uint32_t)buf[i] << (8 * i);
+        }
+        return (value_type)value;
+    }
+
+    static void encode(value_type value, uint8_t *buf)
+    {
+        for (uint8_t i = 0; i < Width; i++) {
+            buf[i] = (uint8_t)((uint32_t)value >> (8 * i));
+        }
+    }
+};
+
+/**
+ * @brief Compile-time burst plan of a list of fields
+ */
+template <typename... Fields>
+struct JoystickReadPlan {
+    static_assert(sizeof...(Fields) > 0, "a plan needs at least one field");
+    static_assert(((Fields::access & JOYSTICK_ACCESS_R) && ...), "write-only field in a read plan");
+
+    static constexpr joystick_field_desc_t fields[] = { { Fields::reg, Fields::width }... };
+    static constexpr joystick_read_plan_t<sizeof...(Fields)> plan = joystick_make_read_plan(fields);
+};
+
+// Unit register map
+typedef JoystickField<JOYSTICK_ADC_VALUE_12BITS_REG, 2, false, JOYSTICK_ACCESS_R>            JoystickRegAdc16X;
+typedef JoystickField<JOYSTICK_ADC_VALUE_12BITS_REG + 2, 2, false, JOYSTICK_ACCESS_R>        JoystickRegAdc16Y;
+typedef JoystickField<JOYSTICK_ADC_VALUE_8BITS_REG, 1, false, JOYSTICK_ACCESS_R>             JoystickRegAdc8X;
+typedef JoystickField<JOYSTICK_ADC_VALUE_8BITS_REG + 1, 1, false, JOYSTICK_ACCESS_R>         JoystickRegAdc8Y;
+typedef JoystickField<JOYSTICK_BUTTON_REG, 1, false, JOYSTICK_ACCESS_R>                      JoystickRegButton;
+typedef JoystickField<JOYSTICK_RGB_REG, 4, false, JOYSTICK_ACCESS_RW>                        JoystickRegRgb;
+typedef JoystickField<JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG, 2, true, JOYSTICK_ACCESS_R>      JoystickRegOffset12X;
+typedef JoystickField<JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 2, 2, true, JOYSTICK_ACCESS_R>  JoystickRegOffset12Y;
+typedef JoystickField<JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG, 1, true, JOYSTICK_ACCESS_R>       JoystickRegOffset8X;
+typedef JoystickField<JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG + 1, 1, true, JOYSTICK_ACCESS_R>   JoystickRegOffset8Y;
+typedef JoystickField<JOYSTICK_BOOTLOADER_VERSION_REG, 1, false, JOYSTICK_ACCESS_R>          JoystickRegBootloader;
+typedef JoystickField<JOYSTICK_FIRMWARE_VERSION_REG, 1, false, JOYSTICK_ACCESS_R>            JoystickRegFirmware;
+typedef JoystickField<JOYSTICK_I2C_ADDRESS_REG, 1, false, JOYSTICK_ACCESS_RW>                JoystickRegAddress;
+
+// Calibration words 0-7: x neg min, x neg max, x pos min, x pos max, then the same for y
+template <uint8_t I>
+using JoystickRegCal = JoystickField<JOYSTICK_ADC_VALUE_CAL_REG + 2 * I, 2, false, JOYSTICK_ACCESS_RW>;
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef _MY_JOYSTICK_SAMPLE_RING_H_
+#define _MY_JOYSTICK_SAMPLE_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Single-producer/single-consumer lock-free sample ring
+ *
+ * The producer (core1 or a timer callback) calls push(), the consumer (core0)
+ * calls pop()/drain()/peek_latest(). Only plain atomic loads and stores are
+ * used, so it is lock-free on the Cortex-M0+ which has no exclusive access
+ * instructions. A push into a full ring drops the new item and counts an
+ * overrun.
+ *
+ * @tparam T item type, copied by value
+ * @tparam N capacity, must be a power of two
+ */
+template <typename T, uint32_t N>
+class JoystickSampleRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+public:
+    JoystickSampleRing() : _head(0), _tail(0), _overruns(0), _has_last(false) {}
+
+    /**
+     * @brief Producer side: append an item
+     * @param item item to append
+     * @return 1 success, 0 ring full (overrun counted)
+     */
+    bool push(const T &item)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            _overruns.store(_overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side: remove the oldest item
+     * @param item pointer of the item to fill
+     * @return 1 success, 0 ring empty
+     */
+    bool pop(T *item)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        *item = _items[tail & (N - 1)];
+        _last = *item;
+        _has_last = true;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side: remove every queued item
+     * @param items pointer of the item array to fill
+     * @param max_items size of the item array
+     * @return number of items removed
+     */
+    uint32_t drain(T *items, uint32_t max_items)
+    {
+        uint32_t count = 0;
+        while (count < max_items && pop(&items[count])) {
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Consumer side: copy the newest item without removing anything
+     * @param item pointer of the item to fill
+     * @return 1 success, 0 nothing has ever been pushed
+     * @note When the ring is empty the last item removed by pop() is returned
+     */
+    bool peek_latest(T *item)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (head != tail) {
+            // Slot head - 1 is not consumed yet, so the producer cannot reuse it
+            *item = _items[(head - 1) & (N - 1)];
+            return true;
+        }
+        if (_has_last) {
+            *item = _last;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Number of queued items
+     */
+    uint32_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Ring capacity
+     */
+    static constexpr uint32_t capacity() { return N; }
+
+    /**
+     * @brief Number of items dropped because the ring was full
+     */
+    uint32_t get_overrun_count() const { return _overruns.load(std::memory_order_relaxed); }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _head;     // Written by the producer only
+    std::atomic<uint32_t> _tail;     // Written by the consumer only
+    std::atomic<uint32_t> _overruns; // Written by the producer only
+    T _last;                         // Consumer side copy of the last popped item
+    bool _has_last;
+};
+
+#endif
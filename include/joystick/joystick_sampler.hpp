@@ -0,0 +1,133 @@
+#ifndef _MY_JOYSTICK_SAMPLER_H_
+#define _MY_JOYSTICK_SAMPLER_H_
+
+#include <atomic>
+#include <pico/stdlib.h>
+#include "joystick.hpp"
+#include "joystick_sample_ring.hpp"
+#include "joystick_poll.hpp"
+
+#ifndef JOYSTICK_SAMPLER_RING_SIZE
+#define JOYSTICK_SAMPLER_RING_SIZE 32      // Samples buffered between two drains
+#endif
+
+#ifndef JOYSTICK_SAMPLER_PERIOD_US
+#define JOYSTICK_SAMPLER_PERIOD_US 5000    // Default sample period (200 Hz)
+#endif
+
+typedef enum { JOYSTICK_SAMPLER_CORE1 = 0, JOYSTICK_SAMPLER_TIMER } joystick_sampler_mode_t;
+
+/**
+ * @brief Background Joystick sampler
+ *
+ * Polls the unit at a fixed rate on core1 (or from a repeating timer on
+ * core0) and publishes timestamped joystick_state_t samples into a lock-free
+ * ring that the game loop drains without blocking.
+ *
+ * While the sampler runs it owns the I2C bus: the game must not call the
+ * Joystick getters itself, and LED changes go through set_rgb_color() of the
+ * sampler so that they are issued between two polls.
+ */
+class JoystickSampler {
+public:
+    JoystickSampler();
+
+    /**
+     * @brief Start sampling
+     * @param joystick initialized Joystick to poll
+     * @param period_us sample period in microseconds
+     * @param mode JOYSTICK_SAMPLER_CORE1 or JOYSTICK_SAMPLER_TIMER
+     * @param fields joystick_state_field_t mask passed to Joystick::read_state
+     * @return 1 success, 0 false
+     */
+    bool begin(Joystick *joystick, uint32_t period_us = JOYSTICK_SAMPLER_PERIOD_US,
+               joystick_sampler_mode_t mode = JOYSTICK_SAMPLER_CORE1,
+               uint8_t fields = JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+
+    /**
+     * @brief Stop sampling and release core1 or the timer
+     */
+    void end(void);
+
+    /**
+     * @brief Get the newest sample without consuming the queue
+     * @param sample pointer of the sample to fill
+     * @return 1 success, 0 no sample yet
+     */
+    bool get_latest(joystick_state_t *sample);
+
+    /**
+     * @brief Remove every queued sample, oldest first
+     * @param samples pointer of the sample array to fill
+     * @param max_samples size of the sample array
+     * @return number of samples removed
+     */
+    uint32_t drain(joystick_state_t *samples, uint32_t max_samples);
+
+    /**
+     * @brief Number of samples dropped because the ring was full
+     */
+    uint32_t get_overrun_count(void) { return _ring.get_overrun_count(); }
+
+    /**
+     * @brief Number of polls where read_state failed
+     */
+    uint32_t get_error_count(void) { return _errors.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of samples taken since begin
+     */
+    uint32_t get_sample_count(void) { return _samples.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Queue a LED color, written by the sampler before its next poll
+     * @param color rgb color
+     */
+    void set_rgb_color(uint32_t color);
+
+    /**
+     * @brief Get the poll timing statistics
+     * @param stats pointer of the statistics to fill
+     * @note Updated by the sampling side without a lock, the fields are
+     *       consistent only once the sampler has stopped
+     */
+    void get_poll_stats(joystick_poll_stats_t *stats) { _poller.get_stats(stats); }
+
+    /**
+     * @brief First time from now that lies offset_us after a poll, to start a
+     *        game frame right after a fresh sample is available
+     * @param offset_us phase after the poll, at least the time of one read
+     * @return absolute time in microseconds
+     * @note Safe to call from the game core while the sampler runs
+     */
+    uint64_t phase_deadline(uint32_t offset_us);
+
+    bool is_running(void) { return _running.load(std::memory_order_acquire); }
+
+private:
+    void sample_once(void);
+    void run_core1(void);
+    static void core1_entry(void);
+    static bool timer_callback(repeating_timer_t *rt);
+
+    Joystick *_joystick;
+    uint32_t _period_us;
+    uint8_t _fields;
+    joystick_sampler_mode_t _mode;
+    repeating_timer_t _timer;
+    JoystickPoller _poller;
+    uint64_t _grid_us;              // Start of the poll grid, set before sampling starts
+
+    JoystickSampleRing<joystick_state_t, JOYSTICK_SAMPLER_RING_SIZE> _ring;
+    std::atomic<bool> _running;
+    std::atomic<bool> _core1_done;
+    std::atomic<uint32_t> _errors;  // Written by the sampling side only
+    std::atomic<uint32_t> _samples; // Written by the sampling side only
+
+    // LED request: the game writes color then bumps seq, the sampler applies it
+    std::atomic<uint32_t> _led_color;
+    std::atomic<uint32_t> _led_seq;
+    uint32_t _led_applied_seq;
+};
+
+#endif
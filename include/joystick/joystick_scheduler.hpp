@@ -0,0 +1,218 @@
+#ifndef _MY_JOYSTICK_SCHEDULER_H_
+#define _MY_JOYSTICK_SCHEDULER_H_
+
+#include <stdint.h>
+#include "joystick_transport.hpp"
+
+#ifndef JOYSTICK_SCHED_QUEUE_SIZE
+#define JOYSTICK_SCHED_QUEUE_SIZE 16     // Transactions waiting for the bus
+#endif
+
+#ifndef JOYSTICK_SCHED_MAX_CLIENTS
+#define JOYSTICK_SCHED_MAX_CLIENTS 8
+#endif
+
+#ifndef JOYSTICK_SCHED_MAX_POSTED
+#define JOYSTICK_SCHED_MAX_POSTED 16     // Largest posted write, copied into the queue
+#endif
+
+typedef enum {
+    JOYSTICK_PRIORITY_HIGH = 0,  // Latency critical input reads
+    JOYSTICK_PRIORITY_NORMAL,    // Other sensors
+    JOYSTICK_PRIORITY_LOW        // LED, calibration and configuration traffic
+} joystick_priority_t;
+
+/**
+ * @brief Bus usage of one scheduler client
+ */
+typedef struct {
+    uint32_t transactions;
+    uint32_t errors;           // Transactions that failed on the bus
+    uint32_t deadline_misses;  // Transactions finished after their deadline
+    uint32_t dropped;          // Posted writes refused because the queue was full
+    uint64_t busy_us;          // Bus time used
+    uint32_t max_wait_us;      // Longest time from submission to start
+} joystick_sched_stats_t;
+
+/**
+ * @brief Prioritized, deadline aware owner of a shared I2C bus
+ *
+ * Every transaction carries its client's priority and a deadline. The next
+ * transaction on the bus is the due one with the earliest deadline, or when
+ * none is due the one with the highest priority, then the earliest deadline,
+ * then the oldest. A transaction is due once waiting for one more
+ * transaction would make it miss its deadline, judged by the last measured
+ * transaction times. Low priority traffic therefore waits behind
+ * input reads but never longer than its deadline.
+ *
+ * Blocking transactions (read, write) return once they are done; any queued
+ * transaction that must go first is executed before them. Posted writes are
+ * queued and sent later by poll(), by flush() or ahead of a blocking
+ * transaction when their deadline has come. Transactions never overlap, so
+ * the schedule is the same on the hardware and on a simulated bus.
+ *
+ * Not thread safe: use the scheduler from one core.
+ */
+class JoystickScheduler {
+public:
+    JoystickScheduler();
+
+    /**
+     * @brief Take ownership of the bus
+     * @param bus transport that performs the transfers (JoystickI2C, JoystickSpeedControl, mock, ...)
+     */
+    void begin(JoystickTransport *bus);
+
+    /**
+     * @brief Register a client
+     * @param priority joystick_priority_t of its transactions
+     * @param deadline_us time allowed from submission to completion
+     * @return client id, -1 too many clients
+     */
+    int add_client(joystick_priority_t priority, uint32_t deadline_us);
+
+    /**
+     * @brief Blocking register read
+     * @param client client id
+     * @param addr I2C address
+     * @param reg first register
+     * @param buf pointer of the receive buffer
+     * @param nbytes number of bytes to read
+     * @return number of bytes read, negative on error
+     */
+    int read(int client, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes);
+
+    /**
+     * @brief Blocking register write
+     * @return number of bytes written, negative on error
+     */
+    int write(int client, uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes);
+
+    /**
+     * @brief Queue a register write, the data is copied
+     * @param client client id
+     * @param addr I2C address
+     * @param reg first register
+     * @param buf pointer of the data
+     * @param nbytes number of bytes, at most JOYSTICK_SCHED_MAX_POSTED
+     * @return 1 queued, 0 queue full or write too long
+     */
+    bool post_write(int client, uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes);
+
+    /**
+     * @brief Run the next queued transaction, call it when the bus is otherwise idle
+     * @return 1 a transaction ran, 0 queue empty
+     */
+    bool poll(void);
+
+    /**
+     * @brief Run every queued transaction
+     */
+    void flush(void);
+
+    /**
+     * @brief Number of queued transactions
+     */
+    uint8_t get_pending(void) { return _pending; }
+
+    /**
+     * @brief Get the bus usage of a client
+     * @param client client id
+     * @return counters of the client, all 0 for an id add_client() did not return
+     */
+    const joystick_sched_stats_t &get_stats(int client);
+
+    /**
+     * @brief Share of the bus used by a client since the last reset_stats()
+     * @param client client id
+     * @return bus time per mille of the elapsed time, 0 for an unknown id
+     */
+    uint32_t get_utilization(int client);
+
+    /**
+     * @brief Clear the usage counters of every client
+     */
+    void reset_stats(void);
+
+    /**
+     * @brief Get the transport of the bus
+     */
+    JoystickTransport *get_bus(void) { return _bus; }
+
+private:
+    struct client_t {
+        uint8_t priority;
+        uint32_t deadline_us;
+        uint32_t last_us;        // Duration of the last transaction, lead time before a deadline
+        joystick_sched_stats_t stats;
+    };
+
+    struct request_t {
+        bool used;
+        bool write;
+        bool posted;
+        uint8_t client;
+        uint8_t addr;
+        uint8_t reg;
+        uint8_t nbytes;
+        uint8_t *buf;                            // Caller buffer of a blocking transaction
+        uint8_t data[JOYSTICK_SCHED_MAX_POSTED]; // Copy of a posted write
+        uint32_t seq;                            // Submission order
+        uint64_t submit_us;
+        uint64_t deadline_us;
+        int result;
+    };
+
+    bool valid_client(int client) const { return client >= 0 && client < _client_count; }
+    request_t *enqueue(int client, uint8_t addr, uint8_t reg, uint8_t nbytes, bool write);
+    request_t *next(uint64_t now_us);
+    void execute(request_t *req);
+    int run_blocking(request_t *req);
+
+    JoystickTransport *_bus;
+    client_t _clients[JOYSTICK_SCHED_MAX_CLIENTS];
+    uint8_t _client_count;
+    request_t _queue[JOYSTICK_SCHED_QUEUE_SIZE];
+    uint8_t _pending;
+    uint32_t _seq;
+    uint64_t _stats_start_us;
+};
+
+/**
+ * @brief Transport of one scheduler client, e.g. for Joystick::begin
+ *
+ * Reads are blocking. Writes are blocking too, unless the client posts them:
+ * a posted write returns at once and is sent when the scheduler gets to it.
+ */
+class JoystickSchedulerClient : public JoystickTransport {
+public:
+    JoystickSchedulerClient();
+
+    /**
+     * @brief Register with a scheduler
+     * @param scheduler bus scheduler
+     * @param priority joystick_priority_t of the transactions
+     * @param deadline_us time allowed from submission to completion
+     * @param posted_writes 1 writes are queued and return at once
+     * @return 1 success, 0 too many clients
+     */
+    bool begin(JoystickScheduler *scheduler, joystick_priority_t priority, uint32_t deadline_us,
+               bool posted_writes = false);
+
+    /**
+     * @brief Client id, for JoystickScheduler::get_stats
+     */
+    int get_id(void) { return _id; }
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override;
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override;
+    uint32_t set_speed(uint32_t speed) override;
+    uint32_t get_speed(void) override;
+
+private:
+    JoystickScheduler *_scheduler;
+    int _id;
+    bool _posted;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef _MY_JOYSTICK_SPEED_H_
+#define _MY_JOYSTICK_SPEED_H_
+
+#include <stdint.h>
+#include "joystick_transport.hpp"
+
+#ifndef JOYSTICK_SPEED_PROBE_COUNT
+#define JOYSTICK_SPEED_PROBE_COUNT 32      // Verified reads per speed during negotiate()
+#endif
+
+#ifndef JOYSTICK_SPEED_WINDOW
+#define JOYSTICK_SPEED_WINDOW 64           // Transfers per runtime error-rate window
+#endif
+
+#ifndef JOYSTICK_SPEED_WINDOW_MAX_ERRORS
+#define JOYSTICK_SPEED_WINDOW_MAX_ERRORS 4 // Errors in a window that trigger a downshift
+#endif
+
+#define JOYSTICK_SPEED_LEVELS 3
+
+class Joystick;
+
+/**
+ * @brief Bus speed negotiation and runtime downshift
+ *
+ * Wraps the transport used by a Joystick. negotiate() steps the bus through
+ * 100 kHz, 400 kHz and 1 MHz, verifying reads of known registers (firmware
+ * version, I2C address) at each step, and settles on the fastest speed
+ * where every probe read matched. Afterwards every transfer is counted:
+ * when a window of JOYSTICK_SPEED_WINDOW transfers holds more than
+ * JOYSTICK_SPEED_WINDOW_MAX_ERRORS NACKs or short reads, the bus drops to
+ * the next slower speed. Once negotiate() has picked a unit only its
+ * transfers are counted, so a dead unit sharing the bus does not slow the
+ * others down.
+ */
+class JoystickSpeedControl : public JoystickTransport {
+public:
+    JoystickSpeedControl();
+
+    /**
+     * @brief Wrap a transport, the transport must support set_speed()
+     * @param transport initialized transport
+     */
+    void begin(JoystickTransport *transport);
+
+    /**
+     * @brief Find the fastest reliable bus speed for a unit and switch to it
+     * @param addr I2C address of the unit
+     * @param max_speed fastest speed to try
+     * @return selected I2C clock, 0 if the unit does not answer reliably at 100 kHz
+     */
+    uint32_t negotiate(uint8_t addr, uint32_t max_speed = 1000000UL);
+
+    /**
+     * @brief Run a Joystick's bus as fast as the wiring allows
+     *
+     * Wraps the Joystick's transport, negotiates the speed and rebinds the
+     * Joystick to this control, which then drops back a speed whenever the
+     * error rate climbs. On failure the Joystick keeps its own transport at
+     * the speed it had.
+     * @param joystick Joystick initialized on its transport
+     * @param addr I2C address of the unit
+     * @param max_speed fastest speed to try
+     * @return selected I2C clock, 0 if negotiation or the rebind failed
+     */
+    uint32_t attach(Joystick *joystick, uint8_t addr, uint32_t max_speed = 1000000UL);
+
+    /**
+     * @brief Count the probe errors of one speed step
+     * @param addr I2C address of the unit
+     * @param firmware_version expected firmware version
+     * @param count number of probe reads
+     * @return number of failed or mismatching reads
+     */
+    uint32_t probe(uint8_t addr, uint8_t firmware_version, uint32_t count = JOYSTICK_SPEED_PROBE_COUNT);
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override;
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override;
+    uint32_t set_speed(uint32_t speed) override;
+    uint32_t get_speed(void) override;
+
+    /**
+     * @brief Number of runtime speed drops
+     */
+    uint32_t get_downshift_count(void) { return _downshifts; }
+
+    /**
+     * @brief Number of failed transfers (negative result or short read) of the negotiated unit
+     */
+    uint32_t get_error_count(void) { return _errors; }
+
+    /**
+     * @brief Number of transfers through this transport
+     */
+    uint32_t get_transfer_count(void) { return _transfers; }
+
+    /**
+     * @brief Bus speeds tried by negotiate(), slowest first
+     */
+    static const uint32_t speeds[JOYSTICK_SPEED_LEVELS];
+
+private:
+    void record(uint8_t addr, bool ok);
+
+    JoystickTransport *_transport;
+    uint8_t _addr;             // Unit whose errors count, 0 any before negotiate()
+    uint8_t _level;            // Index in speeds[] of the current speed
+    uint32_t _window_count;
+    uint32_t _window_errors;
+    uint32_t _errors;
+    uint32_t _transfers;
+    uint32_t _downshifts;
+};
+
+#endif
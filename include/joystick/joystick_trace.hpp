@@ -0,0 +1,135 @@
+#ifndef _MY_JOYSTICK_TRACE_H_
+#define _MY_JOYSTICK_TRACE_H_
+
+#include <stdint.h>
+#include "joystick.hpp"
+
+#ifndef JOYSTICK_TRACE_WINDOW
+#define JOYSTICK_TRACE_WINDOW 256   // Latencies kept for the percentiles
+#endif
+
+/**
+ * @brief Identity of one input sample
+ */
+typedef struct {
+    uint32_t id;          // 0 no sample
+    uint64_t sample_us;   // Time the sample was read
+} joystick_trace_tag_t;
+
+/**
+ * @brief Input-to-photon latency summary
+ */
+typedef struct {
+    uint32_t frames;      // Frames that carried a tag since the last reset
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} joystick_trace_summary_t;
+
+/**
+ * @brief Input-to-photon latency tracing
+ *
+ * tag() stamps a sample with an ID and its read time. The game passes the
+ * tag of the sample it used to draw_begin() before the draw calls of a frame
+ * and calls draw_end() after them. Every display transfer completing in
+ * between is attributed to the tag through on_transfer(), installed as the
+ * ST7789 HAL transfer callback; the frame latency runs from the sample read
+ * to the end of the last of those transfers. When the last transfer is still
+ * in flight at draw_end(), the frame closes on the next completion, also when
+ * the next frame has begun drawing meanwhile: transfers complete in order, so
+ * that completion is the frame's own. It may arrive in the DMA interrupt, so
+ * the frame is recorded by the next draw_begin(), draw_end() or report call.
+ */
+class JoystickTrace {
+public:
+    JoystickTrace();
+
+    /**
+     * @brief Tag a sample
+     * @param state snapshot read by Joystick::read_state, its timestamp is used
+     * @return tag to carry through the game update
+     */
+    joystick_trace_tag_t tag(const joystick_state_t &state);
+
+    /**
+     * @brief Tag a sample read at the current time
+     */
+    joystick_trace_tag_t tag(void);
+
+    /**
+     * @brief Start the draw calls that show a sample
+     * @param tag tag of the sample used by the game update
+     */
+    void draw_begin(const joystick_trace_tag_t &tag);
+
+    /**
+     * @brief End the draw calls of the frame
+     * @param transfer_pending 1 a display transfer is still in flight (ST7789::isDmaBusy)
+     */
+    void draw_end(bool transfer_pending = false);
+
+    /**
+     * @brief A display transfer has left the SPI bus
+     */
+    void on_transfer(void);
+
+    /**
+     * @brief Adapter for st7789::HAL::setTransferCallback, ctx is the JoystickTrace
+     */
+    static void transfer_callback(void *ctx) { static_cast<JoystickTrace *>(ctx)->on_transfer(); }
+
+    /**
+     * @brief Print one line per finished frame
+     * @param enable 1 print "TRACE frame= id= latency_us=" lines
+     */
+    void set_frame_output(bool enable) { _frame_output = enable; }
+
+    /**
+     * @brief Latency of the last finished frame, 0 none
+     */
+    uint32_t get_last_latency(void);
+
+    /**
+     * @brief Percentiles over the last JOYSTICK_TRACE_WINDOW frames
+     * @param summary pointer of the summary to fill
+     */
+    void get_summary(joystick_trace_summary_t *summary);
+
+    /**
+     * @brief Print "TRACE_SUMMARY frames= p50_us= p90_us= p99_us= max_us="
+     */
+    void print_summary(void);
+
+    /**
+     * @brief Forget the recorded latencies
+     */
+    void reset(void);
+
+private:
+    /**
+     * @brief Frame past draw_end() waiting for its last transfer
+     */
+    typedef struct {
+        joystick_trace_tag_t tag;
+        volatile uint64_t end_us;     // First completion after draw_end(), 0 none yet
+        volatile bool used;
+    } closing_t;
+
+    void finish(const joystick_trace_tag_t &tag, uint64_t end_us);
+    void collect(void);
+
+    uint32_t _next_id;
+    joystick_trace_tag_t _active;     // Tag of the frame being drawn
+    volatile uint64_t _last_transfer_us; // End of the last transfer of the frame being drawn
+    volatile bool _drawing;
+    closing_t _closing[2];            // The previous frame may still drain when the next one ends
+    bool _frame_output;
+    uint32_t _frames;
+    uint32_t _last_us;
+    uint32_t _latencies[JOYSTICK_TRACE_WINDOW];
+    uint32_t _count;                  // Valid entries of _latencies
+    uint32_t _head;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _MY_JOYSTICK_TRANSPORT_H_
+#define _MY_JOYSTICK_TRANSPORT_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Register access interface used by Joystick
+ *
+ * A transport moves register bytes between the driver and a device, it knows
+ * nothing about the Joystick register map. Return values follow the Pico SDK
+ * I2C functions: the number of data bytes on success, a negative
+ * PICO_ERROR_xxx code on failure.
+ */
+class JoystickTransport {
+public:
+    virtual ~JoystickTransport() {}
+
+    /**
+     * @brief Read bytes starting at a device register
+     * @param addr I2C address
+     * @param reg first register
+     * @param buf pointer of the receive buffer
+     * @param nbytes number of bytes to read
+     * @return number of bytes read, negative on error
+     */
+    virtual int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) = 0;
+
+    /**
+     * @brief Write bytes starting at a device register
+     * @param addr I2C address
+     * @param reg first register
+     * @param buf pointer of the data
+     * @param nbytes number of bytes to write
+     * @return number of bytes written, negative on error
+     */
+    virtual int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) = 0;
+
+    /**
+     * @brief Change the bus clock
+     * @param speed requested I2C clock
+     * @return clock actually set, 0 if the transport has no adjustable clock
+     */
+    virtual uint32_t set_speed(uint32_t speed) { (void)speed; return 0; }
+
+    /**
+     * @brief Get the bus clock
+     * @return I2C clock, 0 if unknown
+     */
+    virtual uint32_t get_speed(void) { return 0; }
+};
+
+#endif
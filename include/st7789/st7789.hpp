@@ -35,16 +35,30 @@ public:
     void sleepDisplay(bool sleep);
     
     // Screen clearing
-    void clearScreen(uint16_t color = BLACK) { _gfx.clearScreen(_hal.getConfig().width, _hal.getConfig().height, color); }
+    void clearScreen(uint16_t color = BLACK) { fillScreen(color); }
     
     // DMA related functions
     bool isDmaEnabled() const { return _hal.isDmaEnabled(); }
-    bool isDmaBusy() const { return _hal.isDmaBusy(); }
+    bool isDmaBusy() { return _hal.isDmaBusy(); }
+    bool waitIdle(uint32_t timeout_ms = 1000) { return _hal.waitIdle(timeout_ms); }
     
-    // Efficient drawing functions using DMA
+    // Efficient drawing functions using DMA, both return while the transfer is
+    // still running. drawImageDMA: keep data unchanged until waitIdle()
+    // true once the pixels are sent or queued, without DMA they are sent with
+    // blocking writes. false if nothing was drawn or the transfer failed.
     bool drawImageDMA(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* data);
     bool fillRectDMA(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
     
+    // Framebuffer mode: drawing goes into fb (screen sized) and flush() sends
+    // only its dirty rectangles. nullptr draws straight to the panel again.
+    bool setFrameBuffer(FrameBuffer* fb);
+    FrameBuffer* getFrameBuffer() const { return _gfx.getTarget(); }
+    // Queue the dirty rectangles as DMA transfers and clear them, returns
+    // before they are sent. The next drawing call waits until they are, as
+    // they are read from the buffer in place; write fb directly only after
+    // waitIdle().
+    bool flush();
+    
     // Hardware control
     void setBacklight(bool on);
     void setBrightness(uint8_t brightness);
@@ -56,6 +70,8 @@ public:
     
     // Convenient drawing functions (passed to graphics class)
     void drawPixel(int16_t x, int16_t y, uint16_t color) { _gfx.drawPixel(x, y, color); }
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { _gfx.drawFastHLine(x, y, w, color); }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { _gfx.drawFastVLine(x, y, h, color); }
     void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) { _gfx.drawLine(x0, y0, x1, y1, color); }
     void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { _gfx.drawRect(x, y, w, h, color); }
     void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { _gfx.fillRect(x, y, w, h, color); }
@@ -1,8 +1,7 @@
 #pragma once
 
 #include <cstdint>
-#include "hardware/spi.h"
-#include "hardware/dma.h"
+#include "st7789_platform.hpp"
 
 namespace st7789 {
 
@@ -31,13 +30,15 @@ enum Rotation {
 struct DmaConfig {
     bool enabled;           // Whether DMA is enabled
     uint dma_tx_channel;    // DMA transmit channel
-    size_t buffer_size;     // DMA buffer size
+    size_t buffer_size;     // Unused: DMA reads the pixels in place, kept for source compatibility
+    size_t fill_threshold;  // Fills of at least this many pixels run on DMA
     
     // Constructor with default values
     DmaConfig() :
         enabled(true),      // Enable DMA by default
         dma_tx_channel(0),  // Use channel 0, will be automatically assigned during initialization
-        buffer_size(4096)   // Default 4KB buffer
+        buffer_size(4096),  // Default 4KB buffer
+        fill_threshold(64)  // Shorter spans are cheaper to send from the CPU
     {}
 };
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace st7789 {
+
+// Hardware side of the DMA pipeline: one channel sending 16-bit words to SPI.
+// The device driver wraps an RP2040 DMA channel, the host build a fake engine
+// that completes transfers on the simulated clock.
+class DmaEngine {
+public:
+    virtual ~DmaEngine() {}
+
+    // Start sending count words, DmaPipeline::complete() is called when done.
+    // increment false sends the word at data count times.
+    virtual void start(const uint16_t* data, size_t count, bool increment) = 0;
+    virtual void abort() {}
+
+    // Deliver a finished transfer now if the engine has no interrupt
+    virtual void poll() {}
+    // Called while spinning for a free slot or the end of the queue
+    virtual void wait() {}
+
+    // Keep complete() out of the pipeline state while it is updated
+    virtual void lock() {}
+    virtual void unlock() {}
+};
+
+// Two-slot DMA queue. Pixels are streamed straight from the caller's memory
+// (native uint16_t RGB565, sent as 16-bit SPI frames, no copy or swap): one
+// slot is on the wire while the next write waits in the other. write()
+// returns as soon as its slot is queued and waitIdle() is the fence for the
+// end of the transfer.
+class DmaPipeline {
+public:
+    // Called from complete() each time the queue runs empty
+    typedef void (*DrainCallback)(void* ctx);
+
+private:
+    DmaEngine* _engine;
+    const uint16_t* _data[2];
+    uint16_t _fill[2];              // Color word of a fill, read by DMA
+    bool _increment[2];
+    volatile size_t _count[2];      // Words queued in each slot, 0 free
+    volatile int8_t _sending;       // Slot on the wire, -1 none
+    volatile int8_t _queued;        // Slot ready to follow it, -1 none
+    int8_t _next;                   // Slot the next write uses
+    volatile uint32_t _transfers;      // Writes sent since begin
+    DrainCallback _drain_cb;
+    void* _drain_ctx;
+
+    void submit(int8_t slot, const uint16_t* data, size_t count, bool increment);
+    bool waitFree(int8_t slot, uint32_t timeout_ms);
+
+public:
+    DmaPipeline();
+
+    void begin(DmaEngine* engine);
+    void setDrainCallback(DrainCallback cb, void* ctx) { _drain_cb = cb; _drain_ctx = ctx; }
+
+    // Queue RGB565 pixels. data must stay valid until waitIdle() or the drain
+    // callback. Returns false if no slot freed up in time.
+    bool write(const uint16_t* data, size_t len, uint32_t timeout_ms = 1000);
+    
+    // Queue count pixels of one color: a single word with read increment
+    // off, so any count, up to a full screen, is one transfer
+    bool fill(uint16_t color, size_t count, uint32_t timeout_ms = 1000);
+
+    // Fence: wait until every queued write has been sent
+    bool waitIdle(uint32_t timeout_ms = 1000);
+    bool busy();
+    void abort();
+
+    // Engine completion, from the DMA interrupt on the device
+    void complete();
+
+    uint32_t getTransferCount() const { return _transfers; }
+};
+
+} // namespace st7789
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace st7789 {
+
+// Rectangle with inclusive corners
+struct Rect {
+    int16_t x0, y0, x1, y1;
+
+    int32_t area() const { return (int32_t)(x1 - x0 + 1) * (y1 - y0 + 1); }
+};
+
+// RGB565 frame in RAM plus the regions changed since the last flush.
+//
+// Pixels use the driver's byte order (native uint16_t, see HAL::writePixels),
+// so ST7789::flush() streams rows straight from the buffer. Touched regions
+// are merged as they are marked: a rectangle overlapping or touching a dirty
+// one grows it, and when all MAX_DIRTY slots are used the new region joins
+// the rectangle that grows the least.
+class FrameBuffer {
+public:
+    static const uint8_t MAX_DIRTY = 8;
+
+private:
+    uint16_t* _buffer;
+    bool _owned;                // Allocated by begin()
+    uint16_t _width;
+    uint16_t _height;
+    Rect _dirty[MAX_DIRTY];
+    uint8_t _dirty_count;
+
+    void addDirty(Rect r);
+
+public:
+    FrameBuffer();
+    virtual ~FrameBuffer();
+
+    // buffer holds width * height pixels, nullptr allocates it (150 KB for 240x320)
+    bool begin(uint16_t width, uint16_t height, uint16_t* buffer = nullptr);
+    void end();
+
+    uint16_t* data() { return _buffer; }
+    uint16_t width() const { return _width; }
+    uint16_t height() const { return _height; }
+    uint16_t getPixel(int16_t x, int16_t y) const;
+
+    // Drawing, clipped to the frame, marks the touched region dirty
+    void setPixel(int16_t x, int16_t y, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* data);
+
+    // Dirty regions
+    void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+    void markAllDirty() { markDirty(0, 0, _width - 1, _height - 1); }
+    uint8_t getDirtyCount() const { return _dirty_count; }
+    const Rect& getDirty(uint8_t index) const { return _dirty[index]; }
+    void clearDirty() { _dirty_count = 0; }
+};
+
+} // namespace st7789
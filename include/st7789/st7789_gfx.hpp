@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "st7789_config.hpp"
+#include "st7789_framebuffer.hpp"
 
 namespace st7789 {
 
@@ -12,13 +13,28 @@ class ST7789;
 class Graphics {
 private:
     ST7789* _lcd; // Reference to main LCD class
+    FrameBuffer* _fb; // Render target, nullptr draws to the panel
+    bool _fb_on_wire; // A flush may still be reading _fb
+    
+    // Stream count pixels of one color into the open address window
+    void writeColor(uint16_t color, uint32_t count);
+    // Render target, once the DMA of the last flush has read it
+    FrameBuffer* drawTarget();
     
 public:
     Graphics(ST7789* lcd);
     virtual ~Graphics();
     
+    // Draw into a framebuffer instead of the panel, nullptr to draw directly
+    void setTarget(FrameBuffer* fb) { _fb = fb; }
+    FrameBuffer* getTarget() const { return _fb; }
+    // The target is being sent, the next drawing call waits for it
+    void markFlushed() { _fb_on_wire = true; }
+    
     // Basic drawing functions
     void drawPixel(int16_t x, int16_t y, uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);  // One address window per span
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
     void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
     void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
     void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
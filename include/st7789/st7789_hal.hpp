@@ -1,29 +1,45 @@
 #pragma once
 
 #include <cstdint>
-#include "hardware/spi.h"
-#include "hardware/dma.h"
+#include "st7789_platform.hpp"
 #include "st7789_config.hpp"
+#include "st7789_dma.hpp"
 
 namespace st7789 {
 
 // Hardware Abstraction Layer class - handles all hardware-related operations
 class HAL {
+public:
+    // Called when pixels (writePixels, or the DMA queue draining) have left the SPI bus.
+    // Commands and parameters such as the address window do not count. For DMA
+    // transfers it runs in the DMA completion interrupt.
+    typedef void (*TransferCallback)(void* ctx);
+    
 private:
     Config _config;
     bool _initialized;
     
+    // Transfer accounting
+    TransferCallback _transfer_cb;
+    void* _transfer_ctx;
+    uint64_t _spi_bytes;
+    
+    // SPI frame size: 8 bits for commands and parameters, 16 bits for pixels
+    uint8_t _spi_bits;
+    
     // DMA related members
     int _dma_tx_channel;
-    uint16_t* _dma_buffer;
-    size_t _dma_buffer_size;
     bool _dma_enabled;
-    bool _dma_busy;
+    bool _dma_selected;             // CS held low and D/C high for queued DMA data
+    DmaPipeline _dma;
     
     // Private methods
     void initDma();
     void cleanupDma();
-    bool waitForDmaComplete(uint32_t timeout_ms = 1000);
+    void setFrameBits(uint8_t bits);
+    void beginDmaData();
+    void transferComplete();
+    static void dmaDrained(void* ctx);
     
 public:
     HAL();
@@ -37,12 +53,34 @@ public:
     void writeData(uint8_t data);
     void writeDataBulk(const uint8_t* data, size_t len);
     
-    // DMA operations
+    // Pixel data: native uint16_t RGB565, sent MSB first as 16-bit SPI frames.
+    // This is the only pixel byte order of the driver, no swapping anywhere.
+    void writePixels(const uint16_t* data, size_t len);
+    
+    // DMA operations. writeDataDma streams the pixels in place and returns once
+    // they are queued, data must stay valid until waitIdle(). The other IO
+    // operations wait for the queue first and then release CS. Without DMA
+    // the pixels are sent with blocking writes. false if the transfer failed.
     bool writeDataDma(const uint16_t* data, size_t len);
-    bool isDmaBusy() const { return _dma_busy; }
+    // count pixels of one color as a single DMA transfer, returns before it
+    // ends. false if DMA is not available or timed out.
+    bool fillDma(uint16_t color, size_t count);
+    bool waitIdle(uint32_t timeout_ms = 1000);
+    bool isDmaBusy() { return _dma.busy(); }
     bool isDmaEnabled() const { return _dma_enabled; }
     void abortDma();
     
+    // Transfer completion hook, e.g. for input-to-photon tracing
+    void setTransferCallback(TransferCallback cb, void* ctx) { _transfer_cb = cb; _transfer_ctx = ctx; }
+    
+    // Bytes sent over SPI (commands, parameters and pixels) since init
+    uint64_t getSpiBytes() const { return _spi_bytes; }
+    
+#ifdef ST7789_HOST
+    // Host build: pixel the simulated panel holds at x, y
+    uint16_t getPanelPixel(uint16_t x, uint16_t y) const;
+#endif
+    
     // Hardware control
     void reset();
     void setBacklight(bool on);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Platform types and time used by the ST7789 driver.
+//
+// The device build maps them to the Pico SDK. The host build (ST7789_HOST,
+// set by the JOYSTICK_HOST_BUILD CMake option) replaces the SPI and DMA
+// hardware with st7789_hal_host.cpp: transfers only advance the simulated
+// clock shared with the Joystick host build.
+#ifdef ST7789_HOST
+
+typedef unsigned int uint;
+typedef struct spi_inst spi_inst_t;   // Never dereferenced on the host
+#define spi0 ((spi_inst_t*)0)
+#define spi1 ((spi_inst_t*)1)
+
+namespace st7789 {
+uint64_t platformTimeUs();
+void platformSleepUs(uint64_t us);
+// Simulated interrupt of the fake DMA engine, nullptr cb disarms it
+void platformSetAlarm(uint64_t at_us, void (*cb)(void* ctx), void* ctx);
+}
+
+#else
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+
+namespace st7789 {
+inline uint64_t platformTimeUs() { return time_us_64(); }
+inline void platformSleepUs(uint64_t us) { sleep_us(us); }
+}
+
+#endif
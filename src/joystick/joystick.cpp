@@ -1,92 +1,130 @@
-
 #include "joystick.hpp"
-#include "hardware/i2c.h"
-#include "pico/stdlib.h"
 #include <cstring> // For memcpy
 
-// Helper function for reading bytes from a specific register
-static inline int reg_read(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) {
-    // Send the register address we want to read from
-    int ret = i2c_write_blocking(i2c, addr, &reg, 1, true); // true to keep control of bus
-    if (ret < 0) {
-        return ret;
+Joystick::Joystick() :
+    _transport(nullptr),
+    _addr(JOYSTICK_ADDR),
+    _status(JOYSTICK_OK),
+    _read_stats(),
+    _write_stats()
+{
+}
+
+joystick_status_t Joystick::account(joystick_stats_t &stats, int ret, uint8_t nbytes)
+{
+    if (ret == nbytes) {
+        stats.ok++;
+        return JOYSTICK_OK;
+    }
+    if (ret >= 0) {
+        stats.short_xfer++;
+        return JOYSTICK_ERROR_SHORT;
     }
-    // Read the data from the register
-    ret = i2c_read_blocking(i2c, addr, buf, nbytes, false); // false to release bus
+    if (ret == PICO_ERROR_TIMEOUT) {
+        stats.timeout++;
+        return JOYSTICK_ERROR_TIMEOUT;
+    }
+    stats.nack++;
+    return JOYSTICK_ERROR_NACK;
+}
+
+int Joystick::read_regs(uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+#if JOYSTICK_LATENCY_PROFILE
+    uint64_t start = joystick_time_us();
+#endif
+    int ret = _transport ? _transport->read_reg(_addr, reg, buf, nbytes) : PICO_ERROR_GENERIC;
+#if JOYSTICK_LATENCY_PROFILE
+    _latency.add(reg, (uint32_t)(joystick_time_us() - start));
+#endif
+    _status = account(_read_stats, ret, nbytes);
     return ret;
 }
 
-// Helper function for writing bytes to a specific register
-static inline int reg_write(i2c_inst_t *i2c, uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) {
-    uint8_t msg[nbytes + 1];
-    // First byte is the register address
-    msg[0] = reg;
-    // Copy data bytes
-    memcpy(msg + 1, buf, nbytes);
-    // Write the register address followed by the data
-    int ret = i2c_write_blocking(i2c, addr, msg, nbytes + 1, false); // false to release bus
+int Joystick::write_regs(uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+#if JOYSTICK_LATENCY_PROFILE
+    uint64_t start = joystick_time_us();
+#endif
+    int ret = _transport ? _transport->write_reg(_addr, reg, buf, nbytes) : PICO_ERROR_GENERIC;
+#if JOYSTICK_LATENCY_PROFILE
+    _latency.add(reg, (uint32_t)(joystick_time_us() - start));
+#endif
+    _status = account(_write_stats, ret, nbytes);
     return ret;
 }
 
+bool Joystick::read_bursts(const joystick_burst_t *bursts, uint8_t count, uint8_t *buf)
+{
+    // Stop at the first failed burst, so _status is its error
+    for (uint8_t i = 0; i < count; i++) {
+        if (read_regs(bursts[i].reg, &buf[bursts[i].offset], bursts[i].len) != bursts[i].len) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compile-time checks of the burst planner
+static_assert(JoystickReadPlan<JoystickRegOffset12X, JoystickRegOffset12Y>::plan.burst_count == 1,
+              "offset x/y must be one burst");
+static_assert(JoystickReadPlan<JoystickRegOffset12Y, JoystickRegOffset12X>::plan.field_offset[0] == 2,
+              "fields are placed by register address, not request order");
+static_assert(JoystickReadPlan<JoystickRegOffset12X, JoystickRegOffset12Y, JoystickRegButton>::plan.burst_count == 2,
+              "offset x/y plus button must be two bursts");
+static_assert(JoystickReadPlan<JoystickRegCal<0>, JoystickRegCal<2>>::plan.size == 6,
+              "a gap of up to JOYSTICK_BURST_MAX_GAP registers is read through");
+static_assert(JoystickReadPlan<JoystickRegAdc8X, JoystickRegOffset8X>::plan.burst_count == 2,
+              "distant fields must not be merged");
+
+void Joystick::reset_stats(void)
+{
+    _read_stats  = joystick_stats_t();
+    _write_stats = joystick_stats_t();
+}
+
+#ifndef JOYSTICK_HOST
 bool Joystick::begin(i2c_inst_t *i2c_port, uint8_t addr, uint sda_pin, uint scl_pin, uint32_t speed)
 {
-    _i2c_port = i2c_port;
-    _addr     = addr;
-    _sda_pin  = sda_pin;
-    _scl_pin  = scl_pin;
-    _speed    = speed;
+    _addr = addr;
 
-    // Initialize I2C port at requested speed
-    i2c_init(_i2c_port, _speed);
+    // Initialize I2C port and pins at requested speed
+    _i2c.init(i2c_port, sda_pin, scl_pin, speed);
+    _transport = &_i2c;
 
-    // Initialize I2C pins
-    gpio_set_function(_sda_pin, GPIO_FUNC_I2C);
-    gpio_set_function(_scl_pin, GPIO_FUNC_I2C);
-    gpio_pull_up(_sda_pin);
-    gpio_pull_up(_scl_pin);
+    joystick_sleep_ms(10);
 
-    sleep_ms(10);
+    return _i2c.probe(_addr);
+}
+#endif
+
+bool Joystick::begin(JoystickTransport *transport, uint8_t addr)
+{
+    _transport = transport;
+    _addr      = addr;
 
-    // Check device presence by trying to write nothing (just address)
-    uint8_t dummy_byte; // A dummy byte to satisfy write function, won't be sent
-    int ret = i2c_write_blocking(_i2c_port, _addr, &dummy_byte, 0, false);
+    // Check device presence by reading a register every firmware provides
+    uint8_t version;
+    int ret = read_regs(JOYSTICK_FIRMWARE_VERSION_REG, &version, 1);
 
-    return (ret >= 0); // Returns PICO_ERROR_GENERIC (-1) if NACK received (no device)
+    return (ret == 1);
 }
 
 uint16_t Joystick::get_joy_adc_value_x(adc_mode_t adc_bits)
 {
-    uint8_t data[2];
-    uint16_t value = 0;
-    int ret;
-
     if (adc_bits == ADC_16BIT_RESULT) {
-        uint8_t reg = JOYSTICK_ADC_VALUE_12BITS_REG; // Reads X and Y together
-        uint8_t temp_data[4];
-        ret = reg_read(_i2c_port, _addr, reg, temp_data, 4);
-        if (ret == 4) {
-             memcpy(&value, &temp_data[0], 2); // Extract X value
-        }
-    } else if (adc_bits == ADC_8BIT_RESULT) {
-        uint8_t reg = JOYSTICK_ADC_VALUE_8BITS_REG; // Reads X and Y together
-        uint8_t temp_data[2];
-        ret = reg_read(_i2c_port, _addr, reg, temp_data, 2);
-        if (ret == 2) {
-            value = temp_data[0]; // Extract X value
-        }
+        uint16_t value = 0;
+        read<JoystickRegAdc16X>(value);
+        return value;
     }
+    uint8_t value = 0;
+    read<JoystickRegAdc8X>(value);
     return value;
 }
 
 void Joystick::get_joy_adc_16bits_value_xy(uint16_t *adc_x, uint16_t *adc_y)
 {
-    uint8_t data[4];
-    uint8_t reg = JOYSTICK_ADC_VALUE_12BITS_REG;
-    int ret = reg_read(_i2c_port, _addr, reg, data, 4);
-    if (ret == 4) {
-        memcpy(adc_x, &data[0], 2);
-        memcpy(adc_y, &data[2], 2);
-    } else {
+    if (!read<JoystickRegAdc16X, JoystickRegAdc16Y>(*adc_x, *adc_y)) {
         *adc_x = 0;
         *adc_y = 0;
     }
@@ -94,13 +132,7 @@ void Joystick::get_joy_adc_16bits_value_xy(uint16_t *adc_x, uint16_t *adc_y)
 
 void Joystick::get_joy_adc_8bits_value_xy(uint8_t *adc_x, uint8_t *adc_y)
 {
-    uint8_t data[2];
-    uint8_t reg = JOYSTICK_ADC_VALUE_8BITS_REG;
-    int ret = reg_read(_i2c_port, _addr, reg, data, 2);
-     if (ret == 2) {
-        *adc_x = data[0];
-        *adc_y = data[1];
-    } else {
+    if (!read<JoystickRegAdc8X, JoystickRegAdc8Y>(*adc_x, *adc_y)) {
         *adc_x = 0;
         *adc_y = 0;
     }
@@ -108,57 +140,41 @@ void Joystick::get_joy_adc_8bits_value_xy(uint8_t *adc_x, uint8_t *adc_y)
 
 uint16_t Joystick::get_joy_adc_value_y(adc_mode_t adc_bits)
 {
-    uint8_t data[2];
-    uint16_t value = 0;
-    int ret;
-
     if (adc_bits == ADC_16BIT_RESULT) {
-        uint8_t reg = JOYSTICK_ADC_VALUE_12BITS_REG; // Reads X and Y together
-        uint8_t temp_data[4];
-        ret = reg_read(_i2c_port, _addr, reg, temp_data, 4);
-        if (ret == 4) {
-             memcpy(&value, &temp_data[2], 2); // Extract Y value
-        }
-    } else if (adc_bits == ADC_8BIT_RESULT) {
-        uint8_t reg = JOYSTICK_ADC_VALUE_8BITS_REG; // Reads X and Y together
-        uint8_t temp_data[2];
-        ret = reg_read(_i2c_port, _addr, reg, temp_data, 2);
-        if (ret == 2) {
-            value = temp_data[1]; // Extract Y value
-        }
+        uint16_t value = 0;
+        read<JoystickRegAdc16Y>(value);
+        return value;
     }
+    uint8_t value = 0;
+    read<JoystickRegAdc8Y>(value);
     return value;
 }
 
 int16_t Joystick::get_joy_adc_12bits_offset_value_x(void)
 {
     int16_t value = 0;
-    uint8_t reg = JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG;
-    reg_read(_i2c_port, _addr, reg, (uint8_t *)&value, 2);
+    read<JoystickRegOffset12X>(value);
     return value;
 }
 
 int16_t Joystick::get_joy_adc_12bits_offset_value_y(void)
 {
     int16_t value = 0;
-    uint8_t reg = JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 2;
-    reg_read(_i2c_port, _addr, reg, (uint8_t *)&value, 2);
+    read<JoystickRegOffset12Y>(value);
     return value;
 }
 
 int8_t Joystick::get_joy_adc_8bits_offset_value_x(void)
 {
     int8_t value = 0;
-    uint8_t reg = JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG;
-    reg_read(_i2c_port, _addr, reg, (uint8_t *)&value, 1);
+    read<JoystickRegOffset8X>(value);
     return value;
 }
 
 int8_t Joystick::get_joy_adc_8bits_offset_value_y(void)
 {
     int8_t value = 0;
-    uint8_t reg = JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG + 1;
-    reg_read(_i2c_port, _addr, reg, (uint8_t *)&value, 1);
+    read<JoystickRegOffset8Y>(value);
     return value;
 }
 
@@ -166,88 +182,126 @@ void Joystick::set_joy_adc_value_cal(uint16_t x_neg_min, uint16_t x_neg_max, uin
                                  uint16_t x_pos_max, uint16_t y_neg_min, uint16_t y_neg_max,
                                  uint16_t y_pos_min, uint16_t y_pos_max)
 {
+    // The eight words are contiguous, write them in one transaction
     uint8_t data[16];
-    memcpy(&data[0], (uint8_t *)&x_neg_min, 2);
-    memcpy(&data[2], (uint8_t *)&x_neg_max, 2);
-    memcpy(&data[4], (uint8_t *)&x_pos_min, 2);
-    memcpy(&data[6], (uint8_t *)&x_pos_max, 2);
-    memcpy(&data[8], (uint8_t *)&y_neg_min, 2);
-    memcpy(&data[10], (uint8_t *)&y_neg_max, 2);
-    memcpy(&data[12], (uint8_t *)&y_pos_min, 2);
-    memcpy(&data[14], (uint8_t *)&y_pos_max, 2);
+    JoystickRegCal<0>::encode(x_neg_min, &data[0]);
+    JoystickRegCal<1>::encode(x_neg_max, &data[2]);
+    JoystickRegCal<2>::encode(x_pos_min, &data[4]);
+    JoystickRegCal<3>::encode(x_pos_max, &data[6]);
+    JoystickRegCal<4>::encode(y_neg_min, &data[8]);
+    JoystickRegCal<5>::encode(y_neg_max, &data[10]);
+    JoystickRegCal<6>::encode(y_pos_min, &data[12]);
+    JoystickRegCal<7>::encode(y_pos_max, &data[14]);
 
-    reg_write(_i2c_port, _addr, JOYSTICK_ADC_VALUE_CAL_REG, data, 16);
+    write_regs(JOYSTICK_ADC_VALUE_CAL_REG, data, 16);
 }
 
 void Joystick::get_joy_adc_value_cal(uint16_t *x_neg_min, uint16_t *x_neg_max, uint16_t *x_pos_min,
                                  uint16_t *x_pos_max, uint16_t *y_neg_min, uint16_t *y_neg_max,
                                  uint16_t *y_pos_min, uint16_t *y_pos_max)
 {
-    uint8_t data[16];
-    int ret = reg_read(_i2c_port, _addr, JOYSTICK_ADC_VALUE_CAL_REG, data, 16);
-    if (ret == 16) {
-        memcpy((uint8_t *)x_neg_min, &data[0], 2);
-        memcpy((uint8_t *)x_neg_max, &data[2], 2);
-        memcpy((uint8_t *)x_pos_min, &data[4], 2);
-        memcpy((uint8_t *)x_pos_max, &data[6], 2);
-        memcpy((uint8_t *)y_neg_min, &data[8], 2);
-        memcpy((uint8_t *)y_neg_max, &data[10], 2);
-        memcpy((uint8_t *)y_pos_min, &data[12], 2);
-        memcpy((uint8_t *)y_pos_max, &data[14], 2);
-    } else {
+    bool ok = read<JoystickRegCal<0>, JoystickRegCal<1>, JoystickRegCal<2>, JoystickRegCal<3>,
+                   JoystickRegCal<4>, JoystickRegCal<5>, JoystickRegCal<6>, JoystickRegCal<7>>(
+        *x_neg_min, *x_neg_max, *x_pos_min, *x_pos_max, *y_neg_min, *y_neg_max, *y_pos_min, *y_pos_max);
+    if (!ok) {
         // Handle error by zeroing out the values
-        memset(x_neg_min, 0, sizeof(uint16_t) * 8); // Zero out all params
+        *x_neg_min = *x_neg_max = *x_pos_min = *x_pos_max = 0;
+        *y_neg_min = *y_neg_max = *y_pos_min = *y_pos_max = 0;
     }
 }
 
+bool Joystick::read_state(joystick_state_t *state, uint8_t fields)
+{
+    state->fields = 0;
+    state->timestamp_us = joystick_time_us();
+
+    // The first failed burst is the status of the call, a later success must not hide it
+    joystick_status_t status = JOYSTICK_OK;
+    if (fields & JOYSTICK_STATE_RAW) {
+        if (read<JoystickRegAdc16X, JoystickRegAdc16Y>(state->adc_x, state->adc_y)) {
+            state->fields |= JOYSTICK_STATE_RAW;
+        } else {
+            status = _status;
+        }
+    }
+    if (fields & JOYSTICK_STATE_OFFSET) {
+        if (read<JoystickRegOffset12X, JoystickRegOffset12Y>(state->offset_x, state->offset_y)) {
+            state->fields |= JOYSTICK_STATE_OFFSET;
+        } else if (status == JOYSTICK_OK) {
+            status = _status;
+        }
+    }
+    if (fields & JOYSTICK_STATE_BUTTON) {
+        if (read<JoystickRegButton>(state->button)) {
+            state->fields |= JOYSTICK_STATE_BUTTON;
+        } else if (status == JOYSTICK_OK) {
+            status = _status;
+        }
+    }
+    _status = status;
+
+    // Fields that could not be read keep the same defaults as the single getters
+    if (!(state->fields & JOYSTICK_STATE_RAW)) {
+        state->adc_x = 0;
+        state->adc_y = 0;
+    }
+    if (!(state->fields & JOYSTICK_STATE_OFFSET)) {
+        state->offset_x = 0;
+        state->offset_y = 0;
+    }
+    if (!(state->fields & JOYSTICK_STATE_BUTTON)) {
+        state->button = 1;
+    }
+
+    return (state->fields & fields) == (fields & JOYSTICK_STATE_ALL);
+}
+
 uint8_t Joystick::get_button_value(void)
 {
     uint8_t data = 1; // Default to not pressed
-    uint8_t reg = JOYSTICK_BUTTON_REG;
-    reg_read(_i2c_port, _addr, reg, &data, 1);
+    read<JoystickRegButton>(data);
     return data;
 }
 
 void Joystick::set_rgb_color(uint32_t color)
 {
     // Color is sent as R, G, B, Brightness (4 bytes)
-    reg_write(_i2c_port, _addr, JOYSTICK_RGB_REG, (uint8_t *)&color, 4);
+    write<JoystickRegRgb>(color);
 }
 
 uint32_t Joystick::get_rgb_color(void)
 {
     uint32_t rgb_read_buff = 0;
-    reg_read(_i2c_port, _addr, JOYSTICK_RGB_REG, (uint8_t *)&rgb_read_buff, 4);
+    read<JoystickRegRgb>(rgb_read_buff);
     return rgb_read_buff;
 }
 
 uint8_t Joystick::get_firmware_version(void)
 {
     uint8_t reg_value = 0;
-    reg_read(_i2c_port, _addr, JOYSTICK_FIRMWARE_VERSION_REG, &reg_value, 1);
+    read<JoystickRegFirmware>(reg_value);
     return reg_value;
 }
 
 uint8_t Joystick::get_bootloader_version(void)
 {
     uint8_t reg_value = 0;
-    reg_read(_i2c_port, _addr, JOYSTICK_BOOTLOADER_VERSION_REG, &reg_value, 1);
+    read<JoystickRegBootloader>(reg_value);
     return reg_value;
 }
 
 uint8_t Joystick::get_i2c_address(void)
 {
     uint8_t reg_value = 0;
-    reg_read(_i2c_port, _addr, JOYSTICK_I2C_ADDRESS_REG, &reg_value, 1);
+    read<JoystickRegAddress>(reg_value);
     return reg_value;
 }
 
 uint8_t Joystick::set_i2c_address(uint8_t new_addr)
 {
-    int ret = reg_write(_i2c_port, _addr, JOYSTICK_I2C_ADDRESS_REG, &new_addr, 1);
-    if (ret > 0) {
+    if (write<JoystickRegAddress>(new_addr)) {
         _addr = new_addr;
         return 1;
     }
     return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,204 @@
+#include "joystick_async_i2c.hpp"
+#include "hardware/irq.h"
+
+#define I2C_FIFO_DEPTH 16
+
+// Interrupt handlers take no argument, keep one instance per I2C block here
+static JoystickAsyncI2C *async_i2c_instances[2] = {nullptr, nullptr};
+
+JoystickAsyncI2C::JoystickAsyncI2C() :
+    _i2c_port(nullptr),
+    _sda_pin(0),
+    _scl_pin(0),
+    _speed(0),
+    _tx_index(0),
+    _rx_index(0),
+    _aborted(false)
+{
+}
+
+JoystickAsyncI2C::~JoystickAsyncI2C()
+{
+    deinit();
+}
+
+bool JoystickAsyncI2C::init(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed)
+{
+    uint index = i2c_hw_index(i2c_port);
+    if (async_i2c_instances[index] != nullptr && async_i2c_instances[index] != this) {
+        return false;
+    }
+
+    _i2c_port = i2c_port;
+    _sda_pin  = sda_pin;
+    _scl_pin  = scl_pin;
+    clear();
+
+    // Initialize I2C port at requested speed
+    _speed = i2c_init(_i2c_port, speed);
+
+    // Initialize I2C pins
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+
+    // Interrupt on every received byte and when the TX FIFO is empty
+    i2c_hw_t *hw = i2c_get_hw(_i2c_port);
+    hw->intr_mask = 0;
+    hw->rx_tl = 0;
+    hw->tx_tl = 0;
+
+    async_i2c_instances[index] = this;
+    uint irq = I2C0_IRQ + index;
+    irq_set_exclusive_handler(irq, index ? irq_handler_i2c1 : irq_handler_i2c0);
+    irq_set_enabled(irq, true);
+    return true;
+}
+
+void JoystickAsyncI2C::deinit(void)
+{
+    if (_i2c_port == nullptr) {
+        return;
+    }
+    uint index = i2c_hw_index(_i2c_port);
+    uint irq = I2C0_IRQ + index;
+
+    i2c_get_hw(_i2c_port)->intr_mask = 0;
+    irq_set_enabled(irq, false);
+    irq_remove_handler(irq, index ? irq_handler_i2c1 : irq_handler_i2c0);
+    async_i2c_instances[index] = nullptr;
+
+    clear();
+    _i2c_port = nullptr;
+}
+
+void JoystickAsyncI2C::bus_start(transfer_t &t)
+{
+    i2c_hw_t *hw = i2c_get_hw(_i2c_port);
+    _tx_index = 0;
+    _rx_index = 0;
+    _aborted  = false;
+
+    // Target address can only be changed while the block is disabled
+    hw->enable = 0;
+    hw->tar    = t.addr;
+    hw->enable = 1;
+    (void)hw->clr_intr;
+
+    fill_tx_fifo();
+    hw->intr_mask = I2C_IC_INTR_MASK_M_RX_FULL_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS |
+                    I2C_IC_INTR_MASK_M_STOP_DET_BITS |
+                    (_tx_index < t.nbytes + 1 ? I2C_IC_INTR_MASK_M_TX_EMPTY_BITS : 0);
+}
+
+void JoystickAsyncI2C::bus_stop(void)
+{
+    i2c_hw_t *hw = i2c_get_hw(_i2c_port);
+    hw->intr_mask = 0;
+    hw->enable = 0;
+}
+
+void JoystickAsyncI2C::bus_recover(void)
+{
+    _speed = joystick_i2c_recover_bus(_i2c_port, _sda_pin, _scl_pin, _speed);
+    i2c_hw_t *hw = i2c_get_hw(_i2c_port);
+    hw->intr_mask = 0;
+    hw->rx_tl = 0;
+    hw->tx_tl = 0;
+}
+
+void JoystickAsyncI2C::fill_tx_fifo(void)
+{
+    i2c_hw_t *hw = i2c_get_hw(_i2c_port);
+    transfer_t &t = active_transfer();
+    uint8_t total = t.nbytes + 1; // Register byte followed by the data phase
+
+    while (_tx_index < total && hw->txflr < I2C_FIFO_DEPTH) {
+        bool last = (_tx_index == total - 1);
+        uint32_t cmd;
+        if (_tx_index == 0) {
+            // Register address, a write without data ends here
+            cmd = t.reg | (last ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+        } else if (t.is_read) {
+            // Read commands, repeated start before the first one
+            cmd = I2C_IC_DATA_CMD_CMD_BITS |
+                  (_tx_index == 1 ? I2C_IC_DATA_CMD_RESTART_BITS : 0) |
+                  (last ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+        } else {
+            cmd = t.data[_tx_index - 1] | (last ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+        }
+        hw->data_cmd = cmd;
+        _tx_index++;
+    }
+}
+
+void JoystickAsyncI2C::handle_irq(void)
+{
+    i2c_hw_t *hw = i2c_get_hw(_i2c_port);
+    uint32_t status = hw->intr_stat;
+    if (!is_busy()) {
+        hw->intr_mask = 0;
+        return;
+    }
+    transfer_t &t = active_transfer();
+
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // NACK or arbitration lost, the controller flushes the FIFO and sends STOP
+        (void)hw->clr_tx_abrt;
+        _aborted = true;
+    }
+
+    while (hw->rxflr > 0) {
+        uint8_t byte = (uint8_t)hw->data_cmd;
+        if (t.is_read && _rx_index < t.nbytes) {
+            t.data[_rx_index++] = byte;
+        }
+    }
+
+    if ((status & I2C_IC_INTR_STAT_R_TX_EMPTY_BITS) && !_aborted) {
+        fill_tx_fifo();
+        if (_tx_index >= t.nbytes + 1) {
+            hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+        }
+    }
+
+    if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        if (_aborted) {
+            finish_active(PICO_ERROR_GENERIC);
+        } else if (t.is_read) {
+            finish_active(_rx_index); // Short read if less than nbytes
+        } else {
+            finish_active(_tx_index > 0 ? _tx_index - 1 : 0);
+        }
+    }
+}
+
+uint32_t JoystickAsyncI2C::set_speed(uint32_t speed)
+{
+    if (_i2c_port == nullptr) {
+        return 0;
+    }
+    // The clock registers can only be written while the block is idle
+    while (!is_idle()) {
+        poll();
+        tight_loop_contents();
+    }
+    _speed = i2c_set_baudrate(_i2c_port, speed);
+    return _speed;
+}
+
+void JoystickAsyncI2C::irq_handler_i2c0(void)
+{
+    if (async_i2c_instances[0]) {
+        async_i2c_instances[0]->handle_irq();
+    }
+}
+
+void JoystickAsyncI2C::irq_handler_i2c1(void)
+{
+    if (async_i2c_instances[1]) {
+        async_i2c_instances[1]->handle_irq();
+    }
+}
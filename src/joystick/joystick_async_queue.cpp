@@ -0,0 +1,174 @@
+#include "joystick_async_queue.hpp"
+#include <cstring> // For memcpy
+
+JoystickAsyncQueue::JoystickAsyncQueue() :
+    _failures(0),
+    _recover(false),
+    _recoveries(0),
+    _submit(0),
+    _active(0),
+    _complete(0),
+    _busy(false)
+{
+}
+
+void JoystickAsyncQueue::clear(void)
+{
+    _submit = _active = _complete = 0;
+    _busy = false;
+}
+
+bool JoystickAsyncQueue::begin_read(uint8_t addr, uint8_t reg, uint8_t nbytes, joystick_transfer_cb_t cb, void *ctx)
+{
+    return submit(addr, reg, nullptr, nbytes, true, cb, ctx);
+}
+
+bool JoystickAsyncQueue::begin_write(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes,
+                                     joystick_transfer_cb_t cb, void *ctx)
+{
+    return submit(addr, reg, buf, nbytes, false, cb, ctx);
+}
+
+bool JoystickAsyncQueue::submit(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes, bool is_read,
+                                joystick_transfer_cb_t cb, void *ctx)
+{
+    if (!bus_ready() || nbytes > JOYSTICK_ASYNC_MAX_DATA || (is_read && nbytes == 0)) {
+        return false;
+    }
+    if (_submit - _complete >= JOYSTICK_ASYNC_QUEUE_SIZE) {
+        return false; // Queue full
+    }
+
+    transfer_t &t = _queue[_submit % JOYSTICK_ASYNC_QUEUE_SIZE];
+    t.addr    = addr;
+    t.reg     = reg;
+    t.nbytes  = nbytes;
+    t.is_read = is_read;
+    t.cb      = cb;
+    t.ctx     = ctx;
+    t.result  = PICO_ERROR_GENERIC;
+    if (!is_read && nbytes > 0) {
+        memcpy(t.data, buf, nbytes);
+    }
+
+    uint32_t state = lock();
+    _submit = _submit + 1;
+    if (!_busy && !_recover) {
+        start_next();
+    }
+    unlock(state);
+    return true;
+}
+
+// Called with lock() held or from finish_active()
+void JoystickAsyncQueue::start_next(void)
+{
+    if (_active == _submit) {
+        _busy = false;
+        bus_stop();
+        return;
+    }
+
+    transfer_t &t = _queue[_active % JOYSTICK_ASYNC_QUEUE_SIZE];
+    t.start_us = joystick_time_us();
+    _busy = true;
+    bus_start(t);
+}
+
+void JoystickAsyncQueue::finish_active(int result)
+{
+    _queue[_active % JOYSTICK_ASYNC_QUEUE_SIZE].result = result;
+    _active = _active + 1;
+    _busy = false;
+    // Timeouts and NACKs both count, poll() recovers the bus before the next transfer
+    if (result >= 0) {
+        _failures = 0;
+    } else if (++_failures >= JOYSTICK_ASYNC_RECOVERY_THRESHOLD) {
+        _recover = true;
+    }
+    if (!_recover) {
+        start_next();
+    }
+}
+
+uint32_t JoystickAsyncQueue::poll(void)
+{
+    if (!bus_ready()) {
+        return 0;
+    }
+
+    // Abort a transfer the device never finished (clock stretching, stuck bus)
+    uint32_t state = lock();
+    if (_busy) {
+        transfer_t &t = _queue[_active % JOYSTICK_ASYNC_QUEUE_SIZE];
+        if (joystick_time_us() - t.start_us > JOYSTICK_ASYNC_TIMEOUT_US) {
+            bus_stop();
+            finish_active(PICO_ERROR_TIMEOUT);
+        }
+    }
+    if (_recover) {
+        // A device may hold SDA low, free the bus before the next transfer
+        bus_recover();
+        _failures = 0;
+        _recover = false;
+        _recoveries++;
+        start_next();
+    }
+    unlock(state);
+
+    uint32_t dispatched = 0;
+    while (_complete != _active) {
+        transfer_t &t = _queue[_complete % JOYSTICK_ASYNC_QUEUE_SIZE];
+        if (t.cb != nullptr) {
+            t.cb(t.ctx, t.result, t.data, t.nbytes);
+        }
+        _complete = _complete + 1;
+        dispatched++;
+    }
+    return dispatched;
+}
+
+struct blocking_transfer_t {
+    uint8_t *buf;
+    volatile bool done;
+    int result;
+};
+
+static void blocking_transfer_done(void *ctx, int result, const uint8_t *data, uint8_t nbytes)
+{
+    blocking_transfer_t *bt = (blocking_transfer_t *)ctx;
+    if (bt->buf != nullptr && result > 0) {
+        memcpy(bt->buf, data, (uint8_t)result <= nbytes ? (uint8_t)result : nbytes);
+    }
+    bt->result = result;
+    bt->done = true;
+}
+
+int JoystickAsyncQueue::run_blocking(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes, bool is_read)
+{
+    if (!bus_ready() || nbytes > JOYSTICK_ASYNC_MAX_DATA || (is_read && nbytes == 0)) {
+        return PICO_ERROR_GENERIC;
+    }
+    blocking_transfer_t bt = {is_read ? buf : nullptr, false, PICO_ERROR_GENERIC};
+    // Wait for a free slot, every queued transfer is bounded by the timeout
+    while (!submit(addr, reg, buf, nbytes, is_read, blocking_transfer_done, &bt)) {
+        poll();
+        wait();
+    }
+    // Transfers queued earlier are dispatched first, poll() bounds the wait
+    while (!bt.done) {
+        poll();
+        wait();
+    }
+    return bt.result;
+}
+
+int JoystickAsyncQueue::read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    return run_blocking(addr, reg, buf, nbytes, true);
+}
+
+int JoystickAsyncQueue::write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    return run_blocking(addr, reg, (uint8_t *)buf, nbytes, false);
+}
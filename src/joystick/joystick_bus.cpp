@@ -0,0 +1,120 @@
+#include "joystick_bus.hpp"
+
+JoystickBus::JoystickBus() : _transport(nullptr), _count(0), _next(0)
+{
+}
+
+#ifndef JOYSTICK_HOST
+void JoystickBus::begin(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed)
+{
+    _i2c.init(i2c_port, sda_pin, scl_pin, speed);
+    _transport = &_i2c;
+    joystick_sleep_ms(10);
+}
+#endif
+
+void JoystickBus::begin(JoystickTransport *transport)
+{
+    _transport = transport;
+}
+
+int JoystickBus::add_device(uint8_t addr)
+{
+    if (_transport == nullptr || _count >= JOYSTICK_BUS_MAX_DEVICES) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i].addr == addr) {
+            return -1;
+        }
+    }
+
+    device_t &dev = _devices[_count];
+    dev.addr       = addr;
+    dev.health     = joystick_bus_health_t();
+    dev.retry_us   = 0;
+    dev.backoff_us = JOYSTICK_BUS_BACKOFF_MIN_US;
+    dev.health.online = dev.joystick.begin(_transport, addr);
+    if (!dev.health.online) {
+        // Missing at startup, let the first poll retry it
+        dev.health.consecutive_errors = JOYSTICK_BUS_FAIL_THRESHOLD;
+    }
+    return _count++;
+}
+
+bool JoystickBus::poll_device(device_t &dev, uint64_t now_us, uint8_t fields)
+{
+    if (!dev.health.online && now_us < dev.retry_us) {
+        dev.health.skipped++;
+        return false;
+    }
+
+    joystick_state_t sample;
+    if (dev.joystick.read_state(&sample, fields)) {
+        dev.health.reads++;
+        dev.health.consecutive_errors = 0;
+        dev.health.online = true;
+        dev.backoff_us = JOYSTICK_BUS_BACKOFF_MIN_US;
+        dev.ring.push(sample);
+        return true;
+    }
+
+    dev.health.errors++;
+    if (dev.health.consecutive_errors < 0xFF) {
+        dev.health.consecutive_errors++;
+    }
+    if (dev.health.consecutive_errors < JOYSTICK_BUS_FAIL_THRESHOLD) {
+        return false;
+    }
+
+    // Offline: retry later, waiting longer after every failed retry
+    if (!dev.health.online) {
+        dev.backoff_us = dev.backoff_us * 2 > JOYSTICK_BUS_BACKOFF_MAX_US ? JOYSTICK_BUS_BACKOFF_MAX_US
+                                                                           : dev.backoff_us * 2;
+    }
+    dev.health.online = false;
+    dev.retry_us = now_us + dev.backoff_us;
+    return false;
+}
+
+uint8_t JoystickBus::poll(uint64_t now_us, uint8_t fields)
+{
+    if (_count == 0) {
+        return 0;
+    }
+
+    uint8_t read = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (poll_device(_devices[(_next + i) % _count], now_us, fields)) {
+            read++;
+        }
+    }
+    _next = (_next + 1) % _count;
+    return read;
+}
+
+bool JoystickBus::get_latest(uint8_t index, joystick_state_t *sample)
+{
+    if (index >= _count) {
+        return false;
+    }
+    return _devices[index].ring.peek_latest(sample);
+}
+
+uint32_t JoystickBus::drain(uint8_t index, joystick_state_t *samples, uint32_t max_samples)
+{
+    if (index >= _count) {
+        return 0;
+    }
+    return _devices[index].ring.drain(samples, max_samples);
+}
+
+Joystick *JoystickBus::get_joystick(uint8_t index)
+{
+    return index < _count ? &_devices[index].joystick : nullptr;
+}
+
+const joystick_bus_health_t *JoystickBus::get_health(uint8_t index)
+{
+    return index < _count ? &_devices[index].health : nullptr;
+}
@@ -0,0 +1,74 @@
+#include "joystick_cal_device.hpp"
+#include "pico/flash.h"
+#include <cstring> // For memcpy
+
+#define JOYSTICK_CAL_SAMPLE_MS 10
+
+bool joystick_cal_load(joystick_cal_profile_t *profile)
+{
+    // Flash is memory mapped through XIP
+    const uint8_t *record = (const uint8_t *)(XIP_BASE + JOYSTICK_CAL_FLASH_OFFSET);
+    return joystick_cal_decode(record, profile);
+}
+
+// Runs through flash_safe_execute(): interrupts off here, the other core parked in RAM
+static void cal_write_page(void *param)
+{
+    flash_range_erase(JOYSTICK_CAL_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(JOYSTICK_CAL_FLASH_OFFSET, (const uint8_t *)param, FLASH_PAGE_SIZE);
+}
+
+bool joystick_cal_save(const joystick_cal_profile_t &profile)
+{
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    joystick_cal_encode(profile, page);
+
+    // A JoystickSampler on core1 runs from XIP as well, it must not fetch while flash is written
+    if (flash_safe_execute(cal_write_page, page, JOYSTICK_CAL_FLASH_TIMEOUT_MS) != PICO_OK) {
+        return false;
+    }
+
+    joystick_cal_profile_t check;
+    return joystick_cal_load(&check) && memcmp(&check, &profile, sizeof(check)) == 0;
+}
+
+static void sample_phase(Joystick *joystick, JoystickCalibrator &cal, uint32_t duration_ms)
+{
+    absolute_time_t end = make_timeout_time_ms(duration_ms);
+    while (!time_reached(end)) {
+        uint8_t x, y;
+        joystick->get_joy_adc_8bits_value_xy(&x, &y);
+        if (joystick->get_last_status() == JOYSTICK_OK) {
+            cal.add_sample(x, y);
+        }
+        sleep_ms(JOYSTICK_CAL_SAMPLE_MS);
+    }
+}
+
+bool joystick_cal_run(Joystick *joystick, joystick_cal_profile_t *profile, uint32_t phase_ms)
+{
+    static const char *const prompts[JOYSTICK_CAL_DONE] = {
+        "Release the stick",
+        "Hold the stick up",
+        "Hold the stick right",
+        "Rotate the stick along the edge",
+    };
+
+    JoystickCalibrator cal;
+    cal.begin();
+    for (int phase = JOYSTICK_CAL_CENTER; phase < JOYSTICK_CAL_DONE; phase++) {
+        printf("Calibration: %s\n", prompts[phase]);
+        sleep_ms(1000); // Time to move the stick before sampling
+        sample_phase(joystick, cal, phase == JOYSTICK_CAL_SWEEP ? phase_ms * 3 : phase_ms);
+        cal.next_phase();
+    }
+
+    if (!cal.finish(profile)) {
+        printf("Calibration failed: stick travel too small\n");
+        return false;
+    }
+    printf("Calibration: center %u,%u x %u..%u y %u..%u dead zone %u\n", profile->center_x, profile->center_y,
+           profile->min_x, profile->max_x, profile->min_y, profile->max_y, profile->dead_zone);
+    return true;
+}
@@ -0,0 +1,187 @@
+#include "joystick_calibration.hpp"
+#include <cstring> // For memset
+
+JoystickCalibrator::JoystickCalibrator()
+{
+    begin();
+}
+
+void JoystickCalibrator::begin(void)
+{
+    _phase = JOYSTICK_CAL_CENTER;
+    memset(_sum_x, 0, sizeof(_sum_x));
+    memset(_sum_y, 0, sizeof(_sum_y));
+    memset(_count, 0, sizeof(_count));
+    _center_min_x = _center_min_y = 0xFF;
+    _center_max_x = _center_max_y = 0;
+    _min_x = _min_y = 0xFF;
+    _max_x = _max_y = 0;
+}
+
+void JoystickCalibrator::add_sample(uint8_t x, uint8_t y)
+{
+    if (_phase >= JOYSTICK_CAL_DONE) {
+        return;
+    }
+    _sum_x[_phase] += x;
+    _sum_y[_phase] += y;
+    _count[_phase]++;
+
+    if (_phase == JOYSTICK_CAL_CENTER) {
+        if (x < _center_min_x) _center_min_x = x;
+        if (x > _center_max_x) _center_max_x = x;
+        if (y < _center_min_y) _center_min_y = y;
+        if (y > _center_max_y) _center_max_y = y;
+    }
+    if (x < _min_x) _min_x = x;
+    if (x > _max_x) _max_x = x;
+    if (y < _min_y) _min_y = y;
+    if (y > _max_y) _max_y = y;
+}
+
+void JoystickCalibrator::next_phase(void)
+{
+    if (_phase < JOYSTICK_CAL_DONE) {
+        _phase = (joystick_cal_phase_t)(_phase + 1);
+    }
+}
+
+bool JoystickCalibrator::finish(joystick_cal_profile_t *profile)
+{
+    for (int phase = 0; phase < JOYSTICK_CAL_DONE; phase++) {
+        if (_count[phase] == 0) {
+            return false;
+        }
+    }
+
+    uint8_t center_x = (_sum_x[JOYSTICK_CAL_CENTER] + _count[JOYSTICK_CAL_CENTER] / 2) / _count[JOYSTICK_CAL_CENTER];
+    uint8_t center_y = (_sum_y[JOYSTICK_CAL_CENTER] + _count[JOYSTICK_CAL_CENTER] / 2) / _count[JOYSTICK_CAL_CENTER];
+    if (center_x - _min_x < JOYSTICK_CAL_MIN_RANGE || _max_x - center_x < JOYSTICK_CAL_MIN_RANGE ||
+        center_y - _min_y < JOYSTICK_CAL_MIN_RANGE || _max_y - center_y < JOYSTICK_CAL_MIN_RANGE) {
+        return false;
+    }
+
+    // Dead zone covers the noise seen while the stick was released
+    int noise = center_x - _center_min_x;
+    if (_center_max_x - center_x > noise) noise = _center_max_x - center_x;
+    if (center_y - _center_min_y > noise) noise = center_y - _center_min_y;
+    if (_center_max_y - center_y > noise) noise = _center_max_y - center_y;
+    int dead_zone = noise + JOYSTICK_CAL_DEAD_ZONE_MARGIN;
+
+    // Up must come out negative and right positive
+    uint32_t up_y    = _sum_y[JOYSTICK_CAL_UP] / _count[JOYSTICK_CAL_UP];
+    uint32_t right_x = _sum_x[JOYSTICK_CAL_RIGHT] / _count[JOYSTICK_CAL_RIGHT];
+
+    profile->center_x  = center_x;
+    profile->center_y  = center_y;
+    profile->min_x     = _min_x;
+    profile->max_x     = _max_x;
+    profile->min_y     = _min_y;
+    profile->max_y     = _max_y;
+    profile->dead_zone = dead_zone > 0xFF ? 0xFF : dead_zone;
+    profile->invert_x  = right_x < center_x;
+    profile->invert_y  = up_y > center_y;
+    _phase = JOYSTICK_CAL_DONE;
+    return true;
+}
+
+void joystick_cal_build_lut(int16_t *lut, uint8_t center, uint8_t min, uint8_t max, uint8_t dead_zone,
+                            bool invert)
+{
+    int32_t span_pos = (int32_t)max - center - dead_zone;
+    int32_t span_neg = (int32_t)center - min - dead_zone;
+
+    for (int32_t raw = 0; raw < 256; raw++) {
+        int32_t d = raw - center;
+        int32_t value;
+        if (d > dead_zone) {
+            value = span_pos > 0 ? (d - dead_zone) * JOYSTICK_CAL_OUTPUT_MAX / span_pos : JOYSTICK_CAL_OUTPUT_MAX;
+        } else if (d < -dead_zone) {
+            value = span_neg > 0 ? (d + dead_zone) * JOYSTICK_CAL_OUTPUT_MAX / span_neg : -JOYSTICK_CAL_OUTPUT_MAX;
+        } else {
+            value = 0;
+        }
+        // Readings past the calibrated extents saturate
+        if (value > JOYSTICK_CAL_OUTPUT_MAX) value = JOYSTICK_CAL_OUTPUT_MAX;
+        if (value < -JOYSTICK_CAL_OUTPUT_MAX) value = -JOYSTICK_CAL_OUTPUT_MAX;
+        lut[raw] = (int16_t)(invert ? -value : value);
+    }
+}
+
+JoystickCalMap::JoystickCalMap()
+{
+    joystick_cal_profile_t profile = {128, 128, 0, 255, 0, 255, 0, false, false};
+    set_profile(profile);
+}
+
+void JoystickCalMap::set_profile(const joystick_cal_profile_t &profile)
+{
+    joystick_cal_build_lut(_lut_x, profile.center_x, profile.min_x, profile.max_x, profile.dead_zone,
+                           profile.invert_x);
+    joystick_cal_build_lut(_lut_y, profile.center_y, profile.min_y, profile.max_y, profile.dead_zone,
+                           profile.invert_y);
+}
+
+uint32_t joystick_cal_crc32(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    buf[2] = (value >> 16) & 0xFF;
+    buf[3] = (value >> 24) & 0xFF;
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+// Record layout, little endian:
+// 0 magic(4) | 4 version | 5 center x, y | 7 min x, max x | 9 min y, max y | 11 dead zone
+// 12 flags (bit0 invert x, bit1 invert y) | 13 reserved(3) | 16 CRC-32 of bytes 0..15
+void joystick_cal_encode(const joystick_cal_profile_t &profile, uint8_t *record)
+{
+    memset(record, 0, JOYSTICK_CAL_RECORD_SIZE);
+    put_u32(&record[0], JOYSTICK_CAL_MAGIC);
+    record[4]  = JOYSTICK_CAL_VERSION;
+    record[5]  = profile.center_x;
+    record[6]  = profile.center_y;
+    record[7]  = profile.min_x;
+    record[8]  = profile.max_x;
+    record[9]  = profile.min_y;
+    record[10] = profile.max_y;
+    record[11] = profile.dead_zone;
+    record[12] = (profile.invert_x ? 0x01 : 0) | (profile.invert_y ? 0x02 : 0);
+    put_u32(&record[16], joystick_cal_crc32(record, 16));
+}
+
+bool joystick_cal_decode(const uint8_t *record, joystick_cal_profile_t *profile)
+{
+    if (get_u32(&record[0]) != JOYSTICK_CAL_MAGIC || record[4] != JOYSTICK_CAL_VERSION) {
+        return false;
+    }
+    if (get_u32(&record[16]) != joystick_cal_crc32(record, 16)) {
+        return false;
+    }
+    profile->center_x  = record[5];
+    profile->center_y  = record[6];
+    profile->min_x     = record[7];
+    profile->max_x     = record[8];
+    profile->min_y     = record[9];
+    profile->max_y     = record[10];
+    profile->dead_zone = record[11];
+    profile->invert_x  = (record[12] & 0x01) != 0;
+    profile->invert_y  = (record[12] & 0x02) != 0;
+    return true;
+}
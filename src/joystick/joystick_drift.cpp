@@ -0,0 +1,104 @@
+#include "joystick_drift.hpp"
+
+JoystickDrift::JoystickDrift()
+{
+    reset();
+}
+
+void JoystickDrift::set_config(const joystick_drift_config_t &config)
+{
+    _config = config;
+    if (_config.window_shift > 10) {
+        _config.window_shift = 10; // Keeps the sums within 32 bits
+    }
+    reset_window();
+}
+
+void JoystickDrift::reset(void)
+{
+    _stats = joystick_drift_stats_t();
+    _center_q4_x = 0;
+    _center_q4_y = 0;
+    reset_window();
+}
+
+void JoystickDrift::reset_window(void)
+{
+    _sum_x  = 0;
+    _sum_y  = 0;
+    _sq_x   = 0;
+    _sq_y   = 0;
+    _count  = 0;
+    _button = false;
+}
+
+int16_t JoystickDrift::center(int32_t center_q4)
+{
+    return (int16_t)(center_q4 < 0 ? -((-center_q4 + 8) >> 4) : (center_q4 + 8) >> 4);
+}
+
+int32_t JoystickDrift::step(int32_t delta_q4)
+{
+    int32_t limit = (int32_t)_config.max_step * 16;
+    return delta_q4 > limit ? limit : delta_q4 < -limit ? -limit : delta_q4;
+}
+
+void JoystickDrift::update(int16_t offset_x, int16_t offset_y, bool button_pressed)
+{
+    _sum_x += offset_x;
+    _sum_y += offset_y;
+    _sq_x  += (uint64_t)((int32_t)offset_x * offset_x);
+    _sq_y  += (uint64_t)((int32_t)offset_y * offset_y);
+    _button |= button_pressed;
+    if (++_count < (1UL << _config.window_shift)) {
+        return;
+    }
+
+    int32_t n = 1L << _config.window_shift;
+    int32_t mean_x = _sum_x / n;
+    int32_t mean_y = _sum_y / n;
+    // E[v^2] - E[v]^2, in offset units squared
+    int64_t var_x = (int64_t)(_sq_x >> _config.window_shift) - (int64_t)mean_x * mean_x;
+    int64_t var_y = (int64_t)(_sq_y >> _config.window_shift) - (int64_t)mean_y * mean_y;
+    int64_t idle_var = (int64_t)_config.idle_stddev * _config.idle_stddev;
+    int32_t max_drift = _config.max_drift;
+
+    bool idle = !_button && var_x <= idle_var && var_y <= idle_var &&
+                mean_x <= max_drift && mean_x >= -max_drift &&
+                mean_y <= max_drift && mean_y >= -max_drift;
+    if (idle) {
+        // Exponential average of the idle means, slow enough to ignore a resting thumb
+        _center_q4_x += step((mean_x * 16 - _center_q4_x) / (1L << _config.rate_shift));
+        _center_q4_y += step((mean_y * 16 - _center_q4_y) / (1L << _config.rate_shift));
+        _stats.center_x    = center(_center_q4_x);
+        _stats.center_y    = center(_center_q4_y);
+        _stats.last_idle_x = (int16_t)mean_x;
+        _stats.last_idle_y = (int16_t)mean_y;
+        _stats.idle_windows++;
+    } else {
+        _stats.active_windows++;
+    }
+    reset_window();
+}
+
+void JoystickDrift::correct(int16_t *offset_x, int16_t *offset_y)
+{
+    if (_stats.center_x == 0 && _stats.center_y == 0) {
+        return;
+    }
+    int32_t x = *offset_x - _stats.center_x;
+    int32_t y = *offset_y - _stats.center_y;
+    *offset_x = (int16_t)(x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : x);
+    *offset_y = (int16_t)(y > INT16_MAX ? INT16_MAX : y < INT16_MIN ? INT16_MIN : y);
+    _stats.corrected_samples++;
+}
+
+void JoystickDrift::process(joystick_state_t &state)
+{
+    if (!(state.fields & JOYSTICK_STATE_OFFSET)) {
+        return;
+    }
+    bool pressed = (state.fields & JOYSTICK_STATE_BUTTON) && state.button == 0;
+    update(state.offset_x, state.offset_y, pressed);
+    correct(&state.offset_x, &state.offset_y);
+}
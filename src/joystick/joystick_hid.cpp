@@ -0,0 +1,106 @@
+#include "joystick_hid.hpp"
+
+constexpr uint8_t joystick_hid_report_descriptor[JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop)
+    0x09, 0x05,        // Usage (Game Pad)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x16, 0x01, 0x80,  //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x81, 0x02,        //     Input (Data, Variable, Absolute)
+    0xC0,              //   End Collection
+    0x05, 0x09,        //   Usage Page (Button)
+    0x19, 0x01,        //   Usage Minimum (1)
+    0x29, 0x01,        //   Usage Maximum (1)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x02,        //   Input (Data, Variable, Absolute)
+    0x75, 0x07,        //   Report Size (7), padding
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x03,        //   Input (Constant)
+    0xC0               // End Collection
+};
+// A short initializer would be padded with zeros, the descriptor must end on its End Collection
+static_assert(joystick_hid_report_descriptor[JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE - 1] == 0xC0 &&
+              joystick_hid_report_descriptor[JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE - 2] == 0x03,
+              "JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE does not match the descriptor");
+
+static int16_t offset_to_q15(int16_t offset)
+{
+    // 12bits full scale to Q15
+    int32_t value = (int32_t)offset * 8;
+    return (int16_t)(value > JOYSTICK_Q15_ONE ? JOYSTICK_Q15_ONE : value < -JOYSTICK_Q15_ONE ? -JOYSTICK_Q15_ONE : value);
+}
+
+JoystickHidReport::JoystickHidReport() :
+    _x(0),
+    _y(0),
+    _buttons(0),
+    _sent_x(0),
+    _sent_y(0),
+    _sent_buttons(0),
+    _valid(false),
+    _min_delta(JOYSTICK_HID_MIN_DELTA),
+    _sent(0),
+    _unchanged(0)
+{
+    for (uint8_t i = 0; i < JOYSTICK_HID_REPORT_SIZE; i++) {
+        _report[i] = 0;
+    }
+}
+
+bool JoystickHidReport::changed(int16_t value, int16_t sent)
+{
+    if (value == sent) {
+        return false;
+    }
+    // Resting and full deflection must never be held back by the threshold
+    if (value == 0 || value == JOYSTICK_Q15_ONE || value == -JOYSTICK_Q15_ONE) {
+        return true;
+    }
+    int32_t delta = (int32_t)value - sent;
+    return delta >= _min_delta || -delta >= _min_delta;
+}
+
+bool JoystickHidReport::update(const joystick_vector_t &move, bool button_pressed)
+{
+    _x = move.x < -JOYSTICK_Q15_ONE ? -JOYSTICK_Q15_ONE : move.x;
+    _y = move.y < -JOYSTICK_Q15_ONE ? -JOYSTICK_Q15_ONE : move.y;
+    _buttons = button_pressed ? 0x01 : 0x00;
+
+    _report[0] = (uint8_t)_x;
+    _report[1] = (uint8_t)((uint16_t)_x >> 8);
+    _report[2] = (uint8_t)_y;
+    _report[3] = (uint8_t)((uint16_t)_y >> 8);
+    _report[4] = _buttons;
+
+    bool pending = !_valid || _buttons != _sent_buttons || changed(_x, _sent_x) || changed(_y, _sent_y);
+    if (!pending) {
+        _unchanged++;
+    }
+    return pending;
+}
+
+bool JoystickHidReport::update(int16_t offset_x, int16_t offset_y, bool button_pressed)
+{
+    joystick_vector_t move;
+    move.x = offset_to_q15(offset_x);
+    move.y = offset_to_q15(offset_y);
+    return update(move, button_pressed);
+}
+
+void JoystickHidReport::mark_sent(void)
+{
+    _sent_x = _x;
+    _sent_y = _y;
+    _sent_buttons = _buttons;
+    _valid = true;
+    _sent++;
+}
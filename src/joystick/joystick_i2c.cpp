@@ -0,0 +1,145 @@
+#include "joystick_i2c.hpp"
+#include <cstring> // For memcpy
+
+uint32_t joystick_i2c_recover_bus(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed)
+{
+    i2c_deinit(i2c_port);
+
+    // Open-drain by hand: a line is driven low as output, released as input with pull-up
+    gpio_init(sda_pin);
+    gpio_init(scl_pin);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+    gpio_put(sda_pin, 0);
+    gpio_put(scl_pin, 0);
+    gpio_set_dir(sda_pin, GPIO_IN);
+    gpio_set_dir(scl_pin, GPIO_IN);
+    busy_wait_us(5);
+
+    // A device stuck in the middle of a byte releases SDA within 9 clocks
+    for (int i = 0; i < 9 && !gpio_get(sda_pin); i++) {
+        gpio_set_dir(scl_pin, GPIO_OUT);
+        busy_wait_us(5);
+        gpio_set_dir(scl_pin, GPIO_IN);
+        busy_wait_us(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    gpio_set_dir(scl_pin, GPIO_OUT);
+    gpio_set_dir(sda_pin, GPIO_OUT);
+    busy_wait_us(5);
+    gpio_set_dir(scl_pin, GPIO_IN);
+    busy_wait_us(5);
+    gpio_set_dir(sda_pin, GPIO_IN);
+    busy_wait_us(5);
+
+    uint32_t baud = i2c_init(i2c_port, speed);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    return baud;
+}
+
+JoystickI2C::JoystickI2C() :
+    _i2c_port(nullptr),
+    _scl_pin(0),
+    _sda_pin(0),
+    _speed(0),
+    _failures(0),
+    _recoveries(0)
+{
+}
+
+void JoystickI2C::init(i2c_inst_t *i2c_port, uint sda_pin, uint scl_pin, uint32_t speed)
+{
+    _i2c_port = i2c_port;
+    _sda_pin  = sda_pin;
+    _scl_pin  = scl_pin;
+
+    // Initialize I2C port at requested speed, keep the clock actually set
+    _speed = i2c_init(_i2c_port, speed);
+
+    // Initialize I2C pins
+    gpio_set_function(_sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(_scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(_sda_pin);
+    gpio_pull_up(_scl_pin);
+}
+
+bool JoystickI2C::probe(uint8_t addr)
+{
+    // Check device presence by trying to write nothing (just address)
+    uint8_t dummy_byte; // A dummy byte to satisfy write function, won't be sent
+    int ret = i2c_write_timeout_us(_i2c_port, addr, &dummy_byte, 0, false, timeout_us(0));
+
+    return (ret >= 0); // Returns PICO_ERROR_GENERIC (-1) if NACK received (no device)
+}
+
+uint JoystickI2C::timeout_us(uint8_t nbytes)
+{
+    // Address, register and data bytes are 9 clocks each, allow twice the wire time
+    uint32_t speed = _speed ? _speed : 100000;
+    return JOYSTICK_I2C_TIMEOUT_US + (uint)((nbytes + 2) * 9 * 2 * 1000000ULL / speed);
+}
+
+int JoystickI2C::check(int ret)
+{
+    // Timeouts and NACKs both count, a success restarts the count
+    if (ret >= 0) {
+        _failures = 0;
+        return ret;
+    }
+    if (++_failures >= JOYSTICK_I2C_RECOVERY_THRESHOLD) {
+        recover();
+    }
+    return ret;
+}
+
+void JoystickI2C::recover(void)
+{
+    if (_i2c_port == nullptr) {
+        return;
+    }
+    _speed = joystick_i2c_recover_bus(_i2c_port, _sda_pin, _scl_pin, _speed);
+    _failures = 0;
+    _recoveries++;
+}
+
+int JoystickI2C::read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    // Send the register address we want to read from
+    int ret = i2c_write_timeout_us(_i2c_port, addr, &reg, 1, true, timeout_us(1)); // true to keep control of bus
+    if (ret < 0) {
+        return check(ret);
+    }
+    // Read the data from the register
+    ret = i2c_read_timeout_us(_i2c_port, addr, buf, nbytes, false, timeout_us(nbytes)); // false to release bus
+    return check(ret);
+}
+
+int JoystickI2C::write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    if (nbytes > JOYSTICK_I2C_MAX_WRITE) {
+        return PICO_ERROR_GENERIC;
+    }
+    uint8_t msg[JOYSTICK_I2C_MAX_WRITE + 1];
+    // First byte is the register address
+    msg[0] = reg;
+    // Copy data bytes
+    memcpy(msg + 1, buf, nbytes);
+    // Write the register address followed by the data
+    int ret = check(i2c_write_timeout_us(_i2c_port, addr, msg, nbytes + 1, false,
+                                         timeout_us(nbytes + 1))); // false to release bus
+    if (ret < 0) {
+        return ret;
+    }
+    return ret - 1; // Data bytes only
+}
+
+uint32_t JoystickI2C::set_speed(uint32_t speed)
+{
+    if (_i2c_port == nullptr) {
+        return 0;
+    }
+    _speed = i2c_set_baudrate(_i2c_port, speed);
+    return _speed;
+}
@@ -0,0 +1,157 @@
+#include "joystick_input.hpp"
+
+// Whether the current direction is still valid for a sample, with wider sectors
+static bool direction_holds(uint8_t current, int32_t x, int32_t y, int32_t abs_x, int32_t abs_y,
+                            const joystick_input_config_t &config)
+{
+    if (!config.eight_way) {
+        switch (current) {
+            case JOYSTICK_KEY_UP:    return y < 0 && abs_y * 256 >= abs_x * config.hold_ratio_q8;
+            case JOYSTICK_KEY_DOWN:  return y > 0 && abs_y * 256 >= abs_x * config.hold_ratio_q8;
+            case JOYSTICK_KEY_LEFT:  return x < 0 && abs_x * 256 >= abs_y * config.hold_ratio_q8;
+            case JOYSTICK_KEY_RIGHT: return x > 0 && abs_x * 256 >= abs_y * config.hold_ratio_q8;
+            default:                 return false;
+        }
+    }
+
+    const int32_t cardinal_q8 = JOYSTICK_INPUT_DIAGONAL_Q8 + JOYSTICK_INPUT_DIAGONAL_HYSTERESIS_Q8;
+    const int32_t diagonal_q8 = JOYSTICK_INPUT_DIAGONAL_Q8 - JOYSTICK_INPUT_DIAGONAL_HYSTERESIS_Q8;
+    int32_t major = abs_x > abs_y ? abs_x : abs_y;
+    int32_t minor = abs_x > abs_y ? abs_y : abs_x;
+    switch (current) {
+        case JOYSTICK_KEY_UP:         return y < 0 && abs_x * 256 < abs_y * cardinal_q8;
+        case JOYSTICK_KEY_DOWN:       return y > 0 && abs_x * 256 < abs_y * cardinal_q8;
+        case JOYSTICK_KEY_LEFT:       return x < 0 && abs_y * 256 < abs_x * cardinal_q8;
+        case JOYSTICK_KEY_RIGHT:      return x > 0 && abs_y * 256 < abs_x * cardinal_q8;
+        case JOYSTICK_KEY_UP_LEFT:    return y < 0 && x < 0 && minor * 256 >= major * diagonal_q8;
+        case JOYSTICK_KEY_UP_RIGHT:   return y < 0 && x > 0 && minor * 256 >= major * diagonal_q8;
+        case JOYSTICK_KEY_DOWN_LEFT:  return y > 0 && x < 0 && minor * 256 >= major * diagonal_q8;
+        case JOYSTICK_KEY_DOWN_RIGHT: return y > 0 && x > 0 && minor * 256 >= major * diagonal_q8;
+        default:                      return false;
+    }
+}
+
+uint8_t joystick_classify_direction(int16_t x, int16_t y, const joystick_input_config_t &config, uint8_t current)
+{
+    int32_t abs_x = x < 0 ? -(int32_t)x : x;
+    int32_t abs_y = y < 0 ? -(int32_t)y : y;
+    int32_t magnitude = abs_x > abs_y ? abs_x : abs_y;
+
+    // Keep the current direction until the stick is clearly released or moved away
+    if (current != JOYSTICK_KEY_NONE) {
+        if (magnitude < config.release_threshold) {
+            return JOYSTICK_KEY_NONE;
+        }
+        if (direction_holds(current, x, y, abs_x, abs_y, config)) {
+            return current;
+        }
+    }
+
+    if (magnitude < config.press_threshold) {
+        return JOYSTICK_KEY_NONE;
+    }
+
+    if (!config.eight_way) {
+        if (abs_y * 256 > abs_x * config.ratio_q8) {
+            return (y < 0) ? JOYSTICK_KEY_UP : JOYSTICK_KEY_DOWN;
+        }
+        if (abs_x * 256 > abs_y * config.ratio_q8) {
+            return (x < 0) ? JOYSTICK_KEY_LEFT : JOYSTICK_KEY_RIGHT;
+        }
+        return JOYSTICK_KEY_NONE; // Direction is unclear
+    }
+
+    int32_t minor = abs_x > abs_y ? abs_y : abs_x;
+    if (minor * 256 < magnitude * JOYSTICK_INPUT_DIAGONAL_Q8) {
+        if (abs_y > abs_x) {
+            return (y < 0) ? JOYSTICK_KEY_UP : JOYSTICK_KEY_DOWN;
+        }
+        return (x < 0) ? JOYSTICK_KEY_LEFT : JOYSTICK_KEY_RIGHT;
+    }
+    if (y < 0) {
+        return (x < 0) ? JOYSTICK_KEY_UP_LEFT : JOYSTICK_KEY_UP_RIGHT;
+    }
+    return (x < 0) ? JOYSTICK_KEY_DOWN_LEFT : JOYSTICK_KEY_DOWN_RIGHT;
+}
+
+JoystickInput::JoystickInput() :
+    _config(),
+    _direction(),
+    _button(),
+    _raw_direction(JOYSTICK_KEY_NONE),
+    _event_head(0),
+    _event_count(0),
+    _dropped(0)
+{
+}
+
+void JoystickInput::update(const joystick_state_t &state, uint32_t now_ms)
+{
+    update(state.offset_x, state.offset_y, state.button == 0, now_ms);
+}
+
+void JoystickInput::update(int16_t x, int16_t y, bool button_pressed, uint32_t now_ms)
+{
+    _raw_direction = joystick_classify_direction(x, y, _config, _raw_direction);
+    update_key(_direction, _raw_direction, now_ms, true);
+    update_key(_button, button_pressed ? JOYSTICK_KEY_MID : JOYSTICK_KEY_NONE, now_ms, false);
+}
+
+void JoystickInput::update_key(key_state_t &key, uint8_t raw, uint32_t now_ms, bool repeat)
+{
+    if (raw != key.candidate) {
+        key.candidate    = raw;
+        key.candidate_ms = now_ms;
+    }
+
+    if (key.candidate != key.stable && now_ms - key.candidate_ms >= _config.debounce_ms) {
+        if (key.stable != JOYSTICK_KEY_NONE) {
+            push_event(JOYSTICK_EVENT_RELEASE, key.stable, now_ms);
+        }
+        key.stable = key.candidate;
+        if (key.stable != JOYSTICK_KEY_NONE) {
+            push_event(JOYSTICK_EVENT_PRESS, key.stable, now_ms);
+            key.pressed_ms     = now_ms;
+            key.next_repeat_ms = now_ms + _config.repeat_delay_ms;
+            key.long_sent      = false;
+        }
+        return;
+    }
+
+    if (key.stable == JOYSTICK_KEY_NONE) {
+        return;
+    }
+    if (_config.long_press_ms > 0 && !key.long_sent && now_ms - key.pressed_ms >= _config.long_press_ms) {
+        push_event(JOYSTICK_EVENT_LONG_PRESS, key.stable, now_ms);
+        key.long_sent = true;
+    }
+    if (repeat && _config.repeat_delay_ms > 0 && (int32_t)(now_ms - key.next_repeat_ms) >= 0) {
+        push_event(JOYSTICK_EVENT_REPEAT, key.stable, now_ms);
+        // A zero interval repeats once per update
+        key.next_repeat_ms = now_ms + _config.repeat_interval_ms;
+    }
+}
+
+void JoystickInput::push_event(uint8_t type, uint8_t key, uint32_t now_ms)
+{
+    if (_event_count >= JOYSTICK_INPUT_EVENT_QUEUE_SIZE) {
+        _dropped++;
+        return;
+    }
+    joystick_event_t &event = _events[(_event_head + _event_count) % JOYSTICK_INPUT_EVENT_QUEUE_SIZE];
+    event.type    = type;
+    event.key     = key;
+    event.time_ms = now_ms;
+    _event_count++;
+}
+
+bool JoystickInput::poll_event(joystick_event_t *event)
+{
+    if (_event_count == 0) {
+        return false;
+    }
+    *event = _events[_event_head];
+    _event_head = (_event_head + 1) % JOYSTICK_INPUT_EVENT_QUEUE_SIZE;
+    _event_count--;
+    return true;
+}
@@ -0,0 +1,66 @@
+#include "joystick_latency.hpp"
+#include "joystick.hpp"
+#include <stdio.h>
+
+static const char *const group_names[JOYSTICK_LATENCY_GROUPS] = {
+    "adc", "offset", "button", "rgb", "cal", "info"
+};
+
+JoystickLatency::JoystickLatency()
+{
+    reset();
+}
+
+void JoystickLatency::reset(void)
+{
+    for (int i = 0; i < JOYSTICK_LATENCY_GROUPS; i++) {
+        _groups[i] = joystick_latency_t();
+        _groups[i].min_us = 0xFFFFFFFFUL;
+    }
+}
+
+joystick_latency_group_t JoystickLatency::group_of(uint8_t reg)
+{
+    switch (reg & 0xF0) {
+        case JOYSTICK_ADC_VALUE_12BITS_REG:
+        case JOYSTICK_ADC_VALUE_8BITS_REG:         return JOYSTICK_LATENCY_ADC;
+        case JOYSTICK_BUTTON_REG:                  return JOYSTICK_LATENCY_BUTTON;
+        case JOYSTICK_RGB_REG:                     return JOYSTICK_LATENCY_RGB;
+        case JOYSTICK_ADC_VALUE_CAL_REG:           return JOYSTICK_LATENCY_CAL;
+        case JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG:
+        case JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG:  return JOYSTICK_LATENCY_OFFSET;
+        default:                                   return JOYSTICK_LATENCY_INFO;
+    }
+}
+
+void JoystickLatency::add(uint8_t reg, uint32_t us)
+{
+    joystick_latency_t &g = _groups[group_of(reg)];
+    g.count++;
+    g.total_us += us;
+    if (us < g.min_us) g.min_us = us;
+    if (us > g.max_us) g.max_us = us;
+
+    uint32_t bucket = 0;
+    while (us != 0 && bucket < JOYSTICK_LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    g.buckets[bucket]++;
+}
+
+void JoystickLatency::print(void) const
+{
+    for (int i = 0; i < JOYSTICK_LATENCY_GROUPS; i++) {
+        const joystick_latency_t &g = _groups[i];
+        if (g.count == 0) {
+            continue;
+        }
+        printf("LAT %s n=%lu min=%lu mean=%lu max=%lu hist=", group_names[i], (unsigned long)g.count,
+               (unsigned long)g.min_us, (unsigned long)(g.total_us / g.count), (unsigned long)g.max_us);
+        for (int b = 0; b < JOYSTICK_LATENCY_BUCKETS; b++) {
+            printf(b == 0 ? "%lu" : ",%lu", (unsigned long)g.buckets[b]);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,146 @@
+#include "joystick_led.hpp"
+
+JoystickLed::JoystickLed() :
+    _joystick(nullptr),
+    _base(0),
+    _written(0),
+    _written_valid(false),
+    _seq(JOYSTICK_LED_SEQ_NONE),
+    _seq_color(0),
+    _seq_from(0),
+    _seq_duration(0),
+    _seq_off_ms(0),
+    _seq_count(0),
+    _seq_start_ms(0),
+    _seq_started(false),
+    _last_fade_ms(0),
+    _pending(0),
+    _saved(0),
+    _bus_writes(0)
+{
+}
+
+void JoystickLed::begin(Joystick *joystick)
+{
+    _joystick = joystick;
+    _written_valid = false;
+}
+
+void JoystickLed::set_color(uint32_t color)
+{
+    _base = color;
+    _pending++;
+}
+
+void JoystickLed::start_sequence(joystick_led_seq_t seq, uint32_t color, uint32_t duration_ms)
+{
+    _seq          = seq;
+    _seq_color    = color;
+    _seq_duration = duration_ms;
+    _seq_started  = false;
+}
+
+void JoystickLed::flash(uint32_t color, uint32_t duration_ms)
+{
+    start_sequence(JOYSTICK_LED_SEQ_FLASH, color, duration_ms);
+}
+
+void JoystickLed::blink(uint32_t color, uint8_t count, uint32_t on_ms, uint32_t off_ms)
+{
+    if (count == 0) {
+        return;
+    }
+    start_sequence(JOYSTICK_LED_SEQ_BLINK, color, on_ms);
+    _seq_off_ms = off_ms;
+    _seq_count  = count;
+}
+
+void JoystickLed::fade(uint32_t color, uint32_t duration_ms)
+{
+    start_sequence(JOYSTICK_LED_SEQ_FADE, color, duration_ms);
+    _seq_from = _written_valid ? _written : _base;
+    _base     = color;
+}
+
+void JoystickLed::stop(void)
+{
+    _seq = JOYSTICK_LED_SEQ_NONE;
+}
+
+uint32_t JoystickLed::mix_color(uint32_t from, uint32_t to, uint32_t num, uint32_t den)
+{
+    uint32_t color = 0;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int32_t a = (from >> shift) & 0xFF;
+        int32_t b = (to >> shift) & 0xFF;
+        int32_t c = a + (b - a) * (int32_t)num / (int32_t)den;
+        color |= (uint32_t)c << shift;
+    }
+    return color;
+}
+
+void JoystickLed::tick(uint32_t now_ms)
+{
+    uint32_t target = _base;
+
+    if (_seq != JOYSTICK_LED_SEQ_NONE) {
+        if (!_seq_started) {
+            _seq_started  = true;
+            _seq_start_ms = now_ms;
+            _last_fade_ms = now_ms;
+        }
+        uint32_t elapsed = now_ms - _seq_start_ms;
+
+        switch (_seq) {
+            case JOYSTICK_LED_SEQ_FLASH:
+                if (elapsed < _seq_duration) {
+                    target = _seq_color;
+                } else {
+                    _seq = JOYSTICK_LED_SEQ_NONE;
+                }
+                break;
+            case JOYSTICK_LED_SEQ_BLINK: {
+                uint32_t period = _seq_duration + _seq_off_ms;
+                if (period == 0 || elapsed >= period * _seq_count) {
+                    _seq = JOYSTICK_LED_SEQ_NONE;
+                } else if (elapsed % period < _seq_duration) {
+                    target = _seq_color;
+                }
+                break;
+            }
+            case JOYSTICK_LED_SEQ_FADE:
+                if (elapsed >= _seq_duration) {
+                    _seq = JOYSTICK_LED_SEQ_NONE;
+                } else if (now_ms - _last_fade_ms < JOYSTICK_LED_FADE_STEP_MS && _written_valid) {
+                    target = _written; // Hold the current step
+                } else {
+                    _last_fade_ms = now_ms;
+                    target = mix_color(_seq_from, _seq_color, elapsed, _seq_duration);
+                }
+                break;
+            default:
+                _seq = JOYSTICK_LED_SEQ_NONE;
+                break;
+        }
+    }
+
+    // Every set_color since the last tick either ends up in this write or is dropped
+    uint32_t pending = _pending;
+    _pending = 0;
+
+    if ((_written_valid && target == _written) || _joystick == nullptr) {
+        _saved += pending;
+        return;
+    }
+    _joystick->set_rgb_color(target);
+    _bus_writes++;
+    // A failed write leaves the shadow as it was, the next tick retries
+    if (_joystick->get_last_status() != JOYSTICK_OK) {
+        return;
+    }
+    _written = target;
+    _written_valid = true;
+    if (pending > 1) {
+        _saved += pending - 1;
+    }
+}
@@ -0,0 +1,140 @@
+#include "joystick_mock_bus.hpp"
+#include "joystick.hpp"
+#include <cstring> // For memcpy
+
+JoystickMockBus::JoystickMockBus() :
+    _count(0),
+    _transfers(0),
+    _speed(100000),
+    _fault_speed(0),
+    _fault_every(0),
+    _wire_timing(false)
+{
+}
+
+JoystickMockBus::device_t *JoystickMockBus::find(uint8_t addr)
+{
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i].addr == addr) {
+            return &_devices[i];
+        }
+    }
+    return nullptr;
+}
+
+bool JoystickMockBus::add_device(uint8_t addr)
+{
+    if (_count >= JOYSTICK_MOCK_MAX_DEVICES || find(addr) != nullptr) {
+        return false;
+    }
+    device_t &dev = _devices[_count++];
+    dev.addr    = addr;
+    dev.present = true;
+    memset(dev.regs, 0, sizeof(dev.regs));
+    dev.regs[JOYSTICK_BUTTON_REG]             = 1; // Not pressed
+    dev.regs[JOYSTICK_FIRMWARE_VERSION_REG]   = 1;
+    dev.regs[JOYSTICK_BOOTLOADER_VERSION_REG] = 1;
+    dev.regs[JOYSTICK_I2C_ADDRESS_REG]        = addr;
+    set_stick(addr, 0, 0, 1);
+    return true;
+}
+
+void JoystickMockBus::set_present(uint8_t addr, bool present)
+{
+    device_t *dev = find(addr);
+    if (dev != nullptr) {
+        dev->present = present;
+    }
+}
+
+bool JoystickMockBus::set_regs(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    device_t *dev = find(addr);
+    if (dev == nullptr || reg + nbytes > 256) {
+        return false;
+    }
+    memcpy(&dev->regs[reg], buf, nbytes);
+    return true;
+}
+
+bool JoystickMockBus::set_stick(uint8_t addr, int16_t offset_x, int16_t offset_y, uint8_t button)
+{
+    device_t *dev = find(addr);
+    if (dev == nullptr) {
+        return false;
+    }
+    // Every view of the stick position is derived from the offsets, center at half scale
+    uint16_t adc_x = (uint16_t)(32768 + offset_x * 8);
+    uint16_t adc_y = (uint16_t)(32768 + offset_y * 8);
+    memcpy(&dev->regs[JOYSTICK_ADC_VALUE_12BITS_REG], &adc_x, 2);
+    memcpy(&dev->regs[JOYSTICK_ADC_VALUE_12BITS_REG + 2], &adc_y, 2);
+    dev->regs[JOYSTICK_ADC_VALUE_8BITS_REG]     = (uint8_t)(adc_x >> 8);
+    dev->regs[JOYSTICK_ADC_VALUE_8BITS_REG + 1] = (uint8_t)(adc_y >> 8);
+    memcpy(&dev->regs[JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG], &offset_x, 2);
+    memcpy(&dev->regs[JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 2], &offset_y, 2);
+    dev->regs[JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG]     = (uint8_t)(int8_t)(offset_x / 32);
+    dev->regs[JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG + 1] = (uint8_t)(int8_t)(offset_y / 32);
+    dev->regs[JOYSTICK_BUTTON_REG] = button;
+    return true;
+}
+
+void JoystickMockBus::set_speed_fault(uint32_t min_speed, uint32_t fail_every)
+{
+    _fault_speed = min_speed;
+    _fault_every = fail_every;
+}
+
+bool JoystickMockBus::fault(void)
+{
+    return _fault_every > 0 && _speed >= _fault_speed && _transfers % _fault_every == 0;
+}
+
+uint32_t JoystickMockBus::wire_time_us(uint8_t nbytes, bool read)
+{
+    // 9 clocks per byte with its ACK: address, register, data, plus start and stop
+    uint32_t bits = 9 * (2 + nbytes + (read ? 1 : 0)) + 2 + (read ? 1 : 0);
+    return (uint32_t)(((uint64_t)bits * 1000000 + _speed - 1) / _speed);
+}
+
+void JoystickMockBus::wire_delay(uint8_t nbytes, bool read)
+{
+    if (_wire_timing) {
+        joystick_sleep_us(wire_time_us(nbytes, read));
+    }
+}
+
+uint8_t *JoystickMockBus::get_regs(uint8_t addr)
+{
+    device_t *dev = find(addr);
+    return dev != nullptr ? dev->regs : nullptr;
+}
+
+int JoystickMockBus::read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    _transfers++;
+    wire_delay(nbytes, true);
+    device_t *dev = find(addr);
+    if (dev == nullptr || !dev->present || fault()) {
+        return PICO_ERROR_GENERIC; // Address NACK
+    }
+    // The register pointer stops at the last register
+    uint8_t count = reg + nbytes > 256 ? 256 - reg : nbytes;
+    memcpy(buf, &dev->regs[reg], count);
+    return count;
+}
+
+int JoystickMockBus::write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    _transfers++;
+    wire_delay(nbytes, false);
+    device_t *dev = find(addr);
+    if (dev == nullptr || !dev->present || fault()) {
+        return PICO_ERROR_GENERIC;
+    }
+    uint8_t count = reg + nbytes > 256 ? 256 - reg : nbytes;
+    memcpy(&dev->regs[reg], buf, count);
+    if (reg + count > JOYSTICK_I2C_ADDRESS_REG) {
+        dev->addr = dev->regs[JOYSTICK_I2C_ADDRESS_REG];
+    }
+    return count;
+}
@@ -0,0 +1,92 @@
+#include "joystick_pipeline.hpp"
+
+// Tables are generated by the compiler and placed in flash
+const JoystickCurve joystick_curve_linear(JOYSTICK_CURVE_LINEAR, 0);
+const JoystickCurve joystick_curve_expo(JOYSTICK_CURVE_CUBIC, 128);
+const JoystickCurve joystick_curve_cubic(JOYSTICK_CURVE_CUBIC, 256);
+
+static_assert(JoystickCurve(JOYSTICK_CURVE_LINEAR, 0).apply(12345) == 12345, "linear curve must be identity");
+static_assert(JoystickCurve(JOYSTICK_CURVE_CUBIC, 256).apply(JOYSTICK_Q15_ONE) == JOYSTICK_Q15_ONE,
+              "curves must reach full deflection");
+static_assert(JoystickCurve(JOYSTICK_CURVE_CUBIC, 256).apply(-16384) == -4096, "curves must be odd-symmetric");
+
+JoystickPipeline::JoystickPipeline()
+{
+    set_config(joystick_pipeline_config_t());
+}
+
+void JoystickPipeline::set_config(const joystick_pipeline_config_t &config)
+{
+    _config = config;
+    if (_config.outer_zone <= _config.dead_zone) {
+        _config.outer_zone = _config.dead_zone + 1;
+    }
+    if (_config.alpha_min_q8 > 256) _config.alpha_min_q8 = 256;
+    if (_config.alpha_max_q8 > 256) _config.alpha_max_q8 = 256;
+    if (_config.alpha_max_q8 < _config.alpha_min_q8) _config.alpha_max_q8 = _config.alpha_min_q8;
+    if (_config.adapt_q15 < 256) _config.adapt_q15 = 256;
+    // Bounded by 256 << 16, so residual * gain below adapt_q15 fits in 32 bits
+    _adapt_gain_q16 = ((uint32_t)(_config.alpha_max_q8 - _config.alpha_min_q8) << 16) / _config.adapt_q15;
+    reset();
+}
+
+void JoystickPipeline::reset(void)
+{
+    _x.position = _x.velocity = 0;
+    _y.position = _y.velocity = 0;
+    _output.x = 0;
+    _output.y = 0;
+}
+
+int16_t JoystickPipeline::filter(axis_t &axis, int32_t target)
+{
+    int32_t predicted = axis.position + axis.velocity;
+    int32_t residual = target - predicted;
+    uint32_t magnitude = residual < 0 ? -residual : residual;
+
+    // Position gain grows with the residual: jitter is smoothed, real moves are not delayed
+    uint32_t alpha = _config.alpha_max_q8;
+    if (magnitude < _config.adapt_q15) {
+        alpha = _config.alpha_min_q8 + ((magnitude * _adapt_gain_q16) >> 16);
+    }
+
+    axis.position = predicted + (int32_t)(alpha * residual) / 256;
+    axis.velocity += (int32_t)(_config.beta_q8 * residual) / 256;
+
+    if (axis.position > JOYSTICK_Q15_ONE) axis.position = JOYSTICK_Q15_ONE;
+    if (axis.position < -JOYSTICK_Q15_ONE) axis.position = -JOYSTICK_Q15_ONE;
+    if (axis.velocity > JOYSTICK_Q15_ONE) axis.velocity = JOYSTICK_Q15_ONE;
+    if (axis.velocity < -JOYSTICK_Q15_ONE) axis.velocity = -JOYSTICK_Q15_ONE;
+    return (int16_t)axis.position;
+}
+
+joystick_vector_t JoystickPipeline::update(int16_t offset_x, int16_t offset_y)
+{
+    int32_t x = offset_x;
+    int32_t y = offset_y;
+    uint32_t abs_x = x < 0 ? -x : x;
+    uint32_t abs_y = y < 0 ? -y : y;
+
+    // Alpha max plus beta min magnitude estimate (0.960, 0.398), within 4%
+    uint32_t major = abs_x > abs_y ? abs_x : abs_y;
+    uint32_t minor = abs_x > abs_y ? abs_y : abs_x;
+    uint32_t magnitude = (major * 246 + minor * 102) >> 8;
+
+    if (magnitude <= _config.dead_zone) {
+        // Releasing the stick stops at once instead of coasting on the velocity
+        reset();
+        return _output;
+    }
+
+    uint32_t scaled = JOYSTICK_Q15_ONE;
+    if (magnitude < _config.outer_zone) {
+        scaled = (magnitude - _config.dead_zone) * JOYSTICK_Q15_ONE / (_config.outer_zone - _config.dead_zone);
+    }
+    // Keep the direction, rescale the length to the travel outside the dead zone
+    int32_t nx = x * (int32_t)scaled / (int32_t)magnitude;
+    int32_t ny = y * (int32_t)scaled / (int32_t)magnitude;
+
+    _output.x = filter(_x, _config.curve_x->apply(nx));
+    _output.y = filter(_y, _config.curve_y->apply(ny));
+    return _output;
+}
@@ -0,0 +1,80 @@
+#include "joystick_platform.hpp"
+
+// Host build only: simulated clock, see joystick_platform.hpp
+static uint64_t host_time_us = 0;
+static uint64_t host_alarm_us = 0;
+static void (*host_alarm_cb)(void *ctx) = nullptr;
+static void *host_alarm_ctx = nullptr;
+
+static void host_advance_to(uint64_t us)
+{
+    // Stop at the alarm on the way, like an interrupt during the sleep
+    while (host_alarm_cb != nullptr && host_alarm_us <= us) {
+        if (host_alarm_us > host_time_us) {
+            host_time_us = host_alarm_us;
+        }
+        void (*cb)(void *ctx) = host_alarm_cb;
+        host_alarm_cb = nullptr;
+        cb(host_alarm_ctx);
+    }
+    if (us > host_time_us) {
+        host_time_us = us;
+    }
+}
+
+uint64_t joystick_time_us(void)
+{
+    return host_time_us;
+}
+
+void joystick_sleep_us(uint64_t us)
+{
+    host_advance_to(host_time_us + us);
+}
+
+void joystick_sleep_ms(uint32_t ms)
+{
+    host_advance_to(host_time_us + (uint64_t)ms * 1000);
+}
+
+void joystick_sleep_until_us(uint64_t us)
+{
+    host_advance_to(us);
+}
+
+void joystick_host_advance_us(uint64_t us)
+{
+    host_advance_to(host_time_us + us);
+}
+
+void joystick_host_set_time_us(uint64_t us)
+{
+    host_time_us = us;
+}
+
+void joystick_host_set_alarm(uint64_t at_us, void (*cb)(void *ctx), void *ctx)
+{
+    host_alarm_us  = at_us;
+    host_alarm_cb  = cb;
+    host_alarm_ctx = ctx;
+}
+
+// The ST7789 host driver runs on the same clock, see st7789_platform.hpp
+namespace st7789 {
+
+uint64_t platformTimeUs()
+{
+    return host_time_us;
+}
+
+void platformSleepUs(uint64_t us)
+{
+    host_advance_to(host_time_us + us);
+}
+
+void platformSetAlarm(uint64_t at_us, void (*cb)(void* ctx), void* ctx)
+{
+    joystick_host_set_alarm(at_us, cb, ctx);
+}
+
+}
@@ -0,0 +1,130 @@
+#include "joystick_poll.hpp"
+
+JoystickClock joystick_system_clock;
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+JoystickPoller::JoystickPoller() :
+    _clock(&joystick_system_clock),
+    _period_us(0),
+    _deadline_us(0),
+    _last_poll_us(0)
+{
+    reset_stats();
+}
+
+void JoystickPoller::begin(uint32_t period_us, JoystickClock *clock)
+{
+    _clock = clock;
+    _period_us = period_us > 0 ? period_us : 1;
+    _deadline_us = _clock->now_us() + _period_us;
+    _last_poll_us = 0;
+    reset_stats();
+}
+
+void JoystickPoller::reset_stats(void)
+{
+    _polls = 0;
+    _intervals = 0;
+    _sum_dev = 0;
+    _sum_dev2 = 0;
+    _max_late_us = 0;
+    _missed = 0;
+}
+
+void JoystickPoller::mark(uint64_t now_us)
+{
+    if (now_us >= _deadline_us) {
+        uint32_t late = (uint32_t)(now_us - _deadline_us);
+        if (late > _max_late_us) _max_late_us = late;
+        // Stay on the grid: skip the deadlines that passed during a late poll
+        uint64_t skipped = (now_us - _deadline_us) / _period_us;
+        _missed += (uint32_t)skipped;
+        _deadline_us += (skipped + 1) * _period_us;
+    } else {
+        // Early external poll (timer drift): move to the deadline after it
+        _deadline_us += _period_us;
+    }
+
+    if (_polls > 0) {
+        int64_t dev = (int64_t)(now_us - _last_poll_us) - _period_us;
+        _sum_dev += dev;
+        _sum_dev2 += (uint64_t)(dev * dev);
+        _intervals++;
+    }
+    _polls++;
+    _last_poll_us = now_us;
+}
+
+uint64_t JoystickPoller::wait(void)
+{
+    _clock->sleep_until_us(_deadline_us);
+    uint64_t now = _clock->now_us();
+    mark(now);
+    return now;
+}
+
+bool JoystickPoller::poll_due(void)
+{
+    uint64_t now = _clock->now_us();
+    if (now < _deadline_us) {
+        return false;
+    }
+    mark(now);
+    return true;
+}
+
+uint64_t JoystickPoller::phase_deadline(uint32_t offset_us)
+{
+    // Last deadline of the grid
+    return grid_phase(_deadline_us - _period_us, _period_us, offset_us, _clock->now_us());
+}
+
+uint64_t JoystickPoller::grid_phase(uint64_t grid_us, uint32_t period_us, uint32_t offset_us, uint64_t now_us)
+{
+    // Grid point plus the phase, then whole periods until it is ahead
+    uint64_t t = grid_us + offset_us % period_us;
+    if (t < now_us) {
+        t += ((now_us - t) / period_us + 1) * period_us;
+    }
+    return t;
+}
+
+void JoystickPoller::wait_phase(uint32_t offset_us)
+{
+    _clock->sleep_until_us(phase_deadline(offset_us));
+}
+
+void JoystickPoller::get_stats(joystick_poll_stats_t *stats)
+{
+    stats->polls = _polls;
+    stats->period_us = _period_us;
+    stats->max_late_us = _max_late_us;
+    stats->missed = _missed;
+    if (_intervals == 0) {
+        stats->mean_period_us = _period_us;
+        stats->stddev_us = 0;
+        return;
+    }
+    int64_t mean_dev = _sum_dev / (int64_t)_intervals;
+    int64_t var = (int64_t)(_sum_dev2 / _intervals) - mean_dev * mean_dev;
+    stats->mean_period_us = (uint32_t)((int64_t)_period_us + mean_dev);
+    stats->stddev_us = var > 0 ? isqrt64((uint64_t)var) : 0;
+}
@@ -0,0 +1,377 @@
+#include "joystick_record.hpp"
+#include "joystick_calibration.hpp" // For joystick_cal_crc32
+#include <stdio.h>
+#include <cstring> // For strstr
+
+#define RECORD_FLAG_BUTTON 0x01
+#define RECORD_FLAG_DT     0x02
+#define RECORD_FLAG_X      0x04
+#define RECORD_FLAG_Y      0x08
+#define RECORD_MAX_SAMPLE  12   // Flag byte, 5-byte time step, two 3-byte deltas
+
+static uint32_t put_varint(uint8_t *buf, uint32_t value)
+{
+    uint32_t n = 0;
+    while (value >= 0x80) {
+        buf[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool get_varint(const uint8_t *buf, uint32_t size, uint32_t *pos, uint32_t *value)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && *pos < size; shift += 7) {
+        uint8_t byte = buf[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Small deltas of either sign become small unsigned values
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+JoystickRecorder::JoystickRecorder() :
+    _buf(nullptr),
+    _capacity(0),
+    _size(0),
+    _count(0),
+    _full(false),
+    _last_time(0),
+    _last_dt(0),
+    _last_x(0),
+    _last_y(0)
+{
+}
+
+void JoystickRecorder::begin(uint8_t *buf, uint32_t size)
+{
+    _buf      = buf;
+    _capacity = size;
+    _size     = 0;
+    _count    = 0;
+    _full     = false;
+    _last_dt  = 0;
+    _last_x   = 0;
+    _last_y   = 0;
+}
+
+bool JoystickRecorder::record(const joystick_state_t &state)
+{
+    return record(state.timestamp_us, state.offset_x, state.offset_y, state.button);
+}
+
+bool JoystickRecorder::record(uint64_t time_us, int16_t offset_x, int16_t offset_y, uint8_t button)
+{
+    if (_buf == nullptr || _capacity - _size < RECORD_MAX_SAMPLE) {
+        _full = true;
+        return false;
+    }
+
+    if (_count == 0) {
+        _last_time = time_us; // Time starts at the first sample
+    }
+    uint64_t delta = time_us - _last_time;
+    uint32_t dt = delta > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)delta;
+    int32_t dx = offset_x - _last_x;
+    int32_t dy = offset_y - _last_y;
+
+    uint8_t *flags = &_buf[_size++];
+    *flags = button ? RECORD_FLAG_BUTTON : 0;
+    if (dt != _last_dt) {
+        *flags |= RECORD_FLAG_DT;
+        _size += put_varint(&_buf[_size], dt);
+    }
+    if (dx != 0) {
+        *flags |= RECORD_FLAG_X;
+        _size += put_varint(&_buf[_size], zigzag(dx));
+    }
+    if (dy != 0) {
+        *flags |= RECORD_FLAG_Y;
+        _size += put_varint(&_buf[_size], zigzag(dy));
+    }
+
+    _last_time += dt;
+    _last_dt = dt;
+    _last_x  = offset_x;
+    _last_y  = offset_y;
+    _count++;
+    return true;
+}
+
+void JoystickRecorder::dump(void) const
+{
+    printf("JREC %lu %lu %08lx\n", (unsigned long)_count, (unsigned long)_size,
+           (unsigned long)joystick_cal_crc32(_buf, _size));
+    for (uint32_t i = 0; i < _size; i++) {
+        printf("%02x", _buf[i]);
+        if ((i & 31) == 31 || i == _size - 1) {
+            printf("\n");
+        }
+    }
+    printf("JEND\n");
+}
+
+JoystickRecordReader::JoystickRecordReader() :
+    _data(nullptr),
+    _size(0),
+    _pos(0),
+    _time(0),
+    _dt(0),
+    _x(0),
+    _y(0)
+{
+}
+
+void JoystickRecordReader::begin(const uint8_t *data, uint32_t size)
+{
+    _data = data;
+    _size = size;
+    _pos  = 0;
+    _time = 0;
+    _dt   = 0;
+    _x    = 0;
+    _y    = 0;
+}
+
+bool JoystickRecordReader::next(joystick_record_sample_t *sample)
+{
+    if (_data == nullptr || _pos >= _size) {
+        return false;
+    }
+    uint32_t pos = _pos;
+    uint8_t flags = _data[pos++];
+    uint32_t dt = _dt, ux = 0, uy = 0;
+    if ((flags & RECORD_FLAG_DT) && !get_varint(_data, _size, &pos, &dt)) {
+        return false;
+    }
+    if ((flags & RECORD_FLAG_X) && !get_varint(_data, _size, &pos, &ux)) {
+        return false;
+    }
+    if ((flags & RECORD_FLAG_Y) && !get_varint(_data, _size, &pos, &uy)) {
+        return false;
+    }
+
+    // The first sample has no predecessor, its time is 0
+    _time = (_pos == 0) ? 0 : _time + dt;
+    _dt   = dt;
+    _x    = (int16_t)(_x + unzigzag(ux));
+    _y    = (int16_t)(_y + unzigzag(uy));
+    _pos  = pos;
+
+    sample->time_us  = _time;
+    sample->offset_x = _x;
+    sample->offset_y = _y;
+    sample->button   = (flags & RECORD_FLAG_BUTTON) ? 1 : 0;
+    return true;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool joystick_record_parse_dump(const char *text, uint8_t *buf, uint32_t max_size, uint32_t *size)
+{
+    const char *start = strstr(text, "JREC ");
+    if (start == nullptr) {
+        return false;
+    }
+    unsigned long count, expected_size, crc;
+    if (sscanf(start, "JREC %lu %lu %lx", &count, &expected_size, &crc) != 3 || expected_size > max_size) {
+        return false;
+    }
+
+    const char *p = strchr(start, '\n');
+    uint32_t n = 0;
+    int high = -1;
+    while (p != nullptr && *p != '\0' && strncmp(p, "JEND", 4) != 0) {
+        int v = hex_value(*p);
+        if (v >= 0) {
+            if (high < 0) {
+                high = v;
+            } else {
+                if (n >= max_size) {
+                    return false;
+                }
+                buf[n++] = (uint8_t)((high << 4) | v);
+                high = -1;
+            }
+        }
+        p++;
+    }
+    *size = n;
+    return n == expected_size && joystick_cal_crc32(buf, n) == crc;
+}
+
+JoystickReplayTransport::JoystickReplayTransport() :
+    _mode(JOYSTICK_REPLAY_REALTIME),
+    _loop(false),
+    _finished(true),
+    _played(0),
+    _start_us(0),
+    _current(),
+    _next(),
+    _has_next(false),
+    _frame_blocks(0),
+    _rgb(),
+    _cal()
+{
+    _current.button = 1;
+}
+
+void JoystickReplayTransport::begin(const uint8_t *data, uint32_t size, joystick_replay_mode_t mode, bool loop)
+{
+    _reader.begin(data, size);
+    _mode     = mode;
+    _loop     = loop;
+    _played   = 0;
+    _current  = joystick_record_sample_t();
+    _current.button = 1;
+    _has_next = _reader.next(&_next);
+    _finished = !_has_next;
+    _frame_blocks = 0;
+    _start_us = joystick_time_us();
+}
+
+void JoystickReplayTransport::advance(void)
+{
+    if (!_has_next && _loop && _played > 0) {
+        _reader.rewind();
+        _has_next = _reader.next(&_next);
+        _start_us = joystick_time_us();
+    }
+    if (!_has_next) {
+        _finished = true;
+        return;
+    }
+    _current  = _next;
+    _played++;
+    _has_next = _reader.next(&_next);
+    _finished = !_has_next && !_loop;
+}
+
+uint8_t JoystickReplayTransport::reg_value(uint8_t addr, uint8_t reg)
+{
+    int16_t x = _current.offset_x;
+    int16_t y = _current.offset_y;
+    switch (reg) {
+        // 16bits ADC values approximated from the offsets, center at half scale
+        case JOYSTICK_ADC_VALUE_12BITS_REG + 0: return (uint8_t)((32768 + x * 8) & 0xFF);
+        case JOYSTICK_ADC_VALUE_12BITS_REG + 1: return (uint8_t)((32768 + x * 8) >> 8);
+        case JOYSTICK_ADC_VALUE_12BITS_REG + 2: return (uint8_t)((32768 + y * 8) & 0xFF);
+        case JOYSTICK_ADC_VALUE_12BITS_REG + 3: return (uint8_t)((32768 + y * 8) >> 8);
+        case JOYSTICK_ADC_VALUE_8BITS_REG + 0:  return (uint8_t)(128 + x / 32);
+        case JOYSTICK_ADC_VALUE_8BITS_REG + 1:  return (uint8_t)(128 + y / 32);
+        case JOYSTICK_BUTTON_REG:               return _current.button;
+        case JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 0: return (uint8_t)(x & 0xFF);
+        case JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 1: return (uint8_t)((uint16_t)x >> 8);
+        case JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 2: return (uint8_t)(y & 0xFF);
+        case JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 3: return (uint8_t)((uint16_t)y >> 8);
+        case JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG + 0:  return (uint8_t)(int8_t)(x / 32);
+        case JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG + 1:  return (uint8_t)(int8_t)(y / 32);
+        case JOYSTICK_BOOTLOADER_VERSION_REG:   return 1;
+        case JOYSTICK_FIRMWARE_VERSION_REG:     return 1;
+        case JOYSTICK_I2C_ADDRESS_REG:          return addr;
+        default:
+            break;
+    }
+    if (reg >= JOYSTICK_RGB_REG && reg < JOYSTICK_RGB_REG + 4) {
+        return _rgb[reg - JOYSTICK_RGB_REG];
+    }
+    if (reg >= JOYSTICK_ADC_VALUE_CAL_REG && reg < JOYSTICK_ADC_VALUE_CAL_REG + 16) {
+        return _cal[reg - JOYSTICK_ADC_VALUE_CAL_REG];
+    }
+    return 0;
+}
+
+// Bit of an x/y register block in _frame_blocks, 0 for other registers
+static uint8_t xy_block(uint8_t reg)
+{
+    switch (reg) {
+        case JOYSTICK_ADC_VALUE_12BITS_REG:        return 0x01;
+        case JOYSTICK_ADC_VALUE_8BITS_REG:         return 0x02;
+        case JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG: return 0x04;
+        case JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG:  return 0x08;
+        default:                                   return 0;
+    }
+}
+
+void JoystickReplayTransport::play_realtime(void)
+{
+    uint64_t elapsed = joystick_time_us() - _start_us;
+    while (_has_next && _next.time_us <= elapsed) {
+        advance();
+    }
+    if (_has_next || !_loop || _played == 0) {
+        return;
+    }
+
+    // The last sample lasts one recorded time step, then the recording starts over
+    uint32_t step = _reader.get_step_us();
+    uint64_t length = _current.time_us + (step > 0 ? step : 1);
+    if (elapsed < length) {
+        return;
+    }
+    _start_us += elapsed / length * length;
+    elapsed %= length;
+    _reader.rewind();
+    _has_next = _reader.next(&_next);
+    while (_has_next && _next.time_us <= elapsed) {
+        advance();
+    }
+}
+
+int JoystickReplayTransport::read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    if (_mode == JOYSTICK_REPLAY_FAST) {
+        // A frame starts when an x/y block is read again: read_state() reads
+        // two blocks per frame, the getters one, each frame plays one sample
+        uint8_t block = xy_block(reg);
+        if (block != 0) {
+            if (_played == 0 || (_frame_blocks & block)) {
+                advance();
+                _frame_blocks = 0;
+            }
+            _frame_blocks |= block;
+        }
+    } else {
+        play_realtime();
+    }
+
+    for (uint8_t i = 0; i < nbytes; i++) {
+        buf[i] = reg_value(addr, (uint8_t)(reg + i));
+    }
+    return nbytes;
+}
+
+int JoystickReplayTransport::write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    (void)addr;
+    for (uint8_t i = 0; i < nbytes; i++) {
+        uint8_t r = (uint8_t)(reg + i);
+        if (r >= JOYSTICK_RGB_REG && r < JOYSTICK_RGB_REG + 4) {
+            _rgb[r - JOYSTICK_RGB_REG] = buf[i];
+        } else if (r >= JOYSTICK_ADC_VALUE_CAL_REG && r < JOYSTICK_ADC_VALUE_CAL_REG + 16) {
+            _cal[r - JOYSTICK_ADC_VALUE_CAL_REG] = buf[i];
+        }
+    }
+    return nbytes;
+}
@@ -0,0 +1,112 @@
+#include "joystick_record.hpp"
+#include "joystick_calibration.hpp" // For joystick_cal_crc32
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include <cstring> // For memset
+
+#ifndef JOYSTICK_RECORD_FLASH_SIZE
+#define JOYSTICK_RECORD_FLASH_SIZE (5 * FLASH_SECTOR_SIZE) // Header and a full JOYSTICK_RECORD_BUFFER_SIZE buffer
+#endif
+
+#ifndef JOYSTICK_RECORD_FLASH_OFFSET
+// Below the calibration sector at the end of flash
+#define JOYSTICK_RECORD_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE - JOYSTICK_RECORD_FLASH_SIZE)
+#endif
+
+#ifndef JOYSTICK_RECORD_FLASH_TIMEOUT_MS
+#define JOYSTICK_RECORD_FLASH_TIMEOUT_MS 100 // Wait for the other core to park before flash is written
+#endif
+
+// Header fields are little endian, like the calibration record
+static void put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    buf[2] = (value >> 16) & 0xFF;
+    buf[3] = (value >> 24) & 0xFF;
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+    const uint8_t *page;
+} flash_op_t;
+
+// Runs through flash_safe_execute(): interrupts off here, the other core parked in RAM
+static void record_erase(void *param)
+{
+    const flash_op_t *op = (const flash_op_t *)param;
+    flash_range_erase(op->offset, op->size);
+}
+
+static void record_program(void *param)
+{
+    const flash_op_t *op = (const flash_op_t *)param;
+    flash_range_program(op->offset, op->page, op->size);
+}
+
+bool joystick_record_save(const JoystickRecorder &recorder)
+{
+    uint32_t size = recorder.get_size();
+    if (JOYSTICK_RECORD_HEADER_SIZE + size > JOYSTICK_RECORD_FLASH_SIZE) {
+        return false;
+    }
+    const uint8_t *data = recorder.get_data();
+    uint32_t total = JOYSTICK_RECORD_HEADER_SIZE + size;
+    uint32_t erase = (total + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+
+    // A JoystickSampler on core1 runs from XIP as well, it must not fetch while flash is written
+    flash_op_t op = {JOYSTICK_RECORD_FLASH_OFFSET, erase, nullptr};
+    if (flash_safe_execute(record_erase, &op, JOYSTICK_RECORD_FLASH_TIMEOUT_MS) != PICO_OK) {
+        return false;
+    }
+
+    // Program page by page, the header goes in front of the first data bytes
+    uint8_t page[FLASH_PAGE_SIZE];
+    for (uint32_t offset = 0; offset < total; offset += FLASH_PAGE_SIZE) {
+        memset(page, 0xFF, sizeof(page));
+        for (uint32_t i = 0; i < FLASH_PAGE_SIZE && offset + i < total; i++) {
+            uint32_t pos = offset + i;
+            if (pos >= JOYSTICK_RECORD_HEADER_SIZE) {
+                page[i] = data[pos - JOYSTICK_RECORD_HEADER_SIZE];
+            }
+        }
+        if (offset == 0) {
+            put_u32(&page[0], JOYSTICK_RECORD_MAGIC);
+            put_u32(&page[4], recorder.get_sample_count());
+            put_u32(&page[8], size);
+            put_u32(&page[12], joystick_cal_crc32(data, size));
+        }
+        op = {JOYSTICK_RECORD_FLASH_OFFSET + offset, FLASH_PAGE_SIZE, page};
+        if (flash_safe_execute(record_program, &op, JOYSTICK_RECORD_FLASH_TIMEOUT_MS) != PICO_OK) {
+            return false;
+        }
+    }
+
+    const uint8_t *stored;
+    uint32_t stored_size;
+    return joystick_record_load(&stored, &stored_size) && stored_size == size;
+}
+
+bool joystick_record_load(const uint8_t **data, uint32_t *size)
+{
+    // Flash is memory mapped through XIP
+    const uint8_t *header = (const uint8_t *)(XIP_BASE + JOYSTICK_RECORD_FLASH_OFFSET);
+    uint32_t stored_size = get_u32(&header[8]);
+    if (get_u32(&header[0]) != JOYSTICK_RECORD_MAGIC ||
+        JOYSTICK_RECORD_HEADER_SIZE + stored_size > JOYSTICK_RECORD_FLASH_SIZE) {
+        return false;
+    }
+    const uint8_t *samples = header + JOYSTICK_RECORD_HEADER_SIZE;
+    if (get_u32(&header[12]) != joystick_cal_crc32(samples, stored_size)) {
+        return false;
+    }
+    *data = samples;
+    *size = stored_size;
+    return true;
+}
@@ -0,0 +1,156 @@
+#include "joystick_sampler.hpp"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+
+// core1 entry point takes no argument, keep the running instance here
+static JoystickSampler *core1_sampler_instance = nullptr;
+
+JoystickSampler::JoystickSampler() :
+    _joystick(nullptr),
+    _period_us(JOYSTICK_SAMPLER_PERIOD_US),
+    _fields(JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON),
+    _mode(JOYSTICK_SAMPLER_CORE1),
+    _timer(),
+    _grid_us(0),
+    _running(false),
+    _core1_done(true),
+    _errors(0),
+    _samples(0),
+    _led_color(0),
+    _led_seq(0),
+    _led_applied_seq(0)
+{
+}
+
+bool JoystickSampler::begin(Joystick *joystick, uint32_t period_us, joystick_sampler_mode_t mode, uint8_t fields)
+{
+    if (joystick == nullptr || period_us == 0 || is_running()) {
+        return false;
+    }
+
+    _joystick  = joystick;
+    _period_us = period_us;
+    _mode      = mode;
+    _fields    = fields;
+    _led_applied_seq = _led_seq.load(std::memory_order_relaxed);
+    _poller.begin(_period_us);
+    _grid_us = _poller.get_next_deadline_us() - _period_us;
+
+    _running.store(true, std::memory_order_release);
+
+    if (_mode == JOYSTICK_SAMPLER_CORE1) {
+        if (core1_sampler_instance != nullptr) {
+            _running.store(false, std::memory_order_release);
+            return false;
+        }
+        core1_sampler_instance = this;
+        _core1_done.store(false, std::memory_order_release);
+        multicore_launch_core1(core1_entry);
+        return true;
+    }
+
+    // Negative delay: the period is measured between callback starts, not ends
+    if (!add_repeating_timer_us(-(int64_t)_period_us, timer_callback, this, &_timer)) {
+        _running.store(false, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+void JoystickSampler::end(void)
+{
+    if (!is_running()) {
+        return;
+    }
+    _running.store(false, std::memory_order_release);
+
+    if (_mode == JOYSTICK_SAMPLER_CORE1) {
+        // Let core1 finish the transaction in flight before resetting it
+        while (!_core1_done.load(std::memory_order_acquire)) {
+            tight_loop_contents();
+        }
+        multicore_reset_core1();
+        core1_sampler_instance = nullptr;
+    } else {
+        cancel_repeating_timer(&_timer);
+    }
+}
+
+bool JoystickSampler::get_latest(joystick_state_t *sample)
+{
+    return _ring.peek_latest(sample);
+}
+
+uint32_t JoystickSampler::drain(joystick_state_t *samples, uint32_t max_samples)
+{
+    return _ring.drain(samples, max_samples);
+}
+
+void JoystickSampler::set_rgb_color(uint32_t color)
+{
+    if (!is_running()) {
+        _joystick->set_rgb_color(color);
+        return;
+    }
+    _led_color.store(color, std::memory_order_relaxed);
+    _led_seq.store(_led_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint64_t JoystickSampler::phase_deadline(uint32_t offset_us)
+{
+    // The poller's deadlines never leave the grid set up in begin(). Its origin
+    // gives the phase without reading _deadline_us, a 64-bit value the sampling
+    // side rewrites on every poll and that could be read half updated here.
+    return JoystickPoller::grid_phase(_grid_us, _period_us, offset_us, time_us_64());
+}
+
+void JoystickSampler::sample_once(void)
+{
+    // Apply a pending LED request first so the bus is never shared between cores
+    uint32_t led_seq = _led_seq.load(std::memory_order_acquire);
+    if (led_seq != _led_applied_seq) {
+        _led_applied_seq = led_seq;
+        _joystick->set_rgb_color(_led_color.load(std::memory_order_relaxed));
+    }
+
+    joystick_state_t sample;
+    if (!_joystick->read_state(&sample, _fields)) {
+        _errors.store(_errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    _samples.store(_samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _ring.push(sample);
+}
+
+void JoystickSampler::run_core1(void)
+{
+    // Let flash_safe_execute() on core0 park this core while flash is written
+    flash_safe_execute_core_init();
+
+    // Absolute deadlines keep the period constant regardless of bus time
+    while (_running.load(std::memory_order_acquire)) {
+        _poller.wait();
+        sample_once();
+    }
+    flash_safe_execute_core_deinit();
+    _core1_done.store(true, std::memory_order_release);
+}
+
+void JoystickSampler::core1_entry(void)
+{
+    core1_sampler_instance->run_core1();
+    while (true) {
+        tight_loop_contents();
+    }
+}
+
+bool JoystickSampler::timer_callback(repeating_timer_t *rt)
+{
+    JoystickSampler *sampler = (JoystickSampler *)rt->user_data;
+    if (!sampler->_running.load(std::memory_order_acquire)) {
+        return false;
+    }
+    sampler->_poller.mark(time_us_64());
+    sampler->sample_once();
+    return true;
+}
@@ -0,0 +1,258 @@
+#include "joystick_scheduler.hpp"
+#include "joystick.hpp"
+#include <cstring> // For memcpy
+
+JoystickScheduler::JoystickScheduler() :
+    _bus(nullptr),
+    _client_count(0),
+    _pending(0),
+    _seq(0),
+    _stats_start_us(0)
+{
+    for (int i = 0; i < JOYSTICK_SCHED_QUEUE_SIZE; i++) {
+        _queue[i].used = false;
+    }
+}
+
+void JoystickScheduler::begin(JoystickTransport *bus)
+{
+    _bus = bus;
+    reset_stats();
+}
+
+int JoystickScheduler::add_client(joystick_priority_t priority, uint32_t deadline_us)
+{
+    if (_client_count >= JOYSTICK_SCHED_MAX_CLIENTS) {
+        return -1;
+    }
+    client_t &c = _clients[_client_count];
+    c.priority    = (uint8_t)priority;
+    c.deadline_us = deadline_us;
+    c.last_us     = 0;
+    c.stats       = joystick_sched_stats_t();
+    return _client_count++;
+}
+
+JoystickScheduler::request_t *JoystickScheduler::enqueue(int client, uint8_t addr, uint8_t reg,
+                                                         uint8_t nbytes, bool write)
+{
+    if (!valid_client(client)) {
+        return nullptr;
+    }
+    for (int i = 0; i < JOYSTICK_SCHED_QUEUE_SIZE; i++) {
+        request_t &r = _queue[i];
+        if (r.used) {
+            continue;
+        }
+        r.used        = true;
+        r.write       = write;
+        r.posted      = false;
+        r.client      = (uint8_t)client;
+        r.addr        = addr;
+        r.reg         = reg;
+        r.nbytes      = nbytes;
+        r.buf         = nullptr;
+        r.seq         = _seq++;
+        r.submit_us   = joystick_time_us();
+        r.deadline_us = r.submit_us + _clients[client].deadline_us;
+        r.result      = PICO_ERROR_GENERIC;
+        _pending++;
+        return &r;
+    }
+    return nullptr;
+}
+
+JoystickScheduler::request_t *JoystickScheduler::next(uint64_t now_us)
+{
+    // Another transaction may take the bus just before a due one gets its turn
+    uint32_t lead_us = 0;
+    for (uint8_t i = 0; i < _client_count; i++) {
+        if (_clients[i].last_us > lead_us) lead_us = _clients[i].last_us;
+    }
+
+    request_t *best = nullptr;
+    bool best_due = false;
+    for (int i = 0; i < JOYSTICK_SCHED_QUEUE_SIZE; i++) {
+        request_t *r = &_queue[i];
+        if (!r->used) {
+            continue;
+        }
+        bool due = r->deadline_us <= now_us + _clients[r->client].last_us + lead_us;
+        if (best == nullptr) {
+            best = r;
+            best_due = due;
+            continue;
+        }
+        if (due != best_due) {
+            // A due transaction goes before anything that can still wait
+            if (due) {
+                best = r;
+                best_due = true;
+            }
+            continue;
+        }
+        uint8_t p = _clients[r->client].priority;
+        uint8_t best_p = _clients[best->client].priority;
+        bool better;
+        if (!due && p != best_p) {
+            better = p < best_p;
+        } else if (r->deadline_us != best->deadline_us) {
+            better = r->deadline_us < best->deadline_us;
+        } else {
+            better = (int32_t)(r->seq - best->seq) < 0;
+        }
+        if (better) {
+            best = r;
+        }
+    }
+    return best;
+}
+
+void JoystickScheduler::execute(request_t *req)
+{
+    const uint8_t *data = req->posted ? req->data : req->buf;
+    uint64_t start = joystick_time_us();
+    req->result = req->write ? _bus->write_reg(req->addr, req->reg, data, req->nbytes)
+                             : _bus->read_reg(req->addr, req->reg, req->buf, req->nbytes);
+    uint64_t end = joystick_time_us();
+
+    client_t &c = _clients[req->client];
+    c.last_us = (uint32_t)(end - start);
+    joystick_sched_stats_t &s = c.stats;
+    uint32_t wait = (uint32_t)(start - req->submit_us);
+    s.transactions++;
+    s.busy_us += end - start;
+    if (wait > s.max_wait_us) s.max_wait_us = wait;
+    if (end > req->deadline_us) s.deadline_misses++;
+    if (req->result != req->nbytes) s.errors++;
+
+    req->used = false;
+    _pending--;
+}
+
+int JoystickScheduler::run_blocking(request_t *req)
+{
+    if (req == nullptr) {
+        return PICO_ERROR_GENERIC; // Queue full
+    }
+    // Everything the policy puts before this transaction runs first
+    for (;;) {
+        request_t *r = next(joystick_time_us());
+        execute(r);
+        if (r == req) {
+            return r->result;
+        }
+    }
+}
+
+int JoystickScheduler::read(int client, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    request_t *req = enqueue(client, addr, reg, nbytes, false);
+    if (req != nullptr) {
+        req->buf = buf;
+    }
+    return run_blocking(req);
+}
+
+int JoystickScheduler::write(int client, uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    request_t *req = enqueue(client, addr, reg, nbytes, true);
+    if (req != nullptr) {
+        req->buf = const_cast<uint8_t *>(buf); // Only read by write_reg
+    }
+    return run_blocking(req);
+}
+
+bool JoystickScheduler::post_write(int client, uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    request_t *req = nbytes <= JOYSTICK_SCHED_MAX_POSTED ? enqueue(client, addr, reg, nbytes, true) : nullptr;
+    if (req == nullptr) {
+        if (valid_client(client)) {
+            _clients[client].stats.dropped++;
+        }
+        return false;
+    }
+    req->posted = true;
+    memcpy(req->data, buf, nbytes);
+    return true;
+}
+
+bool JoystickScheduler::poll(void)
+{
+    if (_pending == 0) {
+        return false;
+    }
+    execute(next(joystick_time_us()));
+    return true;
+}
+
+void JoystickScheduler::flush(void)
+{
+    while (poll()) {
+    }
+}
+
+const joystick_sched_stats_t &JoystickScheduler::get_stats(int client)
+{
+    // Unknown ids see counters that stay at 0
+    static const joystick_sched_stats_t none = joystick_sched_stats_t();
+    return valid_client(client) ? _clients[client].stats : none;
+}
+
+uint32_t JoystickScheduler::get_utilization(int client)
+{
+    uint64_t elapsed = joystick_time_us() - _stats_start_us;
+    if (!valid_client(client) || elapsed == 0) {
+        return 0;
+    }
+    return (uint32_t)(_clients[client].stats.busy_us * 1000 / elapsed);
+}
+
+void JoystickScheduler::reset_stats(void)
+{
+    for (uint8_t i = 0; i < _client_count; i++) {
+        _clients[i].stats = joystick_sched_stats_t();
+    }
+    _stats_start_us = joystick_time_us();
+}
+
+JoystickSchedulerClient::JoystickSchedulerClient() :
+    _scheduler(nullptr),
+    _id(-1),
+    _posted(false)
+{
+}
+
+bool JoystickSchedulerClient::begin(JoystickScheduler *scheduler, joystick_priority_t priority,
+                                    uint32_t deadline_us, bool posted_writes)
+{
+    _scheduler = scheduler;
+    _id = scheduler->add_client(priority, deadline_us);
+    _posted = posted_writes;
+    return _id >= 0;
+}
+
+int JoystickSchedulerClient::read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    return _scheduler->read(_id, addr, reg, buf, nbytes);
+}
+
+int JoystickSchedulerClient::write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    if (_posted && nbytes <= JOYSTICK_SCHED_MAX_POSTED) {
+        return _scheduler->post_write(_id, addr, reg, buf, nbytes) ? nbytes : PICO_ERROR_GENERIC;
+    }
+    return _scheduler->write(_id, addr, reg, buf, nbytes);
+}
+
+uint32_t JoystickSchedulerClient::set_speed(uint32_t speed)
+{
+    // Queued transactions were submitted for the old clock
+    _scheduler->flush();
+    return _scheduler->get_bus()->set_speed(speed);
+}
+
+uint32_t JoystickSchedulerClient::get_speed(void)
+{
+    return _scheduler->get_bus()->get_speed();
+}
@@ -0,0 +1,153 @@
+#include "joystick_speed.hpp"
+#include "joystick.hpp"
+
+const uint32_t JoystickSpeedControl::speeds[JOYSTICK_SPEED_LEVELS] = {100000, 400000, 1000000};
+
+JoystickSpeedControl::JoystickSpeedControl() :
+    _transport(nullptr),
+    _addr(0),
+    _level(0),
+    _window_count(0),
+    _window_errors(0),
+    _errors(0),
+    _transfers(0),
+    _downshifts(0)
+{
+}
+
+void JoystickSpeedControl::begin(JoystickTransport *transport)
+{
+    _transport = transport;
+    _addr = 0;
+    _level = 0;
+    _window_count = 0;
+    _window_errors = 0;
+}
+
+uint32_t JoystickSpeedControl::probe(uint8_t addr, uint8_t firmware_version, uint32_t count)
+{
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t version = 0;
+        uint8_t i2c_addr = 0;
+        uint8_t offset[4];
+        // Known registers must match, the offset burst checks multi-byte reads
+        bool ok = _transport->read_reg(addr, JOYSTICK_FIRMWARE_VERSION_REG, &version, 1) == 1 &&
+                  version == firmware_version &&
+                  _transport->read_reg(addr, JOYSTICK_I2C_ADDRESS_REG, &i2c_addr, 1) == 1 &&
+                  i2c_addr == addr &&
+                  _transport->read_reg(addr, JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG, offset, 4) == 4;
+        if (!ok) {
+            failures++;
+        }
+    }
+    return failures;
+}
+
+uint32_t JoystickSpeedControl::negotiate(uint8_t addr, uint32_t max_speed)
+{
+    if (_transport == nullptr) {
+        return 0;
+    }
+
+    // Reference values are taken at the slowest speed
+    _level = 0;
+    _transport->set_speed(speeds[0]);
+    uint8_t version = 0;
+    bool found = false;
+    for (int i = 0; i < 3 && !found; i++) {
+        found = _transport->read_reg(addr, JOYSTICK_FIRMWARE_VERSION_REG, &version, 1) == 1;
+    }
+    if (!found || probe(addr, version) > 0) {
+        return 0;
+    }
+
+    // Higher speeds are only tried while the previous one was error free
+    uint8_t best = 0;
+    for (uint8_t level = 1; level < JOYSTICK_SPEED_LEVELS && speeds[level] <= max_speed; level++) {
+        _transport->set_speed(speeds[level]);
+        if (probe(addr, version) > 0) {
+            break;
+        }
+        best = level;
+    }
+
+    _addr = addr;
+    _level = best;
+    _window_count = 0;
+    _window_errors = 0;
+    return _transport->set_speed(speeds[best]);
+}
+
+uint32_t JoystickSpeedControl::attach(Joystick *joystick, uint8_t addr, uint32_t max_speed)
+{
+    JoystickTransport *transport = joystick->get_transport();
+    if (transport == nullptr || transport == this) {
+        return 0;
+    }
+    uint32_t speed = transport->get_speed();
+    begin(transport);
+    uint32_t selected = negotiate(addr, max_speed);
+    if (selected != 0 && joystick->begin(this, addr)) {
+        return selected;
+    }
+    transport->set_speed(speed);
+    joystick->begin(transport, addr);
+    return 0;
+}
+
+void JoystickSpeedControl::record(uint8_t addr, bool ok)
+{
+    _transfers++;
+    // Other units on the bus fail on their own, their errors say nothing about the speed
+    if (_addr != 0 && addr != _addr) {
+        return;
+    }
+    _window_count++;
+    if (!ok) {
+        _errors++;
+        _window_errors++;
+    }
+
+    if (_window_errors > JOYSTICK_SPEED_WINDOW_MAX_ERRORS) {
+        if (_level > 0) {
+            _level--;
+            _transport->set_speed(speeds[_level]);
+            _downshifts++;
+        }
+        _window_count = 0;
+        _window_errors = 0;
+    } else if (_window_count >= JOYSTICK_SPEED_WINDOW) {
+        _window_count = 0;
+        _window_errors = 0;
+    }
+}
+
+int JoystickSpeedControl::read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes)
+{
+    int ret = _transport->read_reg(addr, reg, buf, nbytes);
+    record(addr, ret == nbytes);
+    return ret;
+}
+
+int JoystickSpeedControl::write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes)
+{
+    int ret = _transport->write_reg(addr, reg, buf, nbytes);
+    record(addr, ret == nbytes);
+    return ret;
+}
+
+uint32_t JoystickSpeedControl::set_speed(uint32_t speed)
+{
+    // Runtime downshifts continue from the fastest level not above the request
+    _level = 0;
+    while (_level + 1 < JOYSTICK_SPEED_LEVELS && speeds[_level + 1] <= speed) {
+        _level++;
+    }
+    return _transport->set_speed(speed);
+}
+
+uint32_t JoystickSpeedControl::get_speed(void)
+{
+    return _transport->get_speed();
+}
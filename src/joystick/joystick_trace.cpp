@@ -0,0 +1,158 @@
+#include "joystick_trace.hpp"
+
+JoystickTrace::JoystickTrace() :
+    _next_id(1),
+    _frame_output(false)
+{
+    reset();
+}
+
+void JoystickTrace::reset(void)
+{
+    _active = joystick_trace_tag_t();
+    _last_transfer_us = 0;
+    _drawing = false;
+    for (int i = 0; i < 2; i++) {
+        _closing[i].used = false;
+    }
+    _frames  = 0;
+    _last_us = 0;
+    _count   = 0;
+    _head    = 0;
+}
+
+joystick_trace_tag_t JoystickTrace::tag(const joystick_state_t &state)
+{
+    joystick_trace_tag_t t;
+    t.id = _next_id++;
+    if (_next_id == 0) {
+        _next_id = 1; // 0 means no sample
+    }
+    t.sample_us = state.timestamp_us;
+    return t;
+}
+
+joystick_trace_tag_t JoystickTrace::tag(void)
+{
+    joystick_state_t state;
+    state.timestamp_us = joystick_time_us();
+    return tag(state);
+}
+
+void JoystickTrace::draw_begin(const joystick_trace_tag_t &tag)
+{
+    // A frame still waiting for its last transfer keeps its slot
+    collect();
+    _last_transfer_us = 0;
+    _active = tag;
+    _drawing = true;
+}
+
+void JoystickTrace::draw_end(bool transfer_pending)
+{
+    collect();
+    if (!transfer_pending) {
+        _drawing = false;
+        finish(_active, _last_transfer_us);
+        _active.id = 0;
+        return;
+    }
+
+    // The frame ends with the next completion. Fill the slot before marking it
+    // used, on_transfer() may run in between; a third frame in flight is not traced
+    if (_active.id != 0) {
+        for (int i = 0; i < 2; i++) {
+            if (!_closing[i].used) {
+                _closing[i].tag = _active;
+                _closing[i].end_us = 0;
+                _closing[i].used = true;
+                break;
+            }
+        }
+    }
+    _drawing = false;
+    _active.id = 0;
+}
+
+void JoystickTrace::on_transfer(void)
+{
+    // May run in the DMA interrupt, closed frames are recorded by collect()
+    uint64_t now = joystick_time_us();
+    for (int i = 0; i < 2; i++) {
+        if (_closing[i].used && _closing[i].end_us == 0) {
+            _closing[i].end_us = now;
+        }
+    }
+    if (_drawing && _active.id != 0) {
+        _last_transfer_us = now;
+    }
+}
+
+void JoystickTrace::collect(void)
+{
+    // Oldest frame first
+    int first = (_closing[0].used && _closing[1].used && _closing[1].tag.id < _closing[0].tag.id) ? 1 : 0;
+    for (int n = 0; n < 2; n++) {
+        closing_t &c = _closing[(first + n) % 2];
+        if (c.used && c.end_us != 0) {
+            finish(c.tag, c.end_us);
+            c.used = false;
+        }
+    }
+}
+
+void JoystickTrace::finish(const joystick_trace_tag_t &tag, uint64_t end_us)
+{
+    if (tag.id == 0 || end_us == 0) {
+        return; // Nothing was drawn for this sample
+    }
+    _last_us = (uint32_t)(end_us - tag.sample_us);
+    _latencies[_head] = _last_us;
+    _head = (_head + 1) % JOYSTICK_TRACE_WINDOW;
+    if (_count < JOYSTICK_TRACE_WINDOW) {
+        _count++;
+    }
+    _frames++;
+    if (_frame_output) {
+        printf("TRACE frame=%lu id=%lu latency_us=%lu\n", (unsigned long)_frames, (unsigned long)tag.id,
+               (unsigned long)_last_us);
+    }
+}
+
+uint32_t JoystickTrace::get_last_latency(void)
+{
+    collect();
+    return _last_us;
+}
+
+void JoystickTrace::get_summary(joystick_trace_summary_t *summary)
+{
+    collect();
+    *summary = joystick_trace_summary_t();
+    summary->frames = _frames;
+    if (_count == 0) {
+        return;
+    }
+    // Insertion sort of a copy, only run when a report is printed
+    uint32_t sorted[JOYSTICK_TRACE_WINDOW];
+    for (uint32_t i = 0; i < _count; i++) {
+        uint32_t v = _latencies[i];
+        uint32_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    summary->p50_us = sorted[(_count - 1) * 50 / 100];
+    summary->p90_us = sorted[(_count - 1) * 90 / 100];
+    summary->p99_us = sorted[(_count - 1) * 99 / 100];
+    summary->max_us = sorted[_count - 1];
+}
+
+void JoystickTrace::print_summary(void)
+{
+    joystick_trace_summary_t s;
+    get_summary(&s);
+    printf("TRACE_SUMMARY frames=%lu p50_us=%lu p90_us=%lu p99_us=%lu max_us=%lu\n", (unsigned long)s.frames,
+           (unsigned long)s.p50_us, (unsigned long)s.p90_us, (unsigned long)s.p99_us, (unsigned long)s.max_us);
+}
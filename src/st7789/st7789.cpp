@@ -236,11 +236,8 @@ void ST7789::invertDisplay(bool invert) {
 }
 
 void ST7789::fillScreen(uint16_t color) {
-    if (_hal.isDmaEnabled()) {
-        fillRectDMA(0, 0, _hal.getConfig().width, _hal.getConfig().height, color);
-    } else {
-        _gfx.fillRect(0, 0, _hal.getConfig().width, _hal.getConfig().height, color);
-    }
+    // A single DMA fill when DMA is enabled, see Graphics::fillRect
+    _gfx.fillRect(0, 0, _hal.getConfig().width, _hal.getConfig().height, color);
 }
 
 void ST7789::sleepDisplay(bool sleep) {
@@ -263,6 +260,11 @@ void ST7789::reset() {
 }
 
 bool ST7789::drawImageDMA(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* data) {
+    if (_initialized && _gfx.getTarget()) {
+        // Sent by the next flush()
+        _gfx.drawImage(x, y, w, h, data);
+        return true;
+    }
     if (!_initialized || x >= _hal.getConfig().width || y >= _hal.getConfig().height) {
         return false;
     }
@@ -294,11 +296,16 @@ bool ST7789::drawImageDMA(int16_t x, int16_t y, int16_t w, int16_t h, const uint
     // Set drawing window
     setAddrWindow(x, y, x1, y1);
     
-    // Use DMA to transfer image data
+    // Use DMA to transfer image data, read in place until waitIdle()
     return _hal.writeDataDma(data, w * h);
 }
 
 bool ST7789::fillRectDMA(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (_initialized && _gfx.getTarget()) {
+        // Sent by the next flush()
+        _gfx.fillRect(x, y, w, h, color);
+        return true;
+    }
     if (!_initialized || w <= 0 || h <= 0 ||
         x >= _hal.getConfig().width || y >= _hal.getConfig().height) {
         return false;
@@ -328,33 +335,62 @@ bool ST7789::fillRectDMA(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t co
         return false;
     }
     
+    if (!_hal.isDmaEnabled()) {
+        // If DMA is not available, fall back to normal method
+        _gfx.fillRect(x, y, w, h, color);
+        return true;
+    }
+    
     // Set drawing window
     setAddrWindow(x, y, x1, y1);
     
-    // Prepare fill data
-    const size_t buffer_size = 256; // Use a small buffer
-    uint16_t fill_buffer[buffer_size];
-    for (size_t i = 0; i < buffer_size; i++) {
-        fill_buffer[i] = color;
+    // One transfer of a single color word, returns before it ends
+    return _hal.fillDma(color, (size_t)w * h);
+}
+
+bool ST7789::setFrameBuffer(FrameBuffer* fb) {
+    if (fb && (fb->width() != _hal.getConfig().width ||
+               fb->height() != _hal.getConfig().height)) {
+        return false;
+    }
+    // The panel is out of date until the whole buffer has been flushed
+    if (fb) {
+        fb->markAllDirty();
+    }
+    _gfx.setTarget(fb);
+    return true;
+}
+
+bool ST7789::flush() {
+    FrameBuffer* fb = _gfx.getTarget();
+    if (!_initialized || fb == nullptr) {
+        return false;
     }
     
-    // Calculate total pixels
-    size_t total_pixels = w * h;
-    size_t pixels_sent = 0;
-    
-    // Send in batches
-    while (pixels_sent < total_pixels) {
-        size_t pixels_to_send = (total_pixels - pixels_sent > buffer_size) ? 
-                                buffer_size : (total_pixels - pixels_sent);
+    // Without DMA writeDataDma sends the rows with blocking writes
+    bool ok = true;
+    for (uint8_t i = 0; i < fb->getDirtyCount() && ok; i++) {
+        const Rect& r = fb->getDirty(i);
+        uint16_t w = r.x1 - r.x0 + 1;
+        uint16_t h = r.y1 - r.y0 + 1;
+        const uint16_t* row = fb->data() + (int32_t)r.y0 * fb->width() + r.x0;
+        setAddrWindow(r.x0, r.y0, r.x1, r.y1);
         
-        if (!_hal.writeDataDma(fill_buffer, pixels_to_send)) {
-            return false;
+        // Full-width rows are contiguous in the buffer: one transfer
+        if (w == fb->width()) {
+            ok = _hal.writeDataDma(row, (size_t)w * h);
+            continue;
+        }
+        for (uint16_t y = 0; y < h && ok; y++) {
+            ok = _hal.writeDataDma(row, w);
+            row += fb->width();
         }
-        
-        pixels_sent += pixels_to_send;
     }
-    
-    return true;
+    if (fb->getDirtyCount() > 0) {
+        _gfx.markFlushed();
+    }
+    fb->clearDirty();
+    return ok;
 }
 
 } // namespace st7789 
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "st7789_dma.hpp"
+#include "st7789_platform.hpp"
+
+namespace st7789 {
+
+DmaPipeline::DmaPipeline() :
+    _engine(nullptr),
+    _sending(-1),
+    _queued(-1),
+    _next(0),
+    _transfers(0),
+    _drain_cb(nullptr),
+    _drain_ctx(nullptr) {
+    _data[0] = _data[1] = nullptr;
+    _fill[0] = _fill[1] = 0;
+    _increment[0] = _increment[1] = true;
+    _count[0] = _count[1] = 0;
+}
+
+void DmaPipeline::begin(DmaEngine* engine) {
+    _engine = engine;
+    _count[0] = _count[1] = 0;
+    _sending = -1;
+    _queued = -1;
+    _next = 0;
+    _transfers = 0;
+}
+
+bool DmaPipeline::write(const uint16_t* data, size_t len, uint32_t timeout_ms) {
+    if (len == 0) {
+        return true;
+    }
+    // The slot is free once its previous write has been sent
+    if (!waitFree(_next, timeout_ms)) {
+        return false;
+    }
+    submit(_next, data, len, true);
+    _next ^= 1;
+    return true;
+}
+
+bool DmaPipeline::fill(uint16_t color, size_t count, uint32_t timeout_ms) {
+    if (count == 0) {
+        return true;
+    }
+    if (!waitFree(_next, timeout_ms)) {
+        return false;
+    }
+    // The slot keeps the word alive until the transfer is done
+    _fill[_next] = color;
+    submit(_next, &_fill[_next], count, false);
+    _next ^= 1;
+    return true;
+}
+
+void DmaPipeline::submit(int8_t slot, const uint16_t* data, size_t count, bool increment) {
+    _engine->lock();
+    _data[slot] = data;
+    _increment[slot] = increment;
+    _count[slot] = count;
+    if (_sending < 0) {
+        _sending = slot;
+        _engine->start(data, count, increment);
+    } else {
+        _queued = slot;
+    }
+    _engine->unlock();
+}
+
+void DmaPipeline::complete() {
+    if (_sending < 0) {
+        return;
+    }
+    _count[_sending] = 0;
+    _transfers = _transfers + 1;
+
+    // Start the queued write right away so the SPI does not idle
+    if (_queued >= 0) {
+        _sending = _queued;
+        _queued = -1;
+        _engine->start(_data[_sending], _count[_sending], _increment[_sending]);
+        return;
+    }
+    _sending = -1;
+    if (_drain_cb) {
+        _drain_cb(_drain_ctx);
+    }
+}
+
+bool DmaPipeline::waitFree(int8_t slot, uint32_t timeout_ms) {
+    uint64_t start = platformTimeUs();
+    while (_count[slot] != 0) {
+        if (platformTimeUs() - start > (uint64_t)timeout_ms * 1000) {
+            return false;
+        }
+        _engine->wait();
+    }
+    return true;
+}
+
+bool DmaPipeline::waitIdle(uint32_t timeout_ms) {
+    uint64_t start = platformTimeUs();
+    while (busy()) {
+        if (platformTimeUs() - start > (uint64_t)timeout_ms * 1000) {
+            return false;
+        }
+        _engine->wait();
+    }
+    return true;
+}
+
+bool DmaPipeline::busy() {
+    if (_engine == nullptr) {
+        return false;
+    }
+    _engine->poll();
+    return _sending >= 0;
+}
+
+void DmaPipeline::abort() {
+    if (_engine == nullptr) {
+        return;
+    }
+    _engine->lock();
+    _engine->abort();
+    _count[0] = _count[1] = 0;
+    _sending = -1;
+    _queued = -1;
+    _engine->unlock();
+}
+
+} // namespace st7789
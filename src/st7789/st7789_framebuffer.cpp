@@ -0,0 +1,166 @@
+#include "st7789_framebuffer.hpp"
+#include <cstdlib>
+
+namespace st7789 {
+
+static Rect unionRect(const Rect& a, const Rect& b) {
+    Rect r;
+    r.x0 = a.x0 < b.x0 ? a.x0 : b.x0;
+    r.y0 = a.y0 < b.y0 ? a.y0 : b.y0;
+    r.x1 = a.x1 > b.x1 ? a.x1 : b.x1;
+    r.y1 = a.y1 > b.y1 ? a.y1 : b.y1;
+    return r;
+}
+
+// Overlapping or sharing an edge: the union covers no extra pixels worth a window
+static bool touches(const Rect& a, const Rect& b) {
+    return a.x0 <= b.x1 + 1 && b.x0 <= a.x1 + 1 &&
+           a.y0 <= b.y1 + 1 && b.y0 <= a.y1 + 1;
+}
+
+FrameBuffer::FrameBuffer() :
+    _buffer(nullptr),
+    _owned(false),
+    _width(0),
+    _height(0),
+    _dirty_count(0) {
+}
+
+FrameBuffer::~FrameBuffer() {
+    end();
+}
+
+bool FrameBuffer::begin(uint16_t width, uint16_t height, uint16_t* buffer) {
+    end();
+    if (buffer == nullptr) {
+        buffer = (uint16_t*)malloc((size_t)width * height * sizeof(uint16_t));
+        if (buffer == nullptr) {
+            return false;
+        }
+        _owned = true;
+    }
+    _buffer = buffer;
+    _width = width;
+    _height = height;
+    _dirty_count = 0;
+    return true;
+}
+
+void FrameBuffer::end() {
+    if (_owned) {
+        free(_buffer);
+    }
+    _buffer = nullptr;
+    _owned = false;
+    _width = 0;
+    _height = 0;
+    _dirty_count = 0;
+}
+
+uint16_t FrameBuffer::getPixel(int16_t x, int16_t y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) {
+        return 0;
+    }
+    return _buffer[(int32_t)y * _width + x];
+}
+
+void FrameBuffer::setPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) {
+        return;
+    }
+    _buffer[(int32_t)y * _width + x] = color;
+    markDirty(x, y, x, y);
+}
+
+void FrameBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    int16_t x1 = x + w - 1;
+    int16_t y1 = y + h - 1;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 >= _width) x1 = _width - 1;
+    if (y1 >= _height) y1 = _height - 1;
+    if (x1 < x || y1 < y) {
+        return;
+    }
+
+    for (int16_t row = y; row <= y1; row++) {
+        uint16_t* dst = &_buffer[(int32_t)row * _width + x];
+        for (int16_t col = x; col <= x1; col++) {
+            *dst++ = color;
+        }
+    }
+    markDirty(x, y, x1, y1);
+}
+
+void FrameBuffer::drawImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* data) {
+    // Clip, keeping the source stride of w pixels
+    int16_t sx = 0;
+    int16_t sy = 0;
+    int16_t x1 = x + w - 1;
+    int16_t y1 = y + h - 1;
+    if (x < 0) { sx = -x; x = 0; }
+    if (y < 0) { sy = -y; y = 0; }
+    if (x1 >= _width) x1 = _width - 1;
+    if (y1 >= _height) y1 = _height - 1;
+    if (x1 < x || y1 < y) {
+        return;
+    }
+
+    for (int16_t row = y; row <= y1; row++) {
+        const uint16_t* src = &data[(int32_t)(sy + row - y) * w + sx];
+        uint16_t* dst = &_buffer[(int32_t)row * _width + x];
+        for (int16_t col = x; col <= x1; col++) {
+            *dst++ = *src++;
+        }
+    }
+    markDirty(x, y, x1, y1);
+}
+
+void FrameBuffer::markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= _width) x1 = _width - 1;
+    if (y1 >= _height) y1 = _height - 1;
+    if (x1 < x0 || y1 < y0) {
+        return;
+    }
+    Rect r = { x0, y0, x1, y1 };
+    addDirty(r);
+}
+
+void FrameBuffer::addDirty(Rect r) {
+    // Grow into every touching rect; a grown rect may reach others, so repeat
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < _dirty_count; i++) {
+            if (touches(r, _dirty[i])) {
+                r = unionRect(r, _dirty[i]);
+                _dirty[i] = _dirty[--_dirty_count];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (_dirty_count < MAX_DIRTY) {
+        _dirty[_dirty_count++] = r;
+        return;
+    }
+
+    // No slot left: join the rect whose area grows the least
+    uint8_t best = 0;
+    int32_t best_growth = 0;
+    for (uint8_t i = 0; i < _dirty_count; i++) {
+        int32_t growth = unionRect(r, _dirty[i]).area() - _dirty[i].area();
+        if (i == 0 || growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    r = unionRect(r, _dirty[best]);
+    _dirty[best] = _dirty[--_dirty_count];
+    addDirty(r);
+}
+
+} // namespace st7789
@@ -2,13 +2,14 @@
 #include "st7789.hpp"
 #include <cstdlib>
 #include <cmath>
+#include <utility>
 
 // Forward declaration of font data
 extern const unsigned char font[];
 
 namespace st7789 {
 
-Graphics::Graphics(ST7789* lcd) : _lcd(lcd) {
+Graphics::Graphics(ST7789* lcd) : _lcd(lcd), _fb(nullptr), _fb_on_wire(false) {
 }
 
 Graphics::~Graphics() {
@@ -19,21 +20,51 @@ uint16_t Graphics::color565(uint8_t r, uint8_t g, uint8_t b) {
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
+FrameBuffer* Graphics::drawTarget() {
+    // flush() streams the buffer in place, wait before changing it
+    if (_fb && _fb_on_wire) {
+        _lcd->hal().waitIdle();
+        _fb_on_wire = false;
+    }
+    return _fb;
+}
+
 // Draw a single pixel
 void Graphics::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (FrameBuffer* fb = drawTarget()) {
+        fb->setPixel(x, y, color);
+        return;
+    }
+    
     // Access main LCD class to set drawing window and send data
     _lcd->setAddrWindow(x, y, x, y);
-    
-    // Convert single pixel data to bytes and send
-    uint8_t data[2];
-    data[0] = color >> 8;
-    data[1] = color & 0xFF;
-    
-    _lcd->hal().writeDataBulk(data, 2);
+    _lcd->hal().writePixels(&color, 1);
+}
+
+// Draw a horizontal span
+void Graphics::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+// Draw a vertical span
+void Graphics::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillRect(x, y, 1, h, color);
 }
 
 // Draw a line
 void Graphics::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    // Axis-aligned lines are a single span
+    if (y0 == y1) {
+        if (x0 > x1) std::swap(x0, x1);
+        drawFastHLine(x0, y0, x1 - x0 + 1, color);
+        return;
+    }
+    if (x0 == x1) {
+        if (y0 > y1) std::swap(y0, y1);
+        drawFastVLine(x0, y0, y1 - y0 + 1, color);
+        return;
+    }
+    
     // Use Bresenham's algorithm to draw line
     int16_t steep = abs(y1 - y0) > abs(x1 - x0);
     
@@ -52,14 +83,18 @@ void Graphics::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t
     int16_t err = dx / 2;
     int16_t ystep = (y0 < y1) ? 1 : -1;
     
+    // Pixels on the same row (column when steep) are sent as one span
+    int16_t run_start = x0;
     for (; x0 <= x1; x0++) {
-        if (steep) {
-            drawPixel(y0, x0, color);
-        } else {
-            drawPixel(x0, y0, color);
-        }
-        
         err -= dy;
+        if (err < 0 || x0 == x1) {
+            if (steep) {
+                drawFastVLine(y0, run_start, x0 - run_start + 1, color);
+            } else {
+                drawFastHLine(run_start, y0, x0 - run_start + 1, color);
+            }
+            run_start = x0 + 1;
+        }
         if (err < 0) {
             y0 += ystep;
             err += dx;
@@ -69,45 +104,86 @@ void Graphics::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t
 
 // Draw rectangle outline
 void Graphics::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
-    // Draw four edges
-    drawLine(x, y, x + w - 1, y, color);         // Top edge
-    drawLine(x, y + h - 1, x + w - 1, y + h - 1, color); // Bottom edge
-    drawLine(x, y, x, y + h - 1, color);         // Left edge
-    drawLine(x + w - 1, y, x + w - 1, y + h - 1, color); // Right edge
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    
+    // Draw four edges, the side edges without the corners
+    drawFastHLine(x, y, w, color);                  // Top edge
+    if (h > 1) {
+        drawFastHLine(x, y + h - 1, w, color);      // Bottom edge
+    }
+    if (h > 2) {
+        drawFastVLine(x, y + 1, h - 2, color);      // Left edge
+        if (w > 1) {
+            drawFastVLine(x + w - 1, y + 1, h - 2, color); // Right edge
+        }
+    }
 }
 
 // Fill rectangle
 void Graphics::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (FrameBuffer* fb = drawTarget()) {
+        fb->fillRect(x, y, w, h, color);
+        return;
+    }
+    
+    // Clip to the screen
+    int16_t x1 = x + w - 1;
+    int16_t y1 = y + h - 1;
+    
+    if (x < 0) {
+        x = 0;
+    }
+    if (y < 0) {
+        y = 0;
+    }
+    if (x1 >= _lcd->hal().getConfig().width) {
+        x1 = _lcd->hal().getConfig().width - 1;
+    }
+    if (y1 >= _lcd->hal().getConfig().height) {
+        y1 = _lcd->hal().getConfig().height - 1;
+    }
+    
     // Boundary check
-    if (w <= 0 || h <= 0) {
+    if (x1 < x || y1 < y) {
         return;
     }
     
     // Set drawing window
-    _lcd->setAddrWindow(x, y, x + w - 1, y + h - 1);
-    
-    // Prepare color data
-    uint8_t colorHi = color >> 8;
-    uint8_t colorLo = color & 0xFF;
+    _lcd->setAddrWindow(x, y, x1, y1);
     
     // Calculate total pixels to fill
-    uint32_t total = w * h;
+    uint32_t total = (uint32_t)(x1 - x + 1) * (y1 - y + 1);
     
+    // Large fills are one DMA transfer of a single color word, returning at once
+    HAL& hal = _lcd->hal();
+    if (hal.isDmaEnabled() && total >= hal.getConfig().dma.fill_threshold) {
+        if (hal.fillDma(color, total)) {
+            return;
+        }
+        // The DMA was aborted, resend the whole window with blocking writes
+        _lcd->setAddrWindow(x, y, x1, y1);
+    }
+    writeColor(color, total);
+}
+
+void Graphics::writeColor(uint16_t color, uint32_t count) {
     // If data amount is large, send in batches
     const uint32_t batch_size = 128; // Pixels per batch
-    uint8_t buffer[batch_size * 2];  // 2 bytes per pixel
+    uint16_t buffer[batch_size];
     
-    // Initialize buffer
-    for (uint32_t i = 0; i < batch_size; i++) {
-        buffer[i * 2] = colorHi;
-        buffer[i * 2 + 1] = colorLo;
+    // Initialize only the part of the buffer that is sent
+    uint32_t used = (count > batch_size) ? batch_size : count;
+    for (uint32_t i = 0; i < used; i++) {
+        buffer[i] = color;
     }
     
     // Send data in batches
-    uint32_t remaining = total;
+    uint32_t remaining = count;
     while (remaining > 0) {
         uint32_t current_batch = (remaining > batch_size) ? batch_size : remaining;
-        _lcd->hal().writeDataBulk(buffer, current_batch * 2);
+        _lcd->hal().writePixels(buffer, current_batch);
         remaining -= current_batch;
     }
 }
@@ -151,14 +227,16 @@ void Graphics::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
 
 // Fill circle
 void Graphics::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-    // Draw vertical lines to fill circle
-    drawLine(x0, y0 - r, x0, y0 + r, color);
+    // Fill with horizontal spans, each row of the circle is sent once
+    drawFastHLine(x0 - r, y0, 2 * r + 1, color);
     
     int16_t f = 1 - r;
     int16_t ddF_x = 1;
     int16_t ddF_y = -2 * r;
     int16_t x = 0;
     int16_t y = r;
+    int16_t px = x;
+    int16_t py = y;
     
     while (x < y) {
         if (f >= 0) {
@@ -171,10 +249,18 @@ void Graphics::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
         ddF_x += 2;
         f += ddF_x;
         
-        drawLine(x0 + x, y0 - y, x0 + x, y0 + y, color);
-        drawLine(x0 - x, y0 - y, x0 - x, y0 + y, color);
-        drawLine(x0 + y, y0 - x, x0 + y, y0 + x, color);
-        drawLine(x0 - y, y0 - x, x0 - y, y0 + x, color);
+        // Rows y0 +/- x, skipped once they reach the rows drawn below
+        if (x < y + 1) {
+            drawFastHLine(x0 - y, y0 + x, 2 * y + 1, color);
+            drawFastHLine(x0 - y, y0 - x, 2 * y + 1, color);
+        }
+        // Rows y0 +/- py at their widest, when the octant leaves them
+        if (y != py) {
+            drawFastHLine(x0 - px, y0 + py, 2 * px + 1, color);
+            drawFastHLine(x0 - px, y0 - py, 2 * px + 1, color);
+            py = y;
+        }
+        px = x;
     }
 }
 
@@ -257,6 +343,11 @@ void Graphics::drawString(int16_t x, int16_t y, const char* str, uint16_t color,
 
 // Draw image
 void Graphics::drawImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* data) {
+    if (FrameBuffer* fb = drawTarget()) {
+        fb->drawImage(x, y, w, h, data);
+        return;
+    }
+    
     // Boundary check
     if (x >= _lcd->hal().getConfig().width || y >= _lcd->hal().getConfig().height)
         return;
@@ -288,15 +379,13 @@ void Graphics::drawImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint1
     // Set drawing window
     _lcd->setAddrWindow(x, y, x1, y1);
     
-    // Send image data
-    _lcd->hal().writeDataBulk((const uint8_t*)data, w * h * 2);
+    // Send image data, same byte order as the DMA path
+    _lcd->hal().writePixels(data, w * h);
 }
 
 void Graphics::clearScreen(uint16_t width, uint16_t height, uint16_t color) {
-    const int segment_height = 20;  // Height per clear
-    for (int y = 0; y < height; y += segment_height) {
-        fillRect(0, y, width, segment_height, color);
-    }
+    // One window and, with DMA, one transfer for the whole screen
+    fillRect(0, 0, width, height, color);
 }
 
-} // namespace st7789 
\ No newline at end of file
+} // namespace st7789
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "hardware/gpio.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "pico/stdlib.h"
 #include <cstring>
 #include <cstdio>
@@ -12,25 +13,56 @@ namespace st7789 {
 // Define global variable for DMA interrupt handling
 static HAL* current_hal_instance = nullptr;
 
+// RP2040 DMA channel feeding the SPI TX FIFO
+class RpDmaEngine : public DmaEngine {
+public:
+    int channel = -1;
+    dma_channel_config config;
+    volatile void* dst = nullptr;
+    uint32_t saved_irq = 0;
+    
+    void start(const uint16_t* data, size_t count, bool increment) override {
+        // Fills read one color word, trans_count covers a whole screen
+        channel_config_set_read_increment(&config, increment);
+        dma_channel_configure(channel, &config, dst, data, count, true);
+    }
+    void abort() override {
+        dma_channel_abort(channel);
+    }
+    void wait() override {
+        tight_loop_contents();
+    }
+    void lock() override {
+        saved_irq = save_and_disable_interrupts();
+    }
+    void unlock() override {
+        restore_interrupts(saved_irq);
+    }
+};
+
+static RpDmaEngine dma_engine;
+
 // DMA transfer completion handler
 void dma_complete_handler() {
     // Ensure we have a valid instance
-    if (current_hal_instance) {
+    if (current_hal_instance && (dma_hw->ints0 & (1u << current_hal_instance->_dma_tx_channel))) {
         // Clear interrupt flag
         dma_hw->ints0 = 1u << current_hal_instance->_dma_tx_channel;
         
-        // Update status
-        current_hal_instance->_dma_busy = false;
+        // Start the queued chunk, or report the end of the transfer
+        current_hal_instance->_dma.complete();
     }
 }
 
 HAL::HAL() : 
     _initialized(false),
+    _transfer_cb(nullptr),
+    _transfer_ctx(nullptr),
+    _spi_bytes(0),
+    _spi_bits(8),
     _dma_tx_channel(-1),
-    _dma_buffer(nullptr),
-    _dma_buffer_size(0),
     _dma_enabled(false),
-    _dma_busy(false) {
+    _dma_selected(false) {
 }
 
 HAL::~HAL() {
@@ -60,6 +92,7 @@ bool HAL::init(const Config& config) {
     
     // Initialize SPI
     spi_init(_config.spi_inst, _config.spi_speed_hz);
+    _spi_bits = 8;
     gpio_set_function(_config.pin_sck, GPIO_FUNC_SPI);
     gpio_set_function(_config.pin_din, GPIO_FUNC_SPI);
     
@@ -87,18 +120,7 @@ void HAL::initDma() {
         return;
     }
     
-    // Allocate DMA buffer
-    _dma_buffer_size = _config.dma.buffer_size;
-    _dma_buffer = (uint16_t*)malloc(_dma_buffer_size);
-    if (!_dma_buffer) {
-        printf("Failed to allocate DMA buffer\n");
-        dma_channel_unclaim(_dma_tx_channel);
-        _dma_tx_channel = -1;
-        _dma_enabled = false;
-        return;
-    }
-    
-    // Configure DMA
+    // Configure DMA: 16-bit words from the pixel data to 16-bit SPI frames
     dma_channel_config dma_config = dma_channel_get_default_config(_dma_tx_channel);
     channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_16);
     channel_config_set_dreq(&dma_config, spi_get_dreq(_config.spi_inst, true));
@@ -118,6 +140,12 @@ void HAL::initDma() {
     irq_set_exclusive_handler(DMA_IRQ_0, dma_complete_handler);
     irq_set_enabled(DMA_IRQ_0, true);
     
+    dma_engine.channel = _dma_tx_channel;
+    dma_engine.config = dma_config;
+    dma_engine.dst = &spi_get_hw(_config.spi_inst)->dr;
+    _dma.begin(&dma_engine);
+    _dma.setDrainCallback(dmaDrained, this);
+    
     _dma_enabled = true;
     printf("DMA initialization successful, channel: %d\n", _dma_tx_channel);
 }
@@ -125,7 +153,7 @@ void HAL::initDma() {
 void HAL::cleanupDma() {
     if (_dma_tx_channel >= 0) {
         // Stop any ongoing transfer
-        dma_channel_abort(_dma_tx_channel);
+        abortDma();
         
         // Disable interrupt
         dma_channel_set_irq0_enabled(_dma_tx_channel, false);
@@ -135,121 +163,150 @@ void HAL::cleanupDma() {
         _dma_tx_channel = -1;
     }
     
-    // Release buffer
-    if (_dma_buffer) {
-        free(_dma_buffer);
-        _dma_buffer = nullptr;
-    }
-    
     _dma_enabled = false;
-    _dma_busy = false;
+}
+
+void HAL::setFrameBits(uint8_t bits) {
+    // Only changed between transfers, the SPI is idle after waitIdle()
+    if (_spi_bits != bits) {
+        spi_set_format(_config.spi_inst, bits, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+        _spi_bits = bits;
+    }
 }
 
 void HAL::writeCommand(uint8_t cmd) {
+    waitIdle();
+    setFrameBits(8);
     gpio_put(_config.pin_cs, 0);  // Selected chip
     gpio_put(_config.pin_dc, 0);  // Command mode
     spi_write_blocking(_config.spi_inst, &cmd, 1);
     gpio_put(_config.pin_cs, 1);  // Unselected
+    _spi_bytes += 1;
 }
 
 void HAL::writeData(uint8_t data) {
+    waitIdle();
+    setFrameBits(8);
     gpio_put(_config.pin_cs, 0);  // Selected chip
     gpio_put(_config.pin_dc, 1);  // Data mode
     spi_write_blocking(_config.spi_inst, &data, 1);
     gpio_put(_config.pin_cs, 1);  // Unselected
+    _spi_bytes += 1;
 }
 
 void HAL::writeDataBulk(const uint8_t* data, size_t len) {
     if (len == 0) return;
     
+    waitIdle();
+    setFrameBits(8);
     gpio_put(_config.pin_cs, 0);  // Selected chip
     gpio_put(_config.pin_dc, 1);  // Data mode
     spi_write_blocking(_config.spi_inst, data, len);
     gpio_put(_config.pin_cs, 1);  // Unselected
+    _spi_bytes += len;
+}
+
+void HAL::writePixels(const uint16_t* data, size_t len) {
+    if (len == 0) return;
+    
+    waitIdle();
+    setFrameBits(16);
+    gpio_put(_config.pin_cs, 0);  // Selected chip
+    gpio_put(_config.pin_dc, 1);  // Data mode
+    spi_write16_blocking(_config.spi_inst, data, len);
+    gpio_put(_config.pin_cs, 1);  // Unselected
+    _spi_bytes += len * 2;
+    transferComplete();
 }
 
 bool HAL::writeDataDma(const uint16_t* data, size_t len) {
-    if (!_dma_enabled || !_dma_buffer || _dma_tx_channel < 0) {
-        // If DMA is not available, fall back to normal method
-        writeDataBulk((const uint8_t*)data, len * 2);
-        return false;
+    if (!_dma_enabled || _dma_tx_channel < 0) {
+        // If DMA is not available, fall back to normal method, sent when it returns
+        writePixels(data, len);
+        return true;
     }
-    
-    // If DMA is busy, wait for completion
-    if (_dma_busy) {
-        if (!waitForDmaComplete()) {
-            printf("DMA timeout, abort operation\n");
-            abortDma();
-            return false;
-        }
+    if (len == 0) {
+        return true;
     }
     
-    // Set data/command pin to data mode
-    gpio_put(_config.pin_dc, 1);
-    // Set chip select pin
-    gpio_put(_config.pin_cs, 0);
-    
-    // Handle large transfers
-    size_t remaining = len;
-    const uint16_t* src_ptr = data;
-    
-    while (remaining > 0) {
-        // Determine transfer size
-        size_t transfer_size = (remaining > _dma_buffer_size/2) ? _dma_buffer_size/2 : remaining;
-        
-        // Prepare data (swap bytes for RGB565 format)
-        for (size_t i = 0; i < transfer_size; i++) {
-            uint16_t color = src_ptr[i];
-            // Swap bytes for RGB565 format
-            _dma_buffer[i] = ((color & 0xFF) << 8) | (color >> 8);
-        }
-        
-        // Mark DMA busy
-        _dma_busy = true;
-        
-        // Configure and start DMA transfer
-        dma_channel_set_read_addr(_dma_tx_channel, _dma_buffer, false);
-        dma_channel_set_trans_count(_dma_tx_channel, transfer_size, true); // Start transfer
-        
-        // Wait for transfer to complete
-        if (!waitForDmaComplete()) {
-            printf("DMA transfer timeout\n");
-            abortDma();
-            gpio_put(_config.pin_cs, 1); // Release chip select
-            return false;
-        }
-        
-        // Update pointer and remaining
-        src_ptr += transfer_size;
-        remaining -= transfer_size;
+    // Returns once the pixels are queued, DMA reads them from data in place
+    beginDmaData();
+    if (!_dma.write(data, len)) {
+        printf("DMA transfer timeout\n");
+        abortDma();
+        return false;
+    }
+    _spi_bytes += len * 2;
+    return true;
+}
+
+bool HAL::fillDma(uint16_t color, size_t count) {
+    if (!_dma_enabled || _dma_tx_channel < 0) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
     }
     
-    // Release chip select
-    gpio_put(_config.pin_cs, 1);
+    beginDmaData();
+    if (!_dma.fill(color, count)) {
+        printf("DMA transfer timeout\n");
+        abortDma();
+        return false;
+    }
+    _spi_bytes += count * 2;
     return true;
 }
 
-bool HAL::waitForDmaComplete(uint32_t timeout_ms) {
-    uint32_t start = to_ms_since_boot(get_absolute_time());
-    while (_dma_busy) {
-        // Check timeout
-        if (to_ms_since_boot(get_absolute_time()) - start > timeout_ms) {
-            return false;
+void HAL::beginDmaData() {
+    // Consecutive DMA writes continue the same data phase, CS stays low
+    if (!_dma_selected) {
+        waitIdle();
+        setFrameBits(16);
+        gpio_put(_config.pin_dc, 1);  // Data mode
+        gpio_put(_config.pin_cs, 0);  // Selected chip
+        _dma_selected = true;
+    }
+}
+
+bool HAL::waitIdle(uint32_t timeout_ms) {
+    bool ok = true;
+    if (!_dma.waitIdle(timeout_ms)) {
+        printf("DMA timeout, abort operation\n");
+        abortDma();
+        ok = false;
+    }
+    if (_dma_selected) {
+        // DMA completion only means the FIFO has the last word, let it drain
+        while (spi_is_busy(_config.spi_inst)) {
+            tight_loop_contents();
         }
-        // Yield CPU time
-        tight_loop_contents();
+        gpio_put(_config.pin_cs, 1);  // Unselected
+        _dma_selected = false;
+    }
+    return ok;
+}
+
+void HAL::transferComplete() {
+    if (_transfer_cb) {
+        _transfer_cb(_transfer_ctx);
     }
-    return true;
+}
+
+void HAL::dmaDrained(void* ctx) {
+    static_cast<HAL*>(ctx)->transferComplete();
 }
 
 void HAL::abortDma() {
-    if (_dma_tx_channel >= 0) {
-        dma_channel_abort(_dma_tx_channel);
+    _dma.abort();
+    if (_dma_selected) {
+        gpio_put(_config.pin_cs, 1);  // Release chip select
+        _dma_selected = false;
     }
-    _dma_busy = false;
 }
 
 void HAL::reset() {
+    waitIdle();
     // Reset sequence
     gpio_put(_config.pin_reset, 0);  // Reset state
     delay(20);
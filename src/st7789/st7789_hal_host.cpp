@@ -0,0 +1,309 @@
+#include "st7789_hal.hpp"
+#include <vector>
+
+// Host build only: no SPI or DMA hardware. Every transfer takes the time it
+// would need on the wire at the configured SPI clock on the simulated clock.
+// DMA chunks go to a fake engine that finishes them at their wire time, so
+// the ping-pong pipeline runs the same state machine as on the device.
+
+namespace st7789 {
+
+// Wire time below 1 us carried over to the next transfer
+static uint64_t spi_pending_ns = 0;
+
+static uint64_t spiWireUs(uint32_t speed_hz, size_t bytes) {
+    if (speed_hz == 0) {
+        return 0;
+    }
+    spi_pending_ns += (uint64_t)bytes * 8 * 1000000000ULL / speed_hz;
+    uint64_t us = spi_pending_ns / 1000;
+    spi_pending_ns %= 1000;
+    return us;
+}
+
+static void spiWait(uint32_t speed_hz, size_t bytes) {
+    platformSleepUs(spiWireUs(speed_hz, bytes));
+}
+
+// Panel model: follows CASET/RASET/RAMWR and keeps the pixels written into
+// the address window, so host tests can check what reached the display
+class HostPanel {
+public:
+    std::vector<uint16_t> gram;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint8_t cmd = 0;
+    uint8_t params[4] = {};
+    uint8_t nparams = 0;
+    uint16_t win[4] = {};       // x0, x1, y0, y1
+    uint16_t x = 0;
+    uint16_t y = 0;
+    
+    void begin(uint16_t w, uint16_t h) {
+        width = w;
+        height = h;
+        gram.assign((size_t)w * h, 0);
+    }
+    void command(uint8_t c) {
+        cmd = c;
+        nparams = 0;
+        if (cmd == 0x2C) {          // RAMWR restarts at the window origin
+            x = win[0];
+            y = win[2];
+        }
+    }
+    void param(uint8_t b) {
+        if ((cmd != 0x2A && cmd != 0x2B) || nparams >= 4) {
+            return;
+        }
+        params[nparams++] = b;
+        if (nparams == 4) {
+            uint16_t* w = cmd == 0x2A ? &win[0] : &win[2];
+            w[0] = (params[0] << 8) | params[1];
+            w[1] = (params[2] << 8) | params[3];
+        }
+    }
+    void pixels(const uint16_t* data, size_t count, bool increment) {
+        if (cmd != 0x2C) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (x < width && y < height) {
+                gram[(size_t)y * width + x] = increment ? data[i] : data[0];
+            }
+            if (++x > win[1]) {
+                x = win[0];
+                if (++y > win[3]) {
+                    y = win[2];
+                }
+            }
+        }
+    }
+};
+
+static HostPanel panel;
+
+// Fake DMA engine: a transfer completes when the simulated clock reaches its
+// wire time, through the simulated alarm, like the DMA interrupt would. A
+// transfer started from complete() follows the previous one on the wire.
+class HostDmaEngine : public DmaEngine {
+public:
+    DmaPipeline* pipeline = nullptr;
+    uint32_t speed_hz = 0;
+    bool active = false;
+    bool completing = false;
+    uint64_t end_us = 0;
+    
+    void start(const uint16_t* data, size_t count, bool increment) override {
+        panel.pixels(data, count, increment);
+        uint64_t begin = completing ? end_us : platformTimeUs();
+        end_us = begin + spiWireUs(speed_hz, count * 2);
+        active = true;
+        platformSetAlarm(end_us, alarm, this);
+    }
+    void abort() override {
+        active = false;
+        platformSetAlarm(0, nullptr, nullptr);
+    }
+    void poll() override {
+        // The clock may have been set past the end without sleeping
+        if (active && platformTimeUs() >= end_us) {
+            platformSetAlarm(0, nullptr, nullptr);
+            alarm(this);
+        }
+    }
+    void wait() override {
+        if (active) {
+            platformSleepUs(end_us > platformTimeUs() ? end_us - platformTimeUs() : 0);
+        }
+        poll();
+    }
+    
+    static void alarm(void* ctx) {
+        HostDmaEngine* engine = static_cast<HostDmaEngine*>(ctx);
+        engine->active = false;
+        engine->completing = true;
+        engine->pipeline->complete();
+        engine->completing = false;
+    }
+};
+
+static HostDmaEngine dma_engine;
+
+HAL::HAL() :
+    _initialized(false),
+    _transfer_cb(nullptr),
+    _transfer_ctx(nullptr),
+    _spi_bytes(0),
+    _spi_bits(8),
+    _dma_tx_channel(-1),
+    _dma_enabled(false),
+    _dma_selected(false) {
+}
+
+HAL::~HAL() {
+    cleanupDma();
+}
+
+bool HAL::init(const Config& config) {
+    _config = config;
+    panel.begin(_config.width, _config.height);
+    reset();
+    if (_config.dma.enabled) {
+        initDma();
+    }
+    _initialized = true;
+    return true;
+}
+
+void HAL::initDma() {
+    _dma_tx_channel = 0;
+    dma_engine.pipeline = &_dma;
+    dma_engine.speed_hz = _config.spi_speed_hz;
+    _dma.begin(&dma_engine);
+    _dma.setDrainCallback(dmaDrained, this);
+    _dma_enabled = true;
+}
+
+void HAL::cleanupDma() {
+    abortDma();
+    _dma_tx_channel = -1;
+    _dma_enabled = false;
+}
+
+void HAL::setFrameBits(uint8_t bits) {
+    _spi_bits = bits;
+}
+
+void HAL::writeCommand(uint8_t cmd) {
+    waitIdle();
+    panel.command(cmd);
+    setFrameBits(8);
+    spiWait(_config.spi_speed_hz, 1);
+    _spi_bytes += 1;
+}
+
+void HAL::writeData(uint8_t data) {
+    waitIdle();
+    panel.param(data);
+    setFrameBits(8);
+    spiWait(_config.spi_speed_hz, 1);
+    _spi_bytes += 1;
+}
+
+void HAL::writeDataBulk(const uint8_t* data, size_t len) {
+    if (len == 0) return;
+
+    waitIdle();
+    for (size_t i = 0; i < len; i++) {
+        panel.param(data[i]);
+    }
+    setFrameBits(8);
+    spiWait(_config.spi_speed_hz, len);
+    _spi_bytes += len;
+}
+
+void HAL::writePixels(const uint16_t* data, size_t len) {
+    if (len == 0) return;
+
+    waitIdle();
+    panel.pixels(data, len, true);
+    setFrameBits(16);
+    spiWait(_config.spi_speed_hz, len * 2);
+    _spi_bytes += len * 2;
+    transferComplete();
+}
+
+bool HAL::writeDataDma(const uint16_t* data, size_t len) {
+    if (!_dma_enabled) {
+        writePixels(data, len);
+        return true;
+    }
+    if (len == 0) {
+        return true;
+    }
+    beginDmaData();
+    if (!_dma.write(data, len)) {
+        abortDma();
+        return false;
+    }
+    _spi_bytes += len * 2;
+    return true;
+}
+
+bool HAL::fillDma(uint16_t color, size_t count) {
+    if (!_dma_enabled) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    beginDmaData();
+    if (!_dma.fill(color, count)) {
+        abortDma();
+        return false;
+    }
+    _spi_bytes += count * 2;
+    return true;
+}
+
+void HAL::beginDmaData() {
+    if (!_dma_selected) {
+        waitIdle();
+        setFrameBits(16);
+        _dma_selected = true;
+    }
+}
+
+bool HAL::waitIdle(uint32_t timeout_ms) {
+    bool ok = true;
+    if (!_dma.waitIdle(timeout_ms)) {
+        abortDma();
+        ok = false;
+    }
+    _dma_selected = false;
+    return ok;
+}
+
+void HAL::transferComplete() {
+    if (_transfer_cb) {
+        _transfer_cb(_transfer_ctx);
+    }
+}
+
+void HAL::dmaDrained(void* ctx) {
+    static_cast<HAL*>(ctx)->transferComplete();
+}
+
+void HAL::abortDma() {
+    _dma.abort();
+    _dma_selected = false;
+}
+
+void HAL::reset() {
+    waitIdle();
+    delay(20);
+    delay(120);
+}
+
+void HAL::setBacklight(bool on) {
+    (void)on;
+}
+
+void HAL::setBrightness(uint8_t brightness) {
+    setBacklight(brightness > 0);
+}
+
+uint16_t HAL::getPanelPixel(uint16_t x, uint16_t y) const {
+    if (x >= panel.width || y >= panel.height) {
+        return 0;
+    }
+    return panel.gram[(size_t)y * panel.width + x];
+}
+
+void HAL::delay(uint32_t ms) {
+    platformSleepUs((uint64_t)ms * 1000);
+}
+
+} // namespace st7789
@@ -0,0 +1,268 @@
+#include "joystick.hpp"
+#include "joystick_async_queue.hpp"
+#include "joystick_mock_bus.hpp"
+#include "test_util.hpp"
+
+// JoystickAsyncQueue on a scripted bus: transfers run against JoystickMockBus
+// and end at their wire time through the simulated alarm, like the I2C
+// interrupt. A script forces a NACK or a stall on chosen transfers.
+
+typedef enum { STEP_BUS = 0, STEP_NACK, STEP_STALL } step_t;
+
+class ScriptedBus : public JoystickAsyncQueue {
+public:
+    JoystickMockBus mock;
+    step_t script[32] = {};     // Outcome of transfer n, STEP_BUS past the end
+    uint32_t started = 0;       // Transfers put on the bus
+    uint32_t stops = 0;
+    uint32_t recovers = 0;
+    uint8_t order[32] = {};     // Register of each started transfer
+    int result = 0;             // Result of the transfer on the bus
+
+    ScriptedBus() { mock.add_device(JOYSTICK_ADDR); }
+
+protected:
+    bool bus_ready(void) override { return true; }
+
+    void bus_start(transfer_t &t) override {
+        step_t step = started < 32 ? script[started] : STEP_BUS;
+        if (started < 32) {
+            order[started] = t.reg;
+        }
+        started++;
+        if (step == STEP_STALL) {
+            return; // Never finishes, poll() times it out
+        }
+        if (step == STEP_NACK) {
+            result = PICO_ERROR_GENERIC;
+        } else if (t.is_read) {
+            result = mock.read_reg(t.addr, t.reg, t.data, t.nbytes);
+        } else {
+            result = mock.write_reg(t.addr, t.reg, t.data, t.nbytes);
+        }
+        uint64_t end = joystick_time_us() + mock.wire_time_us(t.nbytes, t.is_read);
+        joystick_host_set_alarm(end, done, this);
+    }
+    void bus_stop(void) override {
+        stops++;
+        joystick_host_set_alarm(0, nullptr, nullptr);
+    }
+    void bus_recover(void) override { recovers++; }
+    void wait(void) override { joystick_sleep_us(10); }
+
+    static void done(void *ctx) {
+        ScriptedBus *bus = static_cast<ScriptedBus *>(ctx);
+        bus->finish_active(bus->result);
+    }
+};
+
+typedef struct {
+    uint32_t calls;
+    uint8_t seq[JOYSTICK_ASYNC_QUEUE_SIZE]; // ctx tag of each callback, in order
+    int results[JOYSTICK_ASYNC_QUEUE_SIZE];
+    uint8_t data[JOYSTICK_ASYNC_QUEUE_SIZE][4];
+} callback_log_t;
+
+static callback_log_t cb_log;
+
+static void log_callback(void *ctx, int result, const uint8_t *data, uint8_t nbytes)
+{
+    uint32_t i = cb_log.calls++;
+    if (i < JOYSTICK_ASYNC_QUEUE_SIZE) {
+        cb_log.seq[i] = (uint8_t)(uintptr_t)ctx;
+        cb_log.results[i] = result;
+        memcpy(cb_log.data[i], data, nbytes < 4 ? nbytes : 4);
+    }
+}
+
+static void test_back_to_back(void)
+{
+    ScriptedBus bus;
+    bus.mock.set_stick(JOYSTICK_ADDR, 100, -100, 0);
+    cb_log = callback_log_t();
+
+    CHECK(bus.begin_read(JOYSTICK_ADDR, JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG, 4, log_callback, (void *)1));
+    CHECK(bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, log_callback, (void *)2));
+    uint8_t rgb[4] = {1, 2, 3, 4};
+    CHECK(bus.begin_write(JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4, log_callback, (void *)3));
+    rgb[0] = 9; // The write was copied at submission
+
+    // Only the first transfer is on the bus, the others wait in the queue
+    CHECK_EQ(bus.started, 1);
+    CHECK_EQ(bus.pending(), 3);
+
+    // Each completion starts the next transfer at once, no callback yet
+    joystick_host_advance_us(10000);
+    CHECK_EQ(bus.started, 3);
+    CHECK_EQ(bus.order[0], JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG);
+    CHECK_EQ(bus.order[1], JOYSTICK_BUTTON_REG);
+    CHECK_EQ(bus.order[2], JOYSTICK_RGB_REG);
+    CHECK_EQ(cb_log.calls, 0);
+    CHECK(!bus.is_idle());
+
+    // Callbacks run from poll(), in submission order
+    CHECK_EQ(bus.poll(), 3);
+    CHECK(bus.is_idle());
+    CHECK_EQ(cb_log.calls, 3);
+    for (uint8_t i = 0; i < 3; i++) {
+        CHECK_EQ(cb_log.seq[i], i + 1);
+    }
+    CHECK_EQ(cb_log.results[0], 4);
+    int16_t x, y;
+    memcpy(&x, &cb_log.data[0][0], 2);
+    memcpy(&y, &cb_log.data[0][2], 2);
+    CHECK_EQ(x, 100);
+    CHECK_EQ(y, -100);
+    CHECK_EQ(cb_log.data[1][0], 0);
+    CHECK_EQ(bus.mock.get_regs(JOYSTICK_ADDR)[JOYSTICK_RGB_REG], 1);
+    CHECK_EQ(bus.stops, 1); // Bus stopped once the queue ran empty
+}
+
+static void test_limits(void)
+{
+    ScriptedBus bus;
+    uint8_t buf[JOYSTICK_ASYNC_MAX_DATA + 1] = {};
+
+    CHECK(!bus.begin_read(JOYSTICK_ADDR, 0, 0, nullptr, nullptr));
+    CHECK(!bus.begin_read(JOYSTICK_ADDR, 0, JOYSTICK_ASYNC_MAX_DATA + 1, nullptr, nullptr));
+    CHECK(!bus.begin_write(JOYSTICK_ADDR, 0, buf, JOYSTICK_ASYNC_MAX_DATA + 1, nullptr, nullptr));
+
+    // Completed but undispatched transfers still hold their slot
+    for (uint32_t i = 0; i < JOYSTICK_ASYNC_QUEUE_SIZE; i++) {
+        CHECK(bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, nullptr, nullptr));
+    }
+    CHECK(!bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, nullptr, nullptr));
+    joystick_host_advance_us(100000);
+    CHECK(!bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, nullptr, nullptr));
+    CHECK_EQ(bus.poll(), JOYSTICK_ASYNC_QUEUE_SIZE);
+    CHECK(bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, nullptr, nullptr));
+}
+
+static void test_errors(void)
+{
+    ScriptedBus bus;
+    bus.script[0] = STEP_NACK;
+    bus.script[1] = STEP_STALL;
+    cb_log = callback_log_t();
+
+    for (uintptr_t i = 1; i <= 3; i++) {
+        bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, log_callback, (void *)i);
+    }
+
+    // The NACK ends its transfer, the stalled one holds the bus until the timeout
+    joystick_host_advance_us(JOYSTICK_ASYNC_TIMEOUT_US / 2);
+    CHECK_EQ(bus.poll(), 1);
+    CHECK_EQ(cb_log.results[0], PICO_ERROR_GENERIC);
+    CHECK_EQ(bus.started, 2);
+
+    joystick_host_advance_us(JOYSTICK_ASYNC_TIMEOUT_US);
+    bus.poll();                                   // Aborts the stall, starts transfer 3
+    joystick_host_advance_us(1000);
+    bus.poll();
+    CHECK_EQ(cb_log.calls, 3);
+    CHECK_EQ(cb_log.results[1], PICO_ERROR_TIMEOUT);
+    CHECK_EQ(cb_log.results[2], 1);
+    CHECK_EQ(bus.get_recovery_count(), 0);
+}
+
+static void test_recovery(void)
+{
+    ScriptedBus bus;
+    for (uint32_t i = 0; i < 5; i++) {
+        bus.script[i] = STEP_STALL;
+    }
+    uint8_t value;
+
+    // Consecutive timeouts recover the bus once the threshold is reached
+    for (uint32_t i = 0; i < JOYSTICK_ASYNC_RECOVERY_THRESHOLD; i++) {
+        CHECK_EQ(bus.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1), PICO_ERROR_TIMEOUT);
+    }
+    CHECK_EQ(bus.recovers, 1);
+    CHECK_EQ(bus.get_recovery_count(), 1);
+
+    // A success in between restarts the count
+    CHECK_EQ(bus.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1), PICO_ERROR_TIMEOUT);
+    CHECK_EQ(bus.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1), PICO_ERROR_TIMEOUT);
+    CHECK_EQ(bus.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1), 1);
+    bus.script[6] = STEP_STALL;
+    CHECK_EQ(bus.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1), PICO_ERROR_TIMEOUT);
+    CHECK_EQ(bus.recovers, 1);
+}
+
+static void test_recovery_nack(void)
+{
+    ScriptedBus bus;
+    bus.script[0] = STEP_NACK;
+    bus.script[1] = STEP_STALL;
+    bus.script[2] = STEP_NACK;
+    cb_log = callback_log_t();
+
+    // NACKs count like timeouts, mixed failures in a row recover the bus too
+    for (uintptr_t i = 1; i <= 4; i++) {
+        bus.begin_read(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, 1, log_callback, (void *)i);
+    }
+    joystick_host_advance_us(JOYSTICK_ASYNC_TIMEOUT_US * 2);
+    bus.poll();
+    CHECK_EQ(bus.started, 3);
+    CHECK_EQ(bus.recovers, 0);
+
+    // The third failure holds transfer 4 back until poll() has recovered the bus
+    joystick_host_advance_us(1000);
+    CHECK_EQ(bus.started, 3);
+    bus.poll();
+    CHECK_EQ(bus.recovers, 1);
+    CHECK_EQ(bus.get_recovery_count(), 1);
+    CHECK_EQ(bus.started, 4);
+    joystick_host_advance_us(1000);
+    bus.poll();
+    CHECK_EQ(cb_log.calls, 4);
+    CHECK_EQ(cb_log.results[0], PICO_ERROR_GENERIC);
+    CHECK_EQ(cb_log.results[1], PICO_ERROR_TIMEOUT);
+    CHECK_EQ(cb_log.results[2], PICO_ERROR_GENERIC);
+    CHECK_EQ(cb_log.results[3], 1);
+
+    // Two NACKs, a success, one NACK: no recovery
+    ScriptedBus other;
+    uint8_t value;
+    other.script[0] = STEP_NACK;
+    other.script[1] = STEP_NACK;
+    other.script[3] = STEP_NACK;
+    for (uint32_t i = 0; i < 4; i++) {
+        other.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1);
+    }
+    CHECK_EQ(other.recovers, 0);
+}
+
+// The whole Joystick API on the queue through the blocking accessors
+static void test_joystick(void)
+{
+    ScriptedBus bus;
+    bus.mock.set_stick(JOYSTICK_ADDR, -700, 300, 0);
+
+    Joystick joystick;
+    CHECK(joystick.begin(&bus, JOYSTICK_ADDR));
+    joystick_state_t state;
+    CHECK(joystick.read_state(&state));
+    CHECK_EQ(state.offset_x, -700);
+    CHECK_EQ(state.offset_y, 300);
+    CHECK_EQ(state.button, 0);
+    joystick.set_rgb_color(0x123456);
+    CHECK_EQ(joystick.get_rgb_color(), 0x123456);
+    CHECK(bus.is_idle());
+
+    // A failed transfer reaches the driver as a NACK
+    bus.script[bus.started] = STEP_NACK;
+    joystick.get_button_value();
+    CHECK_EQ(joystick.get_last_status(), JOYSTICK_ERROR_NACK);
+}
+
+int main(void)
+{
+    test_back_to_back();
+    test_limits();
+    test_errors();
+    test_recovery();
+    test_recovery_nack();
+    test_joystick();
+    return test_result("test_async_queue");
+}
@@ -0,0 +1,167 @@
+#include "joystick_bus.hpp"
+#include "joystick_mock_bus.hpp"
+#include "test_util.hpp"
+
+// JoystickBus with several units answering at different addresses of one mock bus
+
+/**
+ * @brief Transport wrapper recording the address of every transfer
+ */
+class AddressLog : public JoystickTransport {
+public:
+    JoystickMockBus mock;
+    uint8_t addrs[64];
+    uint32_t count = 0;
+
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override
+    {
+        log(addr);
+        return mock.read_reg(addr, reg, buf, nbytes);
+    }
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override
+    {
+        log(addr);
+        return mock.write_reg(addr, reg, buf, nbytes);
+    }
+    uint32_t transfers_to(uint8_t addr)
+    {
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < count && i < 64; i++) {
+            n += addrs[i] == addr;
+        }
+        return n;
+    }
+
+private:
+    void log(uint8_t addr)
+    {
+        if (count < 64) {
+            addrs[count] = addr;
+        }
+        count++;
+    }
+};
+
+static void test_samples(void)
+{
+    AddressLog log;
+    log.mock.add_device(0x63);
+    log.mock.add_device(0x64);
+    log.mock.add_device(0x65);
+    log.mock.set_stick(0x63, 100, 0, 1);
+    log.mock.set_stick(0x64, 0, -200, 0);
+    log.mock.set_stick(0x65, 300, 300, 1);
+
+    JoystickBus bus;
+    bus.begin(&log);
+    CHECK_EQ(bus.add_device(0x63), 0);
+    CHECK_EQ(bus.add_device(0x64), 1);
+    CHECK_EQ(bus.add_device(0x65), 2);
+    CHECK_EQ(bus.add_device(0x64), -1);
+    CHECK_EQ(bus.get_device_count(), 3);
+
+    // Each unit gets its own stream
+    CHECK_EQ(bus.poll(0), 3);
+    log.mock.set_stick(0x64, 0, -250, 1);
+    CHECK_EQ(bus.poll(1000), 3);
+
+    joystick_state_t samples[4];
+    CHECK_EQ(bus.drain(0, samples, 4), 2);
+    CHECK_EQ(samples[0].offset_x, 100);
+    CHECK_EQ(bus.drain(1, samples, 4), 2);
+    CHECK_EQ(samples[0].offset_y, -200);
+    CHECK_EQ(samples[0].button, 0);
+    CHECK_EQ(samples[1].offset_y, -250);
+    CHECK_EQ(samples[1].button, 1);
+    joystick_state_t latest;
+    CHECK(bus.get_latest(2, &latest));
+    CHECK_EQ(latest.offset_x, 300);
+    CHECK(!bus.get_latest(3, &latest));
+    CHECK_EQ(bus.get_health(0)->reads, 2);
+}
+
+static void test_round_robin(void)
+{
+    AddressLog log;
+    JoystickBus bus;
+    bus.begin(&log);
+    for (uint8_t addr = 0x63; addr < 0x66; addr++) {
+        log.mock.add_device(addr);
+        bus.add_device(addr);
+    }
+
+    // Offsets and button are two bursts per unit, each tick starts one unit later
+    log.count = 0;
+    bus.poll(0);
+    bus.poll(1000);
+    const uint8_t expected[] = {0x63, 0x64, 0x65, 0x64, 0x65, 0x63};
+    for (uint32_t i = 0; i < 6; i++) {
+        CHECK_EQ(log.addrs[i * 2], expected[i]);
+        CHECK_EQ(log.addrs[i * 2 + 1], expected[i]);
+    }
+}
+
+static void test_backoff(void)
+{
+    AddressLog log;
+    log.mock.add_device(0x63);
+    log.mock.add_device(0x64);
+
+    JoystickBus bus;
+    bus.begin(&log);
+    bus.add_device(0x63);
+    bus.add_device(0x64);
+    CHECK_EQ(bus.add_device(0x65), 2); // Not connected: added offline, retried by poll
+    CHECK(!bus.is_online(2));
+
+    // Unit 0x64 fails JOYSTICK_BUS_FAIL_THRESHOLD polls in a row before it goes offline
+    log.mock.set_present(0x64, false);
+    uint64_t now = 0;
+    for (uint32_t i = 0; i < JOYSTICK_BUS_FAIL_THRESHOLD; i++) {
+        CHECK(bus.is_online(1));
+        CHECK_EQ(bus.poll(now), 1);
+        now += 1000;
+    }
+    CHECK(!bus.is_online(1));
+    CHECK_EQ(bus.get_health(1)->errors, JOYSTICK_BUS_FAIL_THRESHOLD);
+
+    // Offline units cost no transfer until their retry time
+    log.count = 0;
+    uint64_t offline_at = now - 1000;
+    while (now < offline_at + JOYSTICK_BUS_BACKOFF_MIN_US) {
+        CHECK_EQ(bus.poll(now), 1);
+        now += 1000;
+    }
+    CHECK_EQ(log.transfers_to(0x64), 0);
+    CHECK(bus.get_health(1)->skipped > 0);
+
+    // A failed retry doubles the delay of the next one
+    log.count = 0;
+    bus.poll(now);
+    CHECK_EQ(log.transfers_to(0x64), 2);     // Both bursts of read_state
+    uint64_t retry_at = now;
+    log.count = 0;
+    bus.poll(retry_at + 2 * JOYSTICK_BUS_BACKOFF_MIN_US - 1000);
+    CHECK_EQ(log.transfers_to(0x64), 0);
+    bus.poll(retry_at + 2 * JOYSTICK_BUS_BACKOFF_MIN_US);
+    CHECK_EQ(log.transfers_to(0x64), 2);
+
+    // Back on the bus: online at the next retry, samples flow again
+    log.mock.set_present(0x64, true);
+    now = retry_at + 10 * JOYSTICK_BUS_BACKOFF_MIN_US;
+    CHECK_EQ(bus.poll(now), 2);
+    CHECK(bus.is_online(1));
+    CHECK_EQ(bus.get_health(1)->consecutive_errors, 0);
+
+    // The unit missing from the start is backed off the same way
+    CHECK(!bus.is_online(2));
+    CHECK(bus.get_health(2)->skipped > 0);
+}
+
+int main(void)
+{
+    test_samples();
+    test_round_robin();
+    test_backoff();
+    return test_result("test_bus");
+}
@@ -0,0 +1,186 @@
+#include <string.h>
+#include "joystick_calibration.hpp"
+#include "test_util.hpp"
+
+// Calibration math and the flash record, the parts of the calibration that do not touch the hardware
+
+static void run_sweep(JoystickCalibrator &cal, bool invert_x, bool invert_y)
+{
+    cal.begin();
+
+    // Released: noise of +-3 around 120, 130
+    for (int i = 0; i < 64; i++) {
+        int n = i % 7 - 3;
+        cal.add_sample(120 + n, 130 - n);
+    }
+    cal.next_phase();
+
+    // Up, then right
+    for (int i = 0; i < 16; i++) {
+        cal.add_sample(120, invert_y ? 240 : 20);
+    }
+    cal.next_phase();
+    for (int i = 0; i < 16; i++) {
+        cal.add_sample(invert_x ? 10 : 230, 130);
+    }
+    cal.next_phase();
+
+    // Edge sweep over x 10..230 and y 20..240
+    for (int i = 0; i <= 220; i++) {
+        cal.add_sample(10 + i, 240 - i);
+    }
+    cal.next_phase();
+}
+
+static void test_calibrator(void)
+{
+    JoystickCalibrator cal;
+    joystick_cal_profile_t profile;
+    run_sweep(cal, false, false);
+    CHECK(cal.finish(&profile));
+    CHECK_EQ(cal.get_phase(), JOYSTICK_CAL_DONE);
+    CHECK_EQ(profile.center_x, 120);
+    CHECK_EQ(profile.center_y, 130);
+    CHECK_EQ(profile.min_x, 10);
+    CHECK_EQ(profile.max_x, 230);
+    CHECK_EQ(profile.min_y, 20);
+    CHECK_EQ(profile.max_y, 240);
+    CHECK_EQ(profile.dead_zone, 3 + JOYSTICK_CAL_DEAD_ZONE_MARGIN);
+    CHECK(!profile.invert_x);
+    CHECK(!profile.invert_y);
+
+    // Orientation comes from the up and right steps
+    run_sweep(cal, true, true);
+    CHECK(cal.finish(&profile));
+    CHECK(profile.invert_x);
+    CHECK(profile.invert_y);
+}
+
+static void test_calibrator_fail(void)
+{
+    JoystickCalibrator cal;
+    joystick_cal_profile_t profile;
+
+    // A step without samples
+    cal.begin();
+    cal.add_sample(128, 128);
+    cal.next_phase();
+    cal.next_phase();
+    CHECK(!cal.finish(&profile));
+
+    // Travel below JOYSTICK_CAL_MIN_RANGE on one side
+    cal.begin();
+    cal.add_sample(128, 128);
+    cal.next_phase();
+    for (int phase = JOYSTICK_CAL_UP; phase < JOYSTICK_CAL_DONE; phase++) {
+        cal.add_sample(0, 255);
+        cal.add_sample(255, 128 - JOYSTICK_CAL_MIN_RANGE + 1);
+        cal.next_phase();
+    }
+    CHECK_EQ(cal.get_phase(), JOYSTICK_CAL_DONE);
+    CHECK(!cal.finish(&profile));
+
+    // Samples after the last step are ignored
+    cal.add_sample(0, 0);
+    CHECK_EQ(cal.get_phase(), JOYSTICK_CAL_DONE);
+}
+
+static void test_lut(void)
+{
+    int16_t lut[256];
+    joystick_cal_build_lut(lut, 120, 10, 230, 5, false);
+
+    // Dead zone edges
+    for (int raw = 115; raw <= 125; raw++) {
+        CHECK_EQ(lut[raw], 0);
+    }
+    CHECK(lut[126] > 0);
+    CHECK(lut[114] < 0);
+
+    // Calibrated extents reach full scale, readings past them saturate
+    CHECK_EQ(lut[230], JOYSTICK_CAL_OUTPUT_MAX);
+    CHECK_EQ(lut[10], -JOYSTICK_CAL_OUTPUT_MAX);
+    CHECK_EQ(lut[255], JOYSTICK_CAL_OUTPUT_MAX);
+    CHECK_EQ(lut[0], -JOYSTICK_CAL_OUTPUT_MAX);
+
+    // Linear on each side, so half the travel maps to half scale
+    CHECK_EQ(lut[125 + 105 / 2], 52 * JOYSTICK_CAL_OUTPUT_MAX / 105);
+    for (int raw = 1; raw < 256; raw++) {
+        CHECK(lut[raw] >= lut[raw - 1]);
+    }
+
+    // Inverted axis mirrors the sign
+    int16_t inv[256];
+    joystick_cal_build_lut(inv, 120, 10, 230, 5, true);
+    for (int raw = 0; raw < 256; raw++) {
+        CHECK_EQ(inv[raw], -lut[raw]);
+    }
+
+    // No travel on a side maps straight to full scale
+    joystick_cal_build_lut(lut, 250, 0, 252, 2, false);
+    CHECK_EQ(lut[253], JOYSTICK_CAL_OUTPUT_MAX);
+
+    JoystickCalMap map;
+    joystick_cal_profile_t profile = {120, 130, 10, 230, 20, 240, 5, false, true};
+    map.set_profile(profile);
+    int16_t x, y;
+    map.map(230, 20, &x, &y);
+    CHECK_EQ(x, JOYSTICK_CAL_OUTPUT_MAX);
+    CHECK_EQ(y, JOYSTICK_CAL_OUTPUT_MAX);
+    map.map(120, 133, &x, &y);
+    CHECK_EQ(x, 0);
+    CHECK_EQ(y, 0);
+}
+
+static void test_record(void)
+{
+    // Reference value of the IEEE CRC-32
+    CHECK_EQ(joystick_cal_crc32((const uint8_t *)"123456789", 9), 0xCBF43926UL);
+
+    // Record at the start of an erased flash page
+    joystick_cal_profile_t profile = {120, 130, 10, 230, 20, 240, 5, false, true};
+    uint8_t page[256];
+    memset(page, 0xFF, sizeof(page));
+    joystick_cal_encode(profile, page);
+
+    static const uint8_t layout[16] = {
+        0x4A, 0x43, 0x41, 0x4C, JOYSTICK_CAL_VERSION, 120, 130, 10, 230, 20, 240, 5, 0x02, 0, 0, 0,
+    };
+    CHECK(memcmp(page, layout, sizeof(layout)) == 0);
+    uint32_t crc = joystick_cal_crc32(page, 16);
+    CHECK_EQ(page[16], crc & 0xFF);
+    CHECK_EQ(page[19], crc >> 24);
+    CHECK_EQ(page[JOYSTICK_CAL_RECORD_SIZE], 0xFF); // Rest of the page stays erased
+
+    joystick_cal_profile_t decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    CHECK(joystick_cal_decode(page, &decoded));
+    CHECK(memcmp(&decoded, &profile, sizeof(profile)) == 0);
+
+    // An erased sector and any flipped bit are rejected
+    uint8_t erased[JOYSTICK_CAL_RECORD_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    CHECK(!joystick_cal_decode(erased, &decoded));
+    for (int i = 0; i < JOYSTICK_CAL_RECORD_SIZE; i++) {
+        page[i] ^= 0x10;
+        CHECK(!joystick_cal_decode(page, &decoded));
+        page[i] ^= 0x10;
+    }
+
+    // A record of another version is rejected even with a matching CRC
+    page[4] = JOYSTICK_CAL_VERSION + 1;
+    crc = joystick_cal_crc32(page, 16);
+    for (int i = 0; i < 4; i++) {
+        page[16 + i] = (crc >> (8 * i)) & 0xFF;
+    }
+    CHECK(!joystick_cal_decode(page, &decoded));
+}
+
+int main(void)
+{
+    test_calibrator();
+    test_calibrator_fail();
+    test_lut();
+    test_record();
+    return test_result("test_calibration");
+}
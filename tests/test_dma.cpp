@@ -0,0 +1,210 @@
+#include "st7789.hpp"
+#include "st7789_dma.hpp"
+#include "test_util.hpp"
+
+// DmaPipeline against a scripted engine: the test sees every start() and
+// decides when a transfer ends. The last part measures the host HAL on the
+// simulated clock, pipelined against waiting for every chunk.
+
+using st7789::DmaEngine;
+using st7789::DmaPipeline;
+
+/**
+ * @brief Engine whose transfers end only in wait() or when the test completes them
+ */
+class FakeEngine : public DmaEngine {
+public:
+    DmaPipeline *pipeline = nullptr;
+    const uint16_t *data[16];
+    size_t count[16];
+    bool increment[16];
+    uint32_t starts = 0;
+    uint32_t waits = 0;
+    uint32_t aborts = 0;
+    bool active = false;
+    bool stuck = false;         // wait() lets time pass but nothing finishes
+
+    void start(const uint16_t *d, size_t n, bool inc) override
+    {
+        if (starts < 16) {
+            data[starts] = d;
+            count[starts] = n;
+            increment[starts] = inc;
+        }
+        starts++;
+        active = true;
+    }
+    void abort() override
+    {
+        aborts++;
+        active = false;
+    }
+    void wait() override
+    {
+        waits++;
+        st7789::platformSleepUs(100);
+        if (!stuck) {
+            finish();
+        }
+    }
+    // The transfer on the wire ends, like the DMA interrupt
+    void finish(void)
+    {
+        if (active) {
+            active = false;
+            pipeline->complete();
+        }
+    }
+};
+
+static uint32_t drained = 0;
+
+static void on_drain(void *ctx)
+{
+    (void)ctx;
+    drained++;
+}
+
+static void test_slots(void)
+{
+    FakeEngine engine;
+    DmaPipeline dma;
+    engine.pipeline = &dma;
+    dma.begin(&engine);
+    dma.setDrainCallback(on_drain, nullptr);
+    drained = 0;
+    static const uint16_t a[4] = {1, 2, 3, 4}, b[2] = {5, 6}, c[3] = {7, 8, 9}, d[1] = {10};
+
+    // The first write starts at once and the second waits in the other slot, neither blocks
+    CHECK(!dma.busy());
+    CHECK(dma.write(a, 4));
+    CHECK(dma.write(b, 2));
+    CHECK_EQ(engine.starts, 1);
+    CHECK_EQ(engine.waits, 0);
+    CHECK(engine.data[0] == a);         // Streamed in place, no copy
+    CHECK_EQ(engine.count[0], 4);
+    CHECK(engine.increment[0]);
+    CHECK(dma.busy());
+
+    // The third write waits for its own slot only: a ends, b is chained, c queues behind it
+    CHECK(dma.write(c, 3));
+    CHECK_EQ(engine.waits, 1);
+    CHECK_EQ(engine.starts, 2);
+    CHECK(engine.data[1] == b);
+    CHECK_EQ(engine.count[1], 2);
+    CHECK(engine.active);
+    CHECK_EQ(dma.getTransferCount(), 1);
+
+    // A completion with a write queued starts it at once, without waiting for the caller
+    engine.finish();
+    CHECK_EQ(engine.starts, 3);
+    CHECK(engine.data[2] == c);
+    CHECK_EQ(drained, 0);
+
+    // Slot 1 is free already: d queues without waiting, the fill after it waits for c
+    CHECK(dma.write(d, 1));
+    CHECK_EQ(engine.waits, 1);
+    CHECK(dma.fill(0xF800, 76800));
+    CHECK_EQ(engine.waits, 2);
+    CHECK_EQ(engine.starts, 4);
+    CHECK(engine.data[3] == d);
+
+    // waitIdle() is the fence for everything queued, the drain callback runs once
+    CHECK(dma.waitIdle());
+    CHECK(!dma.busy());
+    CHECK_EQ(engine.starts, 5);
+    CHECK_EQ(engine.count[4], 76800);
+    CHECK(!engine.increment[4]);
+    CHECK_EQ(*engine.data[4], 0xF800);
+    CHECK_EQ(dma.getTransferCount(), 5);
+    CHECK_EQ(drained, 1);
+
+    // Completions without a transfer on the wire are ignored
+    dma.complete();
+    CHECK_EQ(dma.getTransferCount(), 5);
+    CHECK_EQ(drained, 1);
+    CHECK(dma.write(a, 0));
+    CHECK_EQ(engine.starts, 5);
+}
+
+static void test_abort(void)
+{
+    FakeEngine engine;
+    DmaPipeline dma;
+    engine.pipeline = &dma;
+    dma.begin(&engine);
+    static const uint16_t a[2] = {1, 2};
+
+    // Both slots taken and nothing finishing: the next write and the fence time out
+    engine.stuck = true;
+    CHECK(dma.write(a, 2));
+    CHECK(dma.fill(0, 100));
+    uint64_t start = st7789::platformTimeUs();
+    CHECK(!dma.write(a, 2, 2));
+    CHECK(st7789::platformTimeUs() - start > 2000);
+    CHECK(!dma.waitIdle(2));
+    CHECK_EQ(engine.starts, 1);
+
+    // abort() drops the queued slot too, the next write starts at once
+    dma.abort();
+    CHECK_EQ(engine.aborts, 1);
+    CHECK(!dma.busy());
+    CHECK(dma.waitIdle(0));
+    engine.stuck = false;
+    CHECK(dma.write(a, 2));
+    CHECK_EQ(engine.starts, 2);
+    CHECK(engine.data[1] == a);
+    engine.finish();
+    CHECK(!dma.busy());
+    CHECK_EQ(dma.getTransferCount(), 1);
+}
+
+#define CHUNKS 8
+#define CHUNK_PIXELS 1200
+#define RENDER_US 400
+
+// Render a chunk, then send it: pipelined the next chunk is rendered while the
+// previous one is on the wire, serialized every chunk is waited for
+static uint64_t stream(st7789::HAL &hal, bool pipelined)
+{
+    static uint16_t buffers[3][CHUNK_PIXELS];
+    uint64_t start = st7789::platformTimeUs();
+    for (int i = 0; i < CHUNKS; i++) {
+        st7789::platformSleepUs(RENDER_US);
+        CHECK(hal.writeDataDma(buffers[i % 3], CHUNK_PIXELS));
+        if (!pipelined) {
+            CHECK(hal.waitIdle());
+        }
+    }
+    CHECK(hal.waitIdle());
+    return st7789::platformTimeUs() - start;
+}
+
+static void test_throughput(void)
+{
+    st7789::ST7789 lcd;
+    CHECK(lcd.begin());
+    st7789::HAL &hal = lcd.hal();
+    CHECK(hal.waitIdle());              // The screen clear of begin()
+    uint64_t wire_us = (uint64_t)CHUNK_PIXELS * 16 * 1000000 / hal.getConfig().spi_speed_hz;
+
+    uint64_t bytes = hal.getSpiBytes();
+    uint64_t serialized = stream(hal, false);
+    uint64_t pipelined = stream(hal, true);
+    CHECK_EQ(hal.getSpiBytes() - bytes, 2 * CHUNKS * CHUNK_PIXELS * 2);
+    printf("DMA chunks=%d render_us=%d wire_us=%llu serialized_us=%llu pipelined_us=%llu\n",
+           CHUNKS, RENDER_US, (unsigned long long)wire_us,
+           (unsigned long long)serialized, (unsigned long long)pipelined);
+
+    // Serialized the wire idles during every render, pipelined only during the first
+    CHECK_EQ(serialized, CHUNKS * (RENDER_US + wire_us));
+    CHECK_EQ(pipelined, RENDER_US + CHUNKS * wire_us);
+}
+
+int main(void)
+{
+    test_slots();
+    test_abort();
+    test_throughput();
+    return test_result("test_dma");
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include "joystick_drift.hpp"
+#include "test_util.hpp"
+
+// JoystickDrift on synthetic offset traces: a released stick resting off center
+// with ADC noise, a center that wanders over time, and real stick activity
+
+#define WINDOW 32 // Default window_shift
+
+static uint32_t noise_seed = 1;
+
+// Uniform noise in -amplitude..amplitude
+static int16_t noise(int16_t amplitude)
+{
+    noise_seed = noise_seed * 1103515245 + 12345;
+    return (int16_t)((int32_t)((noise_seed >> 16) % (2 * amplitude + 1)) - amplitude);
+}
+
+static void rest(JoystickDrift &drift, int16_t x, int16_t y, uint32_t windows)
+{
+    for (uint32_t i = 0; i < windows * WINDOW; i++) {
+        drift.update(x + noise(10), y + noise(10));
+    }
+}
+
+static void test_static_offset(void)
+{
+    JoystickDrift drift;
+    rest(drift, 120, -80, 1);
+    const joystick_drift_stats_t &stats = drift.get_stats();
+    CHECK_EQ(stats.idle_windows, 1);
+
+    // At most max_step per window, so a stick resting off center is absorbed slowly
+    CHECK(stats.center_x > 0 && stats.center_x <= drift.get_config().max_step);
+    CHECK(stats.center_y < 0 && stats.center_y >= -drift.get_config().max_step);
+
+    rest(drift, 120, -80, 79);
+    CHECK_EQ(stats.idle_windows, 80);
+    CHECK_EQ(stats.active_windows, 0);
+    CHECK(abs(stats.center_x - 120) <= 2);
+    CHECK(abs(stats.center_y + 80) <= 2);
+    CHECK(abs(stats.last_idle_x - 120) <= 4);
+
+    // The corrected trace rests at 0 again
+    int32_t sum_x = 0, sum_y = 0;
+    for (int i = 0; i < 256; i++) {
+        int16_t x = 120 + noise(10);
+        int16_t y = -80 + noise(10);
+        drift.correct(&x, &y);
+        sum_x += x;
+        sum_y += y;
+    }
+    CHECK(abs(sum_x / 256) <= 3);
+    CHECK(abs(sum_y / 256) <= 3);
+    CHECK_EQ(stats.corrected_samples, 256);
+}
+
+static void test_wandering_center(void)
+{
+    JoystickDrift drift;
+    const joystick_drift_stats_t &stats = drift.get_stats();
+
+    // Center drifts by one unit every window up to 200, then back to -100
+    int16_t center;
+    int32_t worst = 0;
+    for (uint32_t w = 0; w < 500; w++) {
+        center = (int16_t)(w < 200 ? w : 400 - w);
+        rest(drift, center, -center / 2, 1);
+        // Past the start the estimate follows with a bounded lag
+        if (w >= 64) {
+            int32_t error = abs(stats.center_x - center);
+            if (error > worst) worst = error;
+        }
+    }
+    CHECK_EQ(stats.idle_windows, 500);
+    CHECK(worst <= 12);
+    CHECK(abs(stats.center_y + center / 2) <= 12);
+}
+
+static void test_activity(void)
+{
+    JoystickDrift drift;
+    const joystick_drift_stats_t &stats = drift.get_stats();
+    rest(drift, 60, 60, 60);
+    int16_t center_x = stats.center_x;
+    CHECK(abs(center_x - 60) <= 2);
+
+    // Sweeps, a stick held past max_drift and a pressed button leave the estimate alone
+    for (uint32_t i = 0; i < 8 * WINDOW; i++) {
+        drift.update((int16_t)((i * 97) % 4096 - 2048), (int16_t)((i * 61) % 4096 - 2048));
+    }
+    rest(drift, 1500, 0, 8);
+    rest(drift, 0, -(drift.get_config().max_drift + 20), 8);
+    CHECK_EQ(stats.active_windows, 24);
+    CHECK_EQ(stats.center_x, center_x);
+    for (uint32_t i = 0; i < 8 * WINDOW; i++) {
+        drift.update(60 + noise(10), 60 + noise(10), i == 5 * WINDOW + 3);
+    }
+    CHECK_EQ(stats.active_windows, 25);
+    CHECK_EQ(stats.idle_windows, 67);
+
+    // A noisy rest above idle_stddev is rejected too
+    uint32_t active = stats.active_windows;
+    for (uint32_t i = 0; i < WINDOW; i++) {
+        drift.update(60 + noise(80), 60);
+    }
+    CHECK_EQ(stats.active_windows, active + 1);
+
+    // Snapshots: the button field counts only when it was read, offsets are corrected in place
+    joystick_state_t state = {};
+    state.fields = JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON;
+    state.button = 1;
+    state.offset_x = 60;
+    state.offset_y = 60;
+    drift.process(state);
+    CHECK(abs(state.offset_x) <= 2);
+    state.fields = JOYSTICK_STATE_BUTTON;
+    state.offset_x = 60;
+    drift.process(state);
+    CHECK_EQ(state.offset_x, 60);
+
+    drift.reset();
+    CHECK_EQ(stats.center_x, 0);
+    CHECK_EQ(stats.idle_windows, 0);
+}
+
+int main(void)
+{
+    test_static_offset();
+    test_wandering_center();
+    test_activity();
+    return test_result("test_drift");
+}
@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include "st7789.hpp"
+#include "test_util.hpp"
+
+// FrameBuffer dirty rectangles and ST7789::flush() on the host panel: what is
+// drawn reaches the panel on flush only, each dirty rectangle costs one
+// address window (11 bytes) plus 2 bytes per pixel, and drawing never changes
+// the buffer while a flush is still sending it.
+
+#define WIDTH 240
+#define HEIGHT 320
+#define WINDOW_BYTES 11
+
+using st7789::FrameBuffer;
+using st7789::Rect;
+
+static bool panel_matches(st7789::ST7789 &lcd, const FrameBuffer &fb)
+{
+    for (int16_t y = 0; y < HEIGHT; y++) {
+        for (int16_t x = 0; x < WIDTH; x++) {
+            if (lcd.hal().getPanelPixel(x, y) != fb.getPixel(x, y)) {
+                printf("panel %d,%d: %04x, framebuffer %04x\n", x, y,
+                       lcd.hal().getPanelPixel(x, y), fb.getPixel(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static uint64_t dirty_bytes(const FrameBuffer &fb)
+{
+    uint64_t bytes = 0;
+    for (uint8_t i = 0; i < fb.getDirtyCount(); i++) {
+        bytes += WINDOW_BYTES + (uint64_t)fb.getDirty(i).area() * 2;
+    }
+    return bytes;
+}
+
+static bool touching(const Rect &a, const Rect &b)
+{
+    return a.x0 <= b.x1 + 1 && b.x0 <= a.x1 + 1 && a.y0 <= b.y1 + 1 && b.y0 <= a.y1 + 1;
+}
+
+static void test_flush(bool dma)
+{
+    st7789::ST7789 lcd;
+    st7789::Config config;
+    config.dma.enabled = dma;
+    CHECK(lcd.begin(config));
+    CHECK(lcd.waitIdle());
+
+    FrameBuffer fb;
+    CHECK(fb.begin(WIDTH, HEIGHT));
+    fb.fillRect(0, 0, WIDTH, HEIGHT, st7789::BLUE);
+    FrameBuffer small;
+    CHECK(small.begin(10, 10));
+    CHECK(!lcd.setFrameBuffer(&small));
+
+    // The first flush sends the whole frame as one window
+    CHECK(lcd.setFrameBuffer(&fb));
+    CHECK_EQ(fb.getDirtyCount(), 1);
+    uint64_t bytes = lcd.hal().getSpiBytes();
+    CHECK(lcd.flush());
+    CHECK_EQ(lcd.hal().getSpiBytes() - bytes, WINDOW_BYTES + WIDTH * HEIGHT * 2);
+    CHECK(lcd.waitIdle());
+    CHECK(panel_matches(lcd, fb));
+
+    // The first drawing call after a flush waits until the buffer has been sent
+    if (dma) {
+        fb.markAllDirty();
+        CHECK(lcd.flush());
+        CHECK(lcd.isDmaBusy());
+        uint64_t start = st7789::platformTimeUs();
+        lcd.drawPixel(0, 0, st7789::BLUE);
+        CHECK(!lcd.isDmaBusy());
+        CHECK(st7789::platformTimeUs() - start >= (uint64_t)WIDTH * HEIGHT * 16 * 1000000 / config.spi_speed_hz);
+        start = st7789::platformTimeUs();
+        lcd.drawPixel(0, 0, st7789::BLUE);
+        CHECK_EQ(st7789::platformTimeUs(), start);
+        CHECK(lcd.flush());
+        CHECK(lcd.waitIdle());
+    }
+
+    // Drawing goes to the buffer only, flush sends the two dirty regions
+    lcd.fillRect(10, 10, 20, 5, st7789::RED);
+    lcd.drawPixel(200, 300, st7789::WHITE);
+    CHECK_EQ(lcd.hal().getPanelPixel(10, 10), st7789::BLUE);
+    CHECK_EQ(fb.getDirtyCount(), 2);
+    bytes = lcd.hal().getSpiBytes();
+    CHECK(lcd.flush());
+    CHECK_EQ(lcd.hal().getSpiBytes() - bytes, 2 * WINDOW_BYTES + (20 * 5 + 1) * 2);
+    CHECK_EQ(fb.getDirtyCount(), 0);
+    CHECK(lcd.waitIdle());
+    CHECK(panel_matches(lcd, fb));
+
+    // Nothing dirty, nothing sent
+    bytes = lcd.hal().getSpiBytes();
+    CHECK(lcd.flush());
+    CHECK_EQ(lcd.hal().getSpiBytes(), bytes);
+
+    // Shapes, text and a clipped image, more regions than slots
+    lcd.fillCircle(50, 50, 10, st7789::GREEN);
+    lcd.drawLine(0, 200, 239, 210, st7789::YELLOW);
+    lcd.drawString(100, 100, "Hi", st7789::WHITE, st7789::BLACK, 1);
+    static const uint16_t image[6] = {1, 2, 3, 4, 5, 6};
+    lcd.drawImage(-1, 318, 3, 2, image);
+    for (int16_t i = 0; i < 12; i++) {
+        lcd.drawPixel(20 * i, 150 + (i & 1) * 20, (uint16_t)(0x0100 + i));
+    }
+    CHECK_EQ(fb.getPixel(0, 318), 2);
+    CHECK_EQ(fb.getPixel(1, 319), 6);
+    CHECK(fb.getDirtyCount() <= FrameBuffer::MAX_DIRTY);
+    uint64_t expected = dirty_bytes(fb);
+    bytes = lcd.hal().getSpiBytes();
+    CHECK(lcd.flush());
+    CHECK_EQ(lcd.hal().getSpiBytes() - bytes, expected);
+    CHECK(lcd.waitIdle());
+    CHECK(panel_matches(lcd, fb));
+
+    // Without a framebuffer drawing reaches the panel directly again
+    CHECK(lcd.setFrameBuffer(nullptr));
+    CHECK(!lcd.flush());
+    CHECK(lcd.fillRectDMA(0, 0, 1, 1, 0xABCD));
+    CHECK(lcd.waitIdle());
+    CHECK_EQ(lcd.hal().getPanelPixel(0, 0), 0xABCD);
+    CHECK(fb.getPixel(0, 0) != 0xABCD);
+}
+
+static void test_merge(void)
+{
+    FrameBuffer fb;
+    CHECK(fb.begin(WIDTH, HEIGHT));
+
+    // Overlapping and edge sharing rectangles grow into one
+    fb.markDirty(0, 0, 9, 9);
+    fb.markDirty(5, 5, 14, 14);
+    CHECK_EQ(fb.getDirtyCount(), 1);
+    fb.markDirty(15, 0, 20, 3);
+    CHECK_EQ(fb.getDirtyCount(), 1);
+    const Rect &r = fb.getDirty(0);
+    CHECK_EQ(r.x0, 0);
+    CHECK_EQ(r.y0, 0);
+    CHECK_EQ(r.x1, 20);
+    CHECK_EQ(r.y1, 14);
+
+    // A column of space keeps regions apart, until one bridges them
+    fb.markDirty(22, 0, 30, 5);
+    CHECK_EQ(fb.getDirtyCount(), 2);
+    fb.markDirty(50, 50, 60, 60);
+    CHECK_EQ(fb.getDirtyCount(), 3);
+    fb.markDirty(20, 5, 49, 49);
+    CHECK_EQ(fb.getDirtyCount(), 1);
+    CHECK_EQ(fb.getDirty(0).x1, 60);
+    CHECK_EQ(fb.getDirty(0).y1, 60);
+
+    // Clipped to the frame, fully outside marks nothing
+    fb.clearDirty();
+    fb.markDirty(-5, -5, 2, 2);
+    fb.markDirty(WIDTH, 0, WIDTH + 5, 5);
+    CHECK_EQ(fb.getDirtyCount(), 1);
+    CHECK_EQ(fb.getDirty(0).x0, 0);
+    CHECK_EQ(fb.getDirty(0).area(), 9);
+}
+
+static void test_overflow(void)
+{
+    FrameBuffer fb;
+    CHECK(fb.begin(WIDTH, HEIGHT));
+
+    // Every slot used by a single pixel, the next region joins the one that grows the least
+    for (int16_t i = 0; i < FrameBuffer::MAX_DIRTY; i++) {
+        fb.markDirty(i * 20, 0, i * 20, 0);
+    }
+    CHECK_EQ(fb.getDirtyCount(), FrameBuffer::MAX_DIRTY);
+    fb.markDirty(145, 0, 145, 0);
+    CHECK_EQ(fb.getDirtyCount(), FrameBuffer::MAX_DIRTY);
+    int grown = 0;
+    for (uint8_t i = 0; i < fb.getDirtyCount(); i++) {
+        const Rect &r = fb.getDirty(i);
+        if (r.area() > 1) {
+            CHECK_EQ(r.x0, 140);
+            CHECK_EQ(r.x1, 145);
+            grown++;
+        }
+    }
+    CHECK_EQ(grown, 1);
+
+    // Random regions: never more than MAX_DIRTY rectangles, none touching, no marked pixel lost
+    static bool marked[HEIGHT][WIDTH];
+    srand(1);
+    fb.clearDirty();
+    for (int run = 0; run < 500; run++) {
+        int16_t x = rand() % WIDTH;
+        int16_t y = rand() % HEIGHT;
+        int16_t x1 = x + rand() % 20;
+        int16_t y1 = y + rand() % 20;
+        fb.markDirty(x, y, x1, y1);
+        for (int16_t row = y; row <= y1 && row < HEIGHT; row++) {
+            for (int16_t col = x; col <= x1 && col < WIDTH; col++) {
+                marked[row][col] = true;
+            }
+        }
+
+        CHECK(fb.getDirtyCount() <= FrameBuffer::MAX_DIRTY);
+        for (uint8_t i = 0; i < fb.getDirtyCount(); i++) {
+            for (uint8_t j = i + 1; j < fb.getDirtyCount(); j++) {
+                CHECK(!touching(fb.getDirty(i), fb.getDirty(j)));
+            }
+        }
+        if (run % 50 == 49) {
+            for (int16_t row = 0; row < HEIGHT; row++) {
+                for (int16_t col = 0; col < WIDTH; col++) {
+                    if (!marked[row][col]) {
+                        continue;
+                    }
+                    bool covered = false;
+                    for (uint8_t i = 0; i < fb.getDirtyCount() && !covered; i++) {
+                        const Rect &r = fb.getDirty(i);
+                        covered = col >= r.x0 && col <= r.x1 && row >= r.y0 && row <= r.y1;
+                    }
+                    CHECK(covered);
+                }
+            }
+        }
+        if (test_failures > 0) {
+            break; // One broken merge is enough output
+        }
+    }
+}
+
+int main(void)
+{
+    test_flush(true);
+    test_flush(false);
+    test_merge();
+    test_overflow();
+    return test_result("test_framebuffer");
+}
@@ -0,0 +1,107 @@
+#include "st7789.hpp"
+#include "test_util.hpp"
+
+// Lines and filled circles on the host panel: every span is one address window
+// (CASET, RASET, RAMWR and their 8 parameter bytes) plus 2 bytes per pixel, so
+// the SPI byte count shows any span that is split or drawn twice.
+
+#define WINDOW_BYTES 11
+
+static uint32_t count_color(st7789::HAL &hal, uint16_t color)
+{
+    uint32_t count = 0;
+    for (uint16_t y = 0; y < hal.getConfig().height; y++) {
+        for (uint16_t x = 0; x < hal.getConfig().width; x++) {
+            if (hal.getPanelPixel(x, y) == color) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static void test_lines(st7789::ST7789 &lcd)
+{
+    st7789::HAL &hal = lcd.hal();
+
+    // Axis-aligned lines in either direction are a single span
+    uint64_t bytes = hal.getSpiBytes();
+    lcd.drawLine(109, 20, 10, 20, st7789::RED);
+    CHECK_EQ(hal.getSpiBytes() - bytes, WINDOW_BYTES + 100 * 2);
+    bytes = hal.getSpiBytes();
+    lcd.drawLine(5, 150, 5, 51, st7789::RED);
+    CHECK_EQ(hal.getSpiBytes() - bytes, WINDOW_BYTES + 100 * 2);
+    lcd.waitIdle();
+    CHECK_EQ(hal.getPanelPixel(10, 20), st7789::RED);
+    CHECK_EQ(hal.getPanelPixel(109, 20), st7789::RED);
+    CHECK_EQ(hal.getPanelPixel(110, 20), st7789::BLACK);
+    CHECK_EQ(hal.getPanelPixel(5, 51), st7789::RED);
+    CHECK_EQ(hal.getPanelPixel(5, 150), st7789::RED);
+    CHECK_EQ(count_color(hal, st7789::RED), 200);
+
+    // Shallow and steep lines: one span per row or column they cross
+    bytes = hal.getSpiBytes();
+    lcd.drawLine(0, 200, 99, 209, st7789::GREEN);
+    CHECK_EQ(hal.getSpiBytes() - bytes, 10 * WINDOW_BYTES + 100 * 2);
+    bytes = hal.getSpiBytes();
+    lcd.drawLine(209, 99, 200, 0, st7789::BLUE);
+    CHECK_EQ(hal.getSpiBytes() - bytes, 10 * WINDOW_BYTES + 100 * 2);
+    lcd.waitIdle();
+    CHECK_EQ(count_color(hal, st7789::GREEN), 100);
+    CHECK_EQ(count_color(hal, st7789::BLUE), 100);
+    CHECK_EQ(hal.getPanelPixel(0, 200), st7789::GREEN);
+    CHECK_EQ(hal.getPanelPixel(99, 209), st7789::GREEN);
+    CHECK_EQ(hal.getPanelPixel(200, 0), st7789::BLUE);
+    CHECK_EQ(hal.getPanelPixel(209, 99), st7789::BLUE);
+
+    // A 45 degree line has nothing to merge, still one window per pixel
+    bytes = hal.getSpiBytes();
+    lcd.drawLine(120, 240, 169, 289, st7789::YELLOW);
+    CHECK_EQ(hal.getSpiBytes() - bytes, 50 * (WINDOW_BYTES + 2));
+    lcd.waitIdle();
+    CHECK_EQ(count_color(hal, st7789::YELLOW), 50);
+    CHECK_EQ(hal.getPanelPixel(144, 264), st7789::YELLOW);
+}
+
+static void test_fill_circle(st7789::ST7789 &lcd)
+{
+    st7789::HAL &hal = lcd.hal();
+    lcd.fillScreen(st7789::BLACK);
+    lcd.waitIdle();
+
+    const int16_t cx = 120, cy = 160;
+    for (int16_t r = 1; r <= 40; r += 13) {
+        uint16_t color = (uint16_t)(0x1000 + r);
+        uint64_t bytes = hal.getSpiBytes();
+        lcd.fillCircle(cx, cy, r, color);
+        lcd.waitIdle();
+
+        // One span per row, no pixel sent twice
+        uint32_t pixels = count_color(hal, color);
+        CHECK_EQ(hal.getSpiBytes() - bytes, (2 * r + 1) * WINDOW_BYTES + pixels * 2);
+
+        // Rows are solid, symmetric and inside the circle
+        for (int16_t dy = -r; dy <= r; dy++) {
+            int16_t half = 0;
+            while (half < r && hal.getPanelPixel(cx + half + 1, cy + dy) == color) {
+                half++;
+            }
+            CHECK_EQ(hal.getPanelPixel(cx - half, cy + dy), color);
+            CHECK(hal.getPanelPixel(cx - half - 1, cy + dy) != color);
+            CHECK(hal.getPanelPixel(cx + half + 1, cy + dy) != color);
+            CHECK(half * half + dy * dy <= r * (r + 1));
+        }
+        CHECK_EQ(hal.getPanelPixel(cx + r, cy), color);
+        CHECK_EQ(hal.getPanelPixel(cx, cy - r), color);
+        CHECK_EQ(hal.getPanelPixel(cx, cy + r), color);
+    }
+}
+
+int main(void)
+{
+    st7789::ST7789 lcd;
+    CHECK(lcd.begin());
+    test_lines(lcd);
+    test_fill_circle(lcd);
+    return test_result("test_gfx");
+}
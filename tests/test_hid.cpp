@@ -0,0 +1,125 @@
+#include "joystick_hid.hpp"
+#include "test_util.hpp"
+
+// Gamepad report packing and change detection, and the descriptor that describes the report
+
+// Input bits declared by the descriptor: Report Size times Report Count of every Input item
+static uint32_t descriptor_input_bits(void)
+{
+    uint32_t size = 0, count = 0, bits = 0;
+    for (uint32_t i = 0; i < JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE;) {
+        uint8_t prefix = joystick_hid_report_descriptor[i];
+        uint8_t len = prefix & 0x03;
+        uint32_t data = 0;
+        for (uint8_t b = 0; b < len; b++) {
+            data |= (uint32_t)joystick_hid_report_descriptor[i + 1 + b] << (8 * b);
+        }
+        switch (prefix & 0xFC) {
+        case 0x74: size = data; break;          // Report Size
+        case 0x94: count = data; break;         // Report Count
+        case 0x80: bits += size * count; break; // Input
+        }
+        i += 1 + len;
+    }
+    return bits;
+}
+
+static void test_descriptor(void)
+{
+    CHECK_EQ(sizeof(joystick_hid_report_descriptor), JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE);
+    CHECK_EQ(joystick_hid_report_descriptor[JOYSTICK_HID_REPORT_DESCRIPTOR_SIZE - 1], 0xC0);
+    CHECK_EQ(descriptor_input_bits(), JOYSTICK_HID_REPORT_SIZE * 8);
+}
+
+static void test_packing(void)
+{
+    JoystickHidReport report;
+    CHECK_EQ(report.get_size(), JOYSTICK_HID_REPORT_SIZE);
+
+    joystick_vector_t move = {0x1234, -2};
+    CHECK(report.update(move, true));
+    const uint8_t expected[JOYSTICK_HID_REPORT_SIZE] = {0x34, 0x12, 0xFE, 0xFF, 0x01};
+    for (int i = 0; i < JOYSTICK_HID_REPORT_SIZE; i++) {
+        CHECK_EQ(report.get_report()[i], expected[i]);
+    }
+
+    // -32768 is outside the logical range and clamps to -32767
+    move.x = -32768;
+    move.y = JOYSTICK_Q15_ONE;
+    report.update(move, false);
+    CHECK_EQ(report.get_report()[0], 0x01);
+    CHECK_EQ(report.get_report()[1], 0x80);
+    CHECK_EQ(report.get_report()[2], 0xFF);
+    CHECK_EQ(report.get_report()[3], 0x7F);
+    CHECK_EQ(report.get_report()[4], 0x00);
+
+    // 12bits offsets are scaled by 8 and saturate
+    report.update(1000, -5000, false);
+    CHECK_EQ(report.get_report()[0] | (report.get_report()[1] << 8), 8000);
+    CHECK_EQ((int16_t)(report.get_report()[2] | (report.get_report()[3] << 8)), -JOYSTICK_Q15_ONE);
+}
+
+static void test_changes(void)
+{
+    JoystickHidReport report;
+    joystick_vector_t move = {1000, -1000};
+
+    // The first report is always sent, then only changes
+    CHECK(report.update(move, false));
+    report.mark_sent();
+    CHECK(!report.update(move, false));
+    CHECK(!report.update(move, false));
+    CHECK_EQ(report.get_unchanged_count(), 2);
+    CHECK_EQ(report.get_sent_count(), 1);
+
+    // A report that was not accepted stays pending
+    CHECK(report.update(move, true));
+    CHECK(report.update(move, true));
+    report.mark_sent();
+    CHECK(!report.update(move, true));
+    CHECK(report.update(move, false));
+    report.mark_sent();
+
+    // Axis changes below the threshold are held back, also when they add up slowly
+    move.x = 1000 + JOYSTICK_HID_MIN_DELTA - 1;
+    CHECK(!report.update(move, false));
+    move.x = 1000 - JOYSTICK_HID_MIN_DELTA + 1;
+    CHECK(!report.update(move, false));
+    move.y = -1000 - JOYSTICK_HID_MIN_DELTA;
+    CHECK(report.update(move, false));
+    report.mark_sent();
+
+    // Center and full deflection are always reported
+    move.x = 0;
+    move.y = -1000 - JOYSTICK_HID_MIN_DELTA;
+    report.update(move, false);
+    report.mark_sent();
+    move.x = 1;
+    CHECK(!report.update(move, false));
+    move.x = 0;
+    CHECK(!report.update(move, false));
+    move.y = -JOYSTICK_Q15_ONE + 1;
+    CHECK(report.update(move, false));
+    report.mark_sent();
+    move.y = -JOYSTICK_Q15_ONE;
+    CHECK(report.update(move, false));
+    report.mark_sent();
+
+    // Threshold 0 reports any change, invalidate() forces one
+    report.set_threshold(0);
+    move.x = 1;
+    CHECK(report.update(move, false));
+    report.mark_sent();
+    CHECK(!report.update(move, false));
+    report.invalidate();
+    CHECK(report.update(move, false));
+    CHECK_EQ(report.get_sent_count(), 8);
+}
+
+int main(void)
+{
+    test_descriptor();
+    test_packing();
+    test_changes();
+    return test_result("test_hid");
+}
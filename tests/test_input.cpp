@@ -0,0 +1,217 @@
+#include "joystick_input.hpp"
+#include "joystick_platform.hpp"
+#include "test_util.hpp"
+
+// Direction classifier and JoystickInput events, sampled every FRAME_MS on the simulated clock
+
+#define FRAME_MS 5
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(joystick_time_us() / 1000);
+}
+
+// Feed the same sample every frame for duration_ms
+static void hold(JoystickInput &input, int16_t x, int16_t y, bool button, uint32_t duration_ms)
+{
+    for (uint32_t t = 0; t < duration_ms; t += FRAME_MS) {
+        joystick_sleep_ms(FRAME_MS);
+        input.update(x, y, button, now_ms());
+    }
+}
+
+static bool next_event(JoystickInput &input, uint8_t type, uint8_t key)
+{
+    joystick_event_t event;
+    if (!input.poll_event(&event)) {
+        printf("no event, expected type %d key %d\n", type, key);
+        return false;
+    }
+    if (event.type != type || event.key != key) {
+        printf("event type %d key %d, expected type %d key %d\n", event.type, event.key, type, key);
+        return false;
+    }
+    return true;
+}
+
+static uint32_t drain(JoystickInput &input)
+{
+    joystick_event_t event;
+    uint32_t count = 0;
+    while (input.poll_event(&event)) {
+        count++;
+    }
+    return count;
+}
+
+static void test_classify_4way(void)
+{
+    joystick_input_config_t config;
+    CHECK_EQ(joystick_classify_direction(0, -2000, config), JOYSTICK_KEY_UP);
+    CHECK_EQ(joystick_classify_direction(0, 2000, config), JOYSTICK_KEY_DOWN);
+    CHECK_EQ(joystick_classify_direction(-2000, 0, config), JOYSTICK_KEY_LEFT);
+    CHECK_EQ(joystick_classify_direction(2000, 0, config), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(1799, 0, config), JOYSTICK_KEY_NONE);
+    CHECK_EQ(joystick_classify_direction(1800, 0, config), JOYSTICK_KEY_RIGHT);
+
+    // Close to the diagonal nothing is reported
+    CHECK_EQ(joystick_classify_direction(2000, 1500, config), JOYSTICK_KEY_NONE);
+
+    // A held direction releases only below release_threshold and survives the diagonal
+    CHECK_EQ(joystick_classify_direction(1200, 0, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(1000, 0, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(999, 0, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_NONE);
+    CHECK_EQ(joystick_classify_direction(2000, 1500, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(2000, 2000, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(1500, 2000, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_NONE);
+    CHECK_EQ(joystick_classify_direction(1000, 2000, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_DOWN);
+}
+
+static void test_classify_8way(void)
+{
+    joystick_input_config_t config;
+    config.eight_way = true;
+    CHECK_EQ(joystick_classify_direction(-2000, -2000, config), JOYSTICK_KEY_UP_LEFT);
+    CHECK_EQ(joystick_classify_direction(2000, -2000, config), JOYSTICK_KEY_UP_RIGHT);
+    CHECK_EQ(joystick_classify_direction(-2000, 2000, config), JOYSTICK_KEY_DOWN_LEFT);
+    CHECK_EQ(joystick_classify_direction(2000, 2000, config), JOYSTICK_KEY_DOWN_RIGHT);
+
+    // The sector edge sits at tan(22.5 deg), 106/256 of the major axis
+    CHECK_EQ(joystick_classify_direction(2000, -828, config), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(2000, -829, config), JOYSTICK_KEY_UP_RIGHT);
+    CHECK_EQ(joystick_classify_direction(-828, 2000, config), JOYSTICK_KEY_DOWN);
+    CHECK_EQ(joystick_classify_direction(-829, 2000, config), JOYSTICK_KEY_DOWN_LEFT);
+
+    // Around the edge the current direction wins on both sides
+    CHECK_EQ(joystick_classify_direction(2000, -900, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(2000, -1100, config, JOYSTICK_KEY_RIGHT), JOYSTICK_KEY_UP_RIGHT);
+    CHECK_EQ(joystick_classify_direction(2000, -700, config, JOYSTICK_KEY_UP_RIGHT), JOYSTICK_KEY_UP_RIGHT);
+    CHECK_EQ(joystick_classify_direction(2000, -600, config, JOYSTICK_KEY_UP_RIGHT), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(joystick_classify_direction(999, -999, config, JOYSTICK_KEY_UP_RIGHT), JOYSTICK_KEY_NONE);
+}
+
+static void test_debounce(void)
+{
+    JoystickInput input;
+    hold(input, 0, 0, false, 50);
+    CHECK_EQ(drain(input), 0);
+
+    // A direction is reported once it was stable for debounce_ms
+    uint32_t start = now_ms();
+    hold(input, 2000, 0, false, FRAME_MS);
+    hold(input, 2000, 0, false, FRAME_MS);
+    CHECK_EQ(input.get_direction(), JOYSTICK_KEY_NONE);
+    hold(input, 2000, 0, false, FRAME_MS);
+    CHECK_EQ(input.get_direction(), JOYSTICK_KEY_RIGHT);
+    joystick_event_t event;
+    CHECK(input.poll_event(&event));
+    CHECK_EQ(event.type, JOYSTICK_EVENT_PRESS);
+    CHECK_EQ(event.key, JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(event.time_ms, start + 3 * FRAME_MS);
+
+    // A dip shorter than debounce_ms is ignored, also below release_threshold
+    hold(input, 500, 0, false, FRAME_MS);
+    hold(input, 2000, 0, false, 50);
+    CHECK_EQ(drain(input), 0);
+
+    // Hysteresis: between release and press threshold the direction is kept
+    hold(input, 1200, 0, false, 100);
+    CHECK_EQ(input.get_direction(), JOYSTICK_KEY_RIGHT);
+    CHECK_EQ(drain(input), 0);
+    hold(input, 900, 0, false, 15);
+    CHECK_EQ(input.get_direction(), JOYSTICK_KEY_NONE);
+    CHECK(next_event(input, JOYSTICK_EVENT_RELEASE, JOYSTICK_KEY_RIGHT));
+
+    // Moving straight to another direction releases the old one first
+    hold(input, 0, -2000, false, 20);
+    hold(input, -2000, 0, false, 20);
+    CHECK(next_event(input, JOYSTICK_EVENT_PRESS, JOYSTICK_KEY_UP));
+    CHECK(next_event(input, JOYSTICK_EVENT_RELEASE, JOYSTICK_KEY_UP));
+    CHECK(next_event(input, JOYSTICK_EVENT_PRESS, JOYSTICK_KEY_LEFT));
+
+    // The button is debounced the same way
+    hold(input, 0, 0, true, FRAME_MS);
+    hold(input, 0, 0, false, 20);
+    hold(input, 0, 0, true, 20);
+    CHECK(input.is_button_pressed());
+    CHECK(next_event(input, JOYSTICK_EVENT_RELEASE, JOYSTICK_KEY_LEFT));
+    CHECK(next_event(input, JOYSTICK_EVENT_PRESS, JOYSTICK_KEY_MID));
+    CHECK_EQ(drain(input), 0);
+}
+
+static void test_long_press_repeat(void)
+{
+    JoystickInput input;
+    hold(input, 0, 0, false, 50);
+
+    // Held direction: PRESS, REPEAT after repeat_delay_ms, then every repeat_interval_ms
+    hold(input, 0, 2000, false, 15);
+    joystick_event_t event;
+    CHECK(input.poll_event(&event));
+    CHECK_EQ(event.type, JOYSTICK_EVENT_PRESS);
+    uint32_t pressed = event.time_ms;
+    hold(input, 0, 2000, false, 1500);
+    uint32_t repeats = 0;
+    while (input.poll_event(&event)) {
+        CHECK_EQ(event.type, JOYSTICK_EVENT_REPEAT);
+        CHECK_EQ(event.key, JOYSTICK_KEY_DOWN);
+        CHECK_EQ(event.time_ms - pressed, 500 + repeats * 250);
+        repeats++;
+    }
+    CHECK_EQ(repeats, 5);
+
+    // LONG_PRESS once at long_press_ms
+    hold(input, 0, 2000, false, 1500);
+    uint32_t longs = 0;
+    while (input.poll_event(&event)) {
+        if (event.type == JOYSTICK_EVENT_LONG_PRESS) {
+            CHECK_EQ(event.time_ms - pressed, 3000);
+            longs++;
+        }
+    }
+    hold(input, 0, 2000, false, 1000);
+    while (input.poll_event(&event)) {
+        CHECK(event.type != JOYSTICK_EVENT_LONG_PRESS);
+    }
+    CHECK_EQ(longs, 1);
+
+    // The button has a long press but no repeat
+    hold(input, 0, 0, false, 20);
+    drain(input);
+    hold(input, 0, 0, true, 3100);
+    CHECK(next_event(input, JOYSTICK_EVENT_PRESS, JOYSTICK_KEY_MID));
+    CHECK(next_event(input, JOYSTICK_EVENT_LONG_PRESS, JOYSTICK_KEY_MID));
+    CHECK_EQ(drain(input), 0);
+
+    // Disabled long press and repeat
+    joystick_input_config_t config;
+    config.long_press_ms = 0;
+    config.repeat_delay_ms = 0;
+    input.set_config(config);
+    hold(input, 0, 0, false, 20);
+    hold(input, 2000, 0, false, 5000);
+    CHECK(next_event(input, JOYSTICK_EVENT_RELEASE, JOYSTICK_KEY_MID));
+    CHECK(next_event(input, JOYSTICK_EVENT_PRESS, JOYSTICK_KEY_RIGHT));
+    CHECK_EQ(drain(input), 0);
+}
+
+static void test_queue_full(void)
+{
+    JoystickInput input;
+    joystick_input_config_t config;
+    config.repeat_interval_ms = 0;          // One REPEAT per update
+    input.set_config(config);
+    hold(input, 2000, 0, false, 500 + 40 * FRAME_MS);
+    CHECK_EQ(drain(input), JOYSTICK_INPUT_EVENT_QUEUE_SIZE);
+    CHECK(input.get_dropped_events() > 0);
+}
+
+int main(void)
+{
+    test_classify_4way();
+    test_classify_8way();
+    test_debounce();
+    test_long_press_repeat();
+    test_queue_full();
+    return test_result("test_input");
+}
@@ -0,0 +1,167 @@
+#include "joystick.hpp"
+#include "joystick_mock_bus.hpp"
+#include "test_util.hpp"
+
+// Joystick driver against the register-file mock of the 0x63 unit
+
+static void test_begin(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+
+    Joystick joystick;
+    CHECK(joystick.begin(&bus, JOYSTICK_ADDR));
+    CHECK(!Joystick().begin(&bus, 0x42));
+}
+
+static void test_getters(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    bus.set_stick(JOYSTICK_ADDR, 1000, -2000, 0);
+    Joystick joystick;
+    joystick.begin(&bus, JOYSTICK_ADDR);
+
+    CHECK_EQ(joystick.get_joy_adc_12bits_offset_value_x(), 1000);
+    CHECK_EQ(joystick.get_joy_adc_12bits_offset_value_y(), -2000);
+    CHECK_EQ(joystick.get_joy_adc_8bits_offset_value_x(), 1000 / 32);
+    CHECK_EQ(joystick.get_joy_adc_value_x(ADC_16BIT_RESULT), 32768 + 1000 * 8);
+    CHECK_EQ(joystick.get_joy_adc_value_y(ADC_8BIT_RESULT), (32768 - 2000 * 8) >> 8);
+    CHECK_EQ(joystick.get_button_value(), 0);
+    CHECK_EQ(joystick.get_firmware_version(), 1);
+    CHECK_EQ(joystick.get_i2c_address(), JOYSTICK_ADDR);
+
+    uint16_t adc_x, adc_y;
+    joystick.get_joy_adc_16bits_value_xy(&adc_x, &adc_y);
+    CHECK_EQ(adc_x, 32768 + 1000 * 8);
+    CHECK_EQ(adc_y, 32768 - 2000 * 8);
+}
+
+static void test_writes(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    Joystick joystick;
+    joystick.begin(&bus, JOYSTICK_ADDR);
+
+    joystick.set_rgb_color(0x00FF8040);
+    CHECK_EQ(joystick.get_rgb_color(), 0x00FF8040);
+
+    joystick.set_joy_adc_value_cal(1, 2, 3, 4, 5, 6, 7, 8);
+    uint16_t cal[8];
+    joystick.get_joy_adc_value_cal(&cal[0], &cal[1], &cal[2], &cal[3], &cal[4], &cal[5], &cal[6], &cal[7]);
+    for (int i = 0; i < 8; i++) {
+        CHECK_EQ(cal[i], i + 1);
+    }
+
+    // The unit answers at its new address, and so does the driver
+    CHECK(joystick.set_i2c_address(0x64));
+    CHECK(bus.get_regs(0x64) != nullptr);
+    CHECK(bus.get_regs(JOYSTICK_ADDR) == nullptr);
+    CHECK_EQ(joystick.get_i2c_address(), 0x64);
+}
+
+static void test_status(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    Joystick joystick;
+    joystick.begin(&bus, JOYSTICK_ADDR);
+    joystick.reset_stats();
+
+    bus.set_present(JOYSTICK_ADDR, false);
+    joystick_result_t<uint8_t> button = joystick.checked(joystick.get_button_value());
+    CHECK(!button.ok());
+    CHECK_EQ(button.status, JOYSTICK_ERROR_NACK);
+    CHECK_EQ(button.value_or(7), 7);
+    CHECK_EQ(joystick.get_read_stats().nack, 1);
+
+    bus.set_present(JOYSTICK_ADDR, true);
+    CHECK(joystick.checked(joystick.get_button_value()).ok());
+    CHECK_EQ(joystick.get_read_stats().ok, 1);
+}
+
+static void test_read_state(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    bus.set_stick(JOYSTICK_ADDR, -300, 450, 0);
+    Joystick joystick;
+    joystick.begin(&bus, JOYSTICK_ADDR);
+    joystick_host_set_time_us(1234);
+
+    // One burst per field: raw x/y, offset x/y (contiguous at 0x50), button
+    joystick_state_t state;
+    uint32_t before = bus.get_transfer_count();
+    CHECK(joystick.read_state(&state));
+    CHECK_EQ(bus.get_transfer_count() - before, 3);
+    CHECK_EQ(state.fields, JOYSTICK_STATE_ALL);
+    CHECK_EQ(state.adc_x, 32768 - 300 * 8);
+    CHECK_EQ(state.adc_y, 32768 + 450 * 8);
+    CHECK_EQ(state.offset_x, -300);
+    CHECK_EQ(state.offset_y, 450);
+    CHECK_EQ(state.button, 0);
+    CHECK_EQ(state.timestamp_us, 1234);
+
+    // The four getters of the old game loops
+    before = bus.get_transfer_count();
+    uint16_t adc_x, adc_y;
+    joystick.get_joy_adc_16bits_value_xy(&adc_x, &adc_y);
+    joystick.get_joy_adc_12bits_offset_value_x();
+    joystick.get_joy_adc_12bits_offset_value_y();
+    joystick.get_button_value();
+    CHECK_EQ(bus.get_transfer_count() - before, 4);
+
+    // Only the selected fields are read
+    before = bus.get_transfer_count();
+    CHECK(joystick.read_state(&state, JOYSTICK_STATE_OFFSET));
+    CHECK_EQ(bus.get_transfer_count() - before, 1);
+    CHECK_EQ(state.fields, JOYSTICK_STATE_OFFSET);
+    CHECK_EQ(state.offset_x, -300);
+    CHECK_EQ(state.adc_x, 0);
+    CHECK_EQ(state.button, 1);
+
+    before = bus.get_transfer_count();
+    CHECK(joystick.read_state(&state, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON));
+    CHECK_EQ(bus.get_transfer_count() - before, 2);
+
+    // A failed read clears its field and the call reports it
+    bus.set_present(JOYSTICK_ADDR, false);
+    CHECK(!joystick.read_state(&state));
+    CHECK_EQ(state.fields, 0);
+    CHECK_EQ(state.offset_x, 0);
+    CHECK_EQ(state.button, 1);
+    CHECK_EQ(joystick.get_last_status(), JOYSTICK_ERROR_NACK);
+
+    // Only the first burst fails: the fields after it are read, the call keeps its error
+    bus.set_present(JOYSTICK_ADDR, true);
+    bus.set_speed_fault(0, 3);
+    while (bus.get_transfer_count() % 3 != 2) {
+        joystick.get_button_value();
+    }
+    CHECK(!joystick.read_state(&state));
+    CHECK_EQ(state.fields, JOYSTICK_STATE_OFFSET | JOYSTICK_STATE_BUTTON);
+    CHECK_EQ(state.offset_x, -300);
+    CHECK_EQ(joystick.get_last_status(), JOYSTICK_ERROR_NACK);
+
+    // A multi-burst read<> stops at the failed burst and reports it
+    while (bus.get_transfer_count() % 3 != 1) {
+        joystick.get_button_value();
+    }
+    int16_t offset_x = 7;
+    uint8_t button = 7;
+    CHECK((!joystick.read<JoystickRegOffset12X, JoystickRegButton>(offset_x, button)));
+    CHECK_EQ(joystick.get_last_status(), JOYSTICK_ERROR_NACK);
+    CHECK_EQ(offset_x, 7);
+    CHECK_EQ(bus.get_transfer_count() % 3, 0);
+}
+
+int main(void)
+{
+    test_begin();
+    test_getters();
+    test_writes();
+    test_status();
+    test_read_state();
+    return test_result("test_joystick");
+}
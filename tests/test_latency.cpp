@@ -0,0 +1,111 @@
+#include "joystick.hpp"
+#include "joystick_latency.hpp"
+#include "joystick_mock_bus.hpp"
+#include "test_util.hpp"
+
+// JoystickLatency buckets and register groups, and the Joystick hooks of a
+// JOYSTICK_LATENCY_PROFILE=1 build timing transfers on the simulated clock.
+
+#if !JOYSTICK_LATENCY_PROFILE
+#error "test_latency must be built with JOYSTICK_LATENCY_PROFILE=1"
+#endif
+
+// Bucket the one sample of a fresh histogram landed in
+static int bucket_of(uint32_t us)
+{
+    JoystickLatency latency;
+    latency.add(JOYSTICK_BUTTON_REG, us);
+    const joystick_latency_t &g = latency.get(JOYSTICK_LATENCY_BUTTON);
+    for (int b = 0; b < JOYSTICK_LATENCY_BUCKETS; b++) {
+        if (g.buckets[b] != 0) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+static void test_buckets(void)
+{
+    // Bucket 0 is 0us, bucket n is [2^(n-1), 2^n), the last one is open ended
+    CHECK_EQ(bucket_of(0), 0);
+    CHECK_EQ(bucket_of(1), 1);
+    CHECK_EQ(bucket_of(2), 2);
+    CHECK_EQ(bucket_of(3), 2);
+    CHECK_EQ(bucket_of(4), 3);
+    for (int n = 2; n < JOYSTICK_LATENCY_BUCKETS - 1; n++) {
+        CHECK_EQ(bucket_of((1UL << (n - 1)) - 1), n - 1);
+        CHECK_EQ(bucket_of(1UL << (n - 1)), n);
+        CHECK_EQ(bucket_of((1UL << n) - 1), n);
+    }
+    CHECK_EQ(bucket_of(1UL << (JOYSTICK_LATENCY_BUCKETS - 2)), JOYSTICK_LATENCY_BUCKETS - 1);
+    CHECK_EQ(bucket_of(1UL << 20), JOYSTICK_LATENCY_BUCKETS - 1);
+    CHECK_EQ(bucket_of(0xFFFFFFFFUL), JOYSTICK_LATENCY_BUCKETS - 1);
+
+    // min, max and total follow the samples, reset() starts over
+    JoystickLatency latency;
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_ADC).min_us, 0xFFFFFFFFUL);
+    latency.add(JOYSTICK_ADC_VALUE_12BITS_REG, 300);
+    latency.add(JOYSTICK_ADC_VALUE_12BITS_REG, 100);
+    latency.add(JOYSTICK_ADC_VALUE_12BITS_REG, 200);
+    const joystick_latency_t &adc = latency.get(JOYSTICK_LATENCY_ADC);
+    CHECK_EQ(adc.count, 3);
+    CHECK_EQ(adc.min_us, 100);
+    CHECK_EQ(adc.max_us, 300);
+    CHECK_EQ(adc.total_us, 600);
+    latency.reset();
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_ADC).count, 0);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_ADC).min_us, 0xFFFFFFFFUL);
+}
+
+static void test_groups(void)
+{
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_ADC_VALUE_12BITS_REG), JOYSTICK_LATENCY_ADC);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_ADC_VALUE_12BITS_REG + 2), JOYSTICK_LATENCY_ADC);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_ADC_VALUE_8BITS_REG + 1), JOYSTICK_LATENCY_ADC);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_BUTTON_REG), JOYSTICK_LATENCY_BUTTON);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_RGB_REG + 3), JOYSTICK_LATENCY_RGB);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_ADC_VALUE_CAL_REG + 15), JOYSTICK_LATENCY_CAL);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG + 2), JOYSTICK_LATENCY_OFFSET);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_OFFSET_ADC_VALUE_8BITS_REG), JOYSTICK_LATENCY_OFFSET);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_BOOTLOADER_VERSION_REG), JOYSTICK_LATENCY_INFO);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_FIRMWARE_VERSION_REG), JOYSTICK_LATENCY_INFO);
+    CHECK_EQ(JoystickLatency::group_of(JOYSTICK_I2C_ADDRESS_REG), JOYSTICK_LATENCY_INFO);
+}
+
+// Every Joystick transaction is timed into the group of its first register
+static void test_joystick(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    bus.set_wire_timing(true);
+    Joystick joystick;
+    CHECK(joystick.begin(&bus, JOYSTICK_ADDR));
+    const JoystickLatency &latency = joystick.get_latency();
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_INFO).count, 1);
+
+    joystick_state_t state;
+    CHECK(joystick.read_state(&state));
+    joystick.set_rgb_color(0x00FF00);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_ADC).count, 1);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_OFFSET).count, 1);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_BUTTON).count, 1);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_RGB).count, 1);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_CAL).count, 0);
+
+    // The recorded time is the wire time on the simulated clock
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_ADC).max_us, bus.wire_time_us(4, true));
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_BUTTON).max_us, bus.wire_time_us(1, true));
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_RGB).max_us, bus.wire_time_us(4, false));
+
+    // A 4 byte read at 100 kHz takes 660us: bucket 10 holds [512, 1024)
+    CHECK_EQ(bus.wire_time_us(4, true), 660);
+    CHECK_EQ(latency.get(JOYSTICK_LATENCY_ADC).buckets[10], 1);
+}
+
+int main(void)
+{
+    test_buckets();
+    test_groups();
+    test_joystick();
+    return test_result("test_latency");
+}
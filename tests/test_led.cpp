@@ -0,0 +1,85 @@
+#include "joystick.hpp"
+#include "joystick_led.hpp"
+#include "joystick_mock_bus.hpp"
+#include "test_util.hpp"
+
+// JoystickLed shadow register: writes only on change, and only a write the
+// unit acknowledged updates the shadow
+
+static uint32_t device_color(JoystickMockBus &bus)
+{
+    const uint8_t *regs = bus.get_regs(JOYSTICK_ADDR);
+    return regs[JOYSTICK_RGB_REG] | (regs[JOYSTICK_RGB_REG + 1] << 8) | (regs[JOYSTICK_RGB_REG + 2] << 16);
+}
+
+static void test_shadow(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    Joystick joystick;
+    CHECK(joystick.begin(&bus, JOYSTICK_ADDR));
+    JoystickLed led;
+    led.begin(&joystick);
+
+    // Several set_color calls per frame cost one write, an unchanged color none
+    led.set_color(0x112233);
+    led.set_color(0x445566);
+    led.tick(0);
+    CHECK_EQ(led.get_bus_writes(), 1);
+    CHECK_EQ(led.get_saved_writes(), 1);
+    CHECK_EQ(device_color(bus), 0x445566);
+    led.set_color(0x445566);
+    led.tick(16);
+    CHECK_EQ(led.get_bus_writes(), 1);
+    CHECK_EQ(led.get_saved_writes(), 2);
+}
+
+static void test_failed_write(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    Joystick joystick;
+    CHECK(joystick.begin(&bus, JOYSTICK_ADDR));
+    JoystickLed led;
+    led.begin(&joystick);
+    led.set_color(0x0000FF);
+    led.tick(0);
+    CHECK_EQ(led.get_color(), 0x0000FF);
+
+    // Every transfer NACKs: the shadow keeps the color the unit really shows
+    bus.set_speed_fault(0, 1);
+    led.set_color(0x00FF00);
+    led.tick(16);
+    CHECK_EQ(led.get_bus_writes(), 2);
+    CHECK(joystick.get_last_status() != JOYSTICK_OK);
+    CHECK_EQ(led.get_color(), 0x0000FF);
+    CHECK_EQ(device_color(bus), 0x0000FF);
+    led.tick(32);
+    CHECK_EQ(led.get_bus_writes(), 3);
+
+    // Once the bus works again the next tick retries, then stays quiet
+    bus.set_speed_fault(0, 0);
+    led.tick(48);
+    CHECK_EQ(led.get_bus_writes(), 4);
+    CHECK_EQ(led.get_color(), 0x00FF00);
+    CHECK_EQ(device_color(bus), 0x00FF00);
+    led.tick(64);
+    CHECK_EQ(led.get_bus_writes(), 4);
+
+    // The first write after begin() failing leaves the shadow unknown
+    JoystickLed fresh;
+    fresh.begin(&joystick);
+    bus.set_present(JOYSTICK_ADDR, false);
+    fresh.set_color(0x00FF00);
+    fresh.tick(0);
+    bus.set_present(JOYSTICK_ADDR, true);
+    fresh.tick(16);
+    CHECK_EQ(fresh.get_bus_writes(), 2);
+}
+
+int main(void)
+{
+    test_shadow();
+    test_failed_write();
+    return test_result("test_led");
+}
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include "joystick_pipeline.hpp"
+#include "test_util.hpp"
+
+// Dead zone, response curves and alpha-beta filter of JoystickPipeline
+
+static joystick_pipeline_config_t unfiltered(void)
+{
+    joystick_pipeline_config_t config;
+    config.alpha_min_q8 = 256;
+    config.beta_q8 = 0;
+    return config;
+}
+
+static void test_dead_zone(void)
+{
+    JoystickPipeline pipeline;
+    pipeline.set_config(unfiltered());
+
+    // The magnitude estimate reads up to 4% short, so the edge sits just past 400 on an axis and a diagonal
+    CHECK_EQ(pipeline.update(417, 0).x, 0);
+    CHECK(pipeline.update(418, 0).x > 0);
+    CHECK_EQ(pipeline.update(0, -417).y, 0);
+    CHECK(pipeline.update(0, -418).y < 0);
+    CHECK_EQ(pipeline.update(-418, 0).x, -pipeline.update(418, 0).x);
+    joystick_vector_t v = pipeline.update(294, 294);
+    CHECK_EQ(v.x, 0);
+    CHECK_EQ(v.y, 0);
+    v = pipeline.update(295, 295);
+    CHECK(v.x > 0);
+    CHECK_EQ(v.x, v.y);
+
+    // Travel starts from 0 past the edge: no jump to a large value
+    CHECK(pipeline.update(418, 0).x < 32);
+
+    // Outer zone and beyond are full deflection
+    CHECK_EQ(pipeline.update(4095, 0).x, JOYSTICK_Q15_ONE);
+    CHECK_EQ(pipeline.update(0, -4095).y, -JOYSTICK_Q15_ONE);
+    CHECK_EQ(pipeline.update(-2048, 0).x, -pipeline.update(2048, 0).x);
+
+    // Releasing into the dead zone stops at once, even with the filter on
+    pipeline.set_config(joystick_pipeline_config_t());
+    for (int i = 0; i < 10; i++) {
+        pipeline.update(3000, -3000);
+    }
+    v = pipeline.update(100, -100);
+    CHECK_EQ(v.x, 0);
+    CHECK_EQ(v.y, 0);
+    CHECK_EQ(pipeline.get_vector().x, 0);
+}
+
+static void test_curves(void)
+{
+    const JoystickCurve *curves[] = {&joystick_curve_linear, &joystick_curve_expo, &joystick_curve_cubic};
+    for (const JoystickCurve *curve : curves) {
+        // End points, saturation past them
+        CHECK_EQ(curve->apply(0), 0);
+        CHECK_EQ(curve->apply(JOYSTICK_Q15_ONE), JOYSTICK_Q15_ONE);
+        CHECK_EQ(curve->apply(-JOYSTICK_Q15_ONE), -JOYSTICK_Q15_ONE);
+        CHECK_EQ(curve->apply(40000), JOYSTICK_Q15_ONE);
+        CHECK_EQ(curve->apply(-40000), -JOYSTICK_Q15_ONE);
+
+        // Monotonic and odd-symmetric over the whole range, never above linear
+        int16_t prev = 0;
+        for (int32_t in = 1; in <= JOYSTICK_Q15_ONE; in++) {
+            int16_t out = curve->apply(in);
+            if (out < prev || curve->apply(-in) != -out || out > in) {
+                CHECK(false);
+                break;
+            }
+            prev = out;
+        }
+    }
+
+    // The more cubic, the finer the control near the center
+    CHECK_EQ(joystick_curve_linear.apply(8192), 8192);
+    CHECK(joystick_curve_expo.apply(8192) < 8192);
+    CHECK(joystick_curve_cubic.apply(8192) < joystick_curve_expo.apply(8192));
+    CHECK_EQ(joystick_curve_cubic.apply(16384), 4096);
+}
+
+static int16_t settled(int16_t offset_x)
+{
+    JoystickPipeline pipeline;
+    pipeline.set_config(unfiltered());
+    return pipeline.update(offset_x, 0).x;
+}
+
+static void test_step_response(void)
+{
+    JoystickPipeline pipeline;
+
+    // Small step: smoothed, overshoots on the velocity, settles within 1%
+    int16_t target = settled(1000);
+    int16_t out[40];
+    for (int i = 0; i < 40; i++) {
+        out[i] = pipeline.update(1000, 0).x;
+    }
+    CHECK(out[0] > 0);
+    CHECK(out[0] < target);
+    CHECK(out[1] > out[0]);
+    int16_t peak = 0;
+    for (int i = 0; i < 40; i++) {
+        if (out[i] > peak) peak = out[i];
+    }
+    CHECK(peak > target);
+    CHECK(peak < target + target * 15 / 100);
+    for (int i = 30; i < 40; i++) {
+        CHECK(abs(out[i] - target) <= target / 100);
+    }
+
+    // Large step: reaches the target in the same sample
+    pipeline.reset();
+    target = settled(3000);
+    CHECK(abs(pipeline.update(3000, 0).x - target) <= 4);
+
+    // Without the velocity term the response rises monotonically without overshoot
+    joystick_pipeline_config_t config;
+    config.beta_q8 = 0;
+    pipeline.set_config(config);
+    target = settled(1000);
+    int16_t prev = 0;
+    for (int i = 0; i < 60; i++) {
+        int16_t x = pipeline.update(1000, 0).x;
+        CHECK(x >= prev);
+        CHECK(x <= target);
+        prev = x;
+    }
+    CHECK(abs(prev - target) <= target / 100);
+
+    // A step back down mirrors the rise
+    JoystickPipeline down;
+    down.set_config(config);
+    for (int i = 0; i < 60; i++) {
+        down.update(-1000, 0);
+    }
+    CHECK_EQ(down.get_vector().x, -prev);
+}
+
+int main(void)
+{
+    test_dead_zone();
+    test_curves();
+    test_step_response();
+    return test_result("test_pipeline");
+}
@@ -0,0 +1,170 @@
+#include "joystick_poll.hpp"
+#include "test_util.hpp"
+
+// JoystickPoller deadline logic on an injected clock: time only moves when the test says so
+
+/**
+ * @brief Manual clock, sleeps wake up late by a scripted latency
+ */
+class FakeClock : public JoystickClock {
+public:
+    uint64_t now = 1000;
+    uint32_t latency[8] = {};   // Wake-up latency of sleep n, repeating
+    uint32_t sleeps = 0;
+
+    uint64_t now_us(void) override { return now; }
+    void sleep_until_us(uint64_t deadline_us) override
+    {
+        if (deadline_us > now) {
+            now = deadline_us;
+        }
+        now += latency[sleeps++ % 8];
+    }
+};
+
+static void test_grid(void)
+{
+    FakeClock clock;
+    JoystickPoller poller;
+    poller.begin(1000, &clock);
+    CHECK_EQ(poller.get_next_deadline_us(), 2000);
+
+    // Work of varying length between polls does not shift the grid
+    for (uint32_t i = 0; i < 10; i++) {
+        CHECK_EQ(poller.wait(), 2000 + i * 1000);
+        CHECK_EQ(poller.get_last_poll_us(), 2000 + i * 1000);
+        clock.now += 100 + i * 50;
+    }
+
+    joystick_poll_stats_t stats;
+    poller.get_stats(&stats);
+    CHECK_EQ(stats.polls, 10);
+    CHECK_EQ(stats.period_us, 1000);
+    CHECK_EQ(stats.mean_period_us, 1000);
+    CHECK_EQ(stats.stddev_us, 0);
+    CHECK_EQ(stats.max_late_us, 0);
+    CHECK_EQ(stats.missed, 0);
+}
+
+static void test_jitter(void)
+{
+    FakeClock clock;
+    for (int i = 0; i < 8; i++) {
+        clock.latency[i] = (i & 1) ? 100 : 0;
+    }
+    JoystickPoller poller;
+    poller.begin(1000, &clock);
+
+    // Late wake-ups alternate the period between 1100 and 900 without drifting
+    for (uint32_t i = 0; i < 101; i++) {
+        poller.wait();
+    }
+    CHECK_EQ(poller.get_next_deadline_us(), 1000 + 102 * 1000);
+
+    joystick_poll_stats_t stats;
+    poller.get_stats(&stats);
+    CHECK_EQ(stats.polls, 101);
+    CHECK_EQ(stats.max_late_us, 100);
+    CHECK_EQ(stats.mean_period_us, 1000);
+    CHECK_EQ(stats.stddev_us, 100);
+    CHECK_EQ(stats.missed, 0);
+
+    // Statistics restart, the grid stays
+    poller.reset_stats();
+    poller.get_stats(&stats);
+    CHECK_EQ(stats.polls, 0);
+    CHECK_EQ(stats.mean_period_us, 1000);
+    CHECK_EQ(poller.get_next_deadline_us(), 1000 + 102 * 1000);
+}
+
+static void test_missed(void)
+{
+    FakeClock clock;
+    JoystickPoller poller;
+    poller.begin(1000, &clock);
+    poller.wait();                      // 2000
+
+    // A stall of 3.5 periods: one late poll takes the 5000 slot, 3000 and 4000 are skipped, no burst
+    clock.now += 3500;
+    CHECK_EQ(poller.wait(), 5500);
+    CHECK_EQ(poller.get_next_deadline_us(), 6000);
+    CHECK_EQ(poller.wait(), 6000);
+
+    joystick_poll_stats_t stats;
+    poller.get_stats(&stats);
+    CHECK_EQ(stats.missed, 2);
+    CHECK_EQ(stats.max_late_us, 2500);    // Counted from the first deadline it missed
+    CHECK_EQ(stats.polls, 3);
+    CHECK_EQ(stats.mean_period_us, 2000);
+
+    // A poll exactly one period late skips exactly one deadline
+    clock.now = 8000;
+    CHECK(poller.poll_due());
+    poller.get_stats(&stats);
+    CHECK_EQ(stats.missed, 3);
+    CHECK_EQ(stats.max_late_us, 2500);
+    CHECK_EQ(poller.get_next_deadline_us(), 9000);
+}
+
+static void test_poll_due(void)
+{
+    FakeClock clock;
+    JoystickPoller poller;
+    poller.begin(500, &clock);
+
+    clock.now = 1499;
+    CHECK(!poller.poll_due());
+    clock.now = 1500;
+    CHECK(poller.poll_due());
+    CHECK(!poller.poll_due());
+    CHECK_EQ(poller.get_next_deadline_us(), 2000);
+
+    // An external timer firing early still moves to the next deadline
+    poller.mark(1990);
+    CHECK_EQ(poller.get_next_deadline_us(), 2500);
+    CHECK_EQ(poller.get_last_poll_us(), 1990);
+    joystick_poll_stats_t stats;
+    poller.get_stats(&stats);
+    CHECK_EQ(stats.polls, 2);
+    CHECK_EQ(stats.max_late_us, 0);
+}
+
+static void test_phase(void)
+{
+    FakeClock clock;
+    JoystickPoller poller;
+    poller.begin(1000, &clock);
+    poller.wait();                      // Poll at 2000, next deadline 3000
+
+    // The phase after the latest poll, or after the next one once it has passed
+    clock.now = 2100;
+    CHECK_EQ(poller.phase_deadline(300), 2300);
+    CHECK_EQ(poller.phase_deadline(1300), 2300);
+    clock.now = 2300;
+    CHECK_EQ(poller.phase_deadline(300), 2300);
+    clock.now = 2301;
+    CHECK_EQ(poller.phase_deadline(300), 3300);
+    CHECK_EQ(poller.phase_deadline(0), 3000);
+
+    // Far behind the grid: still the next point on it
+    clock.now = 7450;
+    CHECK_EQ(poller.phase_deadline(300), 8300);
+
+    // Any earlier point of the grid gives the same phase, e.g. its start
+    CHECK_EQ(JoystickPoller::grid_phase(0, 1000, 300, 7450), 8300);
+    CHECK_EQ(JoystickPoller::grid_phase(2000, 1000, 300, 2100), 2300);
+
+    clock.now = 2100;
+    poller.wait_phase(250);
+    CHECK_EQ(clock.now, 2250);
+}
+
+int main(void)
+{
+    test_grid();
+    test_jitter();
+    test_missed();
+    test_poll_due();
+    test_phase();
+    return test_result("test_poll");
+}
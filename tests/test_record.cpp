@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "joystick.hpp"
+#include "joystick_record.hpp"
+#include "test_util.hpp"
+
+// JoystickRecorder/JoystickRecordReader round trips, the USB dump format and
+// JoystickReplayTransport playback on the simulated clock.
+
+#define SAMPLES 200
+
+static uint8_t buf[JOYSTICK_RECORD_BUFFER_SIZE];
+
+// Steady stretches, large jumps, the int16 extremes, button edges and irregular time steps
+static void make_samples(joystick_record_sample_t *samples)
+{
+    srand(7);
+    uint64_t time_us = 123456;
+    for (int i = 0; i < SAMPLES; i++) {
+        joystick_record_sample_t &s = samples[i];
+        s.time_us = time_us;
+        if (i < 20) {
+            s.offset_x = 5;
+            s.offset_y = -5;
+        } else if (i == 20) {
+            s.offset_x = 32767;
+            s.offset_y = -32768;
+        } else if (i == 21) {
+            s.offset_x = -32768;
+            s.offset_y = 32767;
+        } else {
+            s.offset_x = (int16_t)(rand() % 4096 - 2048);
+            s.offset_y = (int16_t)(rand() % 4096 - 2048);
+        }
+        s.button = (i / 7) & 1;
+        time_us += (i % 50 == 49) ? 3000000 : 5000 + (i % 3);
+    }
+}
+
+static uint32_t record_all(JoystickRecorder &recorder, const joystick_record_sample_t *samples, int count)
+{
+    recorder.begin(buf, sizeof(buf));
+    for (int i = 0; i < count; i++) {
+        CHECK(recorder.record(samples[i].time_us, samples[i].offset_x, samples[i].offset_y, samples[i].button));
+    }
+    return recorder.get_size();
+}
+
+static bool decodes_to(const uint8_t *data, uint32_t size, const joystick_record_sample_t *samples, int count)
+{
+    JoystickRecordReader reader;
+    reader.begin(data, size);
+    joystick_record_sample_t s;
+    for (int i = 0; i < count; i++) {
+        if (!reader.next(&s)) {
+            printf("sample %d missing\n", i);
+            return false;
+        }
+        if (s.time_us != samples[i].time_us - samples[0].time_us || s.offset_x != samples[i].offset_x ||
+            s.offset_y != samples[i].offset_y || s.button != samples[i].button) {
+            printf("sample %d: %llu %d %d %d\n", i, (unsigned long long)s.time_us, s.offset_x, s.offset_y, s.button);
+            return false;
+        }
+    }
+    return !reader.next(&s);
+}
+
+static void test_round_trip(void)
+{
+    static joystick_record_sample_t samples[SAMPLES];
+    make_samples(samples);
+    JoystickRecorder recorder;
+    record_all(recorder, samples, SAMPLES);
+    CHECK_EQ(recorder.get_sample_count(), SAMPLES);
+    CHECK(decodes_to(recorder.get_data(), recorder.get_size(), samples, SAMPLES));
+
+    // A steady stick at a fixed rate costs one byte per sample, the first
+    // sample carries the x/y deltas and the second the time step
+    JoystickRecorder steady;
+    steady.begin(buf, sizeof(buf));
+    for (int i = 0; i < 100; i++) {
+        steady.record((uint64_t)i * 10000, 300, -300, 1);
+    }
+    CHECK_EQ(steady.get_size(), 100 + 2 + 2 + 2);
+
+    // A truncated recording ends early instead of decoding garbage
+    JoystickRecordReader reader;
+    joystick_record_sample_t s;
+    reader.begin(buf, 7);
+    CHECK(reader.next(&s));
+    CHECK(!reader.next(&s));
+
+    // A full buffer refuses samples and keeps the ones recorded
+    static uint8_t small[32];
+    JoystickRecorder full;
+    full.begin(small, sizeof(small));
+    int recorded = 0;
+    for (int i = 0; i < SAMPLES && full.record(samples[i].time_us, samples[i].offset_x, samples[i].offset_y,
+                                               samples[i].button); i++) {
+        recorded++;
+    }
+    CHECK(full.is_full());
+    CHECK(recorded > 0);
+    CHECK(decodes_to(small, full.get_size(), samples, recorded));
+}
+
+// Capture what dump() prints on stdout
+static size_t capture_dump(const JoystickRecorder &recorder, char *text, size_t max)
+{
+    fflush(stdout);
+    int saved = dup(fileno(stdout));
+    FILE *file = tmpfile();
+    dup2(fileno(file), fileno(stdout));
+    printf("boot messages\n");
+    recorder.dump();
+    printf("after the dump\n");
+    fflush(stdout);
+    dup2(saved, fileno(stdout));
+    close(saved);
+    rewind(file);
+    size_t n = fread(text, 1, max - 1, file);
+    text[n] = '\0';
+    fclose(file);
+    return n;
+}
+
+static void test_dump(void)
+{
+    static joystick_record_sample_t samples[SAMPLES];
+    make_samples(samples);
+    JoystickRecorder recorder;
+    uint32_t size = record_all(recorder, samples, SAMPLES);
+
+    static char text[4 * JOYSTICK_RECORD_BUFFER_SIZE];
+    CHECK(capture_dump(recorder, text, sizeof(text)) > 2 * size);
+    static uint8_t parsed[JOYSTICK_RECORD_BUFFER_SIZE];
+    uint32_t parsed_size = 0;
+    CHECK(joystick_record_parse_dump(text, parsed, sizeof(parsed), &parsed_size));
+    CHECK_EQ(parsed_size, size);
+    CHECK(memcmp(parsed, recorder.get_data(), size) == 0);
+    CHECK(decodes_to(parsed, parsed_size, samples, SAMPLES));
+
+    // Buffer too small, a flipped digit or no frame at all
+    CHECK(!joystick_record_parse_dump(text, parsed, size - 1, &parsed_size));
+    char *digit = strchr(strchr(text, '\n') + 1, '\n') + 1;
+    digit = strchr(digit, '\n') + 1;
+    *digit = (*digit == '0') ? '1' : '0';
+    CHECK(!joystick_record_parse_dump(text, parsed, sizeof(parsed), &parsed_size));
+    CHECK(!joystick_record_parse_dump("no recording here\n", parsed, sizeof(parsed), &parsed_size));
+}
+
+// Three samples 10 ms apart: x = 1, 2, 3
+static uint32_t record_three(void)
+{
+    JoystickRecorder recorder;
+    recorder.begin(buf, sizeof(buf));
+    for (int i = 0; i < 3; i++) {
+        recorder.record(1000000 + (uint64_t)i * 10000, (int16_t)(i + 1), 0, 1);
+    }
+    return recorder.get_size();
+}
+
+static int16_t x_at(Joystick &joystick, uint64_t start, uint64_t time_us)
+{
+    joystick_host_set_time_us(start + time_us);
+    return joystick.get_joy_adc_12bits_offset_value_x();
+}
+
+static void test_realtime(void)
+{
+    uint32_t size = record_three();
+    JoystickReplayTransport replay;
+    Joystick joystick;
+    uint64_t start = 5000000;
+
+    // Samples follow their timestamps, the last one is held
+    joystick_host_set_time_us(start);
+    replay.begin(buf, size, JOYSTICK_REPLAY_REALTIME);
+    CHECK(joystick.begin(&replay, JOYSTICK_ADDR));
+    CHECK_EQ(x_at(joystick, start, 0), 1);
+    CHECK_EQ(x_at(joystick, start, 9999), 1);
+    CHECK_EQ(x_at(joystick, start, 10000), 2);
+    CHECK(!replay.is_finished());
+    CHECK_EQ(x_at(joystick, start, 25000), 3);
+    CHECK(replay.is_finished());
+    CHECK_EQ(x_at(joystick, start, 100000), 3);
+    CHECK_EQ(replay.get_played_count(), 3);
+
+    // A reader that falls behind skips samples instead of slowing down
+    joystick_host_set_time_us(start);
+    replay.begin(buf, size, JOYSTICK_REPLAY_REALTIME);
+    CHECK_EQ(x_at(joystick, start, 21000), 3);
+
+    // Loop: the last sample plays for one recorded step, then the first comes back
+    joystick_host_set_time_us(start);
+    replay.begin(buf, size, JOYSTICK_REPLAY_REALTIME, true);
+    CHECK_EQ(x_at(joystick, start, 0), 1);
+    CHECK_EQ(x_at(joystick, start, 10000), 2);
+    CHECK_EQ(x_at(joystick, start, 20000), 3);
+    CHECK_EQ(x_at(joystick, start, 29999), 3);
+    CHECK_EQ(x_at(joystick, start, 30000), 1);
+    CHECK_EQ(x_at(joystick, start, 45000), 2);
+    CHECK(!replay.is_finished());
+
+    // Several laps missed keep the recorded timeline
+    CHECK_EQ(x_at(joystick, start, 30000 * 5 + 20000), 3);
+    CHECK_EQ(x_at(joystick, start, 30000 * 6 + 1), 1);
+}
+
+static void test_fast(void)
+{
+    uint32_t size = record_three();
+    JoystickReplayTransport replay;
+    Joystick joystick;
+    replay.begin(buf, size, JOYSTICK_REPLAY_FAST);
+    CHECK(joystick.begin(&replay, JOYSTICK_ADDR));
+
+    // read_state reads the raw and the offset block, still one sample per frame
+    joystick_state_t state;
+    for (int16_t frame = 1; frame <= 3; frame++) {
+        CHECK(joystick.read_state(&state));
+        CHECK_EQ(state.offset_x, frame);
+        CHECK_EQ(state.adc_x, 32768 + frame * 8);
+    }
+    CHECK(replay.is_finished());
+    CHECK(joystick.read_state(&state));
+    CHECK_EQ(state.offset_x, 3);
+
+    // The getters of the old game loops: x, y and button make one frame
+    replay.begin(buf, size, JOYSTICK_REPLAY_FAST, true);
+    for (int frame = 0; frame < 7; frame++) {
+        CHECK_EQ(joystick.get_joy_adc_12bits_offset_value_x(), frame % 3 + 1);
+        CHECK_EQ(joystick.get_joy_adc_12bits_offset_value_y(), 0);
+        CHECK_EQ(joystick.get_button_value(), 1);
+    }
+    CHECK_EQ(replay.get_played_count(), 7);
+    CHECK(!replay.is_finished());
+
+    // Time plays no part
+    replay.begin(buf, size, JOYSTICK_REPLAY_FAST);
+    joystick_host_advance_us(1000000);
+    CHECK(joystick.read_state(&state, JOYSTICK_STATE_OFFSET));
+    CHECK_EQ(state.offset_x, 1);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_dump();
+    test_realtime();
+    test_fast();
+    return test_result("test_record");
+}
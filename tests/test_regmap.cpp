@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include "joystick.hpp"
+#include "joystick_mock_bus.hpp"
+#include "test_util.hpp"
+
+// Burst plans generated from the register map and the typed read<>/write<> accessors
+
+static void test_plans(void)
+{
+    // Bursts follow the register order, fields keep the request order
+    typedef JoystickReadPlan<JoystickRegOffset12Y, JoystickRegButton, JoystickRegOffset12X> offsets_t;
+    constexpr auto p = offsets_t::plan;
+    CHECK_EQ(p.burst_count, 2);
+    CHECK_EQ(p.bursts[0].reg, JOYSTICK_BUTTON_REG);
+    CHECK_EQ(p.bursts[0].len, 1);
+    CHECK_EQ(p.bursts[0].offset, 0);
+    CHECK_EQ(p.bursts[1].reg, JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG);
+    CHECK_EQ(p.bursts[1].len, 4);
+    CHECK_EQ(p.bursts[1].offset, 1);
+    CHECK_EQ(p.size, 5);
+    CHECK_EQ(p.field_offset[0], 3);
+    CHECK_EQ(p.field_offset[1], 0);
+    CHECK_EQ(p.field_offset[2], 1);
+
+    // Gaps up to JOYSTICK_BURST_MAX_GAP are read through, one more splits
+    constexpr auto gap = JoystickReadPlan<JoystickRegCal<0>, JoystickRegCal<3>>::plan;
+    CHECK_EQ(gap.burst_count, 1);
+    CHECK_EQ(gap.bursts[0].len, 8);
+    CHECK_EQ(gap.field_offset[1], 6);
+    constexpr auto split = JoystickReadPlan<JoystickRegCal<0>, JoystickRegCal<4>>::plan;
+    CHECK_EQ(split.burst_count, 2);
+    CHECK_EQ(split.size, 4);
+    CHECK_EQ(split.field_offset[1], 2);
+
+    // Overlapping and repeated fields share their bytes
+    constexpr joystick_field_desc_t overlap[] = {{0x40, 4}, {0x42, 2}, {0x40, 2}};
+    constexpr auto o = joystick_make_read_plan(overlap);
+    CHECK_EQ(o.burst_count, 1);
+    CHECK_EQ(o.size, 4);
+    CHECK_EQ(o.field_offset[0], 0);
+    CHECK_EQ(o.field_offset[1], 2);
+    CHECK_EQ(o.field_offset[2], 0);
+
+    // The end of the map
+    constexpr auto top = JoystickReadPlan<JoystickRegAddress, JoystickRegBootloader, JoystickRegFirmware>::plan;
+    CHECK_EQ(top.burst_count, 1);
+    CHECK_EQ(top.bursts[0].reg, JOYSTICK_BOOTLOADER_VERSION_REG);
+    CHECK_EQ(top.bursts[0].len, 4);
+    CHECK_EQ(top.field_offset[0], 3);
+}
+
+// Random field sets: every field lands inside one burst, bursts stay apart and minimal
+static void test_generated_plans(void)
+{
+    srand(1);
+    for (int run = 0; run < 2000; run++) {
+        joystick_field_desc_t fields[6];
+        for (int i = 0; i < 6; i++) {
+            fields[i].width = (uint8_t)(1 << (rand() % 3));
+            fields[i].reg = (uint8_t)(rand() % (257 - fields[i].width));
+        }
+        joystick_read_plan_t<6> plan = joystick_make_read_plan(fields);
+
+        uint32_t size = 0;
+        for (uint8_t b = 0; b < plan.burst_count; b++) {
+            const joystick_burst_t &burst = plan.bursts[b];
+            CHECK_EQ(burst.offset, size);
+            size += burst.len;
+            if (b > 0) {
+                const joystick_burst_t &prev = plan.bursts[b - 1];
+                CHECK(burst.reg > prev.reg + prev.len + JOYSTICK_BURST_MAX_GAP);
+            }
+        }
+        CHECK_EQ(plan.size, size);
+
+        for (int i = 0; i < 6; i++) {
+            int found = 0;
+            for (uint8_t b = 0; b < plan.burst_count; b++) {
+                const joystick_burst_t &burst = plan.bursts[b];
+                if (fields[i].reg >= burst.reg && fields[i].reg + fields[i].width <= burst.reg + burst.len) {
+                    CHECK_EQ(plan.field_offset[i], burst.offset + fields[i].reg - burst.reg);
+                    found++;
+                }
+            }
+            CHECK_EQ(found, 1);
+        }
+        if (test_failures > 0) {
+            break; // One broken plan is enough output
+        }
+    }
+}
+
+static void test_read_write(void)
+{
+    JoystickMockBus bus;
+    bus.add_device(JOYSTICK_ADDR);
+    bus.set_stick(JOYSTICK_ADDR, -1234, 567, 1);
+    Joystick joystick;
+    CHECK(joystick.begin(&bus, JOYSTICK_ADDR));
+
+    // Signed and unsigned decoding, two bursts for three fields
+    int16_t x = 0, y = 0;
+    uint8_t button = 0;
+    uint32_t transfers = bus.get_transfer_count();
+    CHECK((joystick.read<JoystickRegOffset12X, JoystickRegButton, JoystickRegOffset12Y>(x, button, y)));
+    CHECK_EQ(bus.get_transfer_count() - transfers, 2);
+    CHECK_EQ(x, -1234);
+    CHECK_EQ(y, 567);
+    CHECK_EQ(button, 1);
+
+    uint16_t adc_x = 0;
+    int8_t off8_y = 0;
+    CHECK((joystick.read<JoystickRegAdc16X, JoystickRegOffset8Y>(adc_x, off8_y)));
+    CHECK_EQ(adc_x, 32768 - 1234 * 8);
+    CHECK_EQ(off8_y, 567 / 32);
+
+    // Little endian encoding, read back through the same field
+    CHECK(joystick.write<JoystickRegRgb>(0x00A1B2C3));
+    const uint8_t *regs = bus.get_regs(JOYSTICK_ADDR);
+    CHECK_EQ(regs[JOYSTICK_RGB_REG], 0xC3);
+    CHECK_EQ(regs[JOYSTICK_RGB_REG + 1], 0xB2);
+    CHECK_EQ(regs[JOYSTICK_RGB_REG + 2], 0xA1);
+    uint32_t rgb = 0;
+    CHECK(joystick.read<JoystickRegRgb>(rgb));
+    CHECK_EQ(rgb, 0x00A1B2C3);
+
+    // A failed read leaves the values unchanged
+    bus.set_present(JOYSTICK_ADDR, false);
+    x = 42;
+    CHECK(!joystick.read<JoystickRegOffset12X>(x));
+    CHECK_EQ(x, 42);
+    CHECK(!joystick.write<JoystickRegRgb>(0));
+}
+
+int main(void)
+{
+    test_plans();
+    test_generated_plans();
+    test_read_write();
+    return test_result("test_regmap");
+}
@@ -0,0 +1,121 @@
+#include <thread>
+#include "joystick_sample_ring.hpp"
+#include "test_util.hpp"
+
+// JoystickSampleRing single-threaded and with a real producer and consumer thread
+
+typedef struct {
+    uint32_t seq;
+    uint32_t check; // ~seq, a torn copy shows up as a mismatch
+} ring_item_t;
+
+static void test_single_thread(void)
+{
+    JoystickSampleRing<ring_item_t, 4> ring;
+    ring_item_t item;
+    CHECK(!ring.pop(&item));
+    CHECK(!ring.peek_latest(&item));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        CHECK(ring.push({i, ~i}));
+    }
+    CHECK(!ring.push({4, ~4u}));
+    CHECK_EQ(ring.get_overrun_count(), 1);
+    CHECK_EQ(ring.size(), 4);
+
+    CHECK(ring.peek_latest(&item));
+    CHECK_EQ(item.seq, 3);
+    CHECK(ring.pop(&item));
+    CHECK_EQ(item.seq, 0);
+
+    // Wrap around the end of the array
+    CHECK(ring.push({4, ~4u}));
+    ring_item_t items[8];
+    CHECK_EQ(ring.drain(items, 8), 4);
+    for (uint32_t i = 0; i < 4; i++) {
+        CHECK_EQ(items[i].seq, i + 1);
+    }
+
+    // Empty again: the newest item is the last one removed
+    CHECK(ring.peek_latest(&item));
+    CHECK_EQ(item.seq, 4);
+}
+
+// The producer retries when the ring is full: every item arrives once, in order
+static void test_two_threads_lossless(void)
+{
+    const uint32_t count = 1000000;
+    static JoystickSampleRing<ring_item_t, 16> ring;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++) {
+            while (!ring.push({i, ~i})) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t bad = 0;
+    ring_item_t item;
+    while (expected < count) {
+        if (!ring.pop(&item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.seq != expected || item.check != ~item.seq) {
+            bad++;
+        }
+        expected = item.seq + 1;
+    }
+    producer.join();
+
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(ring.size(), 0);
+}
+
+// The producer never waits, like the sampler: items are dropped, never reordered
+static void test_two_threads_overrun(void)
+{
+    const uint32_t count = 200000;
+    static JoystickSampleRing<ring_item_t, 8> ring;
+    std::atomic<bool> done(false);
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++) {
+            ring.push({i, ~i});
+        }
+        done.store(true);
+    });
+
+    uint32_t received = 0;
+    uint32_t bad = 0;
+    int64_t last = -1;
+    ring_item_t items[8];
+    for (;;) {
+        bool finished = done.load();
+        uint32_t n = ring.drain(items, 8);
+        for (uint32_t i = 0; i < n; i++) {
+            if ((int64_t)items[i].seq <= last || items[i].check != ~items[i].seq) {
+                bad++;
+            }
+            last = items[i].seq;
+        }
+        received += n;
+        if (finished && n == 0) {
+            break;
+        }
+    }
+    producer.join();
+
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(received + ring.get_overrun_count(), count);
+}
+
+int main(void)
+{
+    test_single_thread();
+    test_two_threads_lossless();
+    test_two_threads_overrun();
+    return test_result("test_sample_ring");
+}
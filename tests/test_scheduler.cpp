@@ -0,0 +1,260 @@
+#include "joystick.hpp"
+#include "joystick_mock_bus.hpp"
+#include "joystick_scheduler.hpp"
+#include "test_util.hpp"
+
+// JoystickScheduler on a mock bus with wire timing: every transfer advances
+// the simulated clock by its time on the wire, so deadlines, waits and bus
+// utilization are those of a real 400 kHz bus.
+
+/**
+ * @brief Transport wrapper recording the register of every transfer
+ */
+class RegLog : public JoystickTransport {
+public:
+    JoystickMockBus mock;
+    uint8_t regs[64];
+    uint32_t count = 0;
+
+    RegLog()
+    {
+        mock.add_device(JOYSTICK_ADDR);
+        mock.set_speed(400000);
+        mock.set_wire_timing(true);
+    }
+    int read_reg(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t nbytes) override
+    {
+        log(reg);
+        return mock.read_reg(addr, reg, buf, nbytes);
+    }
+    int write_reg(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t nbytes) override
+    {
+        log(reg);
+        return mock.write_reg(addr, reg, buf, nbytes);
+    }
+    uint32_t set_speed(uint32_t speed) override { return mock.set_speed(speed); }
+    uint32_t get_speed(void) override { return mock.get_speed(); }
+
+private:
+    void log(uint8_t reg)
+    {
+        if (count < 64) {
+            regs[count] = reg;
+        }
+        count++;
+    }
+};
+
+static const uint8_t rgb[4] = {1, 2, 3, 0};
+
+static void test_priority(void)
+{
+    RegLog bus;
+    JoystickScheduler sched;
+    sched.begin(&bus);
+    int input = sched.add_client(JOYSTICK_PRIORITY_HIGH, 2000);
+    int sensor = sched.add_client(JOYSTICK_PRIORITY_NORMAL, 50000);
+    int led = sched.add_client(JOYSTICK_PRIORITY_LOW, 50000);
+
+    CHECK(sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4));
+    CHECK(sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG + 1, rgb, 1));
+    CHECK(sched.post_write(sensor, JOYSTICK_ADDR, JOYSTICK_ADC_VALUE_CAL_REG, rgb, 2));
+    CHECK_EQ(sched.get_pending(), 3);
+    CHECK_EQ(bus.count, 0);
+
+    // An input read goes ahead of everything that can still wait
+    uint8_t button;
+    CHECK_EQ(sched.read(input, JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &button, 1), 1);
+    CHECK_EQ(bus.count, 1);
+
+    // A low priority read waits for the normal write, then for the low writes with earlier deadlines
+    uint8_t version;
+    CHECK_EQ(sched.read(led, JOYSTICK_ADDR, JOYSTICK_FIRMWARE_VERSION_REG, &version, 1), 1);
+    CHECK_EQ(bus.count, 5);
+    CHECK_EQ(bus.regs[1], JOYSTICK_ADC_VALUE_CAL_REG);
+    CHECK_EQ(bus.regs[2], JOYSTICK_RGB_REG);       // Same priority and deadline: oldest first
+    CHECK_EQ(bus.regs[3], JOYSTICK_RGB_REG + 1);
+    CHECK_EQ(bus.regs[4], JOYSTICK_FIRMWARE_VERSION_REG);
+    CHECK_EQ(sched.get_pending(), 0);
+    CHECK_EQ(bus.mock.get_regs(JOYSTICK_ADDR)[JOYSTICK_RGB_REG], 1);
+    CHECK_EQ(sched.get_stats(led).transactions, 3);
+    CHECK_EQ(sched.get_stats(input).transactions, 1);
+    CHECK_EQ(sched.get_stats(sensor).transactions, 1);
+}
+
+static void test_deadline(void)
+{
+    RegLog bus;
+    JoystickScheduler sched;
+    sched.begin(&bus);
+    int input = sched.add_client(JOYSTICK_PRIORITY_HIGH, 1000);
+    int led = sched.add_client(JOYSTICK_PRIORITY_LOW, 1000);
+
+    // One write first, so the scheduler knows how long an LED write takes
+    CHECK_EQ(sched.write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4), 4);
+
+    // Back to back input reads: the posted write is sent once it is due, just before its deadline
+    CHECK(sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4));
+    uint32_t reads = 0;
+    uint8_t buf[4];
+    while (sched.get_pending() > 0 && reads < 100) {
+        sched.read(input, JOYSTICK_ADDR, JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG, buf, 4);
+        reads++;
+    }
+    CHECK(reads > 1);
+    uint32_t wait = sched.get_stats(led).max_wait_us;
+    CHECK(wait > 1000 / 2);
+    CHECK(wait + bus.mock.wire_time_us(4, false) <= 1000);
+    CHECK_EQ(sched.get_stats(led).deadline_misses, 0);
+    CHECK_EQ(sched.get_stats(input).deadline_misses, 0);
+}
+
+static void test_no_starvation(void)
+{
+    RegLog bus;
+    JoystickScheduler sched;
+    sched.begin(&bus);
+    int input = sched.add_client(JOYSTICK_PRIORITY_HIGH, 1000);
+    int led = sched.add_client(JOYSTICK_PRIORITY_LOW, 2000);
+    sched.write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4);
+    sched.reset_stats();
+
+    // 100 ms of input reads saturating the bus, an LED update every 5 ms
+    uint64_t start = joystick_time_us();
+    uint64_t next_post = start;
+    uint32_t posted = 0;
+    uint8_t buf[4];
+    while (joystick_time_us() - start < 100000) {
+        if (joystick_time_us() >= next_post) {
+            CHECK(sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4));
+            posted++;
+            next_post += 5000;
+        }
+        sched.read(input, JOYSTICK_ADDR, JOYSTICK_OFFSET_ADC_VALUE_12BITS_REG, buf, 4);
+    }
+    CHECK(sched.get_pending() <= 1);
+    sched.flush();
+
+    const joystick_sched_stats_t &in = sched.get_stats(input);
+    const joystick_sched_stats_t &out = sched.get_stats(led);
+    CHECK_EQ(posted, 20);
+    CHECK_EQ(out.transactions, posted);
+    CHECK_EQ(out.deadline_misses, 0);
+    CHECK_EQ(out.dropped, 0);
+    CHECK(out.max_wait_us <= 2000);
+    CHECK_EQ(in.deadline_misses, 0);
+    CHECK_EQ(in.errors, 0);
+
+    // Bus time per client is its transfers times their wire time
+    CHECK_EQ(in.busy_us, (uint64_t)in.transactions * bus.mock.wire_time_us(4, true));
+    CHECK_EQ(out.busy_us, (uint64_t)out.transactions * bus.mock.wire_time_us(4, false));
+
+    // The bus was never idle: the two shares add up to the whole elapsed time
+    uint32_t in_util = sched.get_utilization(input);
+    uint32_t led_util = sched.get_utilization(led);
+    CHECK(led_util > 0);
+    CHECK(in_util > 900);
+    CHECK(in_util + led_util <= 1000);
+    CHECK(in_util + led_util >= 995);
+}
+
+static void test_errors(void)
+{
+    RegLog bus;
+    JoystickScheduler sched;
+    sched.begin(&bus);
+    int input = sched.add_client(JOYSTICK_PRIORITY_HIGH, 1000);
+    int led = sched.add_client(JOYSTICK_PRIORITY_LOW, 100000);
+
+    uint8_t big[JOYSTICK_SCHED_MAX_POSTED + 1] = {};
+    CHECK(!sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, big, sizeof(big)));
+    for (int i = 0; i < JOYSTICK_SCHED_QUEUE_SIZE; i++) {
+        CHECK(sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4));
+    }
+    CHECK(!sched.post_write(led, JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4));
+    CHECK_EQ(sched.get_stats(led).dropped, 2);
+
+    // A full queue refuses blocking transactions too
+    uint8_t button;
+    CHECK(sched.read(input, JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &button, 1) < 0);
+    CHECK_EQ(bus.count, 0);
+    sched.flush();
+
+    bus.mock.set_present(JOYSTICK_ADDR, false);
+    CHECK(sched.read(input, JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &button, 1) < 0);
+    CHECK_EQ(sched.get_stats(input).errors, 1);
+    CHECK_EQ(sched.get_stats(input).transactions, 1);
+}
+
+// Two Joystick drivers sharing the bus through scheduler clients
+static void test_clients(void)
+{
+    RegLog bus;
+    bus.mock.set_stick(JOYSTICK_ADDR, 500, -500, 1);
+    JoystickScheduler sched;
+    sched.begin(&bus);
+    JoystickSchedulerClient input_client, led_client;
+    CHECK(input_client.begin(&sched, JOYSTICK_PRIORITY_HIGH, 2000));
+    CHECK(led_client.begin(&sched, JOYSTICK_PRIORITY_LOW, 20000, true));
+
+    Joystick input, led;
+    CHECK(input.begin(&input_client, JOYSTICK_ADDR));
+    CHECK(led.begin(&led_client, JOYSTICK_ADDR));
+
+    // The posted LED write returns at once and waits behind the input read
+    led.set_rgb_color(0x00FF00);
+    CHECK_EQ(led.get_last_status(), JOYSTICK_OK);
+    CHECK_EQ(sched.get_pending(), 1);
+    joystick_state_t state;
+    CHECK(input.read_state(&state, JOYSTICK_STATE_OFFSET));
+    CHECK_EQ(state.offset_x, 500);
+    CHECK_EQ(sched.get_pending(), 1);
+
+    // Changing the speed sends what was queued at the old one first
+    CHECK_EQ(led_client.set_speed(1000000), 1000000);
+    CHECK_EQ(sched.get_pending(), 0);
+    CHECK_EQ(input_client.get_speed(), 1000000);
+    CHECK_EQ(bus.mock.get_regs(JOYSTICK_ADDR)[JOYSTICK_RGB_REG + 1], 0xFF);
+}
+
+// Ids add_client() never returned are refused instead of indexing past the clients
+static void test_bad_client(void)
+{
+    RegLog bus;
+    JoystickScheduler sched;
+    sched.begin(&bus);
+    for (int i = 0; i < JOYSTICK_SCHED_MAX_CLIENTS; i++) {
+        CHECK_EQ(sched.add_client(JOYSTICK_PRIORITY_NORMAL, 1000), i);
+    }
+    CHECK_EQ(sched.add_client(JOYSTICK_PRIORITY_NORMAL, 1000), -1);
+
+    uint8_t value = 0;
+    const int bad[] = {-1, JOYSTICK_SCHED_MAX_CLIENTS, 1000};
+    for (int id : bad) {
+        CHECK_EQ(sched.read(id, JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &value, 1), PICO_ERROR_GENERIC);
+        CHECK(!sched.post_write(id, JOYSTICK_ADDR, JOYSTICK_RGB_REG, &value, 1));
+        CHECK_EQ(sched.get_stats(id).transactions, 0);
+        CHECK_EQ(sched.get_stats(id).dropped, 0);
+        CHECK_EQ(sched.get_utilization(id), 0);
+    }
+    CHECK_EQ(bus.count, 0);
+    CHECK_EQ(sched.get_pending(), 0);
+
+    // A client whose begin() failed gets errors, not a crash
+    JoystickSchedulerClient extra;
+    CHECK(!extra.begin(&sched, JOYSTICK_PRIORITY_HIGH, 1000));
+    Joystick joystick;
+    CHECK(!joystick.begin(&extra, JOYSTICK_ADDR));
+    CHECK_EQ(bus.count, 0);
+}
+
+int main(void)
+{
+    test_priority();
+    test_deadline();
+    test_no_starvation();
+    test_errors();
+    test_clients();
+    test_bad_client();
+    return test_result("test_scheduler");
+}
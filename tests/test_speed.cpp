@@ -0,0 +1,186 @@
+#include "joystick.hpp"
+#include "joystick_mock_bus.hpp"
+#include "joystick_speed.hpp"
+#include "test_util.hpp"
+
+// JoystickSpeedControl on a mock bus whose transfers fail at or above a chosen speed
+
+static void test_negotiate(void)
+{
+    JoystickMockBus mock;
+    mock.add_device(JOYSTICK_ADDR);
+    JoystickSpeedControl speed;
+    speed.begin(&mock);
+
+    // A clean bus settles on the fastest speed
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 1000000);
+    CHECK_EQ(mock.get_speed(), 1000000);
+
+    // The limit caps the search
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR, 400000), 400000);
+
+    // Errors at 1 MHz keep the bus at 400 kHz, errors at 400 kHz at 100 kHz
+    mock.set_speed_fault(1000000, 50);
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 400000);
+    mock.set_speed_fault(400000, 50);
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 100000);
+    CHECK_EQ(mock.get_speed(), 100000);
+
+    // A single failed probe read is enough to reject a speed
+    mock.set_speed_fault(1000000, JOYSTICK_SPEED_PROBE_COUNT * 3);
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 400000);
+
+    // Negotiation transfers go straight to the wrapped transport
+    CHECK_EQ(speed.get_transfer_count(), 0);
+}
+
+static void test_negotiate_fail(void)
+{
+    JoystickMockBus mock;
+    mock.add_device(JOYSTICK_ADDR);
+    JoystickSpeedControl speed;
+
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 0); // No transport
+    speed.begin(&mock);
+    CHECK_EQ(speed.negotiate(0x20), 0);          // No unit at the address
+
+    // Unreliable even at 100 kHz
+    mock.set_speed_fault(100000, 10);
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 0);
+
+    // A wrong address register fails the probe
+    mock.set_speed_fault(0, 0);
+    uint8_t addr = 0x42;
+    mock.set_regs(JOYSTICK_ADDR, JOYSTICK_I2C_ADDRESS_REG, &addr, 1);
+    CHECK_EQ(speed.probe(JOYSTICK_ADDR, 0, 4), 4);
+}
+
+static uint32_t read_buttons(JoystickSpeedControl &speed, uint32_t count)
+{
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t button;
+        failures += speed.read_reg(JOYSTICK_ADDR, JOYSTICK_BUTTON_REG, &button, 1) != 1;
+    }
+    return failures;
+}
+
+static void test_downshift(void)
+{
+    JoystickMockBus mock;
+    mock.add_device(JOYSTICK_ADDR);
+    JoystickSpeedControl speed;
+    speed.begin(&mock);
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 1000000);
+
+    // Sparse errors stay under the window limit
+    mock.set_speed_fault(1000000, JOYSTICK_SPEED_WINDOW / 2);
+    uint32_t failures = read_buttons(speed, JOYSTICK_SPEED_WINDOW * 8);
+    CHECK(failures > 0);
+    CHECK_EQ(speed.get_error_count(), failures);
+    CHECK_EQ(speed.get_downshift_count(), 0);
+    CHECK_EQ(mock.get_speed(), 1000000);
+
+    // The bus degrades at 1 MHz: one drop to 400 kHz, where it is clean again
+    mock.set_speed_fault(1000000, 8);
+    uint32_t errors = speed.get_error_count();
+    read_buttons(speed, JOYSTICK_SPEED_WINDOW * 4);
+    CHECK_EQ(speed.get_downshift_count(), 1);
+    CHECK_EQ(speed.get_speed(), 400000);
+    CHECK_EQ(speed.get_error_count() - errors, JOYSTICK_SPEED_WINDOW_MAX_ERRORS + 1);
+
+    // Errors at every speed stop at 100 kHz
+    mock.set_speed_fault(100000, 2);
+    read_buttons(speed, JOYSTICK_SPEED_WINDOW * 4);
+    CHECK_EQ(speed.get_downshift_count(), 2);
+    CHECK_EQ(speed.get_speed(), 100000);
+    CHECK_EQ(speed.get_transfer_count(), JOYSTICK_SPEED_WINDOW * 16);
+}
+
+static void test_set_speed(void)
+{
+    JoystickMockBus mock;
+    mock.add_device(JOYSTICK_ADDR);
+    JoystickSpeedControl speed;
+    speed.begin(&mock);
+
+    // A speed between levels downshifts from the level below it
+    CHECK_EQ(speed.set_speed(800000), 800000);
+    mock.set_speed_fault(0, 1);
+    read_buttons(speed, JOYSTICK_SPEED_WINDOW_MAX_ERRORS + 1);
+    CHECK_EQ(speed.get_downshift_count(), 1);
+    CHECK_EQ(mock.get_speed(), 100000);
+
+    // Writes count like reads
+    uint8_t rgb[4] = {};
+    for (uint32_t i = 0; i <= JOYSTICK_SPEED_WINDOW_MAX_ERRORS; i++) {
+        speed.write_reg(JOYSTICK_ADDR, JOYSTICK_RGB_REG, rgb, 4);
+    }
+    CHECK_EQ(speed.get_error_count(), (JOYSTICK_SPEED_WINDOW_MAX_ERRORS + 1) * 2);
+    CHECK_EQ(speed.get_downshift_count(), 1);
+}
+
+static void test_other_unit(void)
+{
+    const uint8_t dead = JOYSTICK_ADDR + 1;
+    JoystickMockBus mock;
+    mock.add_device(JOYSTICK_ADDR);
+    mock.add_device(dead);
+    JoystickSpeedControl speed;
+    speed.begin(&mock);
+    CHECK_EQ(speed.negotiate(JOYSTICK_ADDR), 1000000);
+
+    // A unit that stopped answering does not slow the negotiated one down
+    mock.set_present(dead, false);
+    uint8_t button;
+    for (uint32_t i = 0; i < JOYSTICK_SPEED_WINDOW; i++) {
+        CHECK(speed.read_reg(dead, JOYSTICK_BUTTON_REG, &button, 1) < 0);
+    }
+    CHECK_EQ(speed.get_downshift_count(), 0);
+    CHECK_EQ(speed.get_error_count(), 0);
+    CHECK_EQ(speed.get_transfer_count(), JOYSTICK_SPEED_WINDOW);
+    CHECK_EQ(mock.get_speed(), 1000000);
+
+    // Its own errors still do
+    mock.set_speed_fault(1000000, 1);
+    read_buttons(speed, JOYSTICK_SPEED_WINDOW_MAX_ERRORS + 1);
+    CHECK_EQ(speed.get_downshift_count(), 1);
+    CHECK_EQ(mock.get_speed(), 400000);
+}
+
+static void test_attach(void)
+{
+    JoystickMockBus mock;
+    mock.add_device(JOYSTICK_ADDR);
+    mock.set_speed(400000);
+    Joystick joystick;
+    CHECK(joystick.begin(&mock, JOYSTICK_ADDR));
+
+    // The joystick ends up behind the speed control at the negotiated speed
+    JoystickSpeedControl speed;
+    CHECK_EQ(speed.attach(&joystick, JOYSTICK_ADDR), 1000000);
+    CHECK(joystick.get_transport() == &speed);
+    CHECK_EQ(speed.attach(&joystick, JOYSTICK_ADDR), 0);       // Already attached
+    CHECK(joystick.get_transport() == &speed);
+
+    // A failed negotiation leaves the joystick on its transport, at its speed
+    Joystick other;
+    mock.set_speed(400000);
+    CHECK(other.begin(&mock, JOYSTICK_ADDR));
+    mock.set_speed_fault(100000, 10);
+    JoystickSpeedControl failing;
+    CHECK_EQ(failing.attach(&other, JOYSTICK_ADDR), 0);
+    CHECK(other.get_transport() == &mock);
+    CHECK_EQ(mock.get_speed(), 400000);
+}
+
+int main(void)
+{
+    test_negotiate();
+    test_negotiate_fail();
+    test_downshift();
+    test_set_speed();
+    test_other_unit();
+    test_attach();
+    return test_result("test_speed");
+}
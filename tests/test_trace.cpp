@@ -0,0 +1,127 @@
+#include "joystick_trace.hpp"
+#include "st7789.hpp"
+#include "test_util.hpp"
+
+// JoystickTrace percentiles and frame closing, driven by hand and by the host
+// ST7789 HAL on the simulated clock. A wrapper around the transfer callback
+// logs when every transfer the trace sees has left the bus.
+
+#define WIDTH 240
+#define HEIGHT 320
+
+static JoystickTrace trace;
+static uint32_t transfers = 0;
+static uint64_t transfer_us = 0;    // Time of the last transfer callback
+
+static void log_transfer(void *ctx)
+{
+    transfers++;
+    transfer_us = joystick_time_us();
+    JoystickTrace::transfer_callback(ctx);
+}
+
+// One frame drawn by hand: a transfer latency_us after the sample
+static void frame(uint32_t latency_us)
+{
+    joystick_trace_tag_t tag = trace.tag();
+    trace.draw_begin(tag);
+    joystick_host_advance_us(latency_us);
+    trace.on_transfer();
+    trace.draw_end();
+}
+
+static void test_percentiles(void)
+{
+    trace.reset();
+    joystick_trace_summary_t s;
+    trace.get_summary(&s);
+    CHECK_EQ(s.frames, 0);
+    CHECK_EQ(s.max_us, 0);
+
+    // 1..100 in a shuffled order: index (n - 1) * p / 100 of the sorted latencies
+    for (uint32_t i = 0; i < 100; i++) {
+        frame((i * 37) % 100 + 1);
+    }
+    trace.get_summary(&s);
+    CHECK_EQ(s.frames, 100);
+    CHECK_EQ(s.p50_us, 50);
+    CHECK_EQ(s.p90_us, 90);
+    CHECK_EQ(s.p99_us, 99);
+    CHECK_EQ(s.max_us, 100);
+
+    // Only the last JOYSTICK_TRACE_WINDOW frames count, the frame count goes on
+    for (uint32_t i = 0; i < JOYSTICK_TRACE_WINDOW; i++) {
+        frame(1000 + i);
+    }
+    trace.get_summary(&s);
+    CHECK_EQ(s.frames, 100 + JOYSTICK_TRACE_WINDOW);
+    CHECK_EQ(s.p50_us, 1000 + (JOYSTICK_TRACE_WINDOW - 1) / 2);
+    CHECK_EQ(s.max_us, 1000 + JOYSTICK_TRACE_WINDOW - 1);
+    CHECK_EQ(trace.get_last_latency(), 1000 + JOYSTICK_TRACE_WINDOW - 1);
+
+    // A frame without transfers and transfers outside a frame are not recorded
+    trace.draw_begin(trace.tag());
+    trace.draw_end();
+    trace.on_transfer();
+    trace.get_summary(&s);
+    CHECK_EQ(s.frames, 100 + JOYSTICK_TRACE_WINDOW);
+}
+
+static void test_display(void)
+{
+    st7789::ST7789 lcd;
+    st7789::Config config;
+    CHECK(lcd.begin(config));
+    CHECK(lcd.waitIdle());
+    lcd.hal().setTransferCallback(log_transfer, &trace);
+    trace.reset();
+    uint64_t fill_us = (uint64_t)WIDTH * HEIGHT * 16 * 1000000 / lcd.hal().getConfig().spi_speed_hz;
+
+    // Only pixels count: a fill below dma.fill_threshold is one blocking transfer,
+    // its address window none
+    transfers = 0;
+    lcd.fillRect(0, 0, 5, 5, st7789::RED);
+    CHECK_EQ(transfers, 1);
+
+    // Deferred close: the full screen DMA fill ends in the "interrupt" after draw_end
+    joystick_trace_tag_t tag = trace.tag();
+    trace.draw_begin(tag);
+    lcd.fillScreen(st7789::BLUE);
+    CHECK(lcd.isDmaBusy());
+    trace.draw_end(lcd.isDmaBusy());
+    CHECK_EQ(trace.get_last_latency(), 0);
+    joystick_sleep_us(fill_us * 2);
+    CHECK(!lcd.isDmaBusy());
+    CHECK_EQ(trace.get_last_latency(), transfer_us - tag.sample_us);
+    CHECK(trace.get_last_latency() >= fill_us);
+
+    // Still in flight when the next frame begins: the old frame closes on its
+    // own completion, which the next frame's first draw call waits for
+    tag = trace.tag();
+    trace.draw_begin(tag);
+    lcd.fillScreen(st7789::GREEN);
+    trace.draw_end(lcd.isDmaBusy());
+    joystick_trace_tag_t next = trace.tag();
+    trace.draw_begin(next);
+    CHECK(lcd.isDmaBusy());
+    transfers = 0;
+    lcd.fillRect(0, 0, 5, 5, st7789::RED);
+    CHECK_EQ(transfers, 2);
+    uint32_t previous = trace.get_last_latency();
+    CHECK(previous >= fill_us);
+    CHECK(previous < transfer_us - tag.sample_us);
+    trace.draw_end(lcd.isDmaBusy());
+    CHECK_EQ(trace.get_last_latency(), transfer_us - next.sample_us);
+
+    joystick_trace_summary_t s;
+    trace.get_summary(&s);
+    CHECK_EQ(s.frames, 3);
+    CHECK(s.max_us >= fill_us);
+}
+
+int main(void)
+{
+    test_percentiles();
+    test_display();
+    return test_result("test_trace");
+}
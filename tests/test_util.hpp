@@ -0,0 +1,37 @@
+#ifndef _MY_JOYSTICK_TEST_UTIL_H_
+#define _MY_JOYSTICK_TEST_UTIL_H_
+
+#include <stdio.h>
+
+/**
+ * Minimal checks for the host tests: a failed check prints its location and
+ * the test keeps going, test_result() turns the failures into the exit code
+ * seen by ctest.
+ */
+static int test_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long _a = (long long)(a); \
+        long long _b = (long long)(b); \
+        if (_a != _b) { \
+            printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+            test_failures++; \
+        } \
+    } while (0)
+
+static inline int test_result(const char *name)
+{
+    printf("%s: %s\n", name, test_failures == 0 ? "ok" : "FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
+
+#endif